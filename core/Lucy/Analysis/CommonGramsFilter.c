@@ -0,0 +1,289 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define C_LUCY_COMMONGRAMSFILTER
+#define C_LUCY_TOKEN
+#include "Lucy/Util/ToolSet.h"
+
+#include "Lucy/Analysis/CommonGramsFilter.h"
+#include "Lucy/Analysis/Inversion.h"
+#include "Lucy/Analysis/SnowballStopFilter.h"
+#include "Lucy/Analysis/Token.h"
+
+static INLINE bool
+SI_token_is_common(Hash *common_words, TokenIVARS *token_ivars);
+
+CommonGramsFilter*
+CommonGrams_new(const CharBuf *language, Hash *common_words) {
+    CommonGramsFilter *self
+        = (CommonGramsFilter*)VTable_Make_Obj(COMMONGRAMSFILTER);
+    return CommonGrams_init(self, language, common_words);
+}
+
+CommonGramsFilter*
+CommonGrams_init(CommonGramsFilter *self, const CharBuf *language,
+                 Hash *common_words) {
+    Analyzer_init((Analyzer*)self);
+    CommonGramsFilterIVARS *const ivars = CommonGrams_IVARS(self);
+
+    if (common_words) {
+        if (language) {
+            THROW(ERR, "Can't have both common_words and language");
+        }
+        ivars->common_words = (Hash*)INCREF(common_words);
+    }
+    else if (language) {
+        ivars->language     = CB_Clone(language);
+        ivars->common_words = SnowStop_gen_stoplist(language);
+        if (!ivars->common_words) {
+            THROW(ERR, "Can't get a list of common words for '%o'",
+                  language);
+        }
+    }
+    else {
+        THROW(ERR, "Either common_words or language is required");
+    }
+
+    return self;
+}
+
+void
+CommonGrams_destroy(CommonGramsFilter *self) {
+    CommonGramsFilterIVARS *const ivars = CommonGrams_IVARS(self);
+    DECREF(ivars->language);
+    DECREF(ivars->common_words);
+    SUPER_DESTROY(self, COMMONGRAMSFILTER);
+}
+
+static INLINE bool
+SI_token_is_common(Hash *common_words, TokenIVARS *token_ivars) {
+    return Hash_Fetch_Str(common_words, token_ivars->text, token_ivars->len)
+           ? true : false;
+}
+
+bool
+CommonGrams_is_common(CommonGramsFilter *self, const CharBuf *term) {
+    CommonGramsFilterIVARS *const ivars = CommonGrams_IVARS(self);
+    return Hash_Fetch(ivars->common_words, (Obj*)term) ? true : false;
+}
+
+bool
+CommonGrams_is_gram(CommonGramsFilter *self, const CharBuf *term) {
+    UNUSED_VAR(self);
+    const char *ptr = (const char*)CB_Get_Ptr8((CharBuf*)term);
+    size_t size = CB_Get_Size((CharBuf*)term);
+    return memchr(ptr, COMMONGRAMS_SEPARATOR, size) ? true : false;
+}
+
+Inversion*
+CommonGrams_transform(CommonGramsFilter *self, Inversion *inversion) {
+    CommonGramsFilterIVARS *const ivars = CommonGrams_IVARS(self);
+    Hash *const common_words  = ivars->common_words;
+    Inversion  *new_inversion = Inversion_new(NULL);
+    Token      *prev          = NULL;
+    Token      *token;
+    char       *buf           = NULL;
+    size_t      buf_cap       = 0;
+
+    // A Token's pos_inc is the distance to the Token which follows it, so
+    // each gram goes in front of its first word, with a pos_inc of 0, in
+    // order to share that word's position.  Hold each Token back until the
+    // next one has been seen.
+    while (NULL != (token = Inversion_Next(inversion))) {
+        if (prev) {
+            TokenIVARS *const prev_ivars  = Token_IVARS(prev);
+            TokenIVARS *const token_ivars = Token_IVARS(token);
+            if (prev_ivars->pos_inc == 1
+                && (SI_token_is_common(common_words, prev_ivars)
+                    || SI_token_is_common(common_words, token_ivars))
+               ) {
+                size_t len = prev_ivars->len + 1 + token_ivars->len;
+                if (len > buf_cap) {
+                    buf_cap = len;
+                    buf = (char*)REALLOCATE(buf, buf_cap);
+                }
+                memcpy(buf, prev_ivars->text, prev_ivars->len);
+                buf[prev_ivars->len] = COMMONGRAMS_SEPARATOR;
+                memcpy(buf + prev_ivars->len + 1, token_ivars->text,
+                       token_ivars->len);
+                Token *gram = Token_new(buf, len, prev_ivars->start_offset,
+                                        token_ivars->end_offset,
+                                        prev_ivars->boost, 0);
+                Inversion_Append_Gram(new_inversion, gram);
+            }
+            Inversion_Append(new_inversion, (Token*)INCREF(prev));
+        }
+        prev = token;
+    }
+    if (prev) {
+        Inversion_Append(new_inversion, (Token*)INCREF(prev));
+    }
+
+    FREEMEM(buf);
+    return new_inversion;
+}
+
+static CharBuf*
+S_make_gram(const CharBuf *first, const CharBuf *second) {
+    size_t   size = CB_Get_Size((CharBuf*)first) + 1
+                    + CB_Get_Size((CharBuf*)second);
+    CharBuf *gram = CB_new(size);
+    CB_Cat(gram, first);
+    CB_Cat_Char(gram, COMMONGRAMS_SEPARATOR);
+    CB_Cat(gram, second);
+    return gram;
+}
+
+VArray*
+CommonGrams_gram_terms(CommonGramsFilter *self, VArray *terms) {
+    uint32_t  num_terms = VA_Get_Size(terms);
+    VArray   *unigrams  = VA_new(num_terms);
+    uint32_t  num_grams = 0;
+
+    // Set aside any grams, leaving one term per position.
+    for (uint32_t i = 0; i < num_terms; i++) {
+        Obj *term = VA_Fetch(terms, i);
+        if (!term || !Obj_Is_A(term, CHARBUF)) {
+            DECREF(unigrams);
+            return VA_Clone(terms);
+        }
+        if (CommonGrams_Is_Gram(self, (CharBuf*)term)) {
+            num_grams++;
+        }
+        else {
+            VA_Push(unigrams, INCREF(term));
+        }
+    }
+    uint32_t num_unigrams = VA_Get_Size(unigrams);
+
+    // The grams may only be discarded if each one merely overlaps a pair of
+    // adjacent unigrams, as in analyzer output.  Otherwise -- for instance
+    // when the terms have already been through this method -- they stand
+    // for positions of their own, so leave the terms alone.
+    if (num_grams) {
+        Hash *pairs = Hash_new(num_unigrams);
+        for (uint32_t i = 0; i + 1 < num_unigrams; i++) {
+            CharBuf *gram
+                = S_make_gram((CharBuf*)VA_Fetch(unigrams, i),
+                              (CharBuf*)VA_Fetch(unigrams, i + 1));
+            Hash_Store(pairs, (Obj*)gram, (Obj*)gram);
+        }
+        bool covered = true;
+        for (uint32_t i = 0; i < num_terms && covered; i++) {
+            CharBuf *term = (CharBuf*)VA_Fetch(terms, i);
+            if (CommonGrams_Is_Gram(self, term)
+                && !Hash_Fetch(pairs, (Obj*)term)
+               ) {
+                covered = false;
+            }
+        }
+        DECREF(pairs);
+        if (!covered) {
+            DECREF(unigrams);
+            return VA_Clone(terms);
+        }
+    }
+
+    // Replace each pair which contains a common word with its gram.  The
+    // final term is only needed if it wasn't swallowed by the last pair.
+    VArray   *retval       = VA_new(num_unigrams);
+    bool      last_paired  = false;
+    for (uint32_t i = 0; i < num_unigrams; i++) {
+        CharBuf *term = (CharBuf*)VA_Fetch(unigrams, i);
+        if (i + 1 < num_unigrams) {
+            CharBuf *next = (CharBuf*)VA_Fetch(unigrams, i + 1);
+            if (CommonGrams_Is_Common(self, term)
+                || CommonGrams_Is_Common(self, next)
+               ) {
+                VA_Push(retval, (Obj*)S_make_gram(term, next));
+                last_paired = true;
+                continue;
+            }
+        }
+        else if (last_paired) {
+            break;
+        }
+        VA_Push(retval, INCREF(term));
+        last_paired = false;
+    }
+
+    DECREF(unigrams);
+    return retval;
+}
+
+Hash*
+CommonGrams_dump(CommonGramsFilter *self) {
+    CommonGramsFilterIVARS *const ivars = CommonGrams_IVARS(self);
+    CommonGrams_Dump_t super_dump
+        = SUPER_METHOD_PTR(COMMONGRAMSFILTER, Lucy_CommonGrams_Dump);
+    Hash *dump = super_dump(self);
+    if (ivars->language) {
+        Hash_Store_Str(dump, "language", 8, (Obj*)CB_Clone(ivars->language));
+    }
+    else {
+        VArray *words = Hash_Keys(ivars->common_words);
+        VA_Sort(words, NULL, NULL);
+        Hash_Store_Str(dump, "common_words", 12, (Obj*)words);
+    }
+    return dump;
+}
+
+CommonGramsFilter*
+CommonGrams_load(CommonGramsFilter *self, Obj *dump) {
+    CommonGrams_Load_t super_load
+        = SUPER_METHOD_PTR(COMMONGRAMSFILTER, Lucy_CommonGrams_Load);
+    CommonGramsFilter *loaded = super_load(self, dump);
+    Hash *source   = (Hash*)CERTIFY(dump, HASH);
+    Obj  *language = Hash_Fetch_Str(source, "language", 8);
+    if (language) {
+        return CommonGrams_init(loaded, (CharBuf*)CERTIFY(language, CHARBUF),
+                                NULL);
+    }
+    VArray *words = (VArray*)CERTIFY(
+                        Hash_Fetch_Str(source, "common_words", 12), VARRAY);
+    uint32_t num_words = VA_Get_Size(words);
+    Hash *common_words = Hash_new(num_words);
+    for (uint32_t i = 0; i < num_words; i++) {
+        CharBuf *word = (CharBuf*)CERTIFY(VA_Fetch(words, i), CHARBUF);
+        Hash_Store(common_words, (Obj*)word, (Obj*)CB_newf(""));
+    }
+    CommonGrams_init(loaded, NULL, common_words);
+    DECREF(common_words);
+    return loaded;
+}
+
+bool
+CommonGrams_equals(CommonGramsFilter *self, Obj *other) {
+    if ((CommonGramsFilter*)other == self)   { return true; }
+    if (!Obj_Is_A(other, COMMONGRAMSFILTER)) { return false; }
+    CommonGramsFilterIVARS *const ivars = CommonGrams_IVARS(self);
+    CommonGramsFilterIVARS *const ovars
+        = CommonGrams_IVARS((CommonGramsFilter*)other);
+
+    // Only the words matter, not the values they map to.
+    Hash *words       = ivars->common_words;
+    Hash *other_words = ovars->common_words;
+    if (Hash_Get_Size(words) != Hash_Get_Size(other_words)) { return false; }
+    Obj *key;
+    Obj *ignore;
+    Hash_Iterate(words);
+    while (Hash_Next(words, &key, &ignore)) {
+        if (!Hash_Fetch(other_words, key)) { return false; }
+    }
+    return true;
+}
+
+
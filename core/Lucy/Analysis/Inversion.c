@@ -34,6 +34,7 @@ Inversion_new(Token *seed_token) {
     // Init.
     ivars->cap                 = 16;
     ivars->size                = 0;
+    ivars->num_grams           = 0;
     ivars->tokens              = (Token**)CALLOCATE(ivars->cap, sizeof(Token*));
     ivars->cur                 = 0;
     ivars->inverted            = false;
@@ -68,6 +69,12 @@ Inversion_get_size(Inversion *self) {
     return Inversion_IVARS(self)->size;
 }
 
+uint32_t
+Inversion_get_length(Inversion *self) {
+    InversionIVARS *const ivars = Inversion_IVARS(self);
+    return ivars->size - ivars->num_grams;
+}
+
 Token*
 Inversion_next(Inversion *self) {
     InversionIVARS *const ivars = Inversion_IVARS(self);
@@ -111,6 +118,12 @@ Inversion_append(Inversion *self, Token *token) {
     ivars->size++;
 }
 
+void
+Inversion_append_gram(Inversion *self, Token *token) {
+    Inversion_Append(self, token);
+    Inversion_IVARS(self)->num_grams++;
+}
+
 Token**
 Inversion_next_cluster(Inversion *self, uint32_t *count) {
     InversionIVARS *const ivars = Inversion_IVARS(self);
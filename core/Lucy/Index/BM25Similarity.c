@@ -0,0 +1,171 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define C_LUCY_BM25SIMILARITY
+#include "Lucy/Util/ToolSet.h"
+
+#include <math.h>
+
+#include "Lucy/Index/BM25Similarity.h"
+#include "Lucy/Index/Posting/BM25Posting.h"
+#include "Lucy/Index/Segment.h"
+#include "Lucy/Store/InStream.h"
+#include "Lucy/Store/OutStream.h"
+
+BM25Similarity*
+BM25Sim_new(float k1, float b) {
+    BM25Similarity *self = (BM25Similarity*)VTable_Make_Obj(BM25SIMILARITY);
+    return BM25Sim_init(self, k1, b);
+}
+
+BM25Similarity*
+BM25Sim_init(BM25Similarity *self, float k1, float b) {
+    Sim_init((Similarity*)self);
+    BM25SimilarityIVARS *const ivars = BM25Sim_IVARS(self);
+    if (k1 < 0.0f) {
+        DECREF(self);
+        THROW(ERR, "k1 must not be negative: %f64", (double)k1);
+    }
+    if (b < 0.0f || b > 1.0f) {
+        DECREF(self);
+        THROW(ERR, "b must be between 0 and 1: %f64", (double)b);
+    }
+    ivars->k1 = k1;
+    ivars->b  = b;
+    return self;
+}
+
+float
+BM25Sim_get_k1(BM25Similarity *self) {
+    return BM25Sim_IVARS(self)->k1;
+}
+
+float
+BM25Sim_get_b(BM25Similarity *self) {
+    return BM25Sim_IVARS(self)->b;
+}
+
+Posting*
+BM25Sim_make_posting(BM25Similarity *self) {
+    return (Posting*)BM25Post_new((Similarity*)self);
+}
+
+float
+BM25Sim_tf(BM25Similarity *self, float freq) {
+    BM25SimilarityIVARS *const ivars = BM25Sim_IVARS(self);
+    if (freq <= 0.0f) { return 0.0f; }
+    return freq * (ivars->k1 + 1.0f) / (freq + ivars->k1);
+}
+
+float
+BM25Sim_idf(BM25Similarity *self, int64_t doc_freq, int64_t total_docs) {
+    UNUSED_VAR(self);
+    if (doc_freq > total_docs) { doc_freq = total_docs; }
+    double numerator   = (double)(total_docs - doc_freq) + 0.5;
+    double denominator = (double)doc_freq + 0.5;
+    return (float)sqrt(log(1.0 + numerator / denominator));
+}
+
+float
+BM25Sim_coord(BM25Similarity *self, uint32_t overlap, uint32_t max_overlap) {
+    UNUSED_VAR(self);
+    UNUSED_VAR(overlap);
+    UNUSED_VAR(max_overlap);
+    return 1.0f;
+}
+
+float
+BM25Sim_query_norm(BM25Similarity *self, float sum_of_squared_weights) {
+    UNUSED_VAR(self);
+    UNUSED_VAR(sum_of_squared_weights);
+    return 1.0f;
+}
+
+double
+BM25Sim_avg_field_length(Segment *segment, const CharBuf *field) {
+    Hash *metadata = (Hash*)Seg_Fetch_Metadata_Str(segment, "postings", 8);
+    if (!metadata || !Obj_Is_A((Obj*)metadata, HASH)) { return 0.0; }
+    Hash *field_stats = (Hash*)Hash_Fetch_Str(metadata, "field_stats", 11);
+    if (!field_stats || !Obj_Is_A((Obj*)field_stats, HASH)) { return 0.0; }
+    Hash *stats = (Hash*)Hash_Fetch(field_stats, (Obj*)field);
+    if (!stats || !Obj_Is_A((Obj*)stats, HASH)) { return 0.0; }
+    Obj *num_docs   = Hash_Fetch_Str(stats, "num_docs", 8);
+    Obj *num_tokens = Hash_Fetch_Str(stats, "num_tokens", 10);
+    if (!num_docs || !num_tokens) { return 0.0; }
+    int64_t docs = Obj_To_I64(num_docs);
+    if (docs <= 0) { return 0.0; }
+    return (double)Obj_To_I64(num_tokens) / (double)docs;
+}
+
+Obj*
+BM25Sim_dump(BM25Similarity *self) {
+    BM25SimilarityIVARS *const ivars = BM25Sim_IVARS(self);
+    BM25Sim_Dump_t super_dump
+        = SUPER_METHOD_PTR(BM25SIMILARITY, Lucy_BM25Sim_Dump);
+    Hash *dump = (Hash*)super_dump(self);
+    Hash_Store_Str(dump, "k1", 2, (Obj*)CB_newf("%f64", (double)ivars->k1));
+    Hash_Store_Str(dump, "b", 1, (Obj*)CB_newf("%f64", (double)ivars->b));
+    return (Obj*)dump;
+}
+
+BM25Similarity*
+BM25Sim_load(BM25Similarity *self, Obj *dump) {
+    BM25Sim_Load_t super_load
+        = SUPER_METHOD_PTR(BM25SIMILARITY, Lucy_BM25Sim_Load);
+    BM25Similarity *loaded = super_load(self, dump);
+    BM25SimilarityIVARS *const loaded_ivars = BM25Sim_IVARS(loaded);
+    Hash *source = (Hash*)CERTIFY(dump, HASH);
+    Obj  *k1_dump = Hash_Fetch_Str(source, "k1", 2);
+    Obj  *b_dump  = Hash_Fetch_Str(source, "b", 1);
+    loaded_ivars->k1 = k1_dump ? (float)Obj_To_F64(k1_dump) : 1.2f;
+    loaded_ivars->b  = b_dump  ? (float)Obj_To_F64(b_dump)  : 0.75f;
+    return loaded;
+}
+
+bool
+BM25Sim_equals(BM25Similarity *self, Obj *other) {
+    if ((BM25Similarity*)other == self)                 { return true; }
+    if (!Obj_Is_A(other, BM25SIMILARITY))               { return false; }
+    if (!Sim_equals((Similarity*)self, other))          { return false; }
+    BM25SimilarityIVARS *const ivars = BM25Sim_IVARS(self);
+    BM25SimilarityIVARS *const ovars = BM25Sim_IVARS((BM25Similarity*)other);
+    if (ivars->k1 != ovars->k1)                         { return false; }
+    if (ivars->b != ovars->b)                           { return false; }
+    return true;
+}
+
+void
+BM25Sim_serialize(BM25Similarity *self, OutStream *outstream) {
+    BM25Sim_Serialize_t super_serialize
+        = SUPER_METHOD_PTR(BM25SIMILARITY, Lucy_BM25Sim_Serialize);
+    super_serialize(self, outstream);
+    BM25SimilarityIVARS *const ivars = BM25Sim_IVARS(self);
+    OutStream_Write_F32(outstream, ivars->k1);
+    OutStream_Write_F32(outstream, ivars->b);
+}
+
+BM25Similarity*
+BM25Sim_deserialize(BM25Similarity *self, InStream *instream) {
+    BM25Sim_Deserialize_t super_deserialize
+        = SUPER_METHOD_PTR(BM25SIMILARITY, Lucy_BM25Sim_Deserialize);
+    self = super_deserialize(self, instream);
+    BM25SimilarityIVARS *const ivars = BM25Sim_IVARS(self);
+    ivars->k1 = InStream_Read_F32(instream);
+    ivars->b  = InStream_Read_F32(instream);
+    return self;
+}
+
+
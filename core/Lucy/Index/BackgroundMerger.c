@@ -401,8 +401,27 @@ BGMerger_prepare_commit(BackgroundMerger *self) {
             }
         }
 
-        // Finish the segment.
+        // Finish the segment.  If an index sort renumbered its documents,
+        // fold the renumbering into the doc maps, which are used to carry
+        // forward deletions made while we were merging.
         SegWriter_Finish(ivars->seg_writer);
+        I32Array *sort_map = SegWriter_Get_Sort_Map(ivars->seg_writer);
+        if (sort_map) {
+            CharBuf  *seg_name;
+            I32Array *doc_map;
+            Hash_Iterate(ivars->doc_maps);
+            while (Hash_Next(ivars->doc_maps, (Obj**)&seg_name,
+                             (Obj**)&doc_map)) {
+                for (uint32_t i = 1, max = I32Arr_Get_Size(doc_map);
+                     i < max; i++
+                    ) {
+                    int32_t merged = I32Arr_Get(doc_map, i);
+                    if (merged) {
+                        I32Arr_Set(doc_map, i, I32Arr_Get(sort_map, merged));
+                    }
+                }
+            }
+        }
 
         // Grab the write lock.
         S_obtain_write_lock(self);
@@ -39,6 +39,38 @@ DataWriter_init(DataWriter *self, Schema *schema, Snapshot *snapshot,
     return self;
 }
 
+I32Array*
+DataWriter_invert_doc_map(I32Array *doc_map, int32_t doc_max) {
+    int32_t num_live = 0;
+    int32_t base     = INT32_MAX;
+
+    // Find the size and start of the block of new doc ids.
+    for (int32_t i = 1; i <= doc_max; i++) {
+        int32_t new_doc_id = doc_map ? I32Arr_Get(doc_map, i) : i;
+        if (new_doc_id) {
+            num_live++;
+            if (new_doc_id < base) { base = new_doc_id; }
+        }
+    }
+
+    int32_t *order = (int32_t*)MALLOCATE(((size_t)num_live + 1)
+                                         * sizeof(int32_t));
+    for (int32_t i = 1; i <= doc_max; i++) {
+        int32_t new_doc_id = doc_map ? I32Arr_Get(doc_map, i) : i;
+        if (new_doc_id) {
+            int32_t slot = new_doc_id - base;
+            if (slot >= num_live) {
+                FREEMEM(order);
+                THROW(ERR, "Doc map for %i32 docs is not contiguous",
+                      num_live);
+            }
+            order[slot] = i;
+        }
+    }
+
+    return I32Arr_new_steal(order, (uint32_t)num_live);
+}
+
 void
 DataWriter_destroy(DataWriter *self) {
     DataWriterIVARS *const ivars = DataWriter_IVARS(self);
@@ -24,6 +24,7 @@
 #include "Lucy/Index/DeletionsWriter.h"
 #include "Lucy/Index/Segment.h"
 #include "Lucy/Index/Snapshot.h"
+#include "Lucy/Object/RoaringBitVector.h"
 #include "Lucy/Plan/Schema.h"
 #include "Lucy/Search/BitVecMatcher.h"
 #include "Lucy/Search/SeriesMatcher.h"
@@ -153,15 +154,24 @@ DefDelReader_destroy(DefaultDeletionsReader *self) {
     SUPER_DESTROY(self, DEFAULTDELETIONSREADER);
 }
 
-BitVector*
-DefDelReader_read_deletions(DefaultDeletionsReader *self) {
-    DefaultDeletionsReaderIVARS *const ivars = DefDelReader_IVARS(self);
-    VArray  *segments    = DefDelReader_Get_Segments(self);
-    Segment *segment     = DefDelReader_Get_Segment(self);
-    CharBuf *my_seg_name = Seg_Get_Name(segment);
-    CharBuf *del_file    = NULL;
-    int32_t  del_count   = 0;
+// Load a deletions file written in either the flat or the compressed format.
+static BitVector*
+S_open_deldocs(Folder *folder, CharBuf *filename) {
+    if (!CB_Ends_With_Str(filename, ".rbv", 4)) {
+        return (BitVector*)BitVecDelDocs_new(folder, filename);
+    }
+    InStream *instream = Folder_Open_In(folder, filename);
+    if (!instream) { RETHROW(INCREF(Err_get_error())); }
+    RoaringBitVector *deldocs
+        = (RoaringBitVector*)VTable_Make_Obj(ROARINGBITVECTOR);
+    deldocs = RoarBitVec_Deserialize(deldocs, instream);
+    InStream_Close(instream);
+    DECREF(instream);
+    return (BitVector*)deldocs;
+}
 
+Hash*
+DefDelReader_find_file_data(VArray *segments, const CharBuf *seg_name) {
     // Start with deletions files in the most recently added segments and work
     // backwards.  The first one we find which addresses our segment is the
     // one we need.
@@ -172,24 +182,56 @@ DefDelReader_read_deletions(DefaultDeletionsReader *self) {
         if (metadata) {
             Hash *files = (Hash*)CERTIFY(
                               Hash_Fetch_Str(metadata, "files", 5), HASH);
-            Hash *seg_files_data
-                = (Hash*)Hash_Fetch(files, (Obj*)my_seg_name);
+            Hash *seg_files_data = (Hash*)Hash_Fetch(files, (Obj*)seg_name);
             if (seg_files_data) {
-                Obj *count = (Obj*)CERTIFY(
-                                 Hash_Fetch_Str(seg_files_data, "count", 5),
-                                 OBJ);
-                del_count = (int32_t)Obj_To_I64(count);
-                del_file  = (CharBuf*)CERTIFY(
-                                Hash_Fetch_Str(seg_files_data, "filename", 8),
-                                CHARBUF);
-                break;
+                return (Hash*)CERTIFY(seg_files_data, HASH);
             }
         }
     }
+    return NULL;
+}
+
+BitVector*
+DefDelReader_read_deletions(DefaultDeletionsReader *self) {
+    DefaultDeletionsReaderIVARS *const ivars = DefDelReader_IVARS(self);
+    VArray  *segments    = DefDelReader_Get_Segments(self);
+    Segment *segment     = DefDelReader_Get_Segment(self);
+    CharBuf *my_seg_name = Seg_Get_Name(segment);
+    CharBuf *del_file    = NULL;
+    VArray  *deltas      = NULL;
+    int32_t  del_count   = 0;
+
+    Hash *seg_files_data = DefDelReader_find_file_data(segments, my_seg_name);
+    if (seg_files_data) {
+        Obj *count = (Obj*)CERTIFY(
+                         Hash_Fetch_Str(seg_files_data, "count", 5), OBJ);
+        del_count = (int32_t)Obj_To_I64(count);
+        del_file  = (CharBuf*)CERTIFY(
+                        Hash_Fetch_Str(seg_files_data, "filename", 8),
+                        CHARBUF);
+        deltas    = (VArray*)Hash_Fetch_Str(seg_files_data, "deltas", 6);
+        if (deltas) { CERTIFY(deltas, VARRAY); }
+    }
 
     DECREF(ivars->deldocs);
     if (del_file) {
-        ivars->deldocs = (BitVector*)BitVecDelDocs_new(ivars->folder, del_file);
+        BitVector *deldocs = S_open_deldocs(ivars->folder, del_file);
+        if (deltas && VA_Get_Size(deltas)) {
+            // Fold the deltas into a private copy of the base, since the
+            // base may be backed by a read-only file.
+            BitVector *combined = BitVec_new(BitVec_Get_Capacity(deldocs));
+            BitVec_Or(combined, deldocs);
+            DECREF(deldocs);
+            for (uint32_t i = 0, max = VA_Get_Size(deltas); i < max; i++) {
+                CharBuf *delta_file
+                    = (CharBuf*)CERTIFY(VA_Fetch(deltas, i), CHARBUF);
+                BitVector *delta = S_open_deldocs(ivars->folder, delta_file);
+                BitVec_Or(combined, delta);
+                DECREF(delta);
+            }
+            deldocs = combined;
+        }
+        ivars->deldocs   = deldocs;
         ivars->del_count = del_count;
     }
     else {
@@ -29,6 +29,7 @@
 #include "Lucy/Index/Segment.h"
 #include "Lucy/Index/SegReader.h"
 #include "Lucy/Index/Snapshot.h"
+#include "Lucy/Object/RoaringBitVector.h"
 #include "Lucy/Plan/Schema.h"
 #include "Lucy/Search/BitVecMatcher.h"
 #include "Lucy/Search/Compiler.h"
@@ -66,7 +67,19 @@ DelWriter_generate_doc_map(DeletionsWriter *self, Matcher *deletions,
     return I32Arr_new_steal(doc_map, doc_max + 1);
 }
 
-int32_t DefDelWriter_current_file_format = 1;
+bool
+DelWriter_holds_live_deletions(DeletionsWriter *self,
+                               const CharBuf *seg_name) {
+    UNUSED_VAR(self);
+    UNUSED_VAR(seg_name);
+    return false;
+}
+
+int32_t DefDelWriter_current_file_format = 3;
+
+// Maximum number of delta files a segment's deletions may be spread across
+// before they get consolidated into a new base file.
+#define MAX_DELTAS 8
 
 DefaultDeletionsWriter*
 DefDelWriter_new(Schema *schema, Snapshot *snapshot, Segment *segment,
@@ -87,7 +100,10 @@ DefDelWriter_init(DefaultDeletionsWriter *self, Schema *schema,
     uint32_t num_seg_readers    = VA_Get_Size(ivars->seg_readers);
     ivars->seg_starts           = PolyReader_Offsets(polyreader);
     ivars->bit_vecs             = VA_new(num_seg_readers);
+    ivars->delta_vecs           = VA_new(num_seg_readers);
+    ivars->del_chains           = VA_new(num_seg_readers);
     ivars->updated              = (bool*)CALLOCATE(num_seg_readers, sizeof(bool));
+    ivars->consolidate          = (bool*)CALLOCATE(num_seg_readers, sizeof(bool));
     ivars->searcher             = IxSearcher_new((Obj*)polyreader);
     ivars->name_to_tick         = Hash_new(num_seg_readers);
 
@@ -110,6 +126,21 @@ DefDelWriter_init(DefaultDeletionsWriter *self, Schema *schema,
             DECREF(seg_dels);
         }
         VA_Store(ivars->bit_vecs, i, (Obj*)bit_vec);
+        VA_Store(ivars->delta_vecs, i, (Obj*)RoarBitVec_new(0));
+
+        // Note which files currently hold the segment's deletions.
+        VArray *chain = VA_new(1);
+        Hash *file_data = DefDelReader_find_file_data(
+                              SegReader_Get_Segments(seg_reader),
+                              SegReader_Get_Seg_Name(seg_reader));
+        if (file_data) {
+            Obj *filename = Hash_Fetch_Str(file_data, "filename", 8);
+            VArray *deltas = (VArray*)Hash_Fetch_Str(file_data, "deltas", 6);
+            if (filename) { VA_Push(chain, INCREF(filename)); }
+            if (deltas)   { VA_Push_VArray(chain, deltas); }
+        }
+        VA_Store(ivars->del_chains, i, (Obj*)chain);
+
         Hash_Store(ivars->name_to_tick,
                    (Obj*)SegReader_Get_Seg_Name(seg_reader),
                    (Obj*)Int32_new(i));
@@ -124,47 +155,132 @@ DefDelWriter_destroy(DefaultDeletionsWriter *self) {
     DECREF(ivars->seg_readers);
     DECREF(ivars->seg_starts);
     DECREF(ivars->bit_vecs);
+    DECREF(ivars->delta_vecs);
+    DECREF(ivars->del_chains);
     DECREF(ivars->searcher);
     DECREF(ivars->name_to_tick);
     FREEMEM(ivars->updated);
+    FREEMEM(ivars->consolidate);
     SUPER_DESTROY(self, DEFAULTDELETIONSWRITER);
 }
 
+// Return true if any of the files in a chain of deletions files lives in the
+// segment directory identified by <code>seg_prefix</code>.
+static bool
+S_chain_uses_segment(VArray *chain, const CharBuf *seg_prefix) {
+    for (uint32_t i = 0, max = VA_Get_Size(chain); i < max; i++) {
+        CharBuf *filename = (CharBuf*)VA_Fetch(chain, i);
+        if (CB_Starts_With(filename, seg_prefix)) { return true; }
+    }
+    return false;
+}
+
+// Mark a doc in the segment at <code>tick</code> as deleted, recording it in
+// both the full set of deletions and the deletions added by this session.
+// Return true if the doc wasn't already deleted.
+static bool
+S_zap(DefaultDeletionsWriterIVARS *ivars, uint32_t tick, int32_t doc_id) {
+    BitVector *bit_vec = (BitVector*)VA_Fetch(ivars->bit_vecs, tick);
+    if (BitVec_Get(bit_vec, doc_id)) { return false; }
+    BitVector *delta = (BitVector*)VA_Fetch(ivars->delta_vecs, tick);
+    BitVec_Set(bit_vec, doc_id);
+    BitVec_Set(delta, doc_id);
+    ivars->updated[tick] = true;
+    return true;
+}
+
+static RoaringBitVector*
+S_compress(BitVector *deldocs) {
+    RoaringBitVector *compressed = RoarBitVec_new(0);
+    RoarBitVec_Mimic(compressed, (Obj*)deldocs);
+    RoarBitVec_Run_Optimize(compressed);
+    return compressed;
+}
+
+// Write a deletions file for one target segment, compressed if
+// <code>compressed</code> is supplied and flat otherwise.  Return the name of
+// the file.
 static CharBuf*
-S_del_filename(DefaultDeletionsWriter *self, SegReader *target_reader) {
+S_write_deletions(DefaultDeletionsWriter *self, SegReader *target_reader,
+                  BitVector *deldocs, RoaringBitVector *compressed) {
     DefaultDeletionsWriterIVARS *const ivars = DefDelWriter_IVARS(self);
-    Segment *target_seg = SegReader_Get_Segment(target_reader);
-    return CB_newf("%o/deletions-%o.bv", Seg_Get_Name(ivars->segment),
-                   Seg_Get_Name(target_seg));
+    Segment   *target_seg = SegReader_Get_Segment(target_reader);
+    int32_t    doc_max    = SegReader_Doc_Max(target_reader);
+    double     used       = (doc_max + 1) / 8.0;
+    uint32_t   byte_size  = (uint32_t)ceil(used);
+    uint32_t   new_max    = byte_size * 8 - 1;
+    CharBuf   *filename
+        = CB_newf("%o/deletions-%o.%s", Seg_Get_Name(ivars->segment),
+                  Seg_Get_Name(target_seg), compressed ? "rbv" : "bv");
+    OutStream *outstream = Folder_Open_Out(ivars->folder, filename);
+    if (!outstream) { RETHROW(INCREF(Err_get_error())); }
+
+    if (compressed) {
+        RoarBitVec_Grow(compressed, doc_max + 1);
+        RoarBitVec_Serialize(compressed, outstream);
+    }
+    else {
+        // Ensure that we have 1 bit for each doc in segment.
+        BitVec_Grow(deldocs, new_max);
+        OutStream_Write_Bytes(outstream,
+                              (char*)BitVec_Get_Raw_Bits(deldocs),
+                              byte_size);
+    }
+
+    // Clean up.
+    OutStream_Close(outstream);
+    DECREF(outstream);
+    return filename;
+}
+
+// Write out the deletions for one segment, either as a delta holding only
+// the docs deleted during this session or as a new base file, choosing
+// whichever of the flat and compressed formats is smaller for the latter.
+// Update the segment's chain of deletions files.
+static void
+S_write_seg_deletions(DefaultDeletionsWriter *self, uint32_t tick) {
+    DefaultDeletionsWriterIVARS *const ivars = DefDelWriter_IVARS(self);
+    SegReader *seg_reader = (SegReader*)VA_Fetch(ivars->seg_readers, tick);
+    BitVector *deldocs    = (BitVector*)VA_Fetch(ivars->bit_vecs, tick);
+    BitVector *delta      = (BitVector*)VA_Fetch(ivars->delta_vecs, tick);
+    VArray    *chain      = (VArray*)VA_Fetch(ivars->del_chains, tick);
+    uint32_t   byte_size
+        = (uint32_t)ceil((SegReader_Doc_Max(seg_reader) + 1) / 8.0);
+
+    if (!ivars->consolidate[tick]
+        && VA_Get_Size(chain) > 0
+        && VA_Get_Size(chain) <= MAX_DELTAS
+       ) {
+        RoaringBitVector *compressed = S_compress(delta);
+        if (RoarBitVec_Serialized_Size(compressed) < (uint64_t)byte_size) {
+            CharBuf *filename
+                = S_write_deletions(self, seg_reader, delta, compressed);
+            VA_Push(chain, (Obj*)filename);
+            DECREF(compressed);
+            return;
+        }
+        DECREF(compressed);
+    }
+
+    RoaringBitVector *compressed = S_compress(deldocs);
+    if (RoarBitVec_Serialized_Size(compressed) >= (uint64_t)byte_size) {
+        DECREF(compressed);
+        compressed = NULL;
+    }
+    CharBuf *filename
+        = S_write_deletions(self, seg_reader, deldocs, compressed);
+    VA_Clear(chain);
+    VA_Push(chain, (Obj*)filename);
+    DECREF(compressed);
 }
 
 void
 DefDelWriter_finish(DefaultDeletionsWriter *self) {
     DefaultDeletionsWriterIVARS *const ivars = DefDelWriter_IVARS(self);
-    Folder *const folder = ivars->folder;
 
     for (uint32_t i = 0, max = VA_Get_Size(ivars->seg_readers); i < max; i++) {
-        SegReader *seg_reader = (SegReader*)VA_Fetch(ivars->seg_readers, i);
         if (ivars->updated[i]) {
-            BitVector *deldocs   = (BitVector*)VA_Fetch(ivars->bit_vecs, i);
-            int32_t    doc_max   = SegReader_Doc_Max(seg_reader);
-            double     used      = (doc_max + 1) / 8.0;
-            uint32_t   byte_size = (uint32_t)ceil(used);
-            uint32_t   new_max   = byte_size * 8 - 1;
-            CharBuf   *filename  = S_del_filename(self, seg_reader);
-            OutStream *outstream = Folder_Open_Out(folder, filename);
-            if (!outstream) { RETHROW(INCREF(Err_get_error())); }
-
-            // Ensure that we have 1 bit for each doc in segment.
-            BitVec_Grow(deldocs, new_max);
-
-            // Write deletions data and clean up.
-            OutStream_Write_Bytes(outstream,
-                                  (char*)BitVec_Get_Raw_Bits(deldocs),
-                                  byte_size);
-            OutStream_Close(outstream);
-            DECREF(outstream);
-            DECREF(filename);
+            S_write_seg_deletions(self, i);
         }
     }
 
@@ -182,12 +298,18 @@ DefDelWriter_metadata(DefaultDeletionsWriter *self) {
         SegReader *seg_reader = (SegReader*)VA_Fetch(ivars->seg_readers, i);
         if (ivars->updated[i]) {
             BitVector *deldocs   = (BitVector*)VA_Fetch(ivars->bit_vecs, i);
+            VArray    *chain     = (VArray*)VA_Fetch(ivars->del_chains, i);
+            uint32_t   num_files = VA_Get_Size(chain);
             Segment   *segment   = SegReader_Get_Segment(seg_reader);
-            Hash      *mini_meta = Hash_new(2);
+            Hash      *mini_meta = Hash_new(3);
             Hash_Store_Str(mini_meta, "count", 5,
                            (Obj*)CB_newf("%u32", (uint32_t)BitVec_Count(deldocs)));
             Hash_Store_Str(mini_meta, "filename", 8,
-                           (Obj*)S_del_filename(self, seg_reader));
+                           INCREF(VA_Fetch(chain, 0)));
+            if (num_files > 1) {
+                VArray *deltas = VA_Slice(chain, 1, num_files - 1);
+                Hash_Store_Str(mini_meta, "deltas", 6, (Obj*)deltas);
+            }
             Hash_Store(files, (Obj*)Seg_Get_Name(segment), (Obj*)mini_meta);
         }
     }
@@ -244,6 +366,23 @@ DefDelWriter_seg_del_count(DefaultDeletionsWriter *self,
     return deldocs ? BitVec_Count(deldocs) : 0;
 }
 
+bool
+DefDelWriter_holds_live_deletions(DefaultDeletionsWriter *self,
+                                  const CharBuf *seg_name) {
+    DefaultDeletionsWriterIVARS *const ivars = DefDelWriter_IVARS(self);
+    CharBuf *seg_prefix = CB_newf("%o/", seg_name);
+    bool     retval     = false;
+    for (uint32_t i = 0, max = VA_Get_Size(ivars->del_chains); i < max; i++) {
+        VArray *chain = (VArray*)VA_Fetch(ivars->del_chains, i);
+        if (S_chain_uses_segment(chain, seg_prefix)) {
+            retval = true;
+            break;
+        }
+    }
+    DECREF(seg_prefix);
+    return retval;
+}
+
 void
 DefDelWriter_delete_by_term(DefaultDeletionsWriter *self,
                             const CharBuf *field, Obj *term) {
@@ -253,20 +392,16 @@ DefDelWriter_delete_by_term(DefaultDeletionsWriter *self,
         PostingListReader *plist_reader
             = (PostingListReader*)SegReader_Fetch(
                   seg_reader, VTable_Get_Name(POSTINGLISTREADER));
-        BitVector *bit_vec = (BitVector*)VA_Fetch(ivars->bit_vecs, i);
         PostingList *plist = plist_reader
                              ? PListReader_Posting_List(plist_reader, field, term)
                              : NULL;
         int32_t doc_id;
-        int32_t num_zapped = 0;
 
         // Iterate through postings, marking each doc as deleted.
         if (plist) {
             while (0 != (doc_id = PList_Next(plist))) {
-                num_zapped += !BitVec_Get(bit_vec, doc_id);
-                BitVec_Set(bit_vec, doc_id);
+                S_zap(ivars, i, doc_id);
             }
-            if (num_zapped) { ivars->updated[i] = true; }
             DECREF(plist);
         }
     }
@@ -280,19 +415,15 @@ DefDelWriter_delete_by_query(DefaultDeletionsWriter *self, Query *query) {
 
     for (uint32_t i = 0, max = VA_Get_Size(ivars->seg_readers); i < max; i++) {
         SegReader *seg_reader = (SegReader*)VA_Fetch(ivars->seg_readers, i);
-        BitVector *bit_vec = (BitVector*)VA_Fetch(ivars->bit_vecs, i);
         Matcher *matcher = Compiler_Make_Matcher(compiler, seg_reader, false);
 
         if (matcher) {
             int32_t doc_id;
-            int32_t num_zapped = 0;
 
             // Iterate through matches, marking each doc as deleted.
             while (0 != (doc_id = Matcher_Next(matcher))) {
-                num_zapped += !BitVec_Get(bit_vec, doc_id);
-                BitVec_Set(bit_vec, doc_id);
+                S_zap(ivars, i, doc_id);
             }
-            if (num_zapped) { ivars->updated[i] = true; }
 
             DECREF(matcher);
         }
@@ -305,14 +436,9 @@ void
 DefDelWriter_delete_by_doc_id(DefaultDeletionsWriter *self, int32_t doc_id) {
     DefaultDeletionsWriterIVARS *const ivars = DefDelWriter_IVARS(self);
     uint32_t   sub_tick   = PolyReader_sub_tick(ivars->seg_starts, doc_id);
-    BitVector *bit_vec    = (BitVector*)VA_Fetch(ivars->bit_vecs, sub_tick);
     uint32_t   offset     = I32Arr_Get(ivars->seg_starts, sub_tick);
     int32_t    seg_doc_id = doc_id - offset;
-
-    if (!BitVec_Get(bit_vec, seg_doc_id)) {
-        ivars->updated[sub_tick] = true;
-        BitVec_Set(bit_vec, seg_doc_id);
-    }
+    S_zap(ivars, sub_tick, seg_doc_id);
 }
 
 bool
@@ -344,8 +470,9 @@ DefDelWriter_merge_segment(DefaultDeletionsWriter *self, SegReader *reader,
     Hash *del_meta = (Hash*)Seg_Fetch_Metadata_Str(segment, "deletions", 9);
 
     if (del_meta) {
-        VArray *seg_readers = ivars->seg_readers;
-        Hash   *files = (Hash*)Hash_Fetch_Str(del_meta, "files", 5);
+        VArray  *seg_readers = ivars->seg_readers;
+        Hash    *files = (Hash*)Hash_Fetch_Str(del_meta, "files", 5);
+        CharBuf *seg_prefix = CB_newf("%o/", Seg_Get_Name(segment));
         if (files) {
             CharBuf *seg;
             Hash *mini_meta;
@@ -363,23 +490,21 @@ DefDelWriter_merge_segment(DefaultDeletionsWriter *self, SegReader *reader,
                         = Seg_Get_Name(SegReader_Get_Segment(candidate));
 
                     if (CB_Equals(seg, (Obj*)candidate_name)) {
-                        /* If the count hasn't changed, we're about to
-                         * merge away the most recent deletions file
-                         * pointing at this target segment -- so force a
-                         * new file to be written out. */
-                        int32_t count = (int32_t)Obj_To_I64(Hash_Fetch_Str(mini_meta, "count", 5));
-                        DeletionsReader *del_reader
-                            = (DeletionsReader*)SegReader_Obtain(
-                                  candidate, VTable_Get_Name(DELETIONSREADER));
-                        if (count == DelReader_Del_Count(del_reader)) {
-                            ivars->updated[i] = true;
+                        /* If any of the target segment's current deletions
+                         * files -- base or delta -- live in the segment
+                         * we're about to merge away, force a consolidated
+                         * file to be written out. */
+                        VArray *chain
+                            = (VArray*)VA_Fetch(ivars->del_chains, i);
+                        if (S_chain_uses_segment(chain, seg_prefix)) {
+                            ivars->updated[i]     = true;
+                            ivars->consolidate[i] = true;
                         }
                         break;
                     }
                 }
             }
         }
+        DECREF(seg_prefix);
     }
 }
-
-
@@ -176,22 +176,22 @@ DocWriter_add_segment(DocWriter *self, SegReader *reader,
             = (DefaultDocReader*)CERTIFY(
                   SegReader_Obtain(reader, VTable_Get_Name(DOCREADER)),
                   DEFAULTDOCREADER);
+        I32Array *order = DataWriter_invert_doc_map(doc_map, doc_max);
 
-        for (int32_t i = 1, max = SegReader_Doc_Max(reader); i <= max; i++) {
-            if (I32Arr_Get(doc_map, i)) {
-                int64_t  start = OutStream_Tell(dat_out);
+        for (uint32_t i = 0, max = I32Arr_Get_Size(order); i < max; i++) {
+            int64_t start = OutStream_Tell(dat_out);
 
-                // Copy record over.
-                DefDocReader_Read_Record(doc_reader, buffer, i);
-                char *buf   = BB_Get_Buf(buffer);
-                size_t size = BB_Get_Size(buffer);
-                OutStream_Write_Bytes(dat_out, buf, size);
+            // Copy record over.
+            DefDocReader_Read_Record(doc_reader, buffer, I32Arr_Get(order, i));
+            char *buf   = BB_Get_Buf(buffer);
+            size_t size = BB_Get_Size(buffer);
+            OutStream_Write_Bytes(dat_out, buf, size);
 
-                // Write file pointer.
-                OutStream_Write_I64(ix_out, start);
-            }
+            // Write file pointer.
+            OutStream_Write_I64(ix_out, start);
         }
 
+        DECREF(order);
         DECREF(buffer);
     }
 }
@@ -225,14 +225,12 @@ HLWriter_add_segment(HighlightWriter *self, SegReader *reader,
                   DEFAULTHIGHLIGHTREADER);
         OutStream *dat_out = S_lazy_init(self);
         OutStream *ix_out  = ivars->ix_out;
-        int32_t    orig;
         ByteBuf   *bb = BB_new(0);
 
-        for (orig = 1; orig <= doc_max; orig++) {
-            // Skip deleted docs.
-            if (doc_map && !I32Arr_Get(doc_map, orig)) {
-                continue;
-            }
+        // Visit surviving docs in the order of their new doc ids.
+        I32Array *order = DataWriter_invert_doc_map(doc_map, doc_max);
+        for (uint32_t i = 0, max = I32Arr_Get_Size(order); i < max; i++) {
+            int32_t orig = I32Arr_Get(order, i);
 
             // Write file pointer.
             OutStream_Write_I64(ix_out, OutStream_Tell(dat_out));
@@ -243,6 +241,7 @@ HLWriter_add_segment(HighlightWriter *self, SegReader *reader,
 
             BB_Set_Size(bb, 0);
         }
+        DECREF(order);
         DECREF(bb);
     }
 }
@@ -121,6 +121,18 @@ S_check_cutoff(VArray *array, uint32_t tick, void *data) {
     return SegReader_Get_Seg_Num(seg_reader) > cutoff;
 }
 
+// Segments which hold no docs of their own exist only to hold deletions
+// files.  Merging one away while those files are still in use would force
+// them to be rewritten, so leave it be until they're superseded.
+static bool
+S_check_del_only(VArray *array, uint32_t tick, void *data) {
+    SegReader *seg_reader = (SegReader*)VA_Fetch(array, tick);
+    DeletionsWriter *del_writer = (DeletionsWriter*)data;
+    return SegReader_Doc_Max(seg_reader) != 0
+           || !DelWriter_Holds_Live_Deletions(
+                  del_writer, SegReader_Get_Seg_Name(seg_reader));
+}
+
 static uint32_t
 S_fibonacci(uint32_t n) {
     uint32_t result = 0;
@@ -142,14 +154,17 @@ IxManager_recycle(IndexManager *self, PolyReader *reader,
                   bool optimize) {
     VArray *seg_readers = PolyReader_Get_Seg_Readers(reader);
     VArray *candidates  = VA_Gather(seg_readers, S_check_cutoff, &cutoff);
-    VArray *recyclables = VA_new(VA_Get_Size(candidates));
-    const uint32_t num_candidates = VA_Get_Size(candidates);
 
     if (optimize) {
-        DECREF(recyclables);
         return candidates;
     }
 
+    VArray *eligible = VA_Gather(candidates, S_check_del_only, del_writer);
+    DECREF(candidates);
+    candidates = eligible;
+    VArray *recyclables = VA_new(VA_Get_Size(candidates));
+    const uint32_t num_candidates = VA_Get_Size(candidates);
+
     // Sort by ascending size in docs, choose sparsely populated segments.
     VA_Sort(candidates, S_compare_doc_count, NULL);
     int32_t *counts = (int32_t*)MALLOCATE(num_candidates * sizeof(int32_t));
@@ -18,6 +18,7 @@
 #include "Lucy/Util/ToolSet.h"
 
 #include "Lucy/Index/LexIndex.h"
+#include "Lucy/Index/LexiconWriter.h"
 #include "Lucy/Index/Segment.h"
 #include "Lucy/Index/TermInfo.h"
 #include "Lucy/Index/TermStepper.h"
@@ -46,6 +47,10 @@ LexIndex_init(LexIndex *self, Schema *schema, Folder *folder,
     CharBuf *ixix_file = CB_newf("%o/lexicon-%i32.ixix", seg_name, field_num);
     CharBuf *ix_file   = CB_newf("%o/lexicon-%i32.ix", seg_name, field_num);
     Architecture *arch = Schema_Get_Architecture(schema);
+    Hash *metadata = (Hash*)Seg_Fetch_Metadata_Str(segment, "lexicon", 7);
+    Obj  *format   = metadata && Obj_Is_A((Obj*)metadata, HASH)
+                     ? Hash_Fetch_Str(metadata, "format", 6)
+                     : NULL;
 
     // Init.
     Lex_init((Lexicon*)self, field);
@@ -82,6 +87,9 @@ LexIndex_init(LexIndex *self, Schema *schema, Folder *folder,
     }
     ivars->index_interval = Arch_Index_Interval(arch);
     ivars->skip_interval  = Arch_Skip_Interval(arch);
+    ivars->format         = format
+                            ? (int32_t)Obj_To_I64(format)
+                            : LexWriter_current_file_format;
     ivars->size    = (int32_t)(InStream_Length(ivars->ixix_in) / sizeof(int64_t));
     ivars->offsets = (int64_t*)InStream_Buf(ivars->ixix_in,
                                            (size_t)InStream_Length(ivars->ixix_in));
@@ -131,6 +139,10 @@ S_read_entry(LexIndex *self) {
     int32_t doc_freq = InStream_Read_C32(ix_in);
     TInfo_Set_Doc_Freq(tinfo, doc_freq);
     TInfo_Set_Post_FilePos(tinfo, InStream_Read_C64(ix_in));
+    int64_t prox_filepos = ivars->format >= 4
+                           ? InStream_Read_C64(ix_in)
+                           : 0;
+    TInfo_Set_Prox_FilePos(tinfo, prox_filepos);
     int64_t skip_filepos = doc_freq >= ivars->skip_interval
                            ? InStream_Read_C64(ix_in)
                            : 0;
@@ -31,7 +31,7 @@
 #include "Lucy/Store/Folder.h"
 #include "Lucy/Store/OutStream.h"
 
-int32_t LexWriter_current_file_format = 3;
+int32_t LexWriter_current_file_format = 4;
 
 LexiconWriter*
 LexWriter_new(Schema *schema, Snapshot *snapshot, Segment *segment,
@@ -65,7 +65,8 @@ LexWriter_init(LexiconWriter *self, Schema *schema, Snapshot *snapshot,
     ivars->ix_counts          = Hash_new(0);
     ivars->temp_mode          = false;
     ivars->term_stepper       = NULL;
-    ivars->tinfo_stepper      = (TermStepper*)MatchTInfoStepper_new(schema);
+    ivars->tinfo_stepper      = (TermStepper*)MatchTInfoStepper_new(
+                                    schema, LexWriter_current_file_format);
 
     return self;
 }
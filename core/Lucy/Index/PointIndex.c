@@ -0,0 +1,148 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#define C_LUCY_POINTINDEX
+#include "Lucy/Util/ToolSet.h"
+
+#include "Lucy/Index/PointIndex.h"
+#include "Lucy/Object/BitVector.h"
+#include "Lucy/Store/InStream.h"
+#include "Clownfish/Util/SortUtils.h"
+
+static INLINE int32_t
+SI_offset(PointIndexIVARS *ivars, int32_t ord) {
+    return (int32_t)NumUtil_decode_bigend_u32(ivars->offsets
+                                              + ord * sizeof(uint32_t));
+}
+
+static INLINE int32_t
+SI_doc_id(PointIndexIVARS *ivars, int32_t tick) {
+    return (int32_t)NumUtil_decode_bigend_u32(ivars->doc_ids
+                                              + tick * sizeof(uint32_t));
+}
+
+static int
+S_compare_doc_ids(void *context, const void *va, const void *vb) {
+    UNUSED_VAR(context);
+    int32_t a = *(int32_t*)va;
+    int32_t b = *(int32_t*)vb;
+    return a < b ? -1 : a > b ? 1 : 0;
+}
+
+PointIndex*
+PointIndex_new(const CharBuf *field, InStream *instream, int32_t cardinality,
+               int32_t doc_max) {
+    PointIndex *self = (PointIndex*)VTable_Make_Obj(POINTINDEX);
+    return PointIndex_init(self, field, instream, cardinality, doc_max);
+}
+
+PointIndex*
+PointIndex_init(PointIndex *self, const CharBuf *field, InStream *instream,
+                int32_t cardinality, int32_t doc_max) {
+    PointIndexIVARS *const ivars = PointIndex_IVARS(self);
+
+    // Assign.
+    ivars->field       = CB_Clone(field);
+    ivars->instream    = (InStream*)INCREF(instream);
+    ivars->cardinality = cardinality;
+    ivars->doc_max     = doc_max;
+
+    // Validate file length.
+    int64_t expected = ((int64_t)cardinality + 1 + doc_max)
+                       * (int64_t)sizeof(uint32_t);
+    int64_t len = InStream_Length(instream);
+    if (len != expected) {
+        DECREF(self);
+        THROW(ERR, "Point index for '%o' has length %i64 rather than %i64",
+              field, len, expected);
+    }
+
+    // Mmap offsets and doc ids.
+    ivars->offsets = (char*)InStream_Buf(instream, (size_t)len);
+    ivars->doc_ids = ivars->offsets + (cardinality + 1) * sizeof(uint32_t);
+
+    return self;
+}
+
+void
+PointIndex_destroy(PointIndex *self) {
+    PointIndexIVARS *const ivars = PointIndex_IVARS(self);
+    DECREF(ivars->field);
+    if (ivars->instream) {
+        InStream_Close(ivars->instream);
+        InStream_Dec_RefCount(ivars->instream);
+    }
+    SUPER_DESTROY(self, POINTINDEX);
+}
+
+int32_t
+PointIndex_get_cardinality(PointIndex *self) {
+    return PointIndex_IVARS(self)->cardinality;
+}
+
+int32_t
+PointIndex_doc_freq(PointIndex *self, int32_t lower, int32_t upper) {
+    PointIndexIVARS *const ivars = PointIndex_IVARS(self);
+    if (lower < 0)                   { lower = 0; }
+    if (upper >= ivars->cardinality) { upper = ivars->cardinality - 1; }
+    if (lower > upper)               { return 0; }
+    return SI_offset(ivars, upper + 1) - SI_offset(ivars, lower);
+}
+
+I32Array*
+PointIndex_find_docs(PointIndex *self, int32_t lower, int32_t upper) {
+    PointIndexIVARS *const ivars = PointIndex_IVARS(self);
+    if (lower < 0)                   { lower = 0; }
+    if (upper >= ivars->cardinality) { upper = ivars->cardinality - 1; }
+    if (lower > upper)               { return I32Arr_new_blank(0); }
+
+    const int32_t start    = SI_offset(ivars, lower);
+    const int32_t end      = SI_offset(ivars, upper + 1);
+    const int32_t num_docs = end - start;
+    if (num_docs < 0 || end > ivars->doc_max) {
+        THROW(ERR, "Corrupt point index for '%o'", ivars->field);
+    }
+    int32_t *doc_ids
+        = (int32_t*)MALLOCATE((num_docs + 1) * sizeof(int32_t));
+
+    if (lower == upper) {
+        // Docs which share an ordinal are stored in ascending order.
+        for (int32_t i = 0; i < num_docs; i++) {
+            doc_ids[i] = SI_doc_id(ivars, start + i);
+        }
+    }
+    else if (num_docs > (ivars->doc_max >> 5)) {
+        // Dense: sorting via a bit vector costs less than a comparison sort.
+        BitVector *bit_vec = BitVec_new((uint32_t)ivars->doc_max + 1);
+        for (int32_t i = start; i < end; i++) {
+            BitVec_Set(bit_vec, (uint32_t)SI_doc_id(ivars, i));
+        }
+        BitVec_Next_Hits(bit_vec, 0, doc_ids, (uint32_t)num_docs);
+        DECREF(bit_vec);
+    }
+    else {
+        for (int32_t i = 0; i < num_docs; i++) {
+            doc_ids[i] = SI_doc_id(ivars, start + i);
+        }
+        Sort_quicksort(doc_ids, (size_t)num_docs, sizeof(int32_t),
+                       S_compare_doc_ids, NULL);
+    }
+
+    return I32Arr_new_steal(doc_ids, (uint32_t)num_docs);
+}
+
+
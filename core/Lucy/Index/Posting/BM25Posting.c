@@ -0,0 +1,135 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define C_LUCY_BM25POSTING
+#define C_LUCY_BM25POSTINGMATCHER
+#define C_LUCY_SCOREPOSTING
+#include "Lucy/Util/ToolSet.h"
+
+#include "Lucy/Index/Posting/BM25Posting.h"
+#include "Lucy/Index/BM25Similarity.h"
+#include "Lucy/Index/PostingList.h"
+#include "Lucy/Index/PostingListReader.h"
+#include "Lucy/Index/SegPostingList.h"
+#include "Lucy/Search/Compiler.h"
+
+BM25Posting*
+BM25Post_new(Similarity *sim) {
+    BM25Posting *self = (BM25Posting*)VTable_Make_Obj(BM25POSTING);
+    return BM25Post_init(self, sim);
+}
+
+BM25Posting*
+BM25Post_init(BM25Posting *self, Similarity *sim) {
+    ScorePost_init((ScorePosting*)self, sim);
+    return self;
+}
+
+BM25PostingMatcher*
+BM25Post_make_matcher(BM25Posting *self, Similarity *sim,
+                      PostingList *plist, Compiler *compiler,
+                      bool need_score) {
+    BM25PostingMatcher *matcher
+        = (BM25PostingMatcher*)VTable_Make_Obj(BM25POSTINGMATCHER);
+    BM25PostingIVARS *const ivars = BM25Post_IVARS(self);
+    UNUSED_VAR(sim);
+    UNUSED_VAR(need_score);
+    return BM25PostMatcher_init(matcher, (BM25Similarity*)ivars->sim, plist,
+                                compiler);
+}
+
+BM25PostingMatcher*
+BM25PostMatcher_init(BM25PostingMatcher *self, BM25Similarity *sim,
+                     PostingList *plist, Compiler *compiler) {
+    // Init.
+    TermMatcher_init((TermMatcher*)self, (Similarity*)sim, plist, compiler);
+    BM25PostingMatcherIVARS *const ivars = BM25PostMatcher_IVARS(self);
+    const float   k1      = BM25Sim_Get_K1(sim);
+    float         b       = BM25Sim_Get_B(sim);
+    float *const  decoder = BM25Sim_Get_Norm_Decoder(sim);
+    double        avg_len = 0.0;
+
+    // Find the average length of the field within this segment.  Without
+    // it, fall back to ignoring document length.
+    if (plist && Obj_Is_A((Obj*)plist, SEGPOSTINGLIST)) {
+        SegPostingList *seg_plist = (SegPostingList*)plist;
+        PostingListReader *plist_reader = SegPList_Get_PList_Reader(seg_plist);
+        avg_len = BM25Sim_avg_field_length(
+                      PListReader_Get_Segment(plist_reader),
+                      SegPList_Get_Field(seg_plist));
+    }
+    if (avg_len <= 0.0) { b = 0.0f; }
+
+    /* Each norm byte encodes boost / sqrt(num_tokens), so the length it
+     * stands for is 1 / (norm * norm).  Boosts therefore shorten the
+     * apparent length of a field, raising its score.
+     */
+    ivars->length_factors = (float*)MALLOCATE(256 * sizeof(float));
+    ivars->length_factors[0] = 0.0f; // unused: byte 0 always scores 0
+    for (uint32_t i = 1; i < 256; i++) {
+        double norm      = decoder[i];
+        double rel_len   = b ? (1.0 / (norm * norm)) / avg_len : 0.0;
+        ivars->length_factors[i] = (float)(k1 * (1.0 - b + b * rel_len));
+    }
+
+    // Fill score table.
+    ivars->tf_weight = ivars->weight * (k1 + 1.0f);
+    ivars->score_table = (float*)MALLOCATE(
+                             256 * BM25POSTINGMATCHER_TF_CACHE_SIZE
+                             * sizeof(float));
+    for (uint32_t i = 0; i < 256; i++) {
+        float *row = ivars->score_table + i * BM25POSTINGMATCHER_TF_CACHE_SIZE;
+        row[0] = 0.0f;
+        for (uint32_t freq = 1; freq < BM25POSTINGMATCHER_TF_CACHE_SIZE; freq++) {
+            row[freq] = i
+                        ? ivars->tf_weight * freq
+                          / (freq + ivars->length_factors[i])
+                        : 0.0f;
+        }
+    }
+
+    return self;
+}
+
+float
+BM25PostMatcher_score(BM25PostingMatcher* self) {
+    BM25PostingMatcherIVARS *const ivars = BM25PostMatcher_IVARS(self);
+    ScorePostingIVARS *const posting_ivars
+        = ScorePost_IVARS((ScorePosting*)ivars->posting);
+    const uint32_t freq = posting_ivars->freq;
+    const uint8_t  norm = posting_ivars->norm;
+
+    if (freq < BM25POSTINGMATCHER_TF_CACHE_SIZE) {
+        return ivars->score_table[norm * BM25POSTINGMATCHER_TF_CACHE_SIZE
+                                  + freq];
+    }
+    else if (norm == 0) {
+        return 0.0f;
+    }
+    else {
+        return ivars->tf_weight * freq / (freq + ivars->length_factors[norm]);
+    }
+}
+
+void
+BM25PostMatcher_destroy(BM25PostingMatcher *self) {
+    BM25PostingMatcherIVARS *const ivars = BM25PostMatcher_IVARS(self);
+    FREEMEM(ivars->score_table);
+    FREEMEM(ivars->length_factors);
+    SUPER_DESTROY(self, BM25POSTINGMATCHER);
+}
+
+
@@ -239,18 +239,20 @@ MatchPostWriter_update_skip_info(MatchPostingWriter *self, TermInfo *tinfo) {
 /***************************************************************************/
 
 MatchTermInfoStepper*
-MatchTInfoStepper_new(Schema *schema) {
+MatchTInfoStepper_new(Schema *schema, int32_t format) {
     MatchTermInfoStepper *self
         = (MatchTermInfoStepper*)VTable_Make_Obj(MATCHTERMINFOSTEPPER);
-    return MatchTInfoStepper_init(self, schema);
+    return MatchTInfoStepper_init(self, schema, format);
 }
 
 MatchTermInfoStepper*
-MatchTInfoStepper_init(MatchTermInfoStepper *self, Schema *schema) {
+MatchTInfoStepper_init(MatchTermInfoStepper *self, Schema *schema,
+                       int32_t format) {
     Architecture *arch = Schema_Get_Architecture(schema);
     TermStepper_init((TermStepper*)self);
     MatchTermInfoStepperIVARS *const ivars = MatchTInfoStepper_IVARS(self);
     ivars->skip_interval = Arch_Skip_Interval(arch);
+    ivars->format        = format;
     ivars->value = (Obj*)TInfo_new(0);
     return self;
 }
@@ -275,6 +277,11 @@ MatchTInfoStepper_write_key_frame(MatchTermInfoStepper *self,
     // Write postings file pointer.
     OutStream_Write_C64(outstream, tinfo_ivars->post_filepos);
 
+    // Write positions file pointer.
+    if (ivars->format >= 4) {
+        OutStream_Write_C64(outstream, tinfo_ivars->prox_filepos);
+    }
+
     // Write skip file pointer (maybe).
     if (doc_freq >= ivars->skip_interval) {
         OutStream_Write_C64(outstream, tinfo_ivars->skip_filepos);
@@ -292,6 +299,8 @@ MatchTInfoStepper_write_delta(MatchTermInfoStepper *self,
     int32_t   doc_freq   = TInfo_Get_Doc_Freq(tinfo);
     int64_t   post_delta = TInfo_IVARS(tinfo)->post_filepos
                            - TInfo_IVARS(last_tinfo)->post_filepos;
+    int64_t   prox_delta = TInfo_IVARS(tinfo)->prox_filepos
+                           - TInfo_IVARS(last_tinfo)->prox_filepos;
 
     // Write doc_freq.
     OutStream_Write_C32(outstream, doc_freq);
@@ -299,6 +308,11 @@ MatchTInfoStepper_write_delta(MatchTermInfoStepper *self,
     // Write postings file pointer delta.
     OutStream_Write_C64(outstream, post_delta);
 
+    // Write positions file pointer delta.
+    if (ivars->format >= 4) {
+        OutStream_Write_C64(outstream, prox_delta);
+    }
+
     // Write skip file pointer (maybe).
     if (doc_freq >= ivars->skip_interval) {
         OutStream_Write_C64(outstream, TInfo_IVARS(tinfo)->skip_filepos);
@@ -319,6 +333,11 @@ MatchTInfoStepper_read_key_frame(MatchTermInfoStepper *self,
     // Read postings file pointer.
     tinfo_ivars->post_filepos = InStream_Read_C64(instream);
 
+    // Read positions file pointer.
+    tinfo_ivars->prox_filepos = ivars->format >= 4
+                                ? InStream_Read_C64(instream)
+                                : 0;
+
     // Maybe read skip pointer.
     if (tinfo_ivars->doc_freq >= ivars->skip_interval) {
         tinfo_ivars->skip_filepos = InStream_Read_C64(instream);
@@ -339,6 +358,11 @@ MatchTInfoStepper_read_delta(MatchTermInfoStepper *self, InStream *instream) {
     // Adjust postings file pointer.
     tinfo_ivars->post_filepos += InStream_Read_C64(instream);
 
+    // Adjust positions file pointer.
+    if (ivars->format >= 4) {
+        tinfo_ivars->prox_filepos += InStream_Read_C64(instream);
+    }
+
     // Maybe read skip pointer.
     if (tinfo_ivars->doc_freq >= ivars->skip_interval) {
         tinfo_ivars->skip_filepos = InStream_Read_C64(instream);
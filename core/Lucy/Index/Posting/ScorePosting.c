@@ -16,7 +16,9 @@
 
 #define C_LUCY_SCOREPOSTING
 #define C_LUCY_SCOREPOSTINGMATCHER
+#define C_LUCY_SCOREPOSTINGWRITER
 #define C_LUCY_RAWPOSTING
+#define C_LUCY_TERMINFO
 #define C_LUCY_TOKEN
 #include "Lucy/Util/ToolSet.h"
 
@@ -26,11 +28,18 @@
 #include "Lucy/Index/Posting/RawPosting.h"
 #include "Lucy/Index/PostingList.h"
 #include "Lucy/Index/PostingPool.h"
+#include "Lucy/Index/PolyReader.h"
+#include "Lucy/Index/Segment.h"
 #include "Lucy/Index/Similarity.h"
+#include "Lucy/Index/Snapshot.h"
+#include "Lucy/Index/TermInfo.h"
 #include "Lucy/Plan/FieldType.h"
+#include "Lucy/Plan/Schema.h"
 #include "Lucy/Search/Compiler.h"
 #include "Lucy/Search/Matcher.h"
+#include "Lucy/Store/Folder.h"
 #include "Lucy/Store/InStream.h"
+#include "Lucy/Store/OutStream.h"
 #include "Lucy/Util/MemoryPool.h"
 
 #define FIELD_BOOST_LEN  1
@@ -42,6 +51,15 @@
                    + FREQ_MAX_LEN             /* freq c32 */ \
                    + (C32_MAX_BYTES * _freq)  /* positions deltas */ \
     )
+#define PROX_SKIP_CHUNK  256
+
+// Decode the current doc's positions into the prox array.
+static void
+S_read_positions(ScorePosting *self, InStream *instream);
+
+// Step over the encoded positions of <code>num_prox</code> occurrences.
+static void
+S_skip_positions(InStream *instream, uint32_t num_prox);
 
 ScorePosting*
 ScorePost_new(Similarity *sim) {
@@ -58,6 +76,11 @@ ScorePost_init(ScorePosting *self, Similarity *sim) {
     ivars->weight       = 0.0;
     ivars->prox         = NULL;
     ivars->prox_cap     = 0;
+    ivars->prox_stream  = NULL;
+    ivars->prox_filepos = 0;
+    ivars->prox_skip    = 0;
+    ivars->prox_pending = false;
+    ivars->norm         = 0;
     return self;
 }
 
@@ -65,12 +88,40 @@ void
 ScorePost_destroy(ScorePosting *self) {
     ScorePostingIVARS *const ivars = ScorePost_IVARS(self);
     FREEMEM(ivars->prox);
+    DECREF(ivars->prox_stream);
     SUPER_DESTROY(self, SCOREPOSTING);
 }
 
+void
+ScorePost_set_prox_stream(ScorePosting *self, InStream *prox_stream) {
+    ScorePostingIVARS *const ivars = ScorePost_IVARS(self);
+    InStream *const old_stream = ivars->prox_stream;
+    ivars->prox_stream = (InStream*)INCREF(prox_stream);
+    DECREF(old_stream);
+    ScorePost_Seek_Prox(self, 0);
+}
+
+void
+ScorePost_seek_prox(ScorePosting *self, int64_t filepos) {
+    ScorePostingIVARS *const ivars = ScorePost_IVARS(self);
+    ivars->prox_filepos = filepos;
+    ivars->prox_skip    = 0;
+    ivars->prox_pending = false;
+}
+
 uint32_t*
 ScorePost_get_prox(ScorePosting *self) {
-    return ScorePost_IVARS(self)->prox;
+    ScorePostingIVARS *const ivars = ScorePost_IVARS(self);
+    if (ivars->prox_pending) {
+        InStream *const prox_stream = ivars->prox_stream;
+        InStream_Seek(prox_stream, ivars->prox_filepos);
+        S_skip_positions(prox_stream, ivars->prox_skip);
+        S_read_positions(self, prox_stream);
+        ivars->prox_filepos = InStream_Tell(prox_stream);
+        ivars->prox_skip    = 0;
+        ivars->prox_pending = false;
+    }
+    return ivars->prox;
 }
 
 void
@@ -123,20 +174,28 @@ ScorePost_add_inversion_to_pool(ScorePosting *self, PostingPool *post_pool,
 void
 ScorePost_reset(ScorePosting *self) {
     ScorePostingIVARS *const ivars = ScorePost_IVARS(self);
-    ivars->doc_id = 0;
-    ivars->freq   = 0;
-    ivars->weight = 0.0;
+    ivars->doc_id       = 0;
+    ivars->freq         = 0;
+    ivars->weight       = 0.0;
+    ivars->norm         = 0;
+    ivars->prox_skip    = 0;
+    ivars->prox_pending = false;
 }
 
 void
 ScorePost_read_record(ScorePosting *self, InStream *instream) {
     ScorePostingIVARS *const ivars = ScorePost_IVARS(self);
-    uint32_t  position = 0;
     const size_t max_start_bytes = (C32_MAX_BYTES * 2) + 1;
     char *buf = InStream_Buf(instream, max_start_bytes);
     const uint32_t doc_code = NumUtil_decode_c32(&buf);
     const uint32_t doc_delta = doc_code >> 1;
 
+    // If nobody asked for the last doc's positions, they will have to be
+    // stepped over on the way to the next ones that get asked for.
+    if (ivars->prox_pending) {
+        ivars->prox_skip += ivars->freq;
+    }
+
     // Apply delta doc and retrieve freq.
     ivars->doc_id   += doc_delta;
     if (doc_code & 1) {
@@ -147,11 +206,26 @@ ScorePost_read_record(ScorePosting *self, InStream *instream) {
     }
 
     // Decode boost/norm byte.
-    ivars->weight = ivars->norm_decoder[*(uint8_t*)buf];
+    ivars->norm   = *(uint8_t*)buf;
+    ivars->weight = ivars->norm_decoder[ivars->norm];
     buf++;
+    InStream_Advance_Buf(instream, buf);
 
-    // Read positions.
+    // Positions which live in a stream of their own stay there until
+    // Get_Prox() asks for them; inline positions have to be read now.
+    if (ivars->prox_stream) {
+        ivars->prox_pending = true;
+    }
+    else {
+        S_read_positions(self, instream);
+    }
+}
+
+static void
+S_read_positions(ScorePosting *self, InStream *instream) {
+    ScorePostingIVARS *const ivars = ScorePost_IVARS(self);
     uint32_t num_prox = ivars->freq;
+    uint32_t position = 0;
     if (num_prox > ivars->prox_cap) {
         ivars->prox = (uint32_t*)REALLOCATE(
                          ivars->prox, num_prox * sizeof(uint32_t));
@@ -159,16 +233,29 @@ ScorePost_read_record(ScorePosting *self, InStream *instream) {
     }
     uint32_t *positions = ivars->prox;
 
-    InStream_Advance_Buf(instream, buf);
-    buf = InStream_Buf(instream, num_prox * C32_MAX_BYTES);
+    char *buf = InStream_Buf(instream, num_prox * C32_MAX_BYTES);
     while (num_prox--) {
         position += NumUtil_decode_c32(&buf);
         *positions++ = position;
     }
-
     InStream_Advance_Buf(instream, buf);
 }
 
+static void
+S_skip_positions(InStream *instream, uint32_t num_prox) {
+    while (num_prox) {
+        const uint32_t chunk = num_prox < PROX_SKIP_CHUNK
+                               ? num_prox
+                               : PROX_SKIP_CHUNK;
+        char *buf = InStream_Buf(instream, chunk * C32_MAX_BYTES);
+        for (uint32_t i = 0; i < chunk; i++) {
+            NumUtil_skip_cint(&buf);
+        }
+        InStream_Advance_Buf(instream, buf);
+        num_prox -= chunk;
+    }
+}
+
 RawPosting*
 ScorePost_read_raw(ScorePosting *self, InStream *instream,
                    int32_t last_doc_id, CharBuf *term_text,
@@ -187,18 +274,28 @@ ScorePost_read_raw(ScorePosting *self, InStream *instream,
     RawPosting *const raw_posting
         = RawPost_new(allocation, doc_id, freq, text_buf, text_size);
     RawPostingIVARS *const raw_post_ivars = RawPost_IVARS(raw_posting);
+    ScorePostingIVARS *const ivars = ScorePost_IVARS(self);
+    InStream *const prox_stream = ivars->prox_stream
+                                  ? ivars->prox_stream
+                                  : instream;
     uint32_t num_prox = freq;
     char *const start = raw_post_ivars->blob + text_size;
     char *dest        = start;
-    UNUSED_VAR(self);
 
     // Field_boost.
     *((uint8_t*)dest) = InStream_Read_U8(instream);
     dest++;
 
-    // Read positions.
+    // Read positions, which follow on from the last posting's if they have a
+    // stream of their own.
+    if (ivars->prox_stream) {
+        InStream_Seek(prox_stream, ivars->prox_filepos);
+    }
     while (num_prox--) {
-        dest += InStream_Read_Raw_C64(instream, dest);
+        dest += InStream_Read_Raw_C64(prox_stream, dest);
+    }
+    if (ivars->prox_stream) {
+        ivars->prox_filepos = InStream_Tell(prox_stream);
     }
 
     // Resize raw posting memory allocation.
@@ -261,4 +358,77 @@ ScorePostMatcher_destroy(ScorePostingMatcher *self) {
     SUPER_DESTROY(self, SCOREPOSTINGMATCHER);
 }
 
+/***************************************************************************/
+
+ScorePostingWriter*
+ScorePostWriter_new(Schema *schema, Snapshot *snapshot, Segment *segment,
+                    PolyReader *polyreader, int32_t field_num) {
+    ScorePostingWriter *self
+        = (ScorePostingWriter*)VTable_Make_Obj(SCOREPOSTINGWRITER);
+    return ScorePostWriter_init(self, schema, snapshot, segment, polyreader,
+                                field_num);
+}
+
+ScorePostingWriter*
+ScorePostWriter_init(ScorePostingWriter *self, Schema *schema,
+                     Snapshot *snapshot, Segment *segment,
+                     PolyReader *polyreader, int32_t field_num) {
+    Folder  *folder = PolyReader_Get_Folder(polyreader);
+    CharBuf *filename
+        = CB_newf("%o/postings-%i32.prx", Seg_Get_Name(segment), field_num);
+    MatchPostWriter_init((MatchPostingWriter*)self, schema, snapshot,
+                         segment, polyreader, field_num);
+    ScorePostingWriterIVARS *const ivars = ScorePostWriter_IVARS(self);
+    ivars->prox_out = Folder_Open_Out(folder, filename);
+    if (!ivars->prox_out) { RETHROW(INCREF(Err_get_error())); }
+    DECREF(filename);
+    return self;
+}
+
+void
+ScorePostWriter_destroy(ScorePostingWriter *self) {
+    ScorePostingWriterIVARS *const ivars = ScorePostWriter_IVARS(self);
+    DECREF(ivars->prox_out);
+    SUPER_DESTROY(self, SCOREPOSTINGWRITER);
+}
+
+void
+ScorePostWriter_write_posting(ScorePostingWriter *self, RawPosting *posting) {
+    ScorePostingWriterIVARS *const ivars = ScorePostWriter_IVARS(self);
+    RawPostingIVARS *const posting_ivars = RawPost_IVARS(posting);
+    OutStream *const outstream   = ivars->outstream;
+    const int32_t    doc_id      = posting_ivars->doc_id;
+    const uint32_t   delta_doc   = doc_id - ivars->last_doc_id;
+    char  *const     aux_content = posting_ivars->blob
+                                   + posting_ivars->content_len;
+    if (posting_ivars->freq == 1) {
+        const uint32_t doc_code = (delta_doc << 1) | 1;
+        OutStream_Write_C32(outstream, doc_code);
+    }
+    else {
+        const uint32_t doc_code = delta_doc << 1;
+        OutStream_Write_C32(outstream, doc_code);
+        OutStream_Write_C32(outstream, posting_ivars->freq);
+    }
+
+    // The field boost byte stays with the doc; the positions go elsewhere.
+    OutStream_Write_Bytes(outstream, aux_content, FIELD_BOOST_LEN);
+    OutStream_Write_Bytes(ivars->prox_out, aux_content + FIELD_BOOST_LEN,
+                          posting_ivars->aux_len - FIELD_BOOST_LEN);
+    ivars->last_doc_id = doc_id;
+}
+
+void
+ScorePostWriter_start_term(ScorePostingWriter *self, TermInfo *tinfo) {
+    ScorePostingWriterIVARS *const ivars = ScorePostWriter_IVARS(self);
+    MatchPostWriter_start_term((MatchPostingWriter*)self, tinfo);
+    TInfo_IVARS(tinfo)->prox_filepos = OutStream_Tell(ivars->prox_out);
+}
+
+void
+ScorePostWriter_update_skip_info(ScorePostingWriter *self, TermInfo *tinfo) {
+    ScorePostingWriterIVARS *const ivars = ScorePostWriter_IVARS(self);
+    MatchPostWriter_update_skip_info((MatchPostingWriter*)self, tinfo);
+    TInfo_IVARS(tinfo)->prox_filepos = OutStream_Tell(ivars->prox_out);
+}
 
@@ -30,4 +30,9 @@ PList_init(PostingList *self) {
     return self;
 }
 
+uint32_t
+PList_cost(PostingList *self) {
+    return PList_Get_Doc_Freq(self);
+}
+
 
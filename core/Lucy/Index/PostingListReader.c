@@ -70,7 +70,10 @@ DefPListReader_init(DefaultPostingListReader *self, Schema *schema,
     // Derive.
     ivars->lex_reader = (LexiconReader*)INCREF(lex_reader);
 
-    // Check format.
+    // Check format.  Formats 1 through 3 differ from the current format only
+    // in their skip data and in keeping positions inline, both of which
+    // SegPostingList still knows how to read.
+    ivars->format = PListWriter_current_file_format;
     Hash *my_meta = (Hash*)Seg_Fetch_Metadata_Str(segment, "postings", 8);
     if (!my_meta) {
         my_meta = (Hash*)Seg_Fetch_Metadata_Str(segment, "posting_list", 12);
@@ -80,10 +83,13 @@ DefPListReader_init(DefaultPostingListReader *self, Schema *schema,
         Obj *format = Hash_Fetch_Str(my_meta, "format", 6);
         if (!format) { THROW(ERR, "Missing 'format' var"); }
         else {
-            if (Obj_To_I64(format) != PListWriter_current_file_format) {
-                THROW(ERR, "Unsupported postings format: %i64",
-                      Obj_To_I64(format));
+            int64_t format_val = Obj_To_I64(format);
+            if (format_val < 1
+                || format_val > PListWriter_current_file_format
+               ) {
+                THROW(ERR, "Unsupported postings format: %i64", format_val);
             }
+            ivars->format = (int32_t)format_val;
         }
     }
 
@@ -129,3 +135,8 @@ DefPListReader_get_lex_reader(DefaultPostingListReader *self) {
     return DefPListReader_IVARS(self)->lex_reader;
 }
 
+int32_t
+DefPListReader_get_format(DefaultPostingListReader *self) {
+    return DefPListReader_IVARS(self)->format;
+}
+
@@ -38,7 +38,7 @@
 
 static size_t default_mem_thresh = 0x1000000;
 
-int32_t PListWriter_current_file_format = 1;
+int32_t PListWriter_current_file_format = 4;
 
 // Open streams only if content gets added.
 static void
@@ -48,6 +48,11 @@ S_lazy_init(PostingListWriter *self);
 static PostingPool*
 S_lazy_init_posting_pool(PostingListWriter *self, int32_t field_num);
 
+// Add to the length statistics for a field, growing the arrays if necessary.
+static void
+S_add_field_stats(PostingListWriter *self, int32_t field_num,
+                  uint64_t num_docs, uint64_t num_tokens);
+
 PostingListWriter*
 PListWriter_new(Schema *schema, Snapshot *snapshot, Segment *segment,
                 PolyReader *polyreader, LexiconWriter *lex_writer) {
@@ -73,6 +78,9 @@ PListWriter_init(PostingListWriter *self, Schema *schema, Snapshot *snapshot,
     ivars->mem_pool       = MemPool_new(0);
     ivars->lex_temp_out   = NULL;
     ivars->post_temp_out  = NULL;
+    ivars->field_docs     = NULL;
+    ivars->field_tokens   = NULL;
+    ivars->field_stats_cap = 0;
 
     return self;
 }
@@ -125,9 +133,31 @@ PListWriter_destroy(PostingListWriter *self) {
     DECREF(ivars->lex_temp_out);
     DECREF(ivars->post_temp_out);
     DECREF(ivars->skip_out);
+    FREEMEM(ivars->field_docs);
+    FREEMEM(ivars->field_tokens);
     SUPER_DESTROY(self, POSTINGLISTWRITER);
 }
 
+static void
+S_add_field_stats(PostingListWriter *self, int32_t field_num,
+                  uint64_t num_docs, uint64_t num_tokens) {
+    PostingListWriterIVARS *const ivars = PListWriter_IVARS(self);
+    if (field_num >= ivars->field_stats_cap) {
+        int32_t new_cap = field_num + 8;
+        size_t  amount  = new_cap * sizeof(uint64_t);
+        ivars->field_docs   = (uint64_t*)REALLOCATE(ivars->field_docs, amount);
+        ivars->field_tokens = (uint64_t*)REALLOCATE(ivars->field_tokens,
+                                                    amount);
+        for (int32_t i = ivars->field_stats_cap; i < new_cap; i++) {
+            ivars->field_docs[i]   = 0;
+            ivars->field_tokens[i] = 0;
+        }
+        ivars->field_stats_cap = new_cap;
+    }
+    ivars->field_docs[field_num]   += num_docs;
+    ivars->field_tokens[field_num] += num_tokens;
+}
+
 void
 PListWriter_set_default_mem_thresh(size_t mem_thresh) {
     default_mem_thresh = mem_thresh;
@@ -156,8 +186,9 @@ PListWriter_add_inverted_doc(PostingListWriter *self, Inverter *inverter,
             Inversion   *inversion = Inverter_Get_Inversion(inverter);
             Similarity  *sim  = Inverter_Get_Similarity(inverter);
             PostingPool *pool = S_lazy_init_posting_pool(self, field_num);
-            float length_norm
-                = Sim_Length_Norm(sim, Inversion_Get_Size(inversion));
+            uint32_t     num_tokens = Inversion_Get_Length(inversion);
+            float length_norm = Sim_Length_Norm(sim, num_tokens);
+            S_add_field_stats(self, field_num, 1, num_tokens);
             PostPool_Add_Inversion(pool, inversion, doc_id, doc_boost,
                                    length_norm);
         }
@@ -183,6 +214,15 @@ PListWriter_add_segment(PostingListWriter *self, SegReader *reader,
     Schema  *schema        = ivars->schema;
     Segment *segment       = ivars->segment;
     VArray  *all_fields    = Schema_All_Fields(schema);
+    Hash    *other_meta
+        = (Hash*)Seg_Fetch_Metadata_Str(other_segment, "postings", 8);
+    Hash    *field_stats
+        = other_meta && Obj_Is_A((Obj*)other_meta, HASH)
+          ? (Hash*)Hash_Fetch_Str(other_meta, "field_stats", 11)
+          : NULL;
+    if (field_stats && !Obj_Is_A((Obj*)field_stats, HASH)) {
+        field_stats = NULL;
+    }
     S_lazy_init(self);
 
     for (uint32_t i = 0, max = VA_Get_Size(all_fields); i < max; i++) {
@@ -200,12 +240,47 @@ PListWriter_add_segment(PostingListWriter *self, SegReader *reader,
         PostingPool *pool = S_lazy_init_posting_pool(self, new_field_num);
         PostPool_Add_Segment(pool, reader, doc_map,
                              (int32_t)Seg_Get_Count(segment));
+
+        // Carry over length statistics.  Deleted docs are not subtracted,
+        // so the totals are approximate -- but the average they yield is
+        // what consumers care about, and it stays close.
+        Hash *stats = field_stats
+                      ? (Hash*)Hash_Fetch(field_stats, (Obj*)field)
+                      : NULL;
+        if (stats && Obj_Is_A((Obj*)stats, HASH)) {
+            Obj *num_docs   = Hash_Fetch_Str(stats, "num_docs", 8);
+            Obj *num_tokens = Hash_Fetch_Str(stats, "num_tokens", 10);
+            if (num_docs && num_tokens) {
+                S_add_field_stats(self, new_field_num,
+                                  (uint64_t)Obj_To_I64(num_docs),
+                                  (uint64_t)Obj_To_I64(num_tokens));
+            }
+        }
     }
 
     // Clean up.
     DECREF(all_fields);
 }
 
+Hash*
+PListWriter_metadata(PostingListWriter *self) {
+    PostingListWriterIVARS *const ivars = PListWriter_IVARS(self);
+    Hash *const metadata    = DataWriter_metadata((DataWriter*)self);
+    Hash *const field_stats = Hash_new(0);
+    for (int32_t i = 1; i < ivars->field_stats_cap; i++) {
+        if (!ivars->field_docs[i]) { continue; }
+        CharBuf *field = Seg_Field_Name(ivars->segment, i);
+        Hash    *stats = Hash_new(2);
+        Hash_Store_Str(stats, "num_docs", 8,
+                       (Obj*)CB_newf("%u64", ivars->field_docs[i]));
+        Hash_Store_Str(stats, "num_tokens", 10,
+                       (Obj*)CB_newf("%u64", ivars->field_tokens[i]));
+        Hash_Store(field_stats, (Obj*)field, (Obj*)stats);
+    }
+    Hash_Store_Str(metadata, "field_stats", 11, (Obj*)field_stats);
+    return metadata;
+}
+
 void
 PListWriter_finish(PostingListWriter *self) {
     PostingListWriterIVARS *const ivars = PListWriter_IVARS(self);
@@ -18,7 +18,6 @@
 #define C_LUCY_RAWPOSTING
 #define C_LUCY_MEMORYPOOL
 #define C_LUCY_TERMINFO
-#define C_LUCY_SKIPSTEPPER
 #include "Lucy/Util/ToolSet.h"
 
 #include "Lucy/Index/PostingPool.h"
@@ -34,10 +33,10 @@
 #include "Lucy/Index/RawLexicon.h"
 #include "Lucy/Index/RawPostingList.h"
 #include "Lucy/Index/Segment.h"
+#include "Lucy/Index/SegPostingList.h"
 #include "Lucy/Index/SegReader.h"
 #include "Lucy/Index/Similarity.h"
 #include "Lucy/Index/Snapshot.h"
-#include "Lucy/Index/SkipStepper.h"
 #include "Lucy/Index/TermInfo.h"
 #include "Lucy/Index/TermStepper.h"
 #include "Lucy/Plan/Schema.h"
@@ -56,6 +55,15 @@ static void
 S_write_terms_and_postings(PostingPool *self, PostingWriter *post_writer,
                            OutStream *skip_stream);
 
+// Write one term's buffered level 0 skip entries as a multi-level skip list,
+// preceded by a bitmap of the term's doc ids if <code>term_docs</code> is
+// not NULL.
+static void
+S_write_skip_data(OutStream *skip_stream, int32_t *docs, int64_t *fileposes,
+                  int64_t *prox_fileposes, uint32_t num_entries,
+                  int64_t post_filepos, int64_t prox_filepos,
+                  const int32_t *term_docs, uint32_t num_term_docs);
+
 PostingPool*
 PostPool_new(Schema *schema, Snapshot *snapshot, Segment *segment,
              PolyReader *polyreader,  const CharBuf *field,
@@ -89,7 +97,6 @@ PostPool_init(PostingPool *self, Schema *schema, Snapshot *snapshot,
     ivars->post_start       = INT64_MAX;
     ivars->lex_end          = 0;
     ivars->post_end         = 0;
-    ivars->skip_stepper     = SkipStepper_new();
 
     // Assign.
     ivars->schema         = (Schema*)INCREF(schema);
@@ -131,7 +138,6 @@ PostPool_destroy(PostingPool *self) {
     DECREF(ivars->lex_temp_in);
     DECREF(ivars->post_temp_in);
     DECREF(ivars->posting);
-    DECREF(ivars->skip_stepper);
     DECREF(ivars->type);
     SUPER_DESTROY(self, POSTINGPOOL);
 }
@@ -223,6 +229,22 @@ PostPool_flip(PostingPool *self) {
     ivars->flipped = true;
 }
 
+// Return true if the doc map sends live docs to new ids out of their
+// original order, as happens when a segment is rewritten by an index sort.
+static bool
+S_doc_map_reorders(I32Array *doc_map) {
+    if (!doc_map) { return false; }
+    int32_t last = 0;
+    for (uint32_t i = 1, max = I32Arr_Get_Size(doc_map); i < max; i++) {
+        int32_t new_doc_id = I32Arr_Get(doc_map, i);
+        if (new_doc_id) {
+            if (new_doc_id < last) { return true; }
+            last = new_doc_id;
+        }
+    }
+    return false;
+}
+
 void
 PostPool_add_segment(PostingPool *self, SegReader *reader, I32Array *doc_map,
                      int32_t doc_base) {
@@ -254,6 +276,7 @@ PostPool_add_segment(PostingPool *self, SegReader *reader, I32Array *doc_map,
         run_ivars->plist    = plist;
         run_ivars->doc_base = doc_base;
         run_ivars->doc_map  = (I32Array*)INCREF(doc_map);
+        run_ivars->doc_map_reorders = S_doc_map_reorders(doc_map);
         PostPool_Add_Run(self, (SortExternal*)run);
     }
 }
@@ -365,11 +388,18 @@ S_write_terms_and_postings(PostingPool *self, PostingWriter *post_writer,
     TermInfoIVARS *const skip_tinfo_ivars = TInfo_IVARS(skip_tinfo);
     CharBuf       *const last_term_text   = CB_new(0);
     LexiconWriter *const lex_writer       = ivars->lex_writer;
-    SkipStepper   *const skip_stepper     = ivars->skip_stepper;
-    SkipStepperIVARS *const skip_stepper_ivars
-        = SkipStepper_IVARS(skip_stepper);
-    int32_t        last_skip_doc          = 0;
-    int64_t        last_skip_filepos      = 0;
+    uint32_t       skip_cap               = 16;
+    uint32_t       num_skip_entries       = 0;
+    int32_t       *skip_docs
+        = (int32_t*)MALLOCATE(skip_cap * sizeof(int32_t));
+    int64_t       *skip_fileposes
+        = (int64_t*)MALLOCATE(skip_cap * sizeof(int64_t));
+    int64_t       *skip_prox_fileposes
+        = (int64_t*)MALLOCATE(skip_cap * sizeof(int64_t));
+    uint32_t       term_docs_cap          = 16;
+    int32_t       *term_docs
+        = (int32_t*)MALLOCATE(term_docs_cap * sizeof(int32_t));
+    const int64_t  seg_doc_count          = Seg_Get_Count(ivars->segment);
     const int32_t  skip_interval
         = Arch_Skip_Interval(Schema_Get_Architecture(ivars->schema));
 
@@ -381,7 +411,6 @@ S_write_terms_and_postings(PostingPool *self, PostingWriter *post_writer,
     CB_Mimic_Str(last_term_text, post_ivars->blob, post_ivars->content_len);
     char *last_text_buf = (char*)CB_Get_Ptr8(last_term_text);
     uint32_t last_text_size = CB_Get_Size(last_term_text);
-    SkipStepper_Set_ID_And_Filepos(skip_stepper, 0, 0);
 
     // Initialize sentinel to be used on the last iter, using an empty string
     // in order to make LexiconWriter Do The Right Thing.
@@ -412,6 +441,20 @@ S_write_terms_and_postings(PostingPool *self, PostingWriter *post_writer,
 
         // If the term text changes, process the last term.
         if (!same_text_as_last) {
+            // Write the term's skip data, now that all of it is known.
+            if (num_skip_entries) {
+                const uint32_t doc_freq = tinfo_ivars->doc_freq;
+                const bool dense
+                    = (int64_t)doc_freq * SKIP_DENSE_DIVISOR >= seg_doc_count;
+                tinfo_ivars->skip_filepos = OutStream_Tell(skip_stream);
+                S_write_skip_data(skip_stream, skip_docs, skip_fileposes,
+                                  skip_prox_fileposes, num_skip_entries,
+                                  tinfo_ivars->post_filepos,
+                                  tinfo_ivars->prox_filepos,
+                                  dense ? term_docs : NULL, doc_freq);
+                num_skip_entries = 0;
+            }
+
             // Hand off to LexiconWriter.
             LexWriter_Add_Term(lex_writer, last_term_text, tinfo);
 
@@ -419,12 +462,6 @@ S_write_terms_and_postings(PostingPool *self, PostingWriter *post_writer,
             TInfo_Reset(tinfo);
             PostWriter_Start_Term(post_writer, tinfo);
 
-            // Init skip data in preparation for the next term.
-            skip_stepper_ivars->doc_id  = 0;
-            skip_stepper_ivars->filepos = tinfo_ivars->post_filepos;
-            last_skip_doc         = 0;
-            last_skip_filepos     = tinfo_ivars->post_filepos;
-
             // Remember the term_text so we can write string diffs.
             CB_Mimic_Str(last_term_text, post_ivars->blob,
                          post_ivars->content_len);
@@ -438,27 +475,37 @@ S_write_terms_and_postings(PostingPool *self, PostingWriter *post_writer,
         // Write posting data.
         PostWriter_Write_Posting(post_writer, posting);
 
+        // Remember the doc id in case the term turns out to be dense.
+        if (tinfo_ivars->doc_freq == term_docs_cap) {
+            term_docs_cap *= 2;
+            term_docs = (int32_t*)REALLOCATE(
+                            term_docs, term_docs_cap * sizeof(int32_t));
+        }
+        term_docs[tinfo_ivars->doc_freq] = post_ivars->doc_id;
+
         // Doc freq lags by one iter.
         tinfo_ivars->doc_freq++;
 
-        //  Write skip data.
+        // Buffer a level 0 skip entry once per skip_interval postings.
         if (skip_stream != NULL
-            && same_text_as_last
             && tinfo_ivars->doc_freq % skip_interval == 0
-            && tinfo_ivars->doc_freq != 0
            ) {
-            // If first skip group, save skip stream pos for term info.
-            if (tinfo_ivars->doc_freq == skip_interval) {
-                tinfo_ivars->skip_filepos = OutStream_Tell(skip_stream);
+            if (num_skip_entries == skip_cap) {
+                skip_cap *= 2;
+                skip_docs = (int32_t*)REALLOCATE(
+                                skip_docs, skip_cap * sizeof(int32_t));
+                skip_fileposes = (int64_t*)REALLOCATE(
+                                     skip_fileposes, skip_cap * sizeof(int64_t));
+                skip_prox_fileposes = (int64_t*)REALLOCATE(
+                                          skip_prox_fileposes,
+                                          skip_cap * sizeof(int64_t));
             }
-            // Write deltas.
-            last_skip_doc               = skip_stepper_ivars->doc_id;
-            last_skip_filepos           = skip_stepper_ivars->filepos;
-            skip_stepper_ivars->doc_id  = post_ivars->doc_id;
             PostWriter_Update_Skip_Info(post_writer, skip_tinfo);
-            skip_stepper_ivars->filepos = skip_tinfo_ivars->post_filepos;
-            SkipStepper_Write_Record(skip_stepper, skip_stream,
-                                     last_skip_doc, last_skip_filepos);
+            skip_docs[num_skip_entries]      = post_ivars->doc_id;
+            skip_fileposes[num_skip_entries] = skip_tinfo_ivars->post_filepos;
+            skip_prox_fileposes[num_skip_entries]
+                = skip_tinfo_ivars->prox_filepos;
+            num_skip_entries++;
         }
 
         // Retrieve the next posting from the sort pool.
@@ -472,11 +519,93 @@ S_write_terms_and_postings(PostingPool *self, PostingWriter *post_writer,
     }
 
     // Clean up.
+    FREEMEM(skip_docs);
+    FREEMEM(skip_fileposes);
+    FREEMEM(skip_prox_fileposes);
+    FREEMEM(term_docs);
     DECREF(last_term_text);
     DECREF(skip_tinfo);
     DECREF(tinfo);
 }
 
+static void
+S_write_skip_data(OutStream *skip_stream, int32_t *docs, int64_t *fileposes,
+                  int64_t *prox_fileposes, uint32_t num_entries,
+                  int64_t post_filepos, int64_t prox_filepos,
+                  const int32_t *term_docs, uint32_t num_term_docs) {
+    char     *levels[SKIP_MAX_LEVELS];
+    size_t    level_sizes[SKIP_MAX_LEVELS];
+    size_t   *marks = (size_t*)MALLOCATE(num_entries * sizeof(size_t));
+    uint32_t  num_levels  = 0;
+    uint32_t  stride      = 1;
+    uint32_t  num_in_level = num_entries;
+
+    // Encode each level, bottom up.  Each entry holds deltas for the doc id
+    // and for the postings and positions file pointers.  Entries above level
+    // 0 also carry the offset of the matching entry in the level below them
+    // -- past its deltas but before its own child offset, so that a reader
+    // descending a level can pick that offset up too.
+    while (num_in_level > 0 && num_levels < SKIP_MAX_LEVELS) {
+        const size_t entry_max = C32_MAX_BYTES + C64_MAX_BYTES * 3;
+        char    *const buf = (char*)MALLOCATE(num_in_level * entry_max);
+        char    *ptr          = buf;
+        int32_t  last_doc     = 0;
+        int64_t  last_filepos = post_filepos;
+        int64_t  last_prox    = prox_filepos;
+        for (uint32_t i = 0; i < num_in_level; i++) {
+            const uint32_t tick = (i + 1) * stride - 1;
+            NumUtil_encode_c32((uint32_t)(docs[tick] - last_doc), &ptr);
+            NumUtil_encode_c64((uint64_t)(fileposes[tick] - last_filepos),
+                               &ptr);
+            NumUtil_encode_c64((uint64_t)(prox_fileposes[tick] - last_prox),
+                               &ptr);
+            const size_t mark = (size_t)(ptr - buf);
+            if (num_levels > 0) {
+                // Read the lower level's offset before overwriting slot i;
+                // (i + 1) * SKIP_MULTIPLIER - 1 is never less than i.
+                NumUtil_encode_c64(marks[(i + 1) * SKIP_MULTIPLIER - 1], &ptr);
+            }
+            marks[i]     = mark;
+            last_doc     = docs[tick];
+            last_filepos = fileposes[tick];
+            last_prox    = prox_fileposes[tick];
+        }
+        levels[num_levels]      = buf;
+        level_sizes[num_levels] = (size_t)(ptr - buf);
+        num_levels++;
+        stride       *= SKIP_MULTIPLIER;
+        num_in_level /= SKIP_MULTIPLIER;
+    }
+
+    // Write the level count, flagging whether a bitmap follows.
+    OutStream_Write_C32(skip_stream,
+                        (num_levels << 1) | (term_docs ? 1 : 0));
+
+    // Write the bitmap, bit n of which is set if the term occurs in doc n.
+    if (term_docs) {
+        const uint32_t num_bytes
+            = (uint32_t)(term_docs[num_term_docs - 1] >> 3) + 1;
+        uint8_t *const bits = (uint8_t*)CALLOCATE(num_bytes, sizeof(uint8_t));
+        for (uint32_t i = 0; i < num_term_docs; i++) {
+            NumUtil_u1set(bits, (uint32_t)term_docs[i]);
+        }
+        OutStream_Write_C32(skip_stream, num_bytes);
+        OutStream_Write_Bytes(skip_stream, bits, num_bytes);
+        FREEMEM(bits);
+    }
+
+    // Write the levels from the top down, each level above 0 prefixed by its
+    // length so that readers can find the next.
+    for (uint32_t level = num_levels; level--;) {
+        if (level > 0) {
+            OutStream_Write_C64(skip_stream, level_sizes[level]);
+        }
+        OutStream_Write_Bytes(skip_stream, levels[level], level_sizes[level]);
+        FREEMEM(levels[level]);
+    }
+    FREEMEM(marks);
+}
+
 uint32_t
 PostPool_refill(PostingPool *self) {
     PostingPoolIVARS *const ivars = PostPool_IVARS(self);
@@ -507,8 +636,10 @@ PostPool_refill(PostingPool *self) {
 
 
     while (1) {
+        bool term_start = false;
         if (ivars->post_count == 0) {
             // Read a term.
+            term_start = true;
             if (Lex_Next(lexicon)) {
                 ivars->post_count = Lex_Doc_Freq(lexicon);
                 term_text = (CharBuf*)Lex_Get_Term(lexicon);
@@ -525,8 +656,12 @@ PostPool_refill(PostingPool *self) {
             }
         }
 
-        // Bail if we've hit the ceiling for this run's cache.
-        if (mem_pool_ivars->consumed >= mem_thresh && num_elems > 0) {
+        // Bail if we've hit the ceiling for this run's cache.  When the doc
+        // map reorders docs, remapped postings within a term come out of
+        // order and must be sorted together, so only stop between terms.
+        if (mem_pool_ivars->consumed >= mem_thresh && num_elems > 0
+            && (term_start || !ivars->doc_map_reorders)
+           ) {
             break;
         }
 
@@ -560,6 +695,9 @@ PostPool_refill(PostingPool *self) {
     // Reset the cache array position and length; remember file pos.
     ivars->cache_max   = num_elems;
     ivars->cache_tick  = 0;
+    if (ivars->doc_map_reorders) {
+        PostPool_Sort_Cache(self);
+    }
 
     return num_elems;
 }
@@ -18,6 +18,7 @@
 #include "Lucy/Util/ToolSet.h"
 
 #include "Lucy/Index/RawLexicon.h"
+#include "Lucy/Index/LexiconWriter.h"
 #include "Lucy/Index/Posting/MatchPosting.h"
 #include "Lucy/Index/TermStepper.h"
 #include "Lucy/Index/TermInfo.h"
@@ -50,7 +51,8 @@ RawLex_init(RawLexicon *self, Schema *schema, const CharBuf *field,
 
     // Get steppers.
     ivars->term_stepper  = FType_Make_Term_Stepper(type);
-    ivars->tinfo_stepper = (TermStepper*)MatchTInfoStepper_new(schema);
+    ivars->tinfo_stepper = (TermStepper*)MatchTInfoStepper_new(
+                               schema, LexWriter_current_file_format);
 
     return self;
 }
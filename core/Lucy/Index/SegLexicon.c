@@ -98,7 +98,8 @@ SegLex_init(SegLexicon *self, Schema *schema, Folder *folder,
 
     // Get steppers.
     ivars->term_stepper  = FType_Make_Term_Stepper(type);
-    ivars->tinfo_stepper = (TermStepper*)MatchTInfoStepper_new(schema);
+    ivars->tinfo_stepper = (TermStepper*)MatchTInfoStepper_new(
+                               schema, (int32_t)Obj_To_I64(format));
 
     return self;
 }
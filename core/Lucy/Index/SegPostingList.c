@@ -16,19 +16,20 @@
 
 #define C_LUCY_SEGPOSTINGLIST
 #define C_LUCY_POSTING
-#define C_LUCY_SKIPSTEPPER
 #include "Lucy/Util/ToolSet.h"
 
 #include "Lucy/Index/SegPostingList.h"
 #include "Lucy/Index/Posting.h"
 #include "Lucy/Index/Posting/RawPosting.h"
+#include "Lucy/Index/Posting/ScorePosting.h"
 #include "Lucy/Index/PostingListReader.h"
+#include "Lucy/Index/PostingListWriter.h"
 #include "Lucy/Index/Segment.h"
-#include "Lucy/Index/SkipStepper.h"
 #include "Lucy/Index/TermInfo.h"
 #include "Lucy/Index/SegLexicon.h"
 #include "Lucy/Index/LexiconReader.h"
 #include "Lucy/Index/Similarity.h"
+#include "Lucy/Object/BitVector.h"
 #include "Lucy/Plan/Architecture.h"
 #include "Lucy/Plan/FieldType.h"
 #include "Lucy/Plan/Schema.h"
@@ -42,6 +43,26 @@
 static void
 S_seek_tinfo(SegPostingList *self, TermInfo *tinfo);
 
+// Seek the skip stream to the current term's skip data and read its header.
+// Return the number of skip levels, and supply the size of the bitmap which
+// follows the header, if any.
+static int32_t
+S_read_skip_header(SegPostingList *self, uint32_t *num_bitmap_bytes);
+
+// Read the current term's skip list header and reset every level.
+static void
+S_init_skip_levels(SegPostingList *self);
+
+// Return the doc id of a level's next entry, or INT32_MAX if it has none.
+static int32_t
+S_peek_skip(SkipLevel *level, InStream *skip_stream, bool has_prox,
+            bool has_child);
+
+// Skip ahead to the last posting which precedes `target` according to the
+// skip list.
+static void
+S_skip_to(SegPostingList *self, int32_t target);
+
 SegPostingList*
 SegPList_new(PostingListReader *plist_reader, const CharBuf *field) {
     SegPostingList *self = (SegPostingList*)VTable_Make_Obj(SEGPOSTINGLIST);
@@ -60,6 +81,8 @@ SegPList_init(SegPostingList *self, PostingListReader *plist_reader,
     int32_t       field_num      = Seg_Field_Num(segment, field);
     CharBuf      *post_file      = CB_newf("%o/postings-%i32.dat",
                                            seg_name, field_num);
+    CharBuf      *prox_file      = CB_newf("%o/postings-%i32.prx",
+                                           seg_name, field_num);
     CharBuf      *skip_file      = CB_newf("%o/postings.skip", seg_name);
 
     // Init.
@@ -67,9 +90,20 @@ SegPList_init(SegPostingList *self, PostingListReader *plist_reader,
     ivars->count           = 0;
 
     // Init skipping vars.
-    ivars->skip_stepper    = SkipStepper_new();
-    ivars->skip_count      = 0;
-    ivars->num_skips       = 0;
+    ivars->skip_levels     = (SkipLevel*)MALLOCATE(SKIP_MAX_LEVELS
+                                               * sizeof(SkipLevel));
+    ivars->num_skip_levels = 0;
+    ivars->dense_bits      = NULL;
+    ivars->dense_bits_read = false;
+    ivars->num_dense_bytes = -1;
+    ivars->post_filepos    = 0;
+    ivars->prox_filepos    = 0;
+    ivars->skip_filepos    = 0;
+    ivars->format          = Obj_Is_A((Obj*)plist_reader,
+                                      DEFAULTPOSTINGLISTREADER)
+                             ? DefPListReader_Get_Format(
+                                   (DefaultPostingListReader*)plist_reader)
+                             : PListWriter_current_file_format;
 
     // Assign.
     ivars->plist_reader    = (PostingListReader*)INCREF(plist_reader);
@@ -82,11 +116,13 @@ SegPList_init(SegPostingList *self, PostingListReader *plist_reader,
     ivars->field_num = field_num;
 
     // Open both a main stream and a skip stream if the field exists.
+    ivars->prox_stream = NULL;
     if (Folder_Exists(folder, post_file)) {
         ivars->post_stream = Folder_Open_In(folder, post_file);
         if (!ivars->post_stream) {
             Err *error = (Err*)INCREF(Err_get_error());
             DECREF(post_file);
+            DECREF(prox_file);
             DECREF(skip_file);
             DECREF(self);
             RETHROW(error);
@@ -95,10 +131,28 @@ SegPList_init(SegPostingList *self, PostingListReader *plist_reader,
         if (!ivars->skip_stream) {
             Err *error = (Err*)INCREF(Err_get_error());
             DECREF(post_file);
+            DECREF(prox_file);
             DECREF(skip_file);
             DECREF(self);
             RETHROW(error);
         }
+
+        // Positions have a stream of their own if ScorePostingWriter wrote
+        // them; otherwise they're inline.
+        if (ivars->format >= 4 && Folder_Exists(folder, prox_file)) {
+            ivars->prox_stream = Folder_Open_In(folder, prox_file);
+            if (!ivars->prox_stream) {
+                Err *error = (Err*)INCREF(Err_get_error());
+                DECREF(post_file);
+                DECREF(prox_file);
+                DECREF(skip_file);
+                DECREF(self);
+                RETHROW(error);
+            }
+            ScorePost_Set_Prox_Stream(
+                (ScorePosting*)CERTIFY(ivars->posting, SCOREPOSTING),
+                ivars->prox_stream);
+        }
     }
     else {
         //  Empty, so don't bother with these.
@@ -106,6 +160,7 @@ SegPList_init(SegPostingList *self, PostingListReader *plist_reader,
         ivars->skip_stream = NULL;
     }
     DECREF(post_file);
+    DECREF(prox_file);
     DECREF(skip_file);
 
     return self;
@@ -116,7 +171,8 @@ SegPList_destroy(SegPostingList *self) {
     SegPostingListIVARS *const ivars = SegPList_IVARS(self);
     DECREF(ivars->plist_reader);
     DECREF(ivars->posting);
-    DECREF(ivars->skip_stepper);
+    FREEMEM(ivars->skip_levels);
+    DECREF(ivars->dense_bits);
     DECREF(ivars->field);
 
     if (ivars->post_stream != NULL) {
@@ -125,6 +181,10 @@ SegPList_destroy(SegPostingList *self) {
         DECREF(ivars->post_stream);
         DECREF(ivars->skip_stream);
     }
+    if (ivars->prox_stream != NULL) {
+        InStream_Close(ivars->prox_stream);
+        DECREF(ivars->prox_stream);
+    }
 
     SUPER_DESTROY(self, SEGPOSTINGLIST);
 }
@@ -155,6 +215,16 @@ SegPList_get_post_stream(SegPostingList *self) {
     return SegPList_IVARS(self)->post_stream;
 }
 
+PostingListReader*
+SegPList_get_plist_reader(SegPostingList *self) {
+    return SegPList_IVARS(self)->plist_reader;
+}
+
+CharBuf*
+SegPList_get_field(SegPostingList *self) {
+    return SegPList_IVARS(self)->field;
+}
+
 int32_t
 SegPList_next(SegPostingList *self) {
     SegPostingListIVARS *const ivars = SegPList_IVARS(self);
@@ -176,70 +246,190 @@ SegPList_next(SegPostingList *self) {
 int32_t
 SegPList_advance(SegPostingList *self, int32_t target) {
     SegPostingListIVARS *const ivars = SegPList_IVARS(self);
-    PostingIVARS *const posting_ivars = Post_IVARS(ivars->posting);
-    const uint32_t skip_interval = ivars->skip_interval;
-
-    if (ivars->doc_freq >= skip_interval) {
-        InStream *post_stream           = ivars->post_stream;
-        InStream *skip_stream           = ivars->skip_stream;
-        SkipStepper *const skip_stepper = ivars->skip_stepper;
-        SkipStepperIVARS *const skip_stepper_ivars
-            = SkipStepper_IVARS(skip_stepper);
-        uint32_t new_doc_id             = skip_stepper_ivars->doc_id;
-        int64_t new_filepos             = InStream_Tell(post_stream);
-
-        /* Assuming the default skip_interval of 16...
-         *
-         * Say we're currently on the 5th doc matching this term, and we get a
-         * request to skip to the 18th doc matching it.  We won't have skipped
-         * yet, but we'll have already gone past 5 of the 16 skip docs --
-         * ergo, the modulus in the following formula.
-         */
-        int32_t num_skipped = 0 - (ivars->count % skip_interval);
-        if (num_skipped == 0 && ivars->count != 0) {
-            num_skipped = 0 - skip_interval;
-        }
 
-        // See if there's anything to skip.
-        while (target > skip_stepper_ivars->doc_id) {
-            new_doc_id  = skip_stepper_ivars->doc_id;
-            new_filepos = skip_stepper_ivars->filepos;
+    if (ivars->doc_freq >= (uint32_t)ivars->skip_interval) {
+        S_skip_to(self, target);
+    }
 
-            if (skip_stepper_ivars->doc_id != 0
-                && skip_stepper_ivars->doc_id >= posting_ivars->doc_id
-               ) {
-                num_skipped += skip_interval;
-            }
+    // Done skipping, so scan.
+    while (1) {
+        int32_t doc_id = SegPList_Next(self);
+        if (doc_id == 0 || doc_id >= target) {
+            return doc_id;
+        }
+    }
+}
 
-            if (ivars->skip_count >= ivars->num_skips) {
-                break;
-            }
+static int32_t
+S_peek_skip(SkipLevel *level, InStream *skip_stream, bool has_prox,
+            bool has_child) {
+    if (!level->peeked) {
+        if (level->consumed >= level->size) { return INT32_MAX; }
+        InStream_Seek(skip_stream, level->next_pos);
+        level->peek_doc_id  = level->doc_id + InStream_Read_C32(skip_stream);
+        level->peek_filepos = level->filepos + InStream_Read_C64(skip_stream);
+        level->peek_prox_filepos
+            = has_prox
+              ? level->prox_filepos + InStream_Read_C64(skip_stream)
+              : 0;
+        level->peek_child   = has_child ? InStream_Read_C64(skip_stream) : 0;
+        level->peek_end     = InStream_Tell(skip_stream);
+        level->peeked       = true;
+    }
+    return level->peek_doc_id;
+}
+
+static void
+S_skip_to(SegPostingList *self, int32_t target) {
+    SegPostingListIVARS *const ivars = SegPList_IVARS(self);
+    InStream  *const skip_stream = ivars->skip_stream;
+    InStream  *const post_stream = ivars->post_stream;
+    SkipLevel *const levels      = ivars->skip_levels;
+    const bool       has_prox    = ivars->format >= 4;
+
+    if (!ivars->num_skip_levels) { S_init_skip_levels(self); }
+
+    // Climb only as high as the distance to the target warrants, then work
+    // back down, syncing each level to the furthest entry read above it.
+    int32_t level = 0;
+    while (level + 1 < ivars->num_skip_levels
+           && S_peek_skip(&levels[level + 1], skip_stream, has_prox, true)
+              < target
+          ) {
+        level++;
+    }
+    while (1) {
+        SkipLevel *const current = &levels[level];
+        while (S_peek_skip(current, skip_stream, has_prox, level > 0)
+               < target
+              ) {
+            current->doc_id       = current->peek_doc_id;
+            current->filepos      = current->peek_filepos;
+            current->prox_filepos = current->peek_prox_filepos;
+            current->child        = current->peek_child;
+            current->next_pos     = current->peek_end;
+            current->peeked       = false;
+            current->consumed++;
+        }
+        if (level == 0) { break; }
+
+        SkipLevel *const lower = &levels[level - 1];
+        const uint32_t lower_consumed = current->consumed * SKIP_MULTIPLIER;
+        if (lower_consumed > lower->consumed) {
+            InStream_Seek(skip_stream, lower->start + current->child);
+            lower->child        = level > 1
+                                  ? InStream_Read_C64(skip_stream)
+                                  : 0;
+            lower->next_pos     = InStream_Tell(skip_stream);
+            lower->consumed     = lower_consumed;
+            lower->doc_id       = current->doc_id;
+            lower->filepos      = current->filepos;
+            lower->prox_filepos = current->prox_filepos;
+            lower->peeked       = false;
+        }
+        level--;
+    }
 
-            SkipStepper_Read_Record(skip_stepper, skip_stream);
-            ivars->skip_count++;
+    // If we found something to skip, skip it.
+    if (levels[0].filepos > InStream_Tell(post_stream)) {
+        InStream_Seek(post_stream, levels[0].filepos);
+        Post_IVARS(ivars->posting)->doc_id = levels[0].doc_id;
+        ivars->count = levels[0].consumed * ivars->skip_interval;
+        if (ivars->prox_stream) {
+            ScorePost_Seek_Prox((ScorePosting*)ivars->posting,
+                                levels[0].prox_filepos);
         }
+    }
+}
 
-        // If we found something to skip, skip it.
-        if (new_filepos > InStream_Tell(post_stream)) {
+static int32_t
+S_read_skip_header(SegPostingList *self, uint32_t *num_bitmap_bytes) {
+    SegPostingListIVARS *const ivars = SegPList_IVARS(self);
+    InStream *const skip_stream = ivars->skip_stream;
+    int32_t num_levels = 1;
+    *num_bitmap_bytes = 0;
+
+    // Format 1 skip data is a single level with no header, and format 2 has
+    // no bitmap flag.
+    InStream_Seek(skip_stream, ivars->skip_filepos);
+    if (ivars->format >= 3) {
+        uint32_t header = InStream_Read_C32(skip_stream);
+        num_levels = (int32_t)(header >> 1);
+        if (header & 1) {
+            *num_bitmap_bytes = InStream_Read_C32(skip_stream);
+        }
+    }
+    else if (ivars->format == 2) {
+        num_levels = (int32_t)InStream_Read_C32(skip_stream);
+    }
+    if (num_levels < 1 || num_levels > SKIP_MAX_LEVELS) {
+        THROW(ERR, "Invalid number of skip levels: %i32", num_levels);
+    }
 
-            // Move the postings filepointer up.
-            InStream_Seek(post_stream, new_filepos);
+    return num_levels;
+}
 
-            // Jump to the new doc id.
-            posting_ivars->doc_id = new_doc_id;
+static void
+S_init_skip_levels(SegPostingList *self) {
+    SegPostingListIVARS *const ivars = SegPList_IVARS(self);
+    InStream  *const skip_stream = ivars->skip_stream;
+    SkipLevel *const levels      = ivars->skip_levels;
+    uint32_t num_bitmap_bytes;
+    int32_t  num_levels = S_read_skip_header(self, &num_bitmap_bytes);
+    InStream_Seek(skip_stream, InStream_Tell(skip_stream) + num_bitmap_bytes);
+
+    // Levels are stored top down, each above level 0 prefixed by its length.
+    for (int32_t i = num_levels - 1; i > 0; i--) {
+        int64_t len = (int64_t)InStream_Read_C64(skip_stream);
+        levels[i].start = InStream_Tell(skip_stream);
+        InStream_Seek(skip_stream, levels[i].start + len);
+    }
+    levels[0].start = InStream_Tell(skip_stream);
+
+    for (int32_t i = 0; i < num_levels; i++) {
+        SkipLevel *const level = &levels[i];
+        level->size         = i == 0
+                              ? ivars->doc_freq / ivars->skip_interval
+                              : levels[i - 1].size / SKIP_MULTIPLIER;
+        level->next_pos     = level->start;
+        level->consumed     = 0;
+        level->doc_id       = 0;
+        level->filepos      = ivars->post_filepos;
+        level->prox_filepos = ivars->prox_filepos;
+        level->child        = 0;
+        level->peeked       = false;
+    }
+    ivars->num_skip_levels = num_levels;
+}
 
-            // Increase count by the number of docs we skipped over.
-            ivars->count += num_skipped;
+BitVector*
+SegPList_dense_bits(SegPostingList *self) {
+    SegPostingListIVARS *const ivars = SegPList_IVARS(self);
+    if (!ivars->dense_bits_read) {
+        ivars->dense_bits_read = true;
+        if (SegPList_Has_Dense_Bits(self)) {
+            uint32_t num_bytes;
+            S_read_skip_header(self, &num_bytes);
+            ivars->dense_bits = BitVec_new(num_bytes * 8);
+            InStream_Read_Bytes(ivars->skip_stream,
+                                (char*)BitVec_Get_Raw_Bits(ivars->dense_bits),
+                                num_bytes);
         }
     }
+    return ivars->dense_bits;
+}
 
-    // Done skipping, so scan.
-    while (1) {
-        int32_t doc_id = SegPList_Next(self);
-        if (doc_id == 0 || doc_id >= target) {
-            return doc_id;
+bool
+SegPList_has_dense_bits(SegPostingList *self) {
+    SegPostingListIVARS *const ivars = SegPList_IVARS(self);
+    if (ivars->num_dense_bytes < 0) {
+        uint32_t num_bytes = 0;
+        if (ivars->doc_freq >= (uint32_t)ivars->skip_interval) {
+            S_read_skip_header(self, &num_bytes);
         }
+        ivars->num_dense_bytes = (int32_t)num_bytes;
     }
+    return ivars->num_dense_bytes > 0;
 }
 
 void
@@ -279,6 +469,12 @@ S_seek_tinfo(SegPostingList *self, TermInfo *tinfo) {
     SegPostingListIVARS *const ivars = SegPList_IVARS(self);
     ivars->count = 0;
 
+    // Forget the last term's bitmap.
+    DECREF(ivars->dense_bits);
+    ivars->dense_bits      = NULL;
+    ivars->dense_bits_read = false;
+    ivars->num_dense_bytes = -1;
+
     if (tinfo == NULL) {
         // Next will return false; other methods invalid now.
         ivars->doc_freq = 0;
@@ -291,12 +487,17 @@ S_seek_tinfo(SegPostingList *self, TermInfo *tinfo) {
 
         // Prepare posting.
         Post_Reset(ivars->posting);
+        ivars->prox_filepos = TInfo_Get_Prox_FilePos(tinfo);
+        if (ivars->prox_stream) {
+            ScorePost_Seek_Prox((ScorePosting*)ivars->posting,
+                                ivars->prox_filepos);
+        }
 
-        // Prepare to skip.
-        ivars->skip_count = 0;
-        ivars->num_skips  = ivars->doc_freq / ivars->skip_interval;
-        SkipStepper_Set_ID_And_Filepos(ivars->skip_stepper, 0, post_filepos);
-        InStream_Seek(ivars->skip_stream, TInfo_Get_Skip_FilePos(tinfo));
+        // Prepare to skip.  The skip list header is read lazily, since most
+        // posting lists are never advanced.
+        ivars->post_filepos    = post_filepos;
+        ivars->skip_filepos    = TInfo_Get_Skip_FilePos(tinfo);
+        ivars->num_skip_levels = 0;
     }
 }
 
@@ -18,6 +18,7 @@
 #include "Lucy/Util/ToolSet.h"
 
 #include "Lucy/Index/SegWriter.h"
+#include "Clownfish/Util/SortUtils.h"
 #include "Lucy/Document/Doc.h"
 #include "Lucy/Plan/Schema.h"
 #include "Lucy/Store/DirHandle.h"
@@ -28,7 +29,12 @@
 #include "Lucy/Index/Segment.h"
 #include "Lucy/Index/SegReader.h"
 #include "Lucy/Index/Snapshot.h"
+#include "Lucy/Index/SortCache.h"
+#include "Lucy/Index/SortReader.h"
 #include "Lucy/Plan/Architecture.h"
+#include "Lucy/Plan/FieldType.h"
+#include "Lucy/Search/SortRule.h"
+#include "Lucy/Search/SortSpec.h"
 
 SegWriter*
 SegWriter_new(Schema *schema, Snapshot *snapshot, Segment *segment,
@@ -57,6 +63,7 @@ SegWriter_destroy(SegWriter *self) {
     DECREF(ivars->writers);
     DECREF(ivars->by_api);
     DECREF(ivars->del_writer);
+    DECREF(ivars->sort_map);
     SUPER_DESTROY(self, SEGWRITER);
 }
 
@@ -190,6 +197,200 @@ SegWriter_delete_segment(SegWriter *self, SegReader *reader) {
     Snapshot_Delete_Entry(snapshot, seg_name);
 }
 
+typedef struct {
+    int32_t  **ords;
+    bool      *reverse;
+    uint32_t   num_rules;
+} IndexSortContext;
+
+// Order doc ids by their sort cache ords under each index sort rule in turn,
+// breaking ties by original doc id.
+static int
+S_compare_by_index_sort(void *context, const void *va, const void *vb) {
+    IndexSortContext *sort_context = (IndexSortContext*)context;
+    int32_t a = *(int32_t*)va;
+    int32_t b = *(int32_t*)vb;
+    for (uint32_t i = 0; i < sort_context->num_rules; i++) {
+        int32_t *ords = sort_context->ords[i];
+        if (ords[a] != ords[b]) {
+            int comparison = ords[a] < ords[b] ? -1 : 1;
+            return sort_context->reverse[i] ? -comparison : comparison;
+        }
+    }
+    return a < b ? -1 : a > b ? 1 : 0;
+}
+
+// Compute a doc map which renumbers the docs in the supplied reader so that
+// they follow the index sort.  Return NULL if they already do.
+static I32Array*
+S_index_sort_doc_map(SegReader *reader, Schema *schema, SortSpec *sort_spec) {
+    VArray   *rules     = SortSpec_Get_Rules(sort_spec);
+    uint32_t  num_rules = VA_Get_Size(rules);
+    int32_t   doc_max   = SegReader_Doc_Max(reader);
+    SortReader *sort_reader
+        = (SortReader*)SegReader_Fetch(reader, VTable_Get_Name(SORTREADER));
+    for (uint32_t i = 0; i < num_rules; i++) {
+        CharBuf   *field = SortRule_Get_Field((SortRule*)VA_Fetch(rules, i));
+        FieldType *type  = Schema_Fetch_Type(schema, field);
+        if (!type || !FType_Sortable(type)) {
+            THROW(ERR, "Index sort field '%o' isn't sortable", field);
+        }
+    }
+
+    // Gather ords up front, so that comparisons are cheap.
+    IndexSortContext sort_context;
+    sort_context.ords      = (int32_t**)CALLOCATE(num_rules, sizeof(int32_t*));
+    sort_context.reverse   = (bool*)CALLOCATE(num_rules, sizeof(bool));
+    sort_context.num_rules = num_rules;
+    for (uint32_t i = 0; i < num_rules; i++) {
+        SortRule  *rule  = (SortRule*)VA_Fetch(rules, i);
+        CharBuf   *field = SortRule_Get_Field(rule);
+        SortCache *sort_cache = sort_reader
+                                ? SortReader_Fetch_Sort_Cache(sort_reader, field)
+                                : NULL;
+        int32_t *ords = (int32_t*)CALLOCATE(doc_max + 1, sizeof(int32_t));
+        if (sort_cache) {
+            for (int32_t doc_id = 1; doc_id <= doc_max; doc_id++) {
+                ords[doc_id] = SortCache_Ordinal(sort_cache, doc_id);
+            }
+        }
+        sort_context.ords[i]    = ords;
+        sort_context.reverse[i] = SortRule_Get_Reverse(rule);
+    }
+
+    int32_t *sorted = (int32_t*)MALLOCATE((doc_max + 1) * sizeof(int32_t));
+    for (int32_t doc_id = 1; doc_id <= doc_max; doc_id++) {
+        sorted[doc_id - 1] = doc_id;
+    }
+    Sort_quicksort(sorted, (size_t)doc_max, sizeof(int32_t),
+                   S_compare_by_index_sort, &sort_context);
+    for (uint32_t i = 0; i < num_rules; i++) {
+        FREEMEM(sort_context.ords[i]);
+    }
+    FREEMEM(sort_context.ords);
+    FREEMEM(sort_context.reverse);
+
+    bool     in_order = true;
+    int32_t *doc_map  = (int32_t*)CALLOCATE(doc_max + 1, sizeof(int32_t));
+    for (int32_t i = 0; i < doc_max; i++) {
+        doc_map[sorted[i]] = i + 1;
+        if (sorted[i] != i + 1) { in_order = false; }
+    }
+    FREEMEM(sorted);
+    if (in_order) {
+        FREEMEM(doc_map);
+        return NULL;
+    }
+    return I32Arr_new_steal(doc_map, (uint32_t)doc_max + 1);
+}
+
+// Rewrite the finished segment so that its doc ids follow the index sort.
+// The unsorted files are moved aside and read back through a SegReader,
+// then a second set of writers copies them into a fresh segment directory
+// using a permuting doc map.
+static void
+S_apply_index_sort(SegWriter *self, SortSpec *sort_spec) {
+    SegWriterIVARS *const ivars = SegWriter_IVARS(self);
+    Folder  *folder    = ivars->folder;
+    Segment *segment   = ivars->segment;
+    CharBuf *seg_name  = Seg_Get_Name(segment);
+    CharBuf *temp_dir  = CB_newf("%o_unsorted", seg_name);
+    CharBuf *temp_path = CB_newf("%o/%o", temp_dir, seg_name);
+
+    // Move the unsorted segment aside.
+    if (Folder_Exists(folder, temp_dir)) {
+        if (!Folder_Delete_Tree(folder, temp_dir)) {
+            THROW(ERR, "Couldn't completely remove '%o'", temp_dir);
+        }
+    }
+    if (!Folder_MkDir(folder, temp_dir)
+        || !Folder_Rename(folder, seg_name, temp_path)
+       ) {
+        RETHROW(INCREF(Err_get_error()));
+    }
+    Folder *temp_folder = Folder_Find_Folder(folder, temp_dir);
+    Seg_Write_File(segment, temp_folder);
+    Segment *unsorted = Seg_new(Seg_Get_Number(segment));
+    if (!Seg_Read_File(unsorted, temp_folder)) {
+        THROW(ERR, "Failed to read segment metadata for '%o'", temp_path);
+    }
+    VArray *segments = VA_new(1);
+    VA_Push(segments, INCREF(unsorted));
+    Snapshot  *temp_snapshot = Snapshot_new();
+    SegReader *reader = SegReader_new(ivars->schema, temp_folder,
+                                      temp_snapshot, segments, 0);
+    I32Array *doc_map
+        = S_index_sort_doc_map(reader, ivars->schema, sort_spec);
+
+    if (!doc_map) {
+        // Already in order, so just put the segment back.
+        CharBuf *segmeta_filename = CB_newf("%o/segmeta.json", seg_name);
+        DECREF(reader);
+        if (!Folder_Rename(folder, temp_path, seg_name)
+            || !Folder_Delete(folder, segmeta_filename)
+           ) {
+            RETHROW(INCREF(Err_get_error()));
+        }
+        DECREF(segmeta_filename);
+    }
+    else {
+        // Start over with the Segment, keeping only the deletions metadata
+        // recorded for other segments.
+        Hash *metadata = Seg_Get_Metadata(segment);
+        Obj  *del_meta = INCREF(Hash_Fetch_Str(metadata, "deletions", 9));
+        Hash_Clear(metadata);
+        if (del_meta) {
+            Hash_Store_Str(metadata, "deletions", 9, del_meta);
+        }
+        Seg_Set_Count(segment, 0);
+
+        // Copy everything over, in index sort order.
+        SegWriter *sorted = SegWriter_new(ivars->schema, ivars->snapshot,
+                                          segment, ivars->polyreader);
+        SegWriterIVARS *const sorted_ivars = SegWriter_IVARS(sorted);
+        if (!Folder_MkDir(folder, seg_name)) {
+            RETHROW(INCREF(Err_get_error()));
+        }
+        SegWriter_Add_Segment(sorted, reader, doc_map);
+        for (uint32_t i = 0, max = VA_Get_Size(sorted_ivars->writers);
+             i < max; i++
+            ) {
+            DataWriter *writer
+                = (DataWriter*)VA_Fetch(sorted_ivars->writers, i);
+            DataWriter_Finish(writer);
+        }
+        DECREF(sorted);
+        DECREF(reader);
+
+        // Bring back deletions files written on behalf of other segments.
+        VArray *entries = Folder_List(temp_folder, seg_name);
+        if (!entries) { RETHROW(INCREF(Err_get_error())); }
+        for (uint32_t i = 0, max = VA_Get_Size(entries); i < max; i++) {
+            CharBuf *entry = (CharBuf*)VA_Fetch(entries, i);
+            if (CB_Starts_With_Str(entry, "deletions-", 10)) {
+                CharBuf *from = CB_newf("%o/%o", temp_path, entry);
+                CharBuf *to   = CB_newf("%o/%o", seg_name, entry);
+                bool result = Folder_Rename(folder, from, to);
+                DECREF(from);
+                DECREF(to);
+                if (!result) { RETHROW(INCREF(Err_get_error())); }
+            }
+        }
+        DECREF(entries);
+        DECREF(ivars->sort_map);
+        ivars->sort_map = doc_map;
+    }
+
+    if (!Folder_Delete_Tree(folder, temp_dir)) {
+        THROW(ERR, "Couldn't completely remove '%o'", temp_dir);
+    }
+    DECREF(temp_snapshot);
+    DECREF(segments);
+    DECREF(unsorted);
+    DECREF(temp_path);
+    DECREF(temp_dir);
+}
+
 void
 SegWriter_finish(SegWriter *self) {
     SegWriterIVARS *const ivars = SegWriter_IVARS(self);
@@ -201,6 +402,17 @@ SegWriter_finish(SegWriter *self) {
         DataWriter_Finish(writer);
     }
 
+    // Renumber documents according to the index sort, if any, and record
+    // the order so that searches can rely on it.
+    SortSpec *index_sort = Schema_Get_Index_Sort(ivars->schema);
+    if (index_sort) {
+        if (Seg_Get_Count(ivars->segment) > 1) {
+            S_apply_index_sort(self, index_sort);
+        }
+        Seg_Store_Metadata_Str(ivars->segment, "index_sort", 10,
+                               (Obj*)SortSpec_Dump_Rules(index_sort));
+    }
+
     // Write segment metadata and add the segment directory to the snapshot.
     Snapshot *snapshot = SegWriter_Get_Snapshot(self);
     CharBuf *segmeta_filename = CB_newf("%o/segmeta.json", seg_name);
@@ -230,4 +442,9 @@ SegWriter_get_del_writer(SegWriter *self) {
     return SegWriter_IVARS(self)->del_writer;
 }
 
+I32Array*
+SegWriter_get_sort_map(SegWriter *self) {
+    return SegWriter_IVARS(self)->sort_map;
+}
+
 
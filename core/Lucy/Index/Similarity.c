@@ -26,6 +26,7 @@
 #include "Lucy/Index/Snapshot.h"
 #include "Lucy/Index/PolyReader.h"
 #include "Lucy/Index/Posting/MatchPosting.h"
+#include "Lucy/Index/Posting/RichPosting.h"
 #include "Lucy/Plan/Schema.h"
 #include "Lucy/Store/InStream.h"
 #include "Lucy/Store/OutStream.h"
@@ -62,7 +63,17 @@ PostingWriter*
 Sim_make_posting_writer(Similarity *self, Schema *schema, Snapshot *snapshot,
                         Segment *segment, PolyReader *polyreader,
                         int32_t field_num) {
-    UNUSED_VAR(self);
+    // ScorePostings get their positions written to a file of their own.
+    // RichPosting keeps a boost byte with each position and needs them all
+    // to score a doc, so it has nothing to gain from the split.
+    Posting *posting = Sim_Make_Posting(self);
+    bool split_prox = Obj_Is_A((Obj*)posting, SCOREPOSTING)
+                      && !Obj_Is_A((Obj*)posting, RICHPOSTING);
+    DECREF(posting);
+    if (split_prox) {
+        return (PostingWriter*)ScorePostWriter_new(schema, snapshot, segment,
+                                                   polyreader, field_num);
+    }
     return (PostingWriter*)MatchPostWriter_new(schema, snapshot, segment,
                                                polyreader, field_num);
 }
@@ -104,6 +104,75 @@ SortCache_ordinal(SortCache *self, int32_t doc_id) {
     }
 }
 
+void
+SortCache_ordinals(SortCache *self, int32_t *doc_ids, int32_t *ords,
+                   uint32_t count) {
+    SortCacheIVARS *const ivars = SortCache_IVARS(self);
+    for (uint32_t i = 0; i < count; i++) {
+        if ((uint32_t)doc_ids[i] > (uint32_t)ivars->doc_max) {
+            THROW(ERR, "Out of range: %i32 > %i32", doc_ids[i],
+                  ivars->doc_max);
+        }
+    }
+    void *const ords_buf = ivars->ords;
+    switch (ivars->ord_width) {
+        case 1:
+            for (uint32_t i = 0; i < count; i++) {
+                ords[i] = NumUtil_u1get(ords_buf, doc_ids[i]);
+            }
+            break;
+        case 2:
+            for (uint32_t i = 0; i < count; i++) {
+                ords[i] = NumUtil_u2get(ords_buf, doc_ids[i]);
+            }
+            break;
+        case 4:
+            for (uint32_t i = 0; i < count; i++) {
+                ords[i] = NumUtil_u4get(ords_buf, doc_ids[i]);
+            }
+            break;
+        case 8: {
+                uint8_t *ints = (uint8_t*)ords_buf;
+                for (uint32_t i = 0; i < count; i++) {
+                    ords[i] = ints[doc_ids[i]];
+                }
+            }
+            break;
+        case 16:
+            if (ivars->native_ords) {
+                uint16_t *ints = (uint16_t*)ords_buf;
+                for (uint32_t i = 0; i < count; i++) {
+                    ords[i] = ints[doc_ids[i]];
+                }
+            }
+            else {
+                uint8_t *bytes = (uint8_t*)ords_buf;
+                for (uint32_t i = 0; i < count; i++) {
+                    ords[i] = NumUtil_decode_bigend_u16(
+                                  bytes + doc_ids[i] * sizeof(uint16_t));
+                }
+            }
+            break;
+        case 32:
+            if (ivars->native_ords) {
+                uint32_t *ints = (uint32_t*)ords_buf;
+                for (uint32_t i = 0; i < count; i++) {
+                    ords[i] = (int32_t)ints[doc_ids[i]];
+                }
+            }
+            else {
+                uint8_t *bytes = (uint8_t*)ords_buf;
+                for (uint32_t i = 0; i < count; i++) {
+                    ords[i] = (int32_t)NumUtil_decode_bigend_u32(
+                                  bytes + doc_ids[i] * sizeof(uint32_t));
+                }
+            }
+            break;
+        default:
+            THROW(ERR, "Invalid ord width: %i32", ivars->ord_width);
+    }
+}
+
 int32_t
 SortCache_find(SortCache *self, Obj *term) {
     SortCacheIVARS *const ivars = SortCache_IVARS(self);
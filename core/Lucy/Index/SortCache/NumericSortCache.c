@@ -79,6 +79,55 @@ NumSortCache_destroy(NumericSortCache *self) {
     SUPER_DESTROY(self, NUMERICSORTCACHE);
 }
 
+// Number of ordinals looked up at a time by the bulk accessors.
+#define ORD_CHUNK_SIZE 128
+
+void
+NumSortCache_double_values(NumericSortCache *self, int32_t *doc_ids,
+                           double *values, uint32_t count) {
+    int32_t ords[ORD_CHUNK_SIZE];
+    for (uint32_t start = 0; start < count; start += ORD_CHUNK_SIZE) {
+        uint32_t chunk = count - start < ORD_CHUNK_SIZE
+                         ? count - start
+                         : ORD_CHUNK_SIZE;
+        NumSortCache_Ordinals(self, doc_ids + start, ords, chunk);
+        for (uint32_t i = 0; i < chunk; i++) {
+            values[start + i] = NumSortCache_Double_Value(self, ords[i]);
+        }
+    }
+}
+
+void
+NumSortCache_int64_values(NumericSortCache *self, int32_t *doc_ids,
+                          int64_t *values, uint32_t count, int64_t missing) {
+    NumericSortCacheIVARS *const ivars = NumSortCache_IVARS(self);
+    bool is_i64 = NumSortCache_Is_A(self, INT64SORTCACHE);
+    if (!is_i64 && !NumSortCache_Is_A(self, INT32SORTCACHE)) {
+        THROW(ERR, "'%o' isn't an integer field", ivars->field);
+    }
+    int32_t ords[ORD_CHUNK_SIZE];
+    for (uint32_t start = 0; start < count; start += ORD_CHUNK_SIZE) {
+        uint32_t chunk = count - start < ORD_CHUNK_SIZE
+                         ? count - start
+                         : ORD_CHUNK_SIZE;
+        NumSortCache_Ordinals(self, doc_ids + start, ords, chunk);
+        for (uint32_t i = 0; i < chunk; i++) {
+            int32_t ord = ords[i];
+            if (ord == ivars->null_ord) {
+                values[start + i] = missing;
+            }
+            else if (is_i64) {
+                InStream_Seek(ivars->dat_in, ord * sizeof(int64_t));
+                values[start + i] = InStream_Read_I64(ivars->dat_in);
+            }
+            else {
+                InStream_Seek(ivars->dat_in, ord * sizeof(int32_t));
+                values[start + i] = InStream_Read_I32(ivars->dat_in);
+            }
+        }
+    }
+}
+
 /***************************************************************************/
 
 Float64SortCache*
@@ -124,6 +173,19 @@ F64SortCache_make_blank(Float64SortCache *self) {
     return Float64_new(0.0);
 }
 
+double
+F64SortCache_double_value(Float64SortCache *self, int32_t ord) {
+    Float64SortCacheIVARS *const ivars = F64SortCache_IVARS(self);
+    if (ord == ivars->null_ord) {
+        return F64_NAN;
+    }
+    else if (ord < 0) {
+        THROW(ERR, "Ordinal less than 0 for %o: %i32", ivars->field, ord);
+    }
+    InStream_Seek(ivars->dat_in, ord * sizeof(double));
+    return (double)InStream_Read_F64(ivars->dat_in);
+}
+
 /***************************************************************************/
 
 Float32SortCache*
@@ -169,6 +231,19 @@ F32SortCache_make_blank(Float32SortCache *self) {
     return Float32_new(0.0f);
 }
 
+double
+F32SortCache_double_value(Float32SortCache *self, int32_t ord) {
+    Float32SortCacheIVARS *const ivars = F32SortCache_IVARS(self);
+    if (ord == ivars->null_ord) {
+        return F64_NAN;
+    }
+    else if (ord < 0) {
+        THROW(ERR, "Ordinal less than 0 for %o: %i32", ivars->field, ord);
+    }
+    InStream_Seek(ivars->dat_in, ord * sizeof(float));
+    return (double)InStream_Read_F32(ivars->dat_in);
+}
+
 /***************************************************************************/
 
 Int32SortCache*
@@ -214,6 +289,19 @@ I32SortCache_make_blank(Int32SortCache *self) {
     return Int32_new(0);
 }
 
+double
+I32SortCache_double_value(Int32SortCache *self, int32_t ord) {
+    Int32SortCacheIVARS *const ivars = I32SortCache_IVARS(self);
+    if (ord == ivars->null_ord) {
+        return F64_NAN;
+    }
+    else if (ord < 0) {
+        THROW(ERR, "Ordinal less than 0 for %o: %i32", ivars->field, ord);
+    }
+    InStream_Seek(ivars->dat_in, ord * sizeof(int32_t));
+    return (double)InStream_Read_I32(ivars->dat_in);
+}
+
 /***************************************************************************/
 
 Int64SortCache*
@@ -259,4 +347,17 @@ I64SortCache_make_blank(Int64SortCache *self) {
     return Int64_new(0);
 }
 
+double
+I64SortCache_double_value(Int64SortCache *self, int32_t ord) {
+    Int64SortCacheIVARS *const ivars = I64SortCache_IVARS(self);
+    if (ord == ivars->null_ord) {
+        return F64_NAN;
+    }
+    else if (ord < 0) {
+        THROW(ERR, "Ordinal less than 0 for %o: %i32", ivars->field, ord);
+    }
+    InStream_Seek(ivars->dat_in, ord * sizeof(int64_t));
+    return (double)InStream_Read_I64(ivars->dat_in);
+}
+
 
@@ -126,6 +126,49 @@ TextSortCache_value(TextSortCache *self, int32_t ord, Obj *blank) {
     return blank;
 }
 
+static int
+S_compare_u64(void *context, const void *va, const void *vb) {
+    uint64_t a = *(uint64_t*)va;
+    uint64_t b = *(uint64_t*)vb;
+    UNUSED_VAR(context);
+    return a < b ? -1 : a > b ? 1 : 0;
+}
+
+VArray*
+TextSortCache_values(TextSortCache *self, int32_t *doc_ids, uint32_t count) {
+    VArray  *values = VA_new(count);
+    if (!count) { return values; }
+    int32_t  *ords   = (int32_t*)MALLOCATE(count * sizeof(int32_t));
+    uint64_t *by_ord = (uint64_t*)MALLOCATE(count * sizeof(uint64_t));
+    TextSortCache_Ordinals(self, doc_ids, ords, count);
+
+    // Pack each ordinal with its position and sort, so that each distinct
+    // ordinal is read once and no object is allocated per doc.
+    for (uint32_t i = 0; i < count; i++) {
+        by_ord[i] = ((uint64_t)(uint32_t)ords[i] << 32) | i;
+    }
+    Sort_quicksort(by_ord, count, sizeof(uint64_t), S_compare_u64, NULL);
+
+    Obj     *value    = NULL;
+    int64_t  last_ord = -1;
+    for (uint32_t i = 0; i < count; i++) {
+        int32_t  ord  = (int32_t)(by_ord[i] >> 32);
+        uint32_t tick = (uint32_t)(by_ord[i] & 0xFFFFFFFF);
+        if (ord != last_ord) {
+            CharBuf *blank = TextSortCache_Make_Blank(self);
+            DECREF(value);
+            value = TextSortCache_Value(self, ord, (Obj*)blank);
+            if (!value) { DECREF(blank); }
+            last_ord = ord;
+        }
+        VA_Store(values, tick, INCREF(value));
+    }
+    DECREF(value);
+    FREEMEM(by_ord);
+    FREEMEM(ords);
+    return values;
+}
+
 CharBuf*
 TextSortCache_make_blank(TextSortCache *self) {
     UNUSED_VAR(self);
@@ -43,11 +43,17 @@ static void
 S_flip_run(SortFieldWriter *run, size_t sub_thresh, InStream *ord_in,
            InStream *ix_in, InStream *dat_in);
 
-// Write out a sort cache.  Returns the number of unique values in the sort
-// cache.
+// Write out a sort cache, plus a point index if pts_out is supplied.
+// Returns the number of unique values in the sort cache.
 static int32_t
 S_write_files(SortFieldWriter *self, OutStream *ord_out, OutStream *ix_out,
-              OutStream *dat_out);
+              OutStream *dat_out, OutStream *pts_out);
+
+// Write every doc id grouped by ord, preceded by the offset at which each
+// ord's group begins.
+static void
+S_write_point_index(int32_t *ords, int32_t doc_max, int32_t cardinality,
+                    int32_t null_ord, OutStream *pts_out);
 
 typedef struct lucy_SFWriterElem {
     Obj *value;
@@ -94,6 +100,10 @@ SortFieldWriter_init(SortFieldWriter *self, Schema *schema,
     ivars->run_ord         = 0;
     ivars->run_tick        = 0;
     ivars->ord_width       = 0;
+    ivars->doc_count       = 0;
+    ivars->value_count     = 0;
+    ivars->min_val         = NULL;
+    ivars->max_val         = NULL;
 
     // Assign.
     ivars->field        = CB_Clone(field);
@@ -155,6 +165,8 @@ SortFieldWriter_destroy(SortFieldWriter *self) {
     DECREF(ivars->dat_in);
     DECREF(ivars->sort_cache);
     DECREF(ivars->doc_map);
+    DECREF(ivars->min_val);
+    DECREF(ivars->max_val);
     FREEMEM(ivars->sorted_ids);
     SUPER_DESTROY(self, SORTFIELDWRITER);
 }
@@ -169,6 +181,51 @@ SortFieldWriter_get_ord_width(SortFieldWriter *self) {
     return SortFieldWriter_IVARS(self)->ord_width;
 }
 
+static CharBuf*
+S_stringify_value(Obj *val, int8_t prim_id) {
+    switch (prim_id & FType_PRIMITIVE_ID_MASK) {
+        case FType_TEXT:
+            return CB_Clone((CharBuf*)val);
+        case FType_INT32:
+        case FType_INT64:
+            return CB_newf("%i64", Obj_To_I64(val));
+        case FType_FLOAT32:
+        case FType_FLOAT64: {
+                // CB_newf's "%f64" doesn't preserve full precision, so record
+                // the bit pattern of the double as an integer instead.
+                // Folding -0.0 into 0.0 keeps the pattern above INT64_MIN.
+                double  value = Obj_To_F64(val);
+                int64_t bits;
+                if (value == 0.0) { value = 0.0; }
+                memcpy(&bits, &value, sizeof(bits));
+                return CB_newf("%i64", bits);
+            }
+        default:
+            return NULL;
+    }
+}
+
+Hash*
+SortFieldWriter_stats(SortFieldWriter *self) {
+    SortFieldWriterIVARS *const ivars = SortFieldWriter_IVARS(self);
+    if (!ivars->min_val || !ivars->max_val) { return NULL; }
+    CharBuf *min = S_stringify_value(ivars->min_val, ivars->prim_id);
+    CharBuf *max = S_stringify_value(ivars->max_val, ivars->prim_id);
+    if (!min || !max) {
+        DECREF(min);
+        DECREF(max);
+        return NULL;
+    }
+    Hash *stats = Hash_new(4);
+    Hash_Store_Str(stats, "min", 3, (Obj*)min);
+    Hash_Store_Str(stats, "max", 3, (Obj*)max);
+    Hash_Store_Str(stats, "value_count", 11,
+                   (Obj*)CB_newf("%i32", ivars->value_count));
+    Hash_Store_Str(stats, "doc_count", 9,
+                   (Obj*)CB_newf("%i32", ivars->doc_count));
+    return stats;
+}
+
 static Obj*
 S_find_unique_value(Hash *uniq_vals, Obj *val) {
     int32_t  hash_sum  = Obj_Hash_Sum(val);
@@ -396,7 +453,7 @@ SortFieldWriter_flush(SortFieldWriter *self) {
     // Write files, record stats.
     run_ivars->run_max = (int32_t)Seg_Get_Count(ivars->segment);
     run_ivars->run_cardinality = S_write_files(run, temp_ord_out, temp_ix_out,
-                                               temp_dat_out);
+                                               temp_dat_out, NULL);
 
     // Reclaim the buffer from the run and empty it.
     run_ivars->cache       = NULL;
@@ -526,9 +583,40 @@ SortFieldWriter_flip(SortFieldWriter *self) {
     ivars->flipped = true;
 }
 
+static void
+S_write_point_index(int32_t *ords, int32_t doc_max, int32_t cardinality,
+                    int32_t null_ord, OutStream *pts_out) {
+    // Count docs per ord, then convert the counts to starting offsets.
+    int32_t *offsets
+        = (int32_t*)CALLOCATE(cardinality + 1, sizeof(int32_t));
+    for (int32_t i = 1; i <= doc_max; i++) {
+        int32_t real_ord = ords[i] == -1 ? null_ord : ords[i];
+        offsets[real_ord + 1]++;
+    }
+    for (int32_t ord = 0; ord < cardinality; ord++) {
+        offsets[ord + 1] += offsets[ord];
+    }
+    for (int32_t ord = 0; ord <= cardinality; ord++) {
+        OutStream_Write_I32(pts_out, offsets[ord]);
+    }
+
+    // Bucket doc ids, which leaves each bucket in ascending order.
+    int32_t *doc_ids = (int32_t*)MALLOCATE((doc_max + 1) * sizeof(int32_t));
+    for (int32_t i = 1; i <= doc_max; i++) {
+        int32_t real_ord = ords[i] == -1 ? null_ord : ords[i];
+        doc_ids[offsets[real_ord]++] = i;
+    }
+    for (int32_t i = 0; i < doc_max; i++) {
+        OutStream_Write_I32(pts_out, doc_ids[i]);
+    }
+
+    FREEMEM(doc_ids);
+    FREEMEM(offsets);
+}
+
 static int32_t
 S_write_files(SortFieldWriter *self, OutStream *ord_out, OutStream *ix_out,
-              OutStream *dat_out) {
+              OutStream *dat_out, OutStream *pts_out) {
     SortFieldWriterIVARS *const ivars = SortFieldWriter_IVARS(self);
     int8_t    prim_id   = ivars->prim_id;
     int32_t   doc_max   = (int32_t)Seg_Get_Count(ivars->segment);
@@ -548,6 +636,9 @@ S_write_files(SortFieldWriter *self, OutStream *ord_out, OutStream *ix_out,
     SFWriterElem *elem = (SFWriterElem*)SortFieldWriter_Fetch(self);
     ords[elem->doc_id] = ord;
     ords[0] = 0;
+    DECREF(ivars->min_val);
+    ivars->min_val = Obj_Clone(elem->value);
+    ivars->doc_count = 1;
 
     // Build array of ords, write non-NULL sorted values.
     Obj *val = Obj_Clone(elem->value);
@@ -565,8 +656,11 @@ S_write_files(SortFieldWriter *self, OutStream *ord_out, OutStream *ix_out,
             last_val_address = elem->value;
         }
         ords[elem->doc_id] = ord;
+        ivars->doc_count++;
     }
-    DECREF(val);
+    DECREF(ivars->max_val);
+    ivars->max_val = val;
+    ivars->value_count = ord + 1;
 
     // If there are NULL values, write one now and record the NULL ord.
     if (has_nulls) {
@@ -599,6 +693,10 @@ S_write_files(SortFieldWriter *self, OutStream *ord_out, OutStream *ix_out,
     OutStream_Write_Bytes(ord_out, compressed_ords, (size_t)byte_count);
     FREEMEM(compressed_ords);
 
+    if (pts_out) {
+        S_write_point_index(ords, doc_max, cardinality, null_ord, pts_out);
+    }
+
     FREEMEM(ords);
     return cardinality;
 }
@@ -627,14 +725,23 @@ SortFieldWriter_finish(SortFieldWriter *self) {
     CB_setf(path, "%o/sort-%i32.dat", seg_name, field_num);
     OutStream *dat_out = Folder_Open_Out(folder, path);
     if (!dat_out) { RETHROW(INCREF(Err_get_error())); }
+    OutStream *pts_out = NULL;
+    if (!ivars->var_width) {
+        CB_setf(path, "%o/sort-%i32.pts", seg_name, field_num);
+        pts_out = Folder_Open_Out(folder, path);
+        if (!pts_out) { RETHROW(INCREF(Err_get_error())); }
+    }
     DECREF(path);
 
-    int32_t cardinality = S_write_files(self, ord_out, ix_out, dat_out);
+    int32_t cardinality
+        = S_write_files(self, ord_out, ix_out, dat_out, pts_out);
 
     // Close streams.
     OutStream_Close(ord_out);
     if (ix_out) { OutStream_Close(ix_out); }
     OutStream_Close(dat_out);
+    if (pts_out) { OutStream_Close(pts_out); }
+    DECREF(pts_out);
     DECREF(dat_out);
     DECREF(ix_out);
     DECREF(ord_out);
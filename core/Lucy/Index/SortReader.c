@@ -19,6 +19,7 @@
 #include "Lucy/Util/ToolSet.h"
 
 #include "Lucy/Index/SortReader.h"
+#include "Lucy/Index/PointIndex.h"
 #include "Lucy/Index/Segment.h"
 #include "Lucy/Index/Snapshot.h"
 #include "Lucy/Index/SortCache/NumericSortCache.h"
@@ -46,6 +47,20 @@ SortReader_aggregator(SortReader *self, VArray *readers, I32Array *offsets) {
     return NULL;
 }
 
+PointIndex*
+SortReader_fetch_point_index(SortReader *self, const CharBuf *field) {
+    UNUSED_VAR(self);
+    UNUSED_VAR(field);
+    return NULL;
+}
+
+Hash*
+SortReader_fetch_stats(SortReader *self, const CharBuf *field) {
+    UNUSED_VAR(self);
+    UNUSED_VAR(field);
+    return NULL;
+}
+
 DefaultSortReader*
 DefSortReader_new(Schema *schema, Folder *folder, Snapshot *snapshot,
                   VArray *segments, int32_t seg_tick) {
@@ -71,7 +86,7 @@ DefSortReader_init(DefaultSortReader *self, Schema *schema, Folder *folder,
         if (!format) { THROW(ERR, "Missing 'format' var"); }
         else {
             ivars->format = (int32_t)Obj_To_I64(format);
-            if (ivars->format < 2 || ivars->format > 3) {
+            if (ivars->format < 2 || ivars->format > 4) {
                 THROW(ERR, "Unsupported sort cache format: %i32",
                       ivars->format);
             }
@@ -79,7 +94,9 @@ DefSortReader_init(DefaultSortReader *self, Schema *schema, Folder *folder,
     }
 
     // Init.
-    ivars->caches = Hash_new(0);
+    ivars->caches        = Hash_new(0);
+    ivars->point_indexes = Hash_new(0);
+    ivars->field_stats   = Hash_new(0);
 
     // Either extract or fake up the "counts", "null_ords", and "ord_widths"
     // hashes.
@@ -103,11 +120,20 @@ DefSortReader_init(DefaultSortReader *self, Schema *schema, Folder *folder,
         else {
             ivars->ord_widths = Hash_new(0);
         }
+        ivars->stats = (Hash*)Hash_Fetch_Str(metadata, "stats", 5);
+        if (ivars->stats) {
+            CERTIFY(ivars->stats, HASH);
+            INCREF(ivars->stats);
+        }
+        else {
+            ivars->stats = Hash_new(0);
+        }
     }
     else {
         ivars->counts     = Hash_new(0);
         ivars->null_ords  = Hash_new(0);
         ivars->ord_widths = Hash_new(0);
+        ivars->stats      = Hash_new(0);
     }
 
     return self;
@@ -120,6 +146,10 @@ DefSortReader_close(DefaultSortReader *self) {
         Hash_Dec_RefCount(ivars->caches);
         ivars->caches = NULL;
     }
+    if (ivars->point_indexes) {
+        Hash_Dec_RefCount(ivars->point_indexes);
+        ivars->point_indexes = NULL;
+    }
     if (ivars->counts) {
         Hash_Dec_RefCount(ivars->counts);
         ivars->counts = NULL;
@@ -132,15 +162,26 @@ DefSortReader_close(DefaultSortReader *self) {
         Hash_Dec_RefCount(ivars->ord_widths);
         ivars->ord_widths = NULL;
     }
+    if (ivars->stats) {
+        Hash_Dec_RefCount(ivars->stats);
+        ivars->stats = NULL;
+    }
+    if (ivars->field_stats) {
+        Hash_Dec_RefCount(ivars->field_stats);
+        ivars->field_stats = NULL;
+    }
 }
 
 void
 DefSortReader_destroy(DefaultSortReader *self) {
     DefaultSortReaderIVARS *const ivars = DefSortReader_IVARS(self);
     DECREF(ivars->caches);
+    DECREF(ivars->point_indexes);
     DECREF(ivars->counts);
     DECREF(ivars->null_ords);
     DECREF(ivars->ord_widths);
+    DECREF(ivars->stats);
+    DECREF(ivars->field_stats);
     SUPER_DESTROY(self, DEFAULTSORTREADER);
 }
 
@@ -272,4 +313,112 @@ DefSortReader_fetch_sort_cache(DefaultSortReader *self, const CharBuf *field) {
     return cache;
 }
 
+PointIndex*
+DefSortReader_fetch_point_index(DefaultSortReader *self,
+                                const CharBuf *field) {
+    DefaultSortReaderIVARS *const ivars = DefSortReader_IVARS(self);
+    if (!field || ivars->format < 4) { return NULL; }
+
+    PointIndex *point_index
+        = (PointIndex*)Hash_Fetch(ivars->point_indexes, (Obj*)field);
+    if (!point_index) {
+        // Only fixed-width fields with values have a point index.
+        SortCache *cache = DefSortReader_Fetch_Sort_Cache(self, field);
+        if (!cache) { return NULL; }
+        Schema    *schema  = DefSortReader_Get_Schema(self);
+        FieldType *type    = Schema_Fetch_Type(schema, field);
+        int8_t     prim_id = FType_Primitive_ID(type);
+        if (prim_id == FType_TEXT || prim_id == FType_BLOB) { return NULL; }
+
+        Folder  *folder    = DefSortReader_Get_Folder(self);
+        Segment *segment   = DefSortReader_Get_Segment(self);
+        int32_t  field_num = Seg_Field_Num(segment, field);
+        CharBuf *path = CB_newf("%o/sort-%i32.pts", Seg_Get_Name(segment),
+                                field_num);
+        InStream *instream = Folder_Open_In(folder, path);
+        DECREF(path);
+        if (!instream) {
+            THROW(ERR, "Error opening point index for '%o': %o",
+                  field, Err_get_error());
+        }
+        point_index = PointIndex_new(field, instream,
+                                     SortCache_Get_Cardinality(cache),
+                                     (int32_t)Seg_Get_Count(segment));
+        Hash_Store(ivars->point_indexes, (Obj*)field, (Obj*)point_index);
+        DECREF(instream);
+    }
+
+    return point_index;
+}
+
+// Floating point stats are stored as the integer bit pattern of a double.
+static double
+S_load_stat_double(Obj *dump) {
+    int64_t bits = Obj_To_I64(dump);
+    double  value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+static Obj*
+S_load_stat_value(Obj *dump, int8_t prim_id) {
+    switch (prim_id & FType_PRIMITIVE_ID_MASK) {
+        case FType_TEXT:
+            return (Obj*)CB_Clone((CharBuf*)CERTIFY(dump, CHARBUF));
+        case FType_INT32:
+            return (Obj*)Int32_new((int32_t)Obj_To_I64(dump));
+        case FType_INT64:
+            return (Obj*)Int64_new(Obj_To_I64(dump));
+        case FType_FLOAT32:
+            return (Obj*)Float32_new((float)S_load_stat_double(dump));
+        case FType_FLOAT64:
+            return (Obj*)Float64_new(S_load_stat_double(dump));
+        default:
+            return NULL;
+    }
+}
+
+Hash*
+DefSortReader_fetch_stats(DefaultSortReader *self, const CharBuf *field) {
+    DefaultSortReaderIVARS *const ivars = DefSortReader_IVARS(self);
+    if (!field) { return NULL; }
+
+    Hash *stats = (Hash*)Hash_Fetch(ivars->field_stats, (Obj*)field);
+    if (!stats) {
+        Hash *dump = (Hash*)Hash_Fetch(ivars->stats, (Obj*)field);
+        if (!dump) { return NULL; }
+        CERTIFY(dump, HASH);
+        Schema    *schema = DefSortReader_Get_Schema(self);
+        FieldType *type   = Schema_Fetch_Type(schema, field);
+        if (!type) { return NULL; }
+
+        // Convert the stringified values back to the field's own classes.
+        int8_t prim_id  = FType_Primitive_ID(type);
+        Obj   *min_dump = Hash_Fetch_Str(dump, "min", 3);
+        Obj   *max_dump = Hash_Fetch_Str(dump, "max", 3);
+        Obj   *value_count = Hash_Fetch_Str(dump, "value_count", 11);
+        Obj   *doc_count   = Hash_Fetch_Str(dump, "doc_count", 9);
+        if (!min_dump || !max_dump || !value_count || !doc_count) {
+            THROW(ERR, "Incomplete sort stats for '%o'", field);
+        }
+        Obj *min = S_load_stat_value(min_dump, prim_id);
+        Obj *max = S_load_stat_value(max_dump, prim_id);
+        if (!min || !max) {
+            DECREF(min);
+            DECREF(max);
+            return NULL;
+        }
+        stats = Hash_new(4);
+        Hash_Store_Str(stats, "min", 3, min);
+        Hash_Store_Str(stats, "max", 3, max);
+        Hash_Store_Str(stats, "value_count", 11,
+                       (Obj*)Int32_new((int32_t)Obj_To_I64(value_count)));
+        Hash_Store_Str(stats, "doc_count", 9,
+                       (Obj*)Int32_new((int32_t)Obj_To_I64(doc_count)));
+        Hash_Store(ivars->field_stats, (Obj*)field, (Obj*)stats);
+    }
+
+    return stats;
+}
+
 
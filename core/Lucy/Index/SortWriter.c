@@ -36,7 +36,7 @@
 #include "Lucy/Util/MemoryPool.h"
 #include "Clownfish/Util/SortUtils.h"
 
-int32_t SortWriter_current_file_format = 3;
+int32_t SortWriter_current_file_format = 4;
 
 static size_t default_mem_thresh = 0x400000; // 4 MB
 
@@ -59,6 +59,7 @@ SortWriter_init(SortWriter *self, Schema *schema, Snapshot *snapshot,
     ivars->counts          = Hash_new(0);
     ivars->null_ords       = Hash_new(0);
     ivars->ord_widths      = Hash_new(0);
+    ivars->stats           = Hash_new(0);
     ivars->temp_ord_out    = NULL;
     ivars->temp_ix_out     = NULL;
     ivars->temp_dat_out    = NULL;
@@ -76,6 +77,7 @@ SortWriter_destroy(SortWriter *self) {
     DECREF(ivars->counts);
     DECREF(ivars->null_ords);
     DECREF(ivars->ord_widths);
+    DECREF(ivars->stats);
     DECREF(ivars->temp_ord_out);
     DECREF(ivars->temp_ix_out);
     DECREF(ivars->temp_dat_out);
@@ -230,6 +232,10 @@ SortWriter_finish(SortWriter *self) {
             int32_t ord_width = SortFieldWriter_Get_Ord_Width(field_writer);
             Hash_Store(ivars->ord_widths, (Obj*)field,
                        (Obj*)CB_newf("%i32", ord_width));
+            Hash *stats = SortFieldWriter_Stats(field_writer);
+            if (stats) {
+                Hash_Store(ivars->stats, (Obj*)field, (Obj*)stats);
+            }
         }
 
         DECREF(field_writer);
@@ -259,6 +265,7 @@ SortWriter_metadata(SortWriter *self) {
     Hash_Store_Str(metadata, "counts", 6, INCREF(ivars->counts));
     Hash_Store_Str(metadata, "null_ords", 9, INCREF(ivars->null_ords));
     Hash_Store_Str(metadata, "ord_widths", 10, INCREF(ivars->ord_widths));
+    Hash_Store_Str(metadata, "stats", 5, INCREF(ivars->stats));
     return metadata;
 }
 
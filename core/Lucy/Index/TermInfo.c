@@ -31,6 +31,7 @@ TInfo_init(TermInfo *self, int32_t doc_freq) {
     TermInfoIVARS *const ivars = TInfo_IVARS(self);
     ivars->doc_freq      = doc_freq;
     ivars->post_filepos  = 0;
+    ivars->prox_filepos  = 0;
     ivars->skip_filepos  = 0;
     ivars->lex_filepos   = 0;
     return self;
@@ -42,6 +43,7 @@ TInfo_clone(TermInfo *self) {
     TermInfo *twin = TInfo_new(ivars->doc_freq);
     TermInfoIVARS *const twin_ivars = TInfo_IVARS(twin);
     twin_ivars->post_filepos = ivars->post_filepos;
+    twin_ivars->prox_filepos = ivars->prox_filepos;
     twin_ivars->skip_filepos = ivars->skip_filepos;
     twin_ivars->lex_filepos  = ivars->lex_filepos;
     return twin;
@@ -62,6 +64,11 @@ TInfo_get_post_filepos(TermInfo *self) {
     return TInfo_IVARS(self)->post_filepos;
 }
 
+int64_t
+TInfo_get_prox_filepos(TermInfo *self) {
+    return TInfo_IVARS(self)->prox_filepos;
+}
+
 int64_t
 TInfo_get_skip_filepos(TermInfo *self) {
     return TInfo_IVARS(self)->skip_filepos;
@@ -82,6 +89,11 @@ TInfo_set_post_filepos(TermInfo *self, int64_t filepos) {
     TInfo_IVARS(self)->post_filepos = filepos;
 }
 
+void
+TInfo_set_prox_filepos(TermInfo *self, int64_t filepos) {
+    TInfo_IVARS(self)->prox_filepos = filepos;
+}
+
 void
 TInfo_set_skip_filepos(TermInfo *self, int64_t filepos) {
     TInfo_IVARS(self)->skip_filepos = filepos;
@@ -95,9 +107,10 @@ TInfo_to_string(TermInfo *self) {
     return CB_newf(
                "doc freq:      %i32\n"
                "post filepos:  %i64\n"
+               "prox filepos:  %i64\n"
                "skip filepos:  %i64\n"
                "index filepos: %i64",
-               ivars->doc_freq, ivars->post_filepos,
+               ivars->doc_freq, ivars->post_filepos, ivars->prox_filepos,
                ivars->skip_filepos, ivars->lex_filepos
            );
 }
@@ -109,6 +122,7 @@ TInfo_mimic(TermInfo *self, Obj *other) {
     TermInfoIVARS *const ovars = TInfo_IVARS((TermInfo*)other);
     ivars->doc_freq     = ovars->doc_freq;
     ivars->post_filepos = ovars->post_filepos;
+    ivars->prox_filepos = ovars->prox_filepos;
     ivars->skip_filepos = ovars->skip_filepos;
     ivars->lex_filepos  = ovars->lex_filepos;
 }
@@ -118,6 +132,7 @@ TInfo_reset(TermInfo *self) {
     TermInfoIVARS *const ivars = TInfo_IVARS(self);
     ivars->doc_freq      = 0;
     ivars->post_filepos  = 0;
+    ivars->prox_filepos  = 0;
     ivars->skip_filepos  = 0;
     ivars->lex_filepos   = 0;
 }
@@ -24,9 +24,54 @@
 // Shared subroutine for performing both OR and XOR ops.
 #define DO_OR 1
 #define DO_XOR 2
+#define DO_AND 3
+#define DO_AND_NOT 4
 static void
 S_do_or_or_xor(BitVector *self, const BitVector *other, int operation);
 
+// Combine <code>byte_size</code> bytes of <code>src</code> into
+// <code>dest</code>, 64 bits at a time.
+static void
+S_combine_bits(uint8_t *dest, const uint8_t *src, size_t byte_size,
+               int operation);
+
+// Gather up to <code>max</code> set bits at or above <code>tick</code>.
+static uint32_t
+S_next_hits(BitVectorIVARS *ivars, uint32_t tick, int32_t *hits,
+            uint32_t max);
+
+// Load the 8 bytes starting at <code>offset</code> as a word whose bit n
+// is bit n of those bytes.  Bytes past <code>byte_size</code> read as zero.
+static INLINE uint64_t
+SI_load_word(const uint8_t *bits, size_t offset, size_t byte_size) {
+    uint64_t word = 0;
+    if (offset + sizeof(uint64_t) <= byte_size) {
+        memcpy(&word, bits + offset, sizeof(uint64_t));
+    }
+    else {
+        memcpy(&word, bits + offset, byte_size - offset);
+    }
+#ifdef BIG_END
+    const uint8_t *bytes = (const uint8_t*)&word;
+    uint64_t swapped = 0;
+    for (int32_t i = 7; i >= 0; i--) { swapped = (swapped << 8) | bytes[i]; }
+    word = swapped;
+#endif
+    return word;
+}
+
+// Produce a flat copy of a BitVector which doesn't expose its raw bits.
+static BitVector*
+S_flatten(const BitVector *other);
+
+// Subclasses such as RoaringBitVector keep their bits somewhere other than a
+// flat byte array.
+static INLINE bool
+SI_is_flat(const BitVector *bit_vec) {
+    const BitVectorIVARS *const ivars = BitVec_IVARS((BitVector*)bit_vec);
+    return ivars->bits != NULL || ivars->cap == 0;
+}
+
 // Number of 1 bits given a u8 value.
 static const uint32_t BYTE_COUNTS[256] = {
     0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
@@ -110,6 +155,17 @@ BitVec_mimic(BitVector *self, Obj *other) {
     CERTIFY(other, BITVECTOR);
     BitVectorIVARS *const ivars = BitVec_IVARS(self);
     BitVectorIVARS *const ovars = BitVec_IVARS((BitVector*)other);
+    if (!SI_is_flat((BitVector*)other)) {
+        BitVec_Clear_All(self);
+        BitVec_Grow(self, ovars->cap - 1);
+        for (int32_t tick = BitVec_Next_Hit((BitVector*)other, 0);
+             tick != -1;
+             tick = BitVec_Next_Hit((BitVector*)other, tick + 1)
+            ) {
+            NumUtil_u1set(ivars->bits, tick);
+        }
+        return;
+    }
     const uint32_t my_byte_size = (uint32_t)ceil(ivars->cap / 8.0);
     const uint32_t other_byte_size = (uint32_t)ceil(ovars->cap / 8.0);
     if (my_byte_size > other_byte_size) {
@@ -171,71 +227,123 @@ BitVec_get(BitVector *self, uint32_t tick) {
     return NumUtil_u1get(ivars->bits, tick);
 }
 
-static int32_t
-S_first_bit_in_nonzero_byte(uint8_t num) {
-    int32_t first_bit = 0;
-    if ((num & 0xF) == 0) { first_bit += 4; num >>= 4; }
-    if ((num & 0x3) == 0) { first_bit += 2; num >>= 2; }
-    if ((num & 0x1) == 0) { first_bit += 1; }
-    return first_bit;
+static uint32_t
+S_next_hits(BitVectorIVARS *ivars, uint32_t tick, int32_t *hits,
+            uint32_t max) {
+    const size_t byte_size = (size_t)ceil(ivars->cap / 8.0);
+    size_t       offset    = (tick >> 6) * sizeof(uint64_t);
+    uint32_t     num_hits  = 0;
+
+    if (tick >= ivars->cap || max == 0) { return 0; }
+
+    // Mask off the bits below tick in the first word.
+    uint64_t word = SI_load_word(ivars->bits, offset, byte_size)
+                    & (UINT64_MAX << (tick & 0x3F));
+    while (1) {
+        while (word) {
+            const uint32_t hit = (uint32_t)(offset * 8) + BitVec_ctz64(word);
+            if (hit >= ivars->cap) { return num_hits; }
+            hits[num_hits++] = (int32_t)hit;
+            if (num_hits == max) { return num_hits; }
+            word &= word - 1;
+        }
+        offset += sizeof(uint64_t);
+        if (offset >= byte_size) { break; }
+        word = SI_load_word(ivars->bits, offset, byte_size);
+    }
+
+    return num_hits;
 }
 
 int32_t
 BitVec_next_hit(BitVector *self, uint32_t tick) {
-    BitVectorIVARS *const ivars = BitVec_IVARS(self);
-    size_t byte_size = (size_t)ceil(ivars->cap / 8.0);
-    uint8_t *const limit = ivars->bits + byte_size;
-    uint8_t *ptr = ivars->bits + (tick >> 3);
+    int32_t hit;
+    return S_next_hits(BitVec_IVARS(self), tick, &hit, 1) ? hit : -1;
+}
 
-    if (ptr >= limit) {
-        return -1;
-    }
-    else if (*ptr != 0) {
-        // Special case the first byte.
-        const int32_t base = (ptr - ivars->bits) * 8;
-        const int32_t min_sub_tick = tick & 0x7;
-        unsigned int byte = *ptr >> min_sub_tick;
-        if (byte) {
-            const int32_t candidate 
-                = base + min_sub_tick + S_first_bit_in_nonzero_byte(byte);
-            return candidate < (int32_t)ivars->cap ? candidate : -1;
-        }
-    }
+uint32_t
+BitVec_next_hits(BitVector *self, uint32_t tick, int32_t *hits,
+                 uint32_t max) {
+    return S_next_hits(BitVec_IVARS(self), tick, hits, max);
+}
 
-    for (ptr++ ; ptr < limit; ptr++) {
-        if (*ptr != 0) {
-            // There's a non-zero bit in this byte.
-            const int32_t base = (ptr - ivars->bits) * 8;
-            const int32_t candidate = base + S_first_bit_in_nonzero_byte(*ptr);
-            return candidate < (int32_t)ivars->cap ? candidate : -1;
-        }
+static void
+S_combine_bits(uint8_t *dest, const uint8_t *src, size_t byte_size,
+               int operation) {
+    const size_t num_words = byte_size / sizeof(uint64_t);
+    size_t i = 0;
+
+    // Bitwise ops don't care about byte order, so whole words can be
+    // combined without reinterpreting them.  These simple loops are left
+    // for the compiler to vectorize.
+    switch (operation) {
+        case DO_AND:
+            for (; i < num_words * sizeof(uint64_t); i += sizeof(uint64_t)) {
+                uint64_t a, b;
+                memcpy(&a, dest + i, sizeof(uint64_t));
+                memcpy(&b, src + i, sizeof(uint64_t));
+                a &= b;
+                memcpy(dest + i, &a, sizeof(uint64_t));
+            }
+            for (; i < byte_size; i++) { dest[i] &= src[i]; }
+            break;
+        case DO_OR:
+            for (; i < num_words * sizeof(uint64_t); i += sizeof(uint64_t)) {
+                uint64_t a, b;
+                memcpy(&a, dest + i, sizeof(uint64_t));
+                memcpy(&b, src + i, sizeof(uint64_t));
+                a |= b;
+                memcpy(dest + i, &a, sizeof(uint64_t));
+            }
+            for (; i < byte_size; i++) { dest[i] |= src[i]; }
+            break;
+        case DO_XOR:
+            for (; i < num_words * sizeof(uint64_t); i += sizeof(uint64_t)) {
+                uint64_t a, b;
+                memcpy(&a, dest + i, sizeof(uint64_t));
+                memcpy(&b, src + i, sizeof(uint64_t));
+                a ^= b;
+                memcpy(dest + i, &a, sizeof(uint64_t));
+            }
+            for (; i < byte_size; i++) { dest[i] ^= src[i]; }
+            break;
+        case DO_AND_NOT:
+            for (; i < num_words * sizeof(uint64_t); i += sizeof(uint64_t)) {
+                uint64_t a, b;
+                memcpy(&a, dest + i, sizeof(uint64_t));
+                memcpy(&b, src + i, sizeof(uint64_t));
+                a &= ~b;
+                memcpy(dest + i, &a, sizeof(uint64_t));
+            }
+            for (; i < byte_size; i++) { dest[i] &= ~src[i]; }
+            break;
+        default:
+            THROW(ERR, "Unrecognized operation: %i32", (int32_t)operation);
     }
-
-    return -1;
 }
 
 void
 BitVec_and(BitVector *self, const BitVector *other) {
+    if (!SI_is_flat(other)) {
+        BitVector *flat = S_flatten(other);
+        BitVec_And(self, flat);
+        DECREF(flat);
+        return;
+    }
     BitVectorIVARS *const ivars = BitVec_IVARS(self);
     const BitVectorIVARS *const ovars = BitVec_IVARS((BitVector*)other);
-    uint8_t *bits_a = ivars->bits;
-    uint8_t *bits_b = ovars->bits;
     const uint32_t min_cap = ivars->cap < ovars->cap
                              ? ivars->cap
                              : ovars->cap;
     const size_t byte_size = (size_t)ceil(min_cap / 8.0);
-    uint8_t *const limit = bits_a + byte_size;
 
     // Intersection.
-    while (bits_a < limit) {
-        *bits_a &= *bits_b;
-        bits_a++, bits_b++;
-    }
+    S_combine_bits(ivars->bits, ovars->bits, byte_size, DO_AND);
 
     // Set all remaining to zero.
     if (ivars->cap > min_cap) {
         const size_t self_byte_size = (size_t)ceil(ivars->cap / 8.0);
-        memset(bits_a, 0, self_byte_size - byte_size);
+        memset(ivars->bits + byte_size, 0, self_byte_size - byte_size);
     }
 }
 
@@ -251,12 +359,16 @@ BitVec_xor(BitVector *self, const BitVector *other) {
 
 static void
 S_do_or_or_xor(BitVector *self, const BitVector *other, int operation) {
+    if (!SI_is_flat(other)) {
+        BitVector *flat = S_flatten(other);
+        S_do_or_or_xor(self, flat, operation);
+        DECREF(flat);
+        return;
+    }
     BitVectorIVARS *const ivars = BitVec_IVARS(self);
     const BitVectorIVARS *const ovars = BitVec_IVARS((BitVector*)other);
-    uint8_t *bits_a, *bits_b;
     uint32_t max_cap, min_cap;
-    uint8_t *limit;
-    double byte_size;
+    size_t byte_size;
 
     // Sort out what the minimum and maximum caps are.
     if (ivars->cap < ovars->cap) {
@@ -268,55 +380,45 @@ S_do_or_or_xor(BitVector *self, const BitVector *other, int operation) {
         min_cap = ovars->cap;
     }
 
-    // Grow self if smaller than other, then calc pointers.
+    // Grow self if smaller than other.
     if (max_cap > ivars->cap) { BitVec_Grow(self, max_cap); }
-    bits_a        = ivars->bits;
-    bits_b        = ovars->bits;
-    byte_size     = ceil(min_cap / 8.0);
-    limit         = ivars->bits + (size_t)byte_size;
+    byte_size = (size_t)ceil(min_cap / 8.0);
 
     // Perform union of common bits.
-    if (operation == DO_OR) {
-        while (bits_a < limit) {
-            *bits_a |= *bits_b;
-            bits_a++, bits_b++;
-        }
-    }
-    else if (operation == DO_XOR) {
-        while (bits_a < limit) {
-            *bits_a ^= *bits_b;
-            bits_a++, bits_b++;
-        }
-    }
-    else {
-        THROW(ERR, "Unrecognized operation: %i32", (int32_t)operation);
-    }
+    S_combine_bits(ivars->bits, ovars->bits, byte_size, operation);
 
     // Copy remaining bits if other is bigger than self.
     if (ovars->cap > min_cap) {
-        const double other_byte_size = ceil(ovars->cap / 8.0);
-        const size_t bytes_to_copy = (size_t)(other_byte_size - byte_size);
-        memcpy(bits_a, bits_b, bytes_to_copy);
+        const size_t other_byte_size = (size_t)ceil(ovars->cap / 8.0);
+        memcpy(ivars->bits + byte_size, ovars->bits + byte_size,
+               other_byte_size - byte_size);
     }
 }
 
 void
 BitVec_and_not(BitVector *self, const BitVector *other) {
+    if (!SI_is_flat(other)) {
+        BitVector *flat = S_flatten(other);
+        BitVec_And_Not(self, flat);
+        DECREF(flat);
+        return;
+    }
     BitVectorIVARS *const ivars = BitVec_IVARS(self);
     const BitVectorIVARS *const ovars = BitVec_IVARS((BitVector*)other);
-    uint8_t *bits_a = ivars->bits;
-    uint8_t *bits_b = ovars->bits;
     const uint32_t min_cap = ivars->cap < ovars->cap
                              ? ivars->cap
                              : ovars->cap;
     const size_t byte_size = (size_t)ceil(min_cap / 8.0);
-    uint8_t *const limit = bits_a + byte_size;
 
     // Clear bits set in other.
-    while (bits_a < limit) {
-        *bits_a &= ~(*bits_b);
-        bits_a++, bits_b++;
-    }
+    S_combine_bits(ivars->bits, ovars->bits, byte_size, DO_AND_NOT);
+}
+
+static BitVector*
+S_flatten(const BitVector *other) {
+    BitVector *flat = BitVec_new(BitVec_IVARS((BitVector*)other)->cap);
+    BitVec_Mimic(flat, (Obj*)other);
+    return flat;
 }
 
 void
@@ -377,11 +479,17 @@ BitVec_count(BitVector *self) {
     BitVectorIVARS *const ivars = BitVec_IVARS(self);
     uint32_t count = 0;
     const size_t byte_size = (size_t)ceil(ivars->cap / 8.0);
-    uint8_t *ptr = ivars->bits;
-    uint8_t *const limit = ptr + byte_size;
-
-    for (; ptr < limit; ptr++) {
-        count += BYTE_COUNTS[*ptr];
+    const size_t word_bytes
+        = (byte_size / sizeof(uint64_t)) * sizeof(uint64_t);
+    size_t i = 0;
+
+    for (; i < word_bytes; i += sizeof(uint64_t)) {
+        uint64_t word;
+        memcpy(&word, ivars->bits + i, sizeof(uint64_t));
+        count += BitVec_popcount64(word);
+    }
+    for (; i < byte_size; i++) {
+        count += BYTE_COUNTS[ivars->bits[i]];
     }
 
     return count;
@@ -390,36 +498,12 @@ BitVec_count(BitVector *self) {
 I32Array*
 BitVec_to_array(BitVector *self) {
     BitVectorIVARS *const ivars = BitVec_IVARS(self);
-    uint32_t        count     = BitVec_Count(self);
-    uint32_t        num_left  = count;
-    const uint32_t  capacity  = ivars->cap;
-    uint32_t *const array     = (uint32_t*)CALLOCATE(count, sizeof(uint32_t));
-    const size_t    byte_size = (size_t)ceil(ivars->cap / 8.0);
-    uint8_t *const  bits      = ivars->bits;
-    uint8_t *const  limit     = bits + byte_size;
-    uint32_t        num       = 0;
-    uint32_t        i         = 0;
-
-    while (num_left) {
-        uint8_t *ptr = bits + (num >> 3);
-        while (ptr < limit && *ptr == 0) {
-            num += 8;
-            ptr++;
-        }
-        do {
-            if (BitVec_Get(self, num)) {
-                array[i++] = num;
-                if (--num_left == 0) {
-                    break;
-                }
-            }
-            if (num >= capacity) {
-                THROW(ERR, "Exceeded capacity: %u32 %u32", num, capacity);
-            }
-        } while (++num % 8);
+    uint32_t       count = BitVec_Count(self);
+    int32_t *const array = (int32_t*)MALLOCATE((count + 1) * sizeof(int32_t));
+    uint32_t       found = S_next_hits(ivars, 0, array, count);
+    if (found != count) {
+        FREEMEM(array);
+        THROW(ERR, "Expected %u32 hits, found %u32", count, found);
     }
-
-    return I32Arr_new_steal((int32_t*)array, count);
+    return I32Arr_new_steal(array, count);
 }
-
-
@@ -0,0 +1,171 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define C_LUCY_HYPERLOGLOG
+#include <math.h>
+#include <string.h>
+#include "Lucy/Util/ToolSet.h"
+
+#include "Lucy/Object/HyperLogLog.h"
+#include "Lucy/Store/InStream.h"
+#include "Lucy/Store/OutStream.h"
+
+#define MIN_PRECISION 4
+#define MAX_PRECISION 16
+
+HyperLogLog*
+HLL_new(uint32_t precision) {
+    HyperLogLog *self = (HyperLogLog*)VTable_Make_Obj(HYPERLOGLOG);
+    return HLL_init(self, precision);
+}
+
+HyperLogLog*
+HLL_init(HyperLogLog *self, uint32_t precision) {
+    HyperLogLogIVARS *const ivars = HLL_IVARS(self);
+    if (precision < MIN_PRECISION || precision > MAX_PRECISION) {
+        DECREF(self);
+        THROW(ERR, "HyperLogLog precision must be between %i32 and %i32: "
+              "%u32", (int32_t)MIN_PRECISION, (int32_t)MAX_PRECISION,
+              precision);
+    }
+    ivars->precision     = precision;
+    ivars->num_registers = 1 << precision;
+    ivars->registers
+        = (uint8_t*)CALLOCATE(ivars->num_registers, sizeof(uint8_t));
+    return self;
+}
+
+void
+HLL_destroy(HyperLogLog *self) {
+    FREEMEM(HLL_IVARS(self)->registers);
+    SUPER_DESTROY(self, HYPERLOGLOG);
+}
+
+uint64_t
+HLL_hash_bytes(const void *bytes, size_t size) {
+    // FNV-1a, followed by the MurmurHash3 finalizer so that the high bits,
+    // which choose the register, are well mixed.
+    const uint8_t *ptr  = (const uint8_t*)bytes;
+    uint64_t       hash = UINT64_C(0xcbf29ce484222325);
+    for (size_t i = 0; i < size; i++) {
+        hash ^= ptr[i];
+        hash *= UINT64_C(0x100000001b3);
+    }
+    hash ^= hash >> 33;
+    hash *= UINT64_C(0xff51afd7ed558ccd);
+    hash ^= hash >> 33;
+    hash *= UINT64_C(0xc4ceb9fe1a85ec53);
+    hash ^= hash >> 33;
+    return hash;
+}
+
+void
+HLL_add_hash(HyperLogLog *self, uint64_t hash) {
+    HyperLogLogIVARS *const ivars = HLL_IVARS(self);
+    const uint32_t precision = ivars->precision;
+    const uint32_t tick      = (uint32_t)(hash >> (64 - precision));
+    const uint8_t  max_rank  = (uint8_t)(64 - precision + 1);
+
+    // Rank is the 1-based position of the first set bit among the bits that
+    // didn't choose the register.
+    uint64_t rest = hash << precision;
+    uint8_t  rank = 1;
+    while (rank < max_rank && !(rest & UINT64_C(0x8000000000000000))) {
+        rest <<= 1;
+        rank++;
+    }
+    if (rank > ivars->registers[tick]) {
+        ivars->registers[tick] = rank;
+    }
+}
+
+void
+HLL_merge(HyperLogLog *self, HyperLogLog *other) {
+    HyperLogLogIVARS *const ivars = HLL_IVARS(self);
+    HyperLogLogIVARS *const ovars = HLL_IVARS(other);
+    if (ivars->precision != ovars->precision) {
+        THROW(ERR, "Can't merge HyperLogLog sketches with different "
+              "precisions: %u32 and %u32", ivars->precision,
+              ovars->precision);
+    }
+    for (uint32_t i = 0; i < ivars->num_registers; i++) {
+        if (ovars->registers[i] > ivars->registers[i]) {
+            ivars->registers[i] = ovars->registers[i];
+        }
+    }
+}
+
+uint64_t
+HLL_estimate(HyperLogLog *self) {
+    HyperLogLogIVARS *const ivars = HLL_IVARS(self);
+    const double m     = (double)ivars->num_registers;
+    double       sum   = 0.0;
+    uint32_t     zeros = 0;
+    for (uint32_t i = 0; i < ivars->num_registers; i++) {
+        sum += ldexp(1.0, -(int)ivars->registers[i]);
+        if (!ivars->registers[i]) { zeros++; }
+    }
+
+    double alpha;
+    switch (ivars->num_registers) {
+        case 16: alpha = 0.673; break;
+        case 32: alpha = 0.697; break;
+        case 64: alpha = 0.709; break;
+        default: alpha = 0.7213 / (1.0 + 1.079 / m);
+    }
+    double estimate = alpha * m * m / sum;
+
+    // Small cardinalities are estimated more accurately by linear counting
+    // of the empty registers.
+    if (estimate <= 2.5 * m && zeros) {
+        estimate = m * log(m / (double)zeros);
+    }
+    return (uint64_t)(estimate + 0.5);
+}
+
+uint32_t
+HLL_get_precision(HyperLogLog *self) {
+    return HLL_IVARS(self)->precision;
+}
+
+bool
+HLL_equals(HyperLogLog *self, Obj *other) {
+    if ((HyperLogLog*)other == self)          { return true; }
+    if (!Obj_Is_A(other, HYPERLOGLOG))        { return false; }
+    HyperLogLogIVARS *const ivars = HLL_IVARS(self);
+    HyperLogLogIVARS *const ovars = HLL_IVARS((HyperLogLog*)other);
+    if (ivars->precision != ovars->precision) { return false; }
+    return !memcmp(ivars->registers, ovars->registers, ivars->num_registers);
+}
+
+void
+HLL_serialize(HyperLogLog *self, OutStream *outstream) {
+    HyperLogLogIVARS *const ivars = HLL_IVARS(self);
+    OutStream_Write_C32(outstream, ivars->precision);
+    OutStream_Write_Bytes(outstream, ivars->registers, ivars->num_registers);
+}
+
+HyperLogLog*
+HLL_deserialize(HyperLogLog *self, InStream *instream) {
+    uint32_t precision = InStream_Read_C32(instream);
+    self = HLL_init(self, precision);
+    HyperLogLogIVARS *const ivars = HLL_IVARS(self);
+    InStream_Read_Bytes(instream, (char*)ivars->registers,
+                        ivars->num_registers);
+    return self;
+}
+
+
@@ -0,0 +1,1246 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#define C_LUCY_BITVECTOR
+#define C_LUCY_ROARINGBITVECTOR
+#include "Lucy/Util/ToolSet.h"
+
+#include "Lucy/Object/RoaringBitVector.h"
+#include "Lucy/Store/InStream.h"
+#include "Lucy/Store/OutStream.h"
+
+// Container types.
+#define ROAR_ARRAY  1
+#define ROAR_BITMAP 2
+#define ROAR_RUN    3
+
+// Chunks holding more set bits than this are stored as bitmaps.
+#define ROAR_ARRAY_MAX    4096
+#define ROAR_BITMAP_WORDS 1024
+#define ROAR_CHUNK_BITS   65536
+
+// Operations applied word-by-word.
+#define ROAR_AND     1
+#define ROAR_OR      2
+#define ROAR_XOR     3
+#define ROAR_AND_NOT 4
+
+// Binary search a sorted array of 16-bit values.  Return the index of
+// <code>value</code> if present, or -(insertion_point + 1) otherwise.
+static int32_t
+S_array_search(const uint16_t *array, uint32_t size, uint16_t value);
+
+// Return the index of the last run starting at or before <code>value</code>,
+// or -1.
+static int32_t
+S_run_search(const uint16_t *runs, uint32_t num_runs, uint16_t value);
+
+// Find the first set (or clear) bit at or after <code>pos</code> within a
+// chunk-sized bitmap.  Return ROAR_CHUNK_BITS if there is none.
+static uint32_t
+S_words_next_set(const uint64_t *words, uint32_t pos);
+static uint32_t
+S_words_next_clear(const uint64_t *words, uint32_t pos);
+
+// Set or flip all bits in the inclusive range [first, last].
+static void
+S_words_set_range(uint64_t *words, uint32_t first, uint32_t last);
+static void
+S_words_flip_range(uint64_t *words, uint32_t first, uint32_t last);
+
+static uint32_t
+S_words_count(const uint64_t *words);
+
+// Container primitives.
+static void
+S_cont_init(RoaringContainer *cont, uint16_t key);
+static void
+S_cont_copy(RoaringContainer *dest, const RoaringContainer *source);
+static bool
+S_cont_get(const RoaringContainer *cont, uint16_t low);
+static void
+S_cont_set(RoaringContainer *cont, uint16_t low);
+static void
+S_cont_clear(RoaringContainer *cont, uint16_t low);
+static int32_t
+S_cont_next(const RoaringContainer *cont, uint32_t low);
+static uint32_t
+S_cont_fill_hits(const RoaringContainer *cont, uint32_t low,
+                 int32_t *hits, uint32_t max);
+static void
+S_cont_fill_words(const RoaringContainer *cont, uint64_t *words);
+static void
+S_cont_to_bitmap(RoaringContainer *cont);
+static void
+S_cont_to_runs(RoaringContainer *cont);
+static void
+S_cont_unrun(RoaringContainer *cont);
+static void
+S_cont_normalize(RoaringContainer *cont);
+static uint32_t
+S_cont_count_runs(const RoaringContainer *cont);
+static void
+S_cont_op(RoaringContainer *cont, const RoaringContainer *other, int op);
+static void
+S_cont_op_words(RoaringContainer *cont, const uint64_t *words, int op);
+
+// Locate the container for <code>key</code>.  Return its index, or
+// -(insertion_point + 1) if there isn't one.
+static int32_t
+S_find_cont(RoaringBitVectorIVARS *ivars, uint16_t key);
+
+// Insert an empty container at <code>tick</code>.
+static RoaringContainer*
+S_insert_cont(RoaringBitVectorIVARS *ivars, uint32_t tick, uint16_t key);
+
+// Remove containers which have had all their bits cleared.
+static void
+S_prune(RoaringBitVectorIVARS *ivars);
+
+// Populate from the flat bytes of an ordinary BitVector.
+static void
+S_absorb_flat_bits(RoaringBitVector *self, const uint8_t *bits,
+                   uint32_t cap);
+
+// Perform a binary op against another BitVector.
+static void
+S_do_op(RoaringBitVector *self, const BitVector *other, int op);
+
+RoaringBitVector*
+RoarBitVec_new(uint32_t capacity) {
+    RoaringBitVector *self
+        = (RoaringBitVector*)VTable_Make_Obj(ROARINGBITVECTOR);
+    return RoarBitVec_init(self, capacity);
+}
+
+RoaringBitVector*
+RoarBitVec_init(RoaringBitVector *self, uint32_t capacity) {
+    BitVec_init((BitVector*)self, 0);
+    RoaringBitVectorIVARS *const ivars = RoarBitVec_IVARS(self);
+    ivars->cap       = capacity;
+    ivars->conts     = NULL;
+    ivars->num_conts = 0;
+    ivars->conts_cap = 0;
+    return self;
+}
+
+void
+RoarBitVec_destroy(RoaringBitVector *self) {
+    RoaringBitVectorIVARS *const ivars = RoarBitVec_IVARS(self);
+    RoarBitVec_Clear_All(self);
+    FREEMEM(ivars->conts);
+    SUPER_DESTROY(self, ROARINGBITVECTOR);
+}
+
+RoaringBitVector*
+RoarBitVec_clone(RoaringBitVector *self) {
+    RoaringBitVector *twin = RoarBitVec_new(0);
+    RoarBitVec_Mimic(twin, (Obj*)self);
+    return twin;
+}
+
+bool
+RoarBitVec_equals(RoaringBitVector *self, Obj *other) {
+    if ((RoaringBitVector*)other == self)    { return true; }
+    if (!Obj_Is_A(other, ROARINGBITVECTOR)) { return false; }
+    RoaringBitVectorIVARS *const ivars = RoarBitVec_IVARS(self);
+    RoaringBitVectorIVARS *const ovars
+        = RoarBitVec_IVARS((RoaringBitVector*)other);
+    if (ivars->num_conts != ovars->num_conts) { return false; }
+    for (uint32_t i = 0; i < ivars->num_conts; i++) {
+        RoaringContainer *a = ivars->conts + i;
+        RoaringContainer *b = ovars->conts + i;
+        if (a->key != b->key || a->card != b->card) { return false; }
+        uint32_t tick = 0;
+        while (tick < ROAR_CHUNK_BITS) {
+            int32_t hit_a = S_cont_next(a, tick);
+            int32_t hit_b = S_cont_next(b, tick);
+            if (hit_a != hit_b) { return false; }
+            if (hit_a == -1)    { break; }
+            tick = (uint32_t)hit_a + 1;
+        }
+    }
+    return true;
+}
+
+uint8_t*
+RoarBitVec_get_raw_bits(RoaringBitVector *self) {
+    UNUSED_VAR(self);
+    return NULL;
+}
+
+bool
+RoarBitVec_get(RoaringBitVector *self, uint32_t tick) {
+    RoaringBitVectorIVARS *const ivars = RoarBitVec_IVARS(self);
+    int32_t tick_of_cont = S_find_cont(ivars, (uint16_t)(tick >> 16));
+    if (tick >= ivars->cap || tick_of_cont < 0) { return false; }
+    return S_cont_get(ivars->conts + tick_of_cont, (uint16_t)(tick & 0xFFFF));
+}
+
+void
+RoarBitVec_set(RoaringBitVector *self, uint32_t tick) {
+    RoaringBitVectorIVARS *const ivars = RoarBitVec_IVARS(self);
+    const uint16_t key = (uint16_t)(tick >> 16);
+    int32_t tick_of_cont = S_find_cont(ivars, key);
+    RoaringContainer *cont = tick_of_cont >= 0
+                             ? ivars->conts + tick_of_cont
+                             : S_insert_cont(ivars, -tick_of_cont - 1, key);
+    S_cont_set(cont, (uint16_t)(tick & 0xFFFF));
+    if (tick >= ivars->cap) { ivars->cap = tick + 1; }
+}
+
+void
+RoarBitVec_clear(RoaringBitVector *self, uint32_t tick) {
+    RoaringBitVectorIVARS *const ivars = RoarBitVec_IVARS(self);
+    int32_t tick_of_cont = S_find_cont(ivars, (uint16_t)(tick >> 16));
+    if (tick_of_cont >= 0) {
+        RoaringContainer *cont = ivars->conts + tick_of_cont;
+        S_cont_clear(cont, (uint16_t)(tick & 0xFFFF));
+        if (!cont->card) { S_prune(ivars); }
+    }
+}
+
+void
+RoarBitVec_clear_all(RoaringBitVector *self) {
+    RoaringBitVectorIVARS *const ivars = RoarBitVec_IVARS(self);
+    for (uint32_t i = 0; i < ivars->num_conts; i++) {
+        FREEMEM(ivars->conts[i].data);
+    }
+    ivars->num_conts = 0;
+}
+
+void
+RoarBitVec_grow(RoaringBitVector *self, uint32_t capacity) {
+    RoaringBitVectorIVARS *const ivars = RoarBitVec_IVARS(self);
+    if (capacity > ivars->cap) { ivars->cap = capacity; }
+}
+
+void
+RoarBitVec_flip(RoaringBitVector *self, uint32_t tick) {
+    if (RoarBitVec_Get(self, tick)) { RoarBitVec_Clear(self, tick); }
+    else                            { RoarBitVec_Set(self, tick); }
+}
+
+void
+RoarBitVec_flip_block(RoaringBitVector *self, uint32_t offset,
+                      uint32_t length) {
+    RoaringBitVectorIVARS *const ivars = RoarBitVec_IVARS(self);
+    if (!length) { return; }
+    const uint32_t last      = offset + length - 1;
+    const uint32_t first_key = offset >> 16;
+    const uint32_t last_key  = last >> 16;
+
+    for (uint32_t key = first_key; key <= last_key; key++) {
+        const uint32_t lo = key == first_key ? offset & 0xFFFF : 0;
+        const uint32_t hi = key == last_key ? last & 0xFFFF : 0xFFFF;
+        int32_t tick_of_cont = S_find_cont(ivars, (uint16_t)key);
+        RoaringContainer *cont
+            = tick_of_cont >= 0
+              ? ivars->conts + tick_of_cont
+              : S_insert_cont(ivars, -tick_of_cont - 1, (uint16_t)key);
+        S_cont_to_bitmap(cont);
+        S_words_flip_range((uint64_t*)cont->data, lo, hi);
+        cont->card = S_words_count((uint64_t*)cont->data);
+        S_cont_normalize(cont);
+    }
+    S_prune(ivars);
+    if (last >= ivars->cap) { ivars->cap = last + 1; }
+}
+
+uint32_t
+RoarBitVec_count(RoaringBitVector *self) {
+    RoaringBitVectorIVARS *const ivars = RoarBitVec_IVARS(self);
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < ivars->num_conts; i++) {
+        count += ivars->conts[i].card;
+    }
+    return count;
+}
+
+int32_t
+RoarBitVec_next_hit(RoaringBitVector *self, uint32_t tick) {
+    RoaringBitVectorIVARS *const ivars = RoarBitVec_IVARS(self);
+    int32_t tick_of_cont = S_find_cont(ivars, (uint16_t)(tick >> 16));
+    if (tick_of_cont >= 0) {
+        RoaringContainer *cont = ivars->conts + tick_of_cont;
+        int32_t low = S_cont_next(cont, tick & 0xFFFF);
+        if (low != -1) { return (int32_t)(((uint32_t)cont->key << 16) | low); }
+        tick_of_cont++;
+    }
+    else {
+        tick_of_cont = -tick_of_cont - 1;
+    }
+    if ((uint32_t)tick_of_cont < ivars->num_conts) {
+        RoaringContainer *cont = ivars->conts + tick_of_cont;
+        int32_t low = S_cont_next(cont, 0);
+        return (int32_t)(((uint32_t)cont->key << 16) | low);
+    }
+    return -1;
+}
+
+uint32_t
+RoarBitVec_next_hits(RoaringBitVector *self, uint32_t tick, int32_t *hits,
+                     uint32_t max) {
+    RoaringBitVectorIVARS *const ivars = RoarBitVec_IVARS(self);
+    int32_t  tick_of_cont = S_find_cont(ivars, (uint16_t)(tick >> 16));
+    uint32_t low          = tick & 0xFFFF;
+    uint32_t num_hits     = 0;
+
+    if (tick_of_cont < 0) {
+        tick_of_cont = -tick_of_cont - 1;
+        low = 0;
+    }
+    for (uint32_t i = (uint32_t)tick_of_cont;
+         i < ivars->num_conts && num_hits < max;
+         i++, low = 0
+        ) {
+        num_hits += S_cont_fill_hits(ivars->conts + i, low, hits + num_hits,
+                                     max - num_hits);
+    }
+
+    return num_hits;
+}
+
+I32Array*
+RoarBitVec_to_array(RoaringBitVector *self) {
+    uint32_t count = RoarBitVec_Count(self);
+    int32_t *ints  = (int32_t*)MALLOCATE((count + 1) * sizeof(int32_t));
+    RoarBitVec_Next_Hits(self, 0, ints, count);
+    return I32Arr_new_steal(ints, count);
+}
+
+void
+RoarBitVec_mimic(RoaringBitVector *self, Obj *other) {
+    CERTIFY(other, BITVECTOR);
+    RoaringBitVectorIVARS *const ivars = RoarBitVec_IVARS(self);
+    if ((RoaringBitVector*)other == self) { return; }
+    RoarBitVec_Clear_All(self);
+    if (Obj_Is_A(other, ROARINGBITVECTOR)) {
+        RoaringBitVectorIVARS *const ovars
+            = RoarBitVec_IVARS((RoaringBitVector*)other);
+        if (ivars->conts_cap < ovars->num_conts) {
+            ivars->conts_cap = ovars->num_conts;
+            ivars->conts = (RoaringContainer*)REALLOCATE(
+                               ivars->conts,
+                               ivars->conts_cap * sizeof(RoaringContainer));
+        }
+        for (uint32_t i = 0; i < ovars->num_conts; i++) {
+            S_cont_copy(ivars->conts + i, ovars->conts + i);
+        }
+        ivars->num_conts = ovars->num_conts;
+        ivars->cap       = ovars->cap;
+    }
+    else {
+        BitVector *bit_vec = (BitVector*)other;
+        uint8_t   *bits    = BitVec_Get_Raw_Bits(bit_vec);
+        ivars->cap = BitVec_Get_Capacity(bit_vec);
+        if (bits) {
+            S_absorb_flat_bits(self, bits, ivars->cap);
+        }
+        else {
+            for (int32_t tick = BitVec_Next_Hit(bit_vec, 0);
+                 tick != -1;
+                 tick = BitVec_Next_Hit(bit_vec, tick + 1)
+                ) {
+                RoarBitVec_Set(self, tick);
+            }
+        }
+    }
+}
+
+void
+RoarBitVec_and(RoaringBitVector *self, const BitVector *other) {
+    S_do_op(self, other, ROAR_AND);
+}
+
+void
+RoarBitVec_or(RoaringBitVector *self, const BitVector *other) {
+    S_do_op(self, other, ROAR_OR);
+}
+
+void
+RoarBitVec_xor(RoaringBitVector *self, const BitVector *other) {
+    S_do_op(self, other, ROAR_XOR);
+}
+
+void
+RoarBitVec_and_not(RoaringBitVector *self, const BitVector *other) {
+    S_do_op(self, other, ROAR_AND_NOT);
+}
+
+static void
+S_do_op(RoaringBitVector *self, const BitVector *other, int op) {
+    RoaringBitVectorIVARS *const ivars = RoarBitVec_IVARS(self);
+    RoaringBitVector *roaring = NULL;
+
+    if (Obj_Is_A((Obj*)other, ROARINGBITVECTOR)) {
+        roaring = (RoaringBitVector*)INCREF(other);
+    }
+    else {
+        roaring = RoarBitVec_new(0);
+        RoarBitVec_Mimic(roaring, (Obj*)other);
+    }
+    RoaringBitVectorIVARS *const ovars = RoarBitVec_IVARS(roaring);
+
+    if (op == ROAR_AND || op == ROAR_AND_NOT) {
+        // Only containers already present in self can be affected.
+        for (uint32_t i = 0; i < ivars->num_conts; i++) {
+            RoaringContainer *cont = ivars->conts + i;
+            int32_t tick_of_other = S_find_cont(ovars, cont->key);
+            if (tick_of_other >= 0) {
+                S_cont_op(cont, ovars->conts + tick_of_other, op);
+            }
+            else if (op == ROAR_AND) {
+                FREEMEM(cont->data);
+                cont->data = NULL;
+                cont->card = 0;
+            }
+        }
+    }
+    else {
+        for (uint32_t i = 0; i < ovars->num_conts; i++) {
+            RoaringContainer *other_cont = ovars->conts + i;
+            int32_t tick_of_cont = S_find_cont(ivars, other_cont->key);
+            if (tick_of_cont >= 0) {
+                S_cont_op(ivars->conts + tick_of_cont, other_cont, op);
+            }
+            else {
+                RoaringContainer *cont
+                    = S_insert_cont(ivars, -tick_of_cont - 1,
+                                    other_cont->key);
+                FREEMEM(cont->data);
+                S_cont_copy(cont, other_cont);
+            }
+        }
+        if (ovars->cap > ivars->cap) { ivars->cap = ovars->cap; }
+    }
+
+    S_prune(ivars);
+    DECREF(roaring);
+}
+
+void
+RoarBitVec_run_optimize(RoaringBitVector *self) {
+    RoaringBitVectorIVARS *const ivars = RoarBitVec_IVARS(self);
+    for (uint32_t i = 0; i < ivars->num_conts; i++) {
+        RoaringContainer *cont = ivars->conts + i;
+        const uint32_t run_bytes = S_cont_count_runs(cont) * 2 * sizeof(uint16_t);
+        const uint32_t flat_bytes
+            = cont->card <= ROAR_ARRAY_MAX
+              ? cont->card * sizeof(uint16_t)
+              : ROAR_BITMAP_WORDS * sizeof(uint64_t);
+        if (run_bytes < flat_bytes) {
+            S_cont_to_runs(cont);
+        }
+        else {
+            S_cont_unrun(cont);
+        }
+    }
+}
+
+static uint32_t
+S_c32_size(uint32_t value) {
+    uint32_t size = 1;
+    while (value >= 0x80) {
+        value >>= 7;
+        size++;
+    }
+    return size;
+}
+
+uint64_t
+RoarBitVec_serialized_size(RoaringBitVector *self) {
+    RoaringBitVectorIVARS *const ivars = RoarBitVec_IVARS(self);
+    uint64_t size = S_c32_size(ivars->cap) + S_c32_size(ivars->num_conts);
+    for (uint32_t i = 0; i < ivars->num_conts; i++) {
+        RoaringContainer *cont = ivars->conts + i;
+        size += S_c32_size(cont->key) + 1 + S_c32_size(cont->card);
+        switch (cont->type) {
+            case ROAR_ARRAY:
+                size += cont->card * sizeof(uint16_t);
+                break;
+            case ROAR_BITMAP:
+                size += ROAR_BITMAP_WORDS * sizeof(uint64_t);
+                break;
+            case ROAR_RUN:
+                size += S_c32_size(cont->size)
+                        + cont->size * 2 * sizeof(uint16_t);
+                break;
+            default:
+                THROW(ERR, "Unexpected container type: %u32",
+                      (uint32_t)cont->type);
+        }
+    }
+    return size;
+}
+
+static void
+S_write_u16s(OutStream *outstream, const uint16_t *values, uint32_t count) {
+    char buf[256];
+    while (count) {
+        const uint32_t batch = count < 128 ? count : 128;
+        char *ptr = buf;
+        for (uint32_t i = 0; i < batch; i++) {
+            NumUtil_encode_bigend_u16(values[i], &ptr);
+            ptr += sizeof(uint16_t);
+        }
+        OutStream_Write_Bytes(outstream, buf, batch * sizeof(uint16_t));
+        values += batch;
+        count  -= batch;
+    }
+}
+
+static void
+S_read_u16s(InStream *instream, uint16_t *values, uint32_t count) {
+    char buf[256];
+    while (count) {
+        const uint32_t batch = count < 128 ? count : 128;
+        InStream_Read_Bytes(instream, buf, batch * sizeof(uint16_t));
+        for (uint32_t i = 0; i < batch; i++) {
+            values[i] = NumUtil_decode_bigend_u16(buf + i * sizeof(uint16_t));
+        }
+        values += batch;
+        count  -= batch;
+    }
+}
+
+void
+RoarBitVec_serialize(RoaringBitVector *self, OutStream *outstream) {
+    RoaringBitVectorIVARS *const ivars = RoarBitVec_IVARS(self);
+    OutStream_Write_C32(outstream, ivars->cap);
+    OutStream_Write_C32(outstream, ivars->num_conts);
+    for (uint32_t i = 0; i < ivars->num_conts; i++) {
+        RoaringContainer *cont = ivars->conts + i;
+        OutStream_Write_C32(outstream, cont->key);
+        OutStream_Write_U8(outstream, cont->type);
+        OutStream_Write_C32(outstream, cont->card);
+        switch (cont->type) {
+            case ROAR_ARRAY:
+                S_write_u16s(outstream, (uint16_t*)cont->data, cont->card);
+                break;
+            case ROAR_BITMAP: {
+                    uint64_t *words = (uint64_t*)cont->data;
+                    for (uint32_t j = 0; j < ROAR_BITMAP_WORDS; j++) {
+                        OutStream_Write_U64(outstream, words[j]);
+                    }
+                }
+                break;
+            case ROAR_RUN:
+                OutStream_Write_C32(outstream, cont->size);
+                S_write_u16s(outstream, (uint16_t*)cont->data,
+                             cont->size * 2);
+                break;
+            default:
+                THROW(ERR, "Unexpected container type: %u32",
+                      (uint32_t)cont->type);
+        }
+    }
+}
+
+RoaringBitVector*
+RoarBitVec_deserialize(RoaringBitVector *self, InStream *instream) {
+    self = self ? self : (RoaringBitVector*)VTable_Make_Obj(ROARINGBITVECTOR);
+    RoarBitVec_init(self, 0);
+    RoaringBitVectorIVARS *const ivars = RoarBitVec_IVARS(self);
+    const uint32_t cap       = InStream_Read_C32(instream);
+    const uint32_t num_conts = InStream_Read_C32(instream);
+
+    ivars->conts = (RoaringContainer*)MALLOCATE(
+                       (num_conts + 1) * sizeof(RoaringContainer));
+    ivars->conts_cap = num_conts + 1;
+    for (uint32_t i = 0; i < num_conts; i++) {
+        RoaringContainer *cont = ivars->conts + i;
+        cont->data = NULL;
+        cont->key  = (uint16_t)InStream_Read_C32(instream);
+        cont->type = InStream_Read_U8(instream);
+        cont->card = InStream_Read_C32(instream);
+        ivars->num_conts = i + 1;
+        switch (cont->type) {
+            case ROAR_ARRAY:
+                cont->size = cont->card;
+                cont->cap  = cont->card ? cont->card : 1;
+                cont->data = MALLOCATE(cont->cap * sizeof(uint16_t));
+                S_read_u16s(instream, (uint16_t*)cont->data, cont->card);
+                break;
+            case ROAR_BITMAP: {
+                    uint64_t *words = (uint64_t*)MALLOCATE(
+                                          ROAR_BITMAP_WORDS * sizeof(uint64_t));
+                    for (uint32_t j = 0; j < ROAR_BITMAP_WORDS; j++) {
+                        words[j] = InStream_Read_U64(instream);
+                    }
+                    cont->data = words;
+                    cont->size = cont->cap = ROAR_BITMAP_WORDS;
+                }
+                break;
+            case ROAR_RUN:
+                cont->size = InStream_Read_C32(instream);
+                cont->cap  = cont->size ? cont->size : 1;
+                cont->data = MALLOCATE(cont->cap * 2 * sizeof(uint16_t));
+                S_read_u16s(instream, (uint16_t*)cont->data, cont->size * 2);
+                break;
+            default:
+                THROW(ERR, "Unexpected container type in %o: %u32",
+                      InStream_Get_Filename(instream), (uint32_t)cont->type);
+        }
+    }
+    ivars->cap = cap;
+
+    return self;
+}
+
+/***************************************************************************/
+
+static int32_t
+S_find_cont(RoaringBitVectorIVARS *ivars, uint16_t key) {
+    int32_t lo = 0;
+    int32_t hi = (int32_t)ivars->num_conts - 1;
+    while (lo <= hi) {
+        const int32_t mid = (lo + hi) >> 1;
+        const uint16_t mid_key = ivars->conts[mid].key;
+        if (mid_key < key)      { lo = mid + 1; }
+        else if (mid_key > key) { hi = mid - 1; }
+        else                    { return mid; }
+    }
+    return -(lo + 1);
+}
+
+static RoaringContainer*
+S_insert_cont(RoaringBitVectorIVARS *ivars, uint32_t tick, uint16_t key) {
+    if (ivars->num_conts == ivars->conts_cap) {
+        ivars->conts_cap = (uint32_t)Memory_oversize(ivars->num_conts + 1,
+                                                     sizeof(RoaringContainer));
+        ivars->conts = (RoaringContainer*)REALLOCATE(
+                           ivars->conts,
+                           ivars->conts_cap * sizeof(RoaringContainer));
+    }
+    memmove(ivars->conts + tick + 1, ivars->conts + tick,
+            (ivars->num_conts - tick) * sizeof(RoaringContainer));
+    ivars->num_conts++;
+    S_cont_init(ivars->conts + tick, key);
+    return ivars->conts + tick;
+}
+
+static void
+S_prune(RoaringBitVectorIVARS *ivars) {
+    uint32_t num_kept = 0;
+    for (uint32_t i = 0; i < ivars->num_conts; i++) {
+        RoaringContainer *cont = ivars->conts + i;
+        if (cont->card) {
+            ivars->conts[num_kept++] = *cont;
+        }
+        else {
+            FREEMEM(cont->data);
+        }
+    }
+    ivars->num_conts = num_kept;
+}
+
+static void
+S_absorb_flat_bits(RoaringBitVector *self, const uint8_t *bits,
+                   uint32_t cap) {
+    RoaringBitVectorIVARS *const ivars = RoarBitVec_IVARS(self);
+    const uint32_t byte_size  = (cap + 7) / 8;
+    const uint32_t chunk_size = ROAR_CHUNK_BITS / 8;
+    uint64_t words[ROAR_BITMAP_WORDS];
+
+    for (uint32_t start = 0, key = 0; start < byte_size;
+         start += chunk_size, key++
+        ) {
+        const uint32_t len = byte_size - start < chunk_size
+                             ? byte_size - start
+                             : chunk_size;
+        memset(words, 0, sizeof(words));
+        memcpy(words, bits + start, len);
+#ifdef BIG_END
+        for (uint32_t i = 0; i < ROAR_BITMAP_WORDS; i++) {
+            uint8_t *bytes = (uint8_t*)(words + i);
+            uint64_t word  = 0;
+            for (int32_t j = 7; j >= 0; j--) { word = (word << 8) | bytes[j]; }
+            words[i] = word;
+        }
+#endif
+        const uint32_t card = S_words_count(words);
+        if (card) {
+            RoaringContainer *cont
+                = S_insert_cont(ivars, ivars->num_conts, (uint16_t)key);
+            FREEMEM(cont->data);
+            cont->data = MALLOCATE(sizeof(words));
+            memcpy(cont->data, words, sizeof(words));
+            cont->type = ROAR_BITMAP;
+            cont->card = card;
+            cont->size = cont->cap = ROAR_BITMAP_WORDS;
+            S_cont_normalize(cont);
+        }
+    }
+}
+
+/***************************************************************************/
+
+static int32_t
+S_array_search(const uint16_t *array, uint32_t size, uint16_t value) {
+    int32_t lo = 0;
+    int32_t hi = (int32_t)size - 1;
+    while (lo <= hi) {
+        const int32_t mid = (lo + hi) >> 1;
+        if (array[mid] < value)      { lo = mid + 1; }
+        else if (array[mid] > value) { hi = mid - 1; }
+        else                         { return mid; }
+    }
+    return -(lo + 1);
+}
+
+static int32_t
+S_run_search(const uint16_t *runs, uint32_t num_runs, uint16_t value) {
+    int32_t lo    = 0;
+    int32_t hi    = (int32_t)num_runs - 1;
+    int32_t found = -1;
+    while (lo <= hi) {
+        const int32_t mid = (lo + hi) >> 1;
+        if (runs[mid * 2] <= value) {
+            found = mid;
+            lo = mid + 1;
+        }
+        else {
+            hi = mid - 1;
+        }
+    }
+    return found;
+}
+
+static uint32_t
+S_words_next_set(const uint64_t *words, uint32_t pos) {
+    if (pos >= ROAR_CHUNK_BITS) { return ROAR_CHUNK_BITS; }
+    uint32_t tick = pos >> 6;
+    uint64_t word = words[tick] & (~UINT64_C(0) << (pos & 63));
+    while (1) {
+        if (word) { return (tick << 6) + BitVec_ctz64(word); }
+        if (++tick >= ROAR_BITMAP_WORDS) { return ROAR_CHUNK_BITS; }
+        word = words[tick];
+    }
+}
+
+static uint32_t
+S_words_next_clear(const uint64_t *words, uint32_t pos) {
+    if (pos >= ROAR_CHUNK_BITS) { return ROAR_CHUNK_BITS; }
+    uint32_t tick = pos >> 6;
+    uint64_t word = ~words[tick] & (~UINT64_C(0) << (pos & 63));
+    while (1) {
+        if (word) { return (tick << 6) + BitVec_ctz64(word); }
+        if (++tick >= ROAR_BITMAP_WORDS) { return ROAR_CHUNK_BITS; }
+        word = ~words[tick];
+    }
+}
+
+static void
+S_words_set_range(uint64_t *words, uint32_t first, uint32_t last) {
+    const uint32_t first_word = first >> 6;
+    const uint32_t last_word  = last >> 6;
+    const uint64_t first_mask = ~UINT64_C(0) << (first & 63);
+    const uint64_t last_mask  = ~UINT64_C(0) >> (63 - (last & 63));
+    if (first_word == last_word) {
+        words[first_word] |= first_mask & last_mask;
+        return;
+    }
+    words[first_word] |= first_mask;
+    for (uint32_t i = first_word + 1; i < last_word; i++) {
+        words[i] = ~UINT64_C(0);
+    }
+    words[last_word] |= last_mask;
+}
+
+static void
+S_words_flip_range(uint64_t *words, uint32_t first, uint32_t last) {
+    const uint32_t first_word = first >> 6;
+    const uint32_t last_word  = last >> 6;
+    const uint64_t first_mask = ~UINT64_C(0) << (first & 63);
+    const uint64_t last_mask  = ~UINT64_C(0) >> (63 - (last & 63));
+    if (first_word == last_word) {
+        words[first_word] ^= first_mask & last_mask;
+        return;
+    }
+    words[first_word] ^= first_mask;
+    for (uint32_t i = first_word + 1; i < last_word; i++) {
+        words[i] = ~words[i];
+    }
+    words[last_word] ^= last_mask;
+}
+
+static uint32_t
+S_words_count(const uint64_t *words) {
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < ROAR_BITMAP_WORDS; i++) {
+        count += BitVec_popcount64(words[i]);
+    }
+    return count;
+}
+
+/***************************************************************************/
+
+static void
+S_cont_init(RoaringContainer *cont, uint16_t key) {
+    cont->key  = key;
+    cont->type = ROAR_ARRAY;
+    cont->card = 0;
+    cont->size = 0;
+    cont->cap  = 4;
+    cont->data = MALLOCATE(cont->cap * sizeof(uint16_t));
+}
+
+static void
+S_cont_copy(RoaringContainer *dest, const RoaringContainer *source) {
+    size_t elem_size = source->type == ROAR_ARRAY  ? sizeof(uint16_t)
+                       : source->type == ROAR_RUN  ? 2 * sizeof(uint16_t)
+                       : sizeof(uint64_t);
+    *dest = *source;
+    dest->data = MALLOCATE(source->cap * elem_size);
+    memcpy(dest->data, source->data, source->size * elem_size);
+}
+
+static bool
+S_cont_get(const RoaringContainer *cont, uint16_t low) {
+    switch (cont->type) {
+        case ROAR_ARRAY:
+            return S_array_search((uint16_t*)cont->data, cont->card, low) >= 0;
+        case ROAR_BITMAP: {
+                const uint64_t *words = (uint64_t*)cont->data;
+                return (words[low >> 6] >> (low & 63)) & 1;
+            }
+        case ROAR_RUN: {
+                const uint16_t *runs = (uint16_t*)cont->data;
+                int32_t tick = S_run_search(runs, cont->size, low);
+                return tick >= 0 && runs[tick * 2 + 1] >= low;
+            }
+        default:
+            THROW(ERR, "Unexpected container type: %u32",
+                  (uint32_t)cont->type);
+            UNREACHABLE_RETURN(bool);
+    }
+}
+
+static void
+S_cont_set(RoaringContainer *cont, uint16_t low) {
+    if (cont->type == ROAR_RUN) {
+        if (S_cont_get(cont, low)) { return; }
+        S_cont_unrun(cont);
+    }
+    if (cont->type == ROAR_ARRAY) {
+        uint16_t *array = (uint16_t*)cont->data;
+        int32_t tick = S_array_search(array, cont->card, low);
+        if (tick >= 0) { return; }
+        tick = -tick - 1;
+        if (cont->card == cont->cap) {
+            cont->cap = cont->cap * 2 < ROAR_ARRAY_MAX + 1
+                        ? cont->cap * 2
+                        : ROAR_ARRAY_MAX + 1;
+            cont->data = REALLOCATE(cont->data, cont->cap * sizeof(uint16_t));
+            array = (uint16_t*)cont->data;
+        }
+        memmove(array + tick + 1, array + tick,
+                (cont->card - tick) * sizeof(uint16_t));
+        array[tick] = low;
+        cont->card++;
+        cont->size = cont->card;
+        S_cont_normalize(cont);
+    }
+    else {
+        uint64_t *words = (uint64_t*)cont->data;
+        const uint64_t mask = UINT64_C(1) << (low & 63);
+        if (!(words[low >> 6] & mask)) {
+            words[low >> 6] |= mask;
+            cont->card++;
+        }
+    }
+}
+
+static void
+S_cont_clear(RoaringContainer *cont, uint16_t low) {
+    if (cont->type == ROAR_RUN) {
+        if (!S_cont_get(cont, low)) { return; }
+        S_cont_unrun(cont);
+    }
+    if (cont->type == ROAR_ARRAY) {
+        uint16_t *array = (uint16_t*)cont->data;
+        int32_t tick = S_array_search(array, cont->card, low);
+        if (tick < 0) { return; }
+        memmove(array + tick, array + tick + 1,
+                (cont->card - tick - 1) * sizeof(uint16_t));
+        cont->card--;
+        cont->size = cont->card;
+    }
+    else {
+        uint64_t *words = (uint64_t*)cont->data;
+        const uint64_t mask = UINT64_C(1) << (low & 63);
+        if (words[low >> 6] & mask) {
+            words[low >> 6] &= ~mask;
+            cont->card--;
+            S_cont_normalize(cont);
+        }
+    }
+}
+
+static int32_t
+S_cont_next(const RoaringContainer *cont, uint32_t low) {
+    switch (cont->type) {
+        case ROAR_ARRAY: {
+                const uint16_t *array = (uint16_t*)cont->data;
+                int32_t tick = S_array_search(array, cont->card,
+                                              (uint16_t)low);
+                if (tick < 0) { tick = -tick - 1; }
+                return (uint32_t)tick < cont->card ? array[tick] : -1;
+            }
+        case ROAR_BITMAP: {
+                uint32_t hit = S_words_next_set((uint64_t*)cont->data, low);
+                return hit < ROAR_CHUNK_BITS ? (int32_t)hit : -1;
+            }
+        case ROAR_RUN: {
+                const uint16_t *runs = (uint16_t*)cont->data;
+                int32_t tick = S_run_search(runs, cont->size, (uint16_t)low);
+                if (tick >= 0 && runs[tick * 2 + 1] >= low) {
+                    return (int32_t)low;
+                }
+                tick++;
+                return (uint32_t)tick < cont->size ? runs[tick * 2] : -1;
+            }
+        default:
+            THROW(ERR, "Unexpected container type: %u32",
+                  (uint32_t)cont->type);
+            UNREACHABLE_RETURN(int32_t);
+    }
+}
+
+static uint32_t
+S_cont_fill_hits(const RoaringContainer *cont, uint32_t low, int32_t *hits,
+                 uint32_t max) {
+    const int32_t base = (int32_t)((uint32_t)cont->key << 16);
+    uint32_t num_hits = 0;
+
+    switch (cont->type) {
+        case ROAR_ARRAY: {
+                const uint16_t *array = (uint16_t*)cont->data;
+                int32_t tick = low
+                               ? S_array_search(array, cont->card,
+                                                (uint16_t)low)
+                               : 0;
+                if (tick < 0) { tick = -tick - 1; }
+                for (uint32_t i = (uint32_t)tick;
+                     i < cont->card && num_hits < max;
+                     i++
+                    ) {
+                    hits[num_hits++] = base | array[i];
+                }
+            }
+            break;
+        case ROAR_BITMAP: {
+                const uint64_t *words = (uint64_t*)cont->data;
+                uint32_t tick = low >> 6;
+                uint64_t word = words[tick] & (~UINT64_C(0) << (low & 63));
+                while (num_hits < max) {
+                    while (word && num_hits < max) {
+                        hits[num_hits++]
+                            = base | (int32_t)((tick << 6) + BitVec_ctz64(word));
+                        word &= word - 1;
+                    }
+                    if (++tick >= ROAR_BITMAP_WORDS) { break; }
+                    word = words[tick];
+                }
+            }
+            break;
+        case ROAR_RUN: {
+                const uint16_t *runs = (uint16_t*)cont->data;
+                int32_t tick = S_run_search(runs, cont->size, (uint16_t)low);
+                if (tick < 0) { tick = 0; }
+                for (uint32_t i = (uint32_t)tick;
+                     i < cont->size && num_hits < max;
+                     i++
+                    ) {
+                    uint32_t value = runs[i * 2] > low ? runs[i * 2] : low;
+                    const uint32_t last = runs[i * 2 + 1];
+                    for (; value <= last && num_hits < max; value++) {
+                        hits[num_hits++] = base | (int32_t)value;
+                    }
+                }
+            }
+            break;
+        default:
+            THROW(ERR, "Unexpected container type: %u32",
+                  (uint32_t)cont->type);
+    }
+
+    return num_hits;
+}
+
+static void
+S_cont_fill_words(const RoaringContainer *cont, uint64_t *words) {
+    switch (cont->type) {
+        case ROAR_ARRAY: {
+                const uint16_t *array = (uint16_t*)cont->data;
+                for (uint32_t i = 0; i < cont->card; i++) {
+                    words[array[i] >> 6] |= UINT64_C(1) << (array[i] & 63);
+                }
+            }
+            break;
+        case ROAR_BITMAP:
+            memcpy(words, cont->data, ROAR_BITMAP_WORDS * sizeof(uint64_t));
+            break;
+        case ROAR_RUN: {
+                const uint16_t *runs = (uint16_t*)cont->data;
+                for (uint32_t i = 0; i < cont->size; i++) {
+                    S_words_set_range(words, runs[i * 2], runs[i * 2 + 1]);
+                }
+            }
+            break;
+        default:
+            THROW(ERR, "Unexpected container type: %u32",
+                  (uint32_t)cont->type);
+    }
+}
+
+static void
+S_cont_to_bitmap(RoaringContainer *cont) {
+    if (cont->type == ROAR_BITMAP) { return; }
+    uint64_t *words
+        = (uint64_t*)CALLOCATE(ROAR_BITMAP_WORDS, sizeof(uint64_t));
+    S_cont_fill_words(cont, words);
+    FREEMEM(cont->data);
+    cont->data = words;
+    cont->type = ROAR_BITMAP;
+    cont->size = cont->cap = ROAR_BITMAP_WORDS;
+}
+
+static void
+S_bitmap_to_array(RoaringContainer *cont) {
+    const uint64_t *words = (uint64_t*)cont->data;
+    const uint32_t  cap   = cont->card ? cont->card : 1;
+    uint16_t       *array = (uint16_t*)MALLOCATE(cap * sizeof(uint16_t));
+    uint32_t        num   = 0;
+    for (uint32_t i = 0; i < ROAR_BITMAP_WORDS; i++) {
+        uint64_t word = words[i];
+        while (word) {
+            array[num++] = (uint16_t)((i << 6) + BitVec_ctz64(word));
+            word &= word - 1;
+        }
+    }
+    FREEMEM(cont->data);
+    cont->data = array;
+    cont->type = ROAR_ARRAY;
+    cont->size = cont->card;
+    cont->cap  = cap;
+}
+
+static void
+S_cont_unrun(RoaringContainer *cont) {
+    if (cont->type != ROAR_RUN) { return; }
+    S_cont_to_bitmap(cont);
+    S_cont_normalize(cont);
+}
+
+static void
+S_cont_to_runs(RoaringContainer *cont) {
+    if (cont->type == ROAR_RUN) { return; }
+    const uint32_t num_runs = S_cont_count_runs(cont);
+    uint16_t *runs = (uint16_t*)MALLOCATE(
+                         (num_runs ? num_runs : 1) * 2 * sizeof(uint16_t));
+    uint32_t  num  = 0;
+
+    if (cont->type == ROAR_ARRAY) {
+        const uint16_t *array = (uint16_t*)cont->data;
+        for (uint32_t i = 0; i < cont->card; i++) {
+            if (num && runs[num * 2 - 1] + 1 == array[i]) {
+                runs[num * 2 - 1] = array[i];
+            }
+            else {
+                runs[num * 2]     = array[i];
+                runs[num * 2 + 1] = array[i];
+                num++;
+            }
+        }
+    }
+    else {
+        const uint64_t *words = (uint64_t*)cont->data;
+        uint32_t pos = S_words_next_set(words, 0);
+        while (pos < ROAR_CHUNK_BITS) {
+            uint32_t end = S_words_next_clear(words, pos);
+            runs[num * 2]     = (uint16_t)pos;
+            runs[num * 2 + 1] = (uint16_t)(end - 1);
+            num++;
+            pos = S_words_next_set(words, end);
+        }
+    }
+
+    FREEMEM(cont->data);
+    cont->data = runs;
+    cont->type = ROAR_RUN;
+    cont->size = num;
+    cont->cap  = num_runs ? num_runs : 1;
+}
+
+static void
+S_cont_normalize(RoaringContainer *cont) {
+    if (cont->type == ROAR_BITMAP && cont->card <= ROAR_ARRAY_MAX) {
+        S_bitmap_to_array(cont);
+    }
+    else if (cont->type == ROAR_ARRAY && cont->card > ROAR_ARRAY_MAX) {
+        S_cont_to_bitmap(cont);
+    }
+}
+
+static uint32_t
+S_cont_count_runs(const RoaringContainer *cont) {
+    uint32_t num_runs = 0;
+    switch (cont->type) {
+        case ROAR_ARRAY: {
+                const uint16_t *array = (uint16_t*)cont->data;
+                for (uint32_t i = 0; i < cont->card; i++) {
+                    if (i == 0 || array[i - 1] + 1 != array[i]) { num_runs++; }
+                }
+            }
+            break;
+        case ROAR_BITMAP: {
+                // Count the set bits whose predecessor is clear.
+                const uint64_t *words = (uint64_t*)cont->data;
+                uint64_t carry = 0;
+                for (uint32_t i = 0; i < ROAR_BITMAP_WORDS; i++) {
+                    const uint64_t word = words[i];
+                    num_runs += BitVec_popcount64(word & ~((word << 1) | carry));
+                    carry = word >> 63;
+                }
+            }
+            break;
+        case ROAR_RUN:
+            num_runs = cont->size;
+            break;
+        default:
+            THROW(ERR, "Unexpected container type: %u32",
+                  (uint32_t)cont->type);
+    }
+    return num_runs;
+}
+
+static void
+S_cont_op(RoaringContainer *cont, const RoaringContainer *other, int op) {
+    if (cont->type == ROAR_ARRAY && (op == ROAR_AND || op == ROAR_AND_NOT)) {
+        // Filter the array in place.
+        uint16_t *array = (uint16_t*)cont->data;
+        uint32_t  num   = 0;
+        if (op == ROAR_AND && other->type == ROAR_ARRAY) {
+            const uint16_t *other_array = (uint16_t*)other->data;
+            uint32_t i = 0, j = 0;
+            while (i < cont->card && j < other->card) {
+                if (array[i] < other_array[j])      { i++; }
+                else if (array[i] > other_array[j]) { j++; }
+                else {
+                    array[num++] = array[i];
+                    i++, j++;
+                }
+            }
+        }
+        else {
+            const bool wanted = op == ROAR_AND;
+            for (uint32_t i = 0; i < cont->card; i++) {
+                if (S_cont_get(other, array[i]) == wanted) {
+                    array[num++] = array[i];
+                }
+            }
+        }
+        cont->card = cont->size = num;
+    }
+    else if (op == ROAR_AND && other->type == ROAR_ARRAY) {
+        // The intersection can be no larger than the other array.
+        const uint16_t *other_array = (uint16_t*)other->data;
+        const uint32_t  cap   = other->card ? other->card : 1;
+        uint16_t       *array = (uint16_t*)MALLOCATE(cap * sizeof(uint16_t));
+        uint32_t        num   = 0;
+        for (uint32_t i = 0; i < other->card; i++) {
+            if (S_cont_get(cont, other_array[i])) {
+                array[num++] = other_array[i];
+            }
+        }
+        FREEMEM(cont->data);
+        cont->data = array;
+        cont->type = ROAR_ARRAY;
+        cont->card = cont->size = num;
+        cont->cap  = cap;
+    }
+    else if (op == ROAR_OR
+             && cont->type == ROAR_ARRAY
+             && other->type == ROAR_ARRAY
+             && cont->card + other->card <= ROAR_ARRAY_MAX
+            ) {
+        // Merge two small arrays.
+        const uint16_t *a   = (uint16_t*)cont->data;
+        const uint16_t *b   = (uint16_t*)other->data;
+        const uint32_t  cap = cont->card + other->card;
+        uint16_t *merged = (uint16_t*)MALLOCATE(cap * sizeof(uint16_t));
+        uint32_t i = 0, j = 0, num = 0;
+        while (i < cont->card && j < other->card) {
+            if (a[i] < b[j])      { merged[num++] = a[i++]; }
+            else if (a[i] > b[j]) { merged[num++] = b[j++]; }
+            else                  { merged[num++] = a[i++]; j++; }
+        }
+        while (i < cont->card)  { merged[num++] = a[i++]; }
+        while (j < other->card) { merged[num++] = b[j++]; }
+        FREEMEM(cont->data);
+        cont->data = merged;
+        cont->card = cont->size = num;
+        cont->cap  = cap;
+    }
+    else {
+        uint64_t words[ROAR_BITMAP_WORDS];
+        memset(words, 0, sizeof(words));
+        S_cont_fill_words(other, words);
+        S_cont_op_words(cont, words, op);
+    }
+}
+
+static void
+S_cont_op_words(RoaringContainer *cont, const uint64_t *other_words,
+                int op) {
+    S_cont_to_bitmap(cont);
+    uint64_t *words = (uint64_t*)cont->data;
+    uint32_t  card  = 0;
+    switch (op) {
+        case ROAR_AND:
+            for (uint32_t i = 0; i < ROAR_BITMAP_WORDS; i++) {
+                words[i] &= other_words[i];
+                card += BitVec_popcount64(words[i]);
+            }
+            break;
+        case ROAR_OR:
+            for (uint32_t i = 0; i < ROAR_BITMAP_WORDS; i++) {
+                words[i] |= other_words[i];
+                card += BitVec_popcount64(words[i]);
+            }
+            break;
+        case ROAR_XOR:
+            for (uint32_t i = 0; i < ROAR_BITMAP_WORDS; i++) {
+                words[i] ^= other_words[i];
+                card += BitVec_popcount64(words[i]);
+            }
+            break;
+        case ROAR_AND_NOT:
+            for (uint32_t i = 0; i < ROAR_BITMAP_WORDS; i++) {
+                words[i] &= ~other_words[i];
+                card += BitVec_popcount64(words[i]);
+            }
+            break;
+        default:
+            THROW(ERR, "Unrecognized operation: %i32", (int32_t)op);
+    }
+    cont->card = card;
+    S_cont_normalize(cont);
+}
+
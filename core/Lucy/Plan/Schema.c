@@ -28,6 +28,8 @@
 #include "Lucy/Plan/StringType.h"
 #include "Lucy/Plan/FullTextType.h"
 #include "Lucy/Plan/Architecture.h"
+#include "Lucy/Search/SortRule.h"
+#include "Lucy/Search/SortSpec.h"
 #include "Lucy/Store/Folder.h"
 #include "Lucy/Util/Json.h"
 
@@ -77,6 +79,7 @@ Schema_destroy(Schema *self) {
     DECREF(ivars->types);
     DECREF(ivars->sims);
     DECREF(ivars->sim);
+    DECREF(ivars->index_sort);
     SUPER_DESTROY(self, SCHEMA);
 }
 
@@ -222,6 +225,31 @@ Schema_get_similarity(Schema *self) {
     return Schema_IVARS(self)->sim;
 }
 
+void
+Schema_set_index_sort(Schema *self, SortSpec *sort_spec) {
+    SchemaIVARS *const ivars = Schema_IVARS(self);
+    if (sort_spec) {
+        VArray *rules = SortSpec_Get_Rules(sort_spec);
+        if (!VA_Get_Size(rules)) {
+            THROW(ERR, "Index sort must have at least one rule");
+        }
+        for (uint32_t i = 0, max = VA_Get_Size(rules); i < max; i++) {
+            SortRule *rule = (SortRule*)VA_Fetch(rules, i);
+            if (SortRule_Get_Type(rule) != SortRule_FIELD) {
+                THROW(ERR, "Index sort rules must sort by field");
+            }
+        }
+    }
+    SortSpec *old_sort = ivars->index_sort;
+    ivars->index_sort = (SortSpec*)INCREF(sort_spec);
+    DECREF(old_sort);
+}
+
+SortSpec*
+Schema_get_index_sort(Schema *self) {
+    return Schema_IVARS(self)->index_sort;
+}
+
 VArray*
 Schema_all_fields(Schema *self) {
     return Hash_Keys(Schema_IVARS(self)->types);
@@ -289,6 +317,12 @@ Schema_dump(Schema *self) {
         }
     }
 
+    // Dump the index sort.
+    if (ivars->index_sort) {
+        Hash_Store_Str(dump, "index_sort", 10,
+                       (Obj*)SortSpec_Dump_Rules(ivars->index_sort));
+    }
+
     return dump;
 }
 
@@ -389,6 +423,15 @@ Schema_load(Schema *self, Obj *dump) {
         }
     }
 
+    // Restore the index sort.
+    VArray *sort_dump = (VArray*)Hash_Fetch_Str(source, "index_sort", 10);
+    if (sort_dump) {
+        SortSpec *sort_spec
+            = SortSpec_load_rules((VArray*)CERTIFY(sort_dump, VARRAY));
+        Schema_Set_Index_Sort(loaded, sort_spec);
+        DECREF(sort_spec);
+    }
+
     DECREF(analyzers);
 
     return loaded;
@@ -408,6 +451,12 @@ Schema_eat(Schema *self, Schema *other) {
     while (Hash_Next(ovars->types, (Obj**)&field, (Obj**)&type)) {
         Schema_Spec_Field(self, field, type);
     }
+
+    // Adopt the other Schema's index sort unless we have our own.
+    SchemaIVARS *const ivars = Schema_IVARS(self);
+    if (!ivars->index_sort && ovars->index_sort) {
+        ivars->index_sort = (SortSpec*)INCREF(ovars->index_sort);
+    }
 }
 
 void
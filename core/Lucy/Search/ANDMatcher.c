@@ -19,6 +19,17 @@
 
 #include "Lucy/Search/ANDMatcher.h"
 #include "Lucy/Index/Similarity.h"
+#include "Lucy/Object/BitVector.h"
+
+// Return a copy of the kids array, sorted by ascending Cost().  The sort is
+// stable, so Matchers of equal or unknown cost keep their query order.
+static Matcher**
+S_order_by_cost(Matcher **kids, uint32_t num_kids);
+
+// If at least two kids can supply dense bitmaps, return their intersection,
+// computed a word at a time.  Otherwise return NULL.
+static BitVector*
+S_intersect_dense_bits(Matcher **kids, uint32_t num_kids);
 
 ANDMatcher*
 ANDMatcher_new(VArray *children, Similarity *sim) {
@@ -45,14 +56,63 @@ ANDMatcher_init(ANDMatcher *self, VArray *children, Similarity *sim) {
 
     // Derive.
     ivars->matching_kids = ivars->num_kids;
+    ivars->leads = S_order_by_cost(ivars->kids, ivars->num_kids);
+    ivars->dense_bits = ivars->more
+                        ? S_intersect_dense_bits(ivars->kids, ivars->num_kids)
+                        : NULL;
 
     return self;
 }
 
+static BitVector*
+S_intersect_dense_bits(Matcher **kids, uint32_t num_kids) {
+    // Consult the cheap flag first, so that no bitmap is read or copied
+    // unless there are at least two to combine.
+    uint32_t num_dense = 0;
+    for (uint32_t i = 0; i < num_kids; i++) {
+        if (Matcher_Has_Dense_Bits(kids[i])) { num_dense++; }
+    }
+    if (num_dense < 2) { return NULL; }
+
+    BitVector *intersection = NULL;
+    for (uint32_t i = 0; i < num_kids; i++) {
+        if (!Matcher_Has_Dense_Bits(kids[i])) { continue; }
+        BitVector *bits = Matcher_Dense_Bits(kids[i]);
+        if (intersection) {
+            BitVec_And(intersection, bits);
+        }
+        else {
+            intersection = BitVec_Clone(bits);
+        }
+    }
+    return intersection;
+}
+
+static Matcher**
+S_order_by_cost(Matcher **kids, uint32_t num_kids) {
+    Matcher  **leads = (Matcher**)MALLOCATE(num_kids * sizeof(Matcher*));
+    uint32_t  *costs = (uint32_t*)MALLOCATE(num_kids * sizeof(uint32_t));
+    for (uint32_t i = 0; i < num_kids; i++) {
+        const uint32_t cost = Matcher_Cost(kids[i]);
+        uint32_t j = i;
+        while (j > 0 && costs[j - 1] > cost) {
+            leads[j] = leads[j - 1];
+            costs[j] = costs[j - 1];
+            j--;
+        }
+        leads[j] = kids[i];
+        costs[j] = cost;
+    }
+    FREEMEM(costs);
+    return leads;
+}
+
 void
 ANDMatcher_destroy(ANDMatcher *self) {
     ANDMatcherIVARS *const ivars = ANDMatcher_IVARS(self);
     FREEMEM(ivars->kids);
+    FREEMEM(ivars->leads);
+    DECREF(ivars->dense_bits);
     SUPER_DESTROY(self, ANDMATCHER);
 }
 
@@ -63,7 +123,7 @@ ANDMatcher_next(ANDMatcher *self) {
         return ANDMatcher_Advance(self, 1);
     }
     if (ivars->more) {
-        const int32_t target = Matcher_Get_Doc_ID(ivars->kids[0]) + 1;
+        const int32_t target = Matcher_Get_Doc_ID(ivars->leads[0]) + 1;
         return ANDMatcher_Advance(self, target);
     }
     else {
@@ -74,18 +134,30 @@ ANDMatcher_next(ANDMatcher *self) {
 int32_t
 ANDMatcher_advance(ANDMatcher *self, int32_t target) {
     ANDMatcherIVARS *const ivars = ANDMatcher_IVARS(self);
-    Matcher **const kids     = ivars->kids;
-    const uint32_t  num_kids = ivars->num_kids;
-    int32_t         highest  = 0;
+    Matcher   **const leads      = ivars->leads;
+    BitVector  *const dense_bits = ivars->dense_bits;
+    const uint32_t    num_kids   = ivars->num_kids;
+    int32_t           highest    = 0;
 
     if (!ivars->more) { return 0; }
 
-    // First step: Advance first child and use its doc as a starting point.
+    // No doc can match unless it is in the intersection of the dense kids'
+    // bitmaps, so go straight to the next doc which is.
+    if (dense_bits) {
+        target = BitVec_Next_Hit(dense_bits, (uint32_t)target);
+        if (target < 0) {
+            ivars->more = false;
+            return 0;
+        }
+    }
+
+    // First step: Advance the child with the fewest docs and use its doc as a
+    // starting point.  The others then skip ahead to meet it.
     if (ivars->first_time) {
         ivars->first_time = false;
     }
     else {
-        highest = Matcher_Advance(kids[0], target);
+        highest = Matcher_Advance(leads[0], target);
         if (!highest) {
             ivars->more = false;
             return 0;
@@ -98,7 +170,7 @@ ANDMatcher_advance(ANDMatcher *self, int32_t target) {
 
         // Scoot all Matchers up.
         for (uint32_t i = 0; i < num_kids; i++) {
-            Matcher *const child = kids[i];
+            Matcher *const child = leads[i];
             int32_t candidate = Matcher_Get_Doc_ID(child);
 
             // If this child is highest, others will need to catch up.
@@ -109,6 +181,13 @@ ANDMatcher_advance(ANDMatcher *self, int32_t target) {
             // If least doc Matchers can agree on exceeds target, raise bar.
             if (target < highest) {
                 target = highest;
+                if (dense_bits) {
+                    target = BitVec_Next_Hit(dense_bits, (uint32_t)target);
+                    if (target < 0) {
+                        ivars->more = false;
+                        return 0;
+                    }
+                }
             }
 
             // Scoot this Matcher up if not already at highest.
@@ -124,7 +203,7 @@ ANDMatcher_advance(ANDMatcher *self, int32_t target) {
 
         // If Matchers don't agree, send back through the loop.
         for (uint32_t i = 0; i < num_kids; i++) {
-            Matcher *const child = kids[i];
+            Matcher *const child = leads[i];
             const int32_t candidate = Matcher_Get_Doc_ID(child);
             if (candidate != highest) {
                 agreement = false;
@@ -143,9 +222,31 @@ ANDMatcher_advance(ANDMatcher *self, int32_t target) {
     return highest;
 }
 
+uint32_t
+ANDMatcher_next_block(ANDMatcher *self, int32_t *doc_ids, float *scores,
+                      uint32_t max) {
+    ANDMatcherIVARS *const ivars = ANDMatcher_IVARS(self);
+    uint32_t count = 0;
+    if (!ivars->more) { return 0; }
+
+    // Call the local implementations directly, bypassing dispatch.
+    int32_t doc_id = ivars->first_time
+                     ? 0
+                     : Matcher_Get_Doc_ID(ivars->leads[0]);
+    while (count < max) {
+        doc_id = ANDMatcher_advance(self, doc_id + 1);
+        if (!doc_id) { break; }
+        doc_ids[count] = doc_id;
+        if (scores) { scores[count] = ANDMatcher_score(self); }
+        count++;
+    }
+
+    return count;
+}
+
 int32_t
 ANDMatcher_get_doc_id(ANDMatcher *self) {
-    return Matcher_Get_Doc_ID(ANDMatcher_IVARS(self)->kids[0]);
+    return Matcher_Get_Doc_ID(ANDMatcher_IVARS(self)->leads[0]);
 }
 
 float
@@ -163,3 +264,15 @@ ANDMatcher_score(ANDMatcher *self) {
     return score;
 }
 
+uint32_t
+ANDMatcher_cost(ANDMatcher *self) {
+    ANDMatcherIVARS *const ivars = ANDMatcher_IVARS(self);
+    uint32_t cost = UINT32_MAX;
+    for (uint32_t i = 0; i < ivars->num_kids; i++) {
+        const uint32_t kid_cost = Matcher_Cost(ivars->kids[i]);
+        if (kid_cost < cost) { cost = kid_cost; }
+    }
+    return cost;
+}
+
+
@@ -24,6 +24,7 @@
 #include "Lucy/Index/Similarity.h"
 #include "Lucy/Plan/Schema.h"
 #include "Lucy/Search/ANDMatcher.h"
+#include "Lucy/Search/NoMatchQuery.h"
 #include "Lucy/Search/Searcher.h"
 #include "Lucy/Search/Span.h"
 #include "Lucy/Store/InStream.h"
@@ -64,6 +65,40 @@ ANDQuery_to_string(ANDQuery *self) {
 }
 
 
+Query*
+ANDQuery_rewrite(ANDQuery *self, Searcher *searcher) {
+    ANDQueryIVARS *const ivars = ANDQuery_IVARS(self);
+    VArray *rewritten = ANDQuery_Rewrite_Children(self, searcher, true);
+    VArray *kids      = rewritten ? rewritten : ivars->children;
+    bool    can_match = true;
+    Query  *retval;
+
+    for (uint32_t i = 0, max = VA_Get_Size(kids); i < max; i++) {
+        if (Obj_Is_A(VA_Fetch(kids, i), NOMATCHQUERY)) {
+            can_match = false;
+            break;
+        }
+    }
+
+    if (!can_match) {
+        // One required clause which can never match rules out everything.
+        retval = (Query*)NoMatchQuery_new();
+    }
+    else if (VA_Get_Size(kids) == 1 && ivars->boost == 1.0f) {
+        retval = (Query*)INCREF(VA_Fetch(kids, 0));
+    }
+    else if (rewritten) {
+        retval = (Query*)ANDQuery_new(rewritten);
+        Query_Set_Boost(retval, ivars->boost);
+    }
+    else {
+        retval = (Query*)INCREF(self);
+    }
+
+    DECREF(rewritten);
+    return retval;
+}
+
 bool
 ANDQuery_equals(ANDQuery *self, Obj *other) {
     if ((ANDQuery*)other == self)   { return true; }
@@ -19,6 +19,9 @@
 
 #include "Lucy/Search/BitVecMatcher.h"
 
+// Number of set bits fetched from the BitVector at a time.
+#define HIT_BUF_SIZE 64
+
 BitVecMatcher*
 BitVecMatcher_new(BitVector *bit_vector) {
     BitVecMatcher *self = (BitVecMatcher*)VTable_Make_Obj(BITVECMATCHER);
@@ -29,8 +32,13 @@ BitVecMatcher*
 BitVecMatcher_init(BitVecMatcher *self, BitVector *bit_vector) {
     BitVecMatcherIVARS *const ivars = BitVecMatcher_IVARS(self);
     Matcher_init((Matcher*)self);
-    ivars->bit_vec = (BitVector*)INCREF(bit_vector);
-    ivars->doc_id = 0;
+    ivars->bit_vec  = (BitVector*)INCREF(bit_vector);
+    ivars->doc_id   = 0;
+    ivars->hits     = (int32_t*)MALLOCATE(HIT_BUF_SIZE * sizeof(int32_t));
+    ivars->num_hits = 0;
+    ivars->hit_tick = 0;
+    ivars->cost     = 0;
+    ivars->counted  = false;
     return self;
 }
 
@@ -38,21 +46,94 @@ void
 BitVecMatcher_destroy(BitVecMatcher *self) {
     BitVecMatcherIVARS *const ivars = BitVecMatcher_IVARS(self);
     DECREF(ivars->bit_vec);
+    FREEMEM(ivars->hits);
     SUPER_DESTROY(self, BITVECMATCHER);
 }
 
+// Refill the buffer with the set bits at or above <code>target</code> and
+// return the first of them, or 0 if there are none.
+static int32_t
+S_refill(BitVecMatcherIVARS *ivars, int32_t target) {
+    ivars->num_hits = BitVec_Next_Hits(ivars->bit_vec, (uint32_t)target,
+                                       ivars->hits, HIT_BUF_SIZE);
+    if (ivars->num_hits == 0) {
+        ivars->hit_tick = 0;
+        ivars->doc_id   = -1;
+        return 0;
+    }
+    ivars->hit_tick = 1;
+    ivars->doc_id   = ivars->hits[0];
+    return ivars->doc_id;
+}
+
 int32_t
 BitVecMatcher_next(BitVecMatcher *self) {
     BitVecMatcherIVARS *const ivars = BitVecMatcher_IVARS(self);
-    ivars->doc_id = BitVec_Next_Hit(ivars->bit_vec, ivars->doc_id + 1);
-    return ivars->doc_id == -1 ? 0 : ivars->doc_id;
+    if (ivars->hit_tick < ivars->num_hits) {
+        ivars->doc_id = ivars->hits[ivars->hit_tick++];
+        return ivars->doc_id;
+    }
+    return S_refill(ivars, ivars->doc_id + 1);
 }
 
 int32_t
 BitVecMatcher_advance(BitVecMatcher *self, int32_t target) {
     BitVecMatcherIVARS *const ivars = BitVecMatcher_IVARS(self);
-    ivars->doc_id = BitVec_Next_Hit(ivars->bit_vec, target);
-    return ivars->doc_id == -1 ? 0 : ivars->doc_id;
+
+    // Skip ahead within the buffer if the target lies inside it, galloping
+    // to bracket the target and then binary searching.
+    if (ivars->hit_tick < ivars->num_hits
+        && ivars->doc_id < target
+        && ivars->hits[ivars->num_hits - 1] >= target
+       ) {
+        const int32_t *const hits = ivars->hits;
+        uint32_t lo   = ivars->hit_tick;
+        uint32_t hi   = ivars->num_hits - 1;
+        uint32_t step = 1;
+        while (lo + step < hi && hits[lo + step] < target) {
+            lo += step;
+            step <<= 1;
+        }
+        if (lo + step < hi) { hi = lo + step; }
+        while (lo < hi) {
+            const uint32_t mid = lo + ((hi - lo) >> 1);
+            if (hits[mid] < target) { lo = mid + 1; }
+            else                    { hi = mid; }
+        }
+        ivars->hit_tick = lo + 1;
+        ivars->doc_id   = hits[lo];
+        return ivars->doc_id;
+    }
+    return S_refill(ivars, target);
+}
+
+uint32_t
+BitVecMatcher_next_block(BitVecMatcher *self, int32_t *doc_ids,
+                         float *scores, uint32_t max) {
+    BitVecMatcherIVARS *const ivars = BitVecMatcher_IVARS(self);
+    uint32_t count = 0;
+
+    // Bail if a previous call to Next() or Advance() ran off the end.
+    if (ivars->doc_id < 0) { return 0; }
+
+    // Drain the buffer, then fetch the rest straight into doc_ids.
+    while (count < max && ivars->hit_tick < ivars->num_hits) {
+        doc_ids[count++] = ivars->hits[ivars->hit_tick++];
+    }
+    if (count < max) {
+        const int32_t target = count ? doc_ids[count - 1] + 1
+                                     : ivars->doc_id + 1;
+        count += BitVec_Next_Hits(ivars->bit_vec, (uint32_t)target,
+                                  doc_ids + count, max - count);
+        ivars->num_hits = 0;
+        ivars->hit_tick = 0;
+    }
+    if (count) { ivars->doc_id = doc_ids[count - 1]; }
+    if (scores) {
+        for (uint32_t i = 0; i < count; i++) { scores[i] = 0.0f; }
+    }
+
+    return count;
 }
 
 int32_t
@@ -60,4 +141,20 @@ BitVecMatcher_get_doc_id(BitVecMatcher *self) {
     return BitVecMatcher_IVARS(self)->doc_id;
 }
 
+float
+BitVecMatcher_score(BitVecMatcher *self) {
+    UNUSED_VAR(self);
+    return 0.0f;
+}
+
+uint32_t
+BitVecMatcher_cost(BitVecMatcher *self) {
+    BitVecMatcherIVARS *const ivars = BitVecMatcher_IVARS(self);
+    if (!ivars->counted) {
+        ivars->cost    = BitVec_Count(ivars->bit_vec);
+        ivars->counted = true;
+    }
+    return ivars->cost;
+}
+
 
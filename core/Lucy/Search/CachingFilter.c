@@ -0,0 +1,180 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#define C_LUCY_CACHINGFILTER
+#define C_LUCY_CACHINGFILTERCOMPILER
+#include "Lucy/Util/ToolSet.h"
+
+#include "Lucy/Search/CachingFilter.h"
+#include "Lucy/Index/DocVector.h"
+#include "Lucy/Index/SegReader.h"
+#include "Lucy/Object/RoaringBitVector.h"
+#include "Lucy/Search/BitVecMatcher.h"
+#include "Lucy/Search/FilterCache.h"
+#include "Lucy/Search/Searcher.h"
+
+// Memory bound for the private cache used when none is supplied.
+#define DEFAULT_CACHE_BYTES 16777216
+
+CachingFilter*
+CachingFilter_new(Query *query, FilterCache *cache) {
+    CachingFilter *self = (CachingFilter*)VTable_Make_Obj(CACHINGFILTER);
+    return CachingFilter_init(self, query, cache);
+}
+
+CachingFilter*
+CachingFilter_init(CachingFilter *self, Query *query, FilterCache *cache) {
+    PolyQuery_init((PolyQuery*)self, NULL);
+    CachingFilterIVARS *const ivars = CachingFilter_IVARS(self);
+    CachingFilter_Set_Boost(self, 0.0f);
+    PolyQuery_Add_Child((PolyQuery*)self, query);
+    ivars->cache = cache
+                   ? (FilterCache*)INCREF(cache)
+                   : FilterCache_new(DEFAULT_CACHE_BYTES);
+    return self;
+}
+
+void
+CachingFilter_destroy(CachingFilter *self) {
+    CachingFilterIVARS *const ivars = CachingFilter_IVARS(self);
+    DECREF(ivars->cache);
+    SUPER_DESTROY(self, CACHINGFILTER);
+}
+
+Query*
+CachingFilter_get_query(CachingFilter *self) {
+    CachingFilterIVARS *const ivars = CachingFilter_IVARS(self);
+    return (Query*)VA_Fetch(ivars->children, 0);
+}
+
+FilterCache*
+CachingFilter_get_cache(CachingFilter *self) {
+    CachingFilterIVARS *const ivars = CachingFilter_IVARS(self);
+    // A deserialized CachingFilter starts out without a cache.
+    if (!ivars->cache) { ivars->cache = FilterCache_new(DEFAULT_CACHE_BYTES); }
+    return ivars->cache;
+}
+
+CharBuf*
+CachingFilter_to_string(CachingFilter *self) {
+    CharBuf *query_string = Query_To_String(CachingFilter_Get_Query(self));
+    CharBuf *retval = CB_newf("CachingFilter(%o)", query_string);
+    DECREF(query_string);
+    return retval;
+}
+
+bool
+CachingFilter_equals(CachingFilter *self, Obj *other) {
+    if ((CachingFilter*)other == self)   { return true; }
+    if (!Obj_Is_A(other, CACHINGFILTER)) { return false; }
+    return PolyQuery_equals((PolyQuery*)self, other);
+}
+
+Compiler*
+CachingFilter_make_compiler(CachingFilter *self, Searcher *searcher,
+                            float boost, bool subordinate) {
+    CachingFilterCompiler *compiler
+        = CachingFilterCompiler_new(self, searcher, boost);
+    if (!subordinate) {
+        CachingFilterCompiler_Normalize(compiler);
+    }
+    return (Compiler*)compiler;
+}
+
+/**********************************************************************/
+
+CachingFilterCompiler*
+CachingFilterCompiler_new(CachingFilter *parent, Searcher *searcher,
+                          float boost) {
+    CachingFilterCompiler *self
+        = (CachingFilterCompiler*)VTable_Make_Obj(CACHINGFILTERCOMPILER);
+    return CachingFilterCompiler_init(self, parent, searcher, boost);
+}
+
+CachingFilterCompiler*
+CachingFilterCompiler_init(CachingFilterCompiler *self,
+                           CachingFilter *parent, Searcher *searcher,
+                           float boost) {
+    PolyCompiler_init((PolyCompiler*)self, (PolyQuery*)parent, searcher,
+                      boost);
+    return self;
+}
+
+float
+CachingFilterCompiler_sum_of_squared_weights(CachingFilterCompiler *self) {
+    UNUSED_VAR(self);
+    return 0.0f;
+}
+
+VArray*
+CachingFilterCompiler_highlight_spans(CachingFilterCompiler *self,
+                                      Searcher *searcher, DocVector *doc_vec,
+                                      const CharBuf *field) {
+    UNUSED_VAR(self);
+    UNUSED_VAR(searcher);
+    UNUSED_VAR(doc_vec);
+    UNUSED_VAR(field);
+    return VA_new(0);
+}
+
+// Gather the docs matched by the wrapped Query in one segment, ignoring
+// deletions, which are applied separately at search time.
+static RoaringBitVector*
+S_gather_bits(Compiler *compiler, SegReader *reader) {
+    RoaringBitVector *bits = RoarBitVec_new(SegReader_Doc_Max(reader) + 1);
+    Matcher *matcher = Compiler_Make_Matcher(compiler, reader, false);
+    if (matcher) {
+        BitVector *flat = BitVec_new(SegReader_Doc_Max(reader) + 1);
+        int32_t doc_id;
+        while (0 != (doc_id = Matcher_Next(matcher))) {
+            BitVec_Set(flat, doc_id);
+        }
+        RoarBitVec_Mimic(bits, (Obj*)flat);
+        RoarBitVec_Run_Optimize(bits);
+        DECREF(flat);
+        DECREF(matcher);
+    }
+    return bits;
+}
+
+Matcher*
+CachingFilterCompiler_make_matcher(CachingFilterCompiler *self,
+                                   SegReader *reader, bool need_score) {
+    CachingFilterCompilerIVARS *const ivars
+        = CachingFilterCompiler_IVARS(self);
+    CachingFilter *parent = (CachingFilter*)ivars->parent;
+    FilterCache   *cache  = CachingFilter_Get_Cache(parent);
+    Query         *query  = CachingFilter_Get_Query(parent);
+    BitVector     *bits   = FilterCache_Fetch(cache, query, reader);
+    UNUSED_VAR(need_score);
+
+    if (!bits) {
+        Compiler *child
+            = (Compiler*)CERTIFY(VA_Fetch(ivars->children, 0), COMPILER);
+        RoaringBitVector *gathered = S_gather_bits(child, reader);
+        FilterCache_Store(cache, query, reader, gathered);
+        bits = (BitVector*)gathered;
+    }
+
+    Matcher *retval = BitVec_Count(bits)
+                      ? (Matcher*)BitVecMatcher_new(bits)
+                      : NULL;
+    DECREF(bits);
+    return retval;
+}
+
+
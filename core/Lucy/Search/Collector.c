@@ -17,6 +17,7 @@
 #define C_LUCY_COLLECTOR
 #define C_LUCY_BITCOLLECTOR
 #define C_LUCY_OFFSETCOLLECTOR
+#define C_LUCY_BLOCKCURSOR
 #include "Lucy/Util/ToolSet.h"
 
 #include "Lucy/Search/Collector.h"
@@ -41,6 +42,26 @@ Coll_destroy(Collector *self) {
     SUPER_DESTROY(self, COLLECTOR);
 }
 
+void
+Coll_collect_block(Collector *self, int32_t *doc_ids, float *scores,
+                   uint32_t count) {
+    CollectorIVARS *const ivars = Coll_IVARS(self);
+    BlockCursorIVARS *cursor_ivars
+        = ivars->matcher && Matcher_Is_A(ivars->matcher, BLOCKCURSOR)
+          ? BlockCursor_IVARS((BlockCursor*)ivars->matcher)
+          : NULL;
+
+    for (uint32_t i = 0; i < count; i++) {
+        // Point the cursor at the doc so that Collect() can score it.
+        if (cursor_ivars) {
+            cursor_ivars->doc_id = doc_ids[i];
+            cursor_ivars->score  = scores ? scores[i] : 0.0f;
+        }
+        Coll_Collect(self, doc_ids[i]);
+        if (Coll_Segment_Done(self)) { break; }
+    }
+}
+
 void
 Coll_set_reader(Collector *self, SegReader *reader) {
     CollectorIVARS *const ivars = Coll_IVARS(self);
@@ -60,6 +81,12 @@ Coll_set_base(Collector *self, int32_t base) {
     Coll_IVARS(self)->base = base;
 }
 
+bool
+Coll_segment_done(Collector *self) {
+    UNUSED_VAR(self);
+    return false;
+}
+
 BitCollector*
 BitColl_new(BitVector *bit_vec) {
     BitCollector *self = (BitCollector*)VTable_Make_Obj(BITCOLLECTOR);
@@ -89,6 +116,18 @@ BitColl_collect(BitCollector *self, int32_t doc_id) {
     BitVec_Set(ivars->bit_vec, (ivars->base + doc_id));
 }
 
+void
+BitColl_collect_block(BitCollector *self, int32_t *doc_ids, float *scores,
+                      uint32_t count) {
+    BitCollectorIVARS *const ivars = BitColl_IVARS(self);
+    BitVector *const bit_vec = ivars->bit_vec;
+    const int32_t base = ivars->base;
+    UNUSED_VAR(scores);
+    for (uint32_t i = 0; i < count; i++) {
+        BitVec_Set(bit_vec, (base + doc_ids[i]));
+    }
+}
+
 bool
 BitColl_need_score(BitCollector *self) {
     UNUSED_VAR(self);
@@ -134,6 +173,7 @@ void
 OffsetColl_set_matcher(OffsetCollector *self, Matcher *matcher) {
     OffsetCollectorIVARS *const ivars = OffsetColl_IVARS(self);
     Coll_Set_Matcher(ivars->inner_coll, matcher);
+    Coll_set_matcher((Collector*)self, matcher);
 }
 
 void
@@ -148,4 +188,10 @@ OffsetColl_need_score(OffsetCollector *self) {
     return Coll_Need_Score(ivars->inner_coll);
 }
 
+bool
+OffsetColl_segment_done(OffsetCollector *self) {
+    OffsetCollectorIVARS *const ivars = OffsetColl_IVARS(self);
+    return Coll_Segment_Done(ivars->inner_coll);
+}
+
 
@@ -0,0 +1,271 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define C_LUCY_AGGREGATIONCOLLECTOR
+#include "Lucy/Util/ToolSet.h"
+
+#include "Lucy/Search/Collector/AggregationCollector.h"
+#include "Lucy/Index/SegReader.h"
+#include "Lucy/Index/SortCache/NumericSortCache.h"
+#include "Lucy/Index/SortReader.h"
+#include "Lucy/Search/Matcher.h"
+
+AggregationCollector*
+AggColl_new(const CharBuf *field, VArray *bounds, Collector *inner_coll) {
+    AggregationCollector *self
+        = (AggregationCollector*)VTable_Make_Obj(AGGREGATIONCOLLECTOR);
+    return AggColl_init(self, field, bounds, inner_coll);
+}
+
+AggregationCollector*
+AggColl_init(AggregationCollector *self, const CharBuf *field,
+             VArray *bounds, Collector *inner_coll) {
+    AggregationCollectorIVARS *const ivars = AggColl_IVARS(self);
+    Coll_init((Collector*)self);
+    uint32_t num_bounds = bounds ? VA_Get_Size(bounds) : 0;
+
+    ivars->field       = CB_Clone(field);
+    ivars->inner_coll  = (Collector*)INCREF(inner_coll);
+    ivars->sort_cache  = NULL;
+    ivars->count       = 0;
+    ivars->sum         = 0.0;
+    ivars->min         = F64_NAN;
+    ivars->max         = F64_NAN;
+    ivars->int_sum     = 0;
+    ivars->int_min     = 0;
+    ivars->int_max     = 0;
+    ivars->int_cache   = false;
+    ivars->saw_float   = false;
+    ivars->num_bounds  = num_bounds;
+    ivars->bounds      = num_bounds
+                         ? (double*)MALLOCATE(num_bounds * sizeof(double))
+                         : NULL;
+    ivars->bucket_counts
+        = num_bounds
+          ? (uint64_t*)CALLOCATE(num_bounds + 1, sizeof(uint64_t))
+          : NULL;
+
+    for (uint32_t i = 0; i < num_bounds; i++) {
+        Obj *bound = VA_Fetch(bounds, i);
+        if (!bound) {
+            DECREF(self);
+            THROW(ERR, "Bucket boundary %u32 is NULL", i);
+        }
+        ivars->bounds[i] = Obj_To_F64(bound);
+        if (i > 0 && !(ivars->bounds[i] > ivars->bounds[i - 1])) {
+            DECREF(self);
+            THROW(ERR, "Bucket boundaries must be strictly ascending");
+        }
+    }
+
+    return self;
+}
+
+void
+AggColl_destroy(AggregationCollector *self) {
+    AggregationCollectorIVARS *const ivars = AggColl_IVARS(self);
+    DECREF(ivars->field);
+    DECREF(ivars->inner_coll);
+    FREEMEM(ivars->bounds);
+    FREEMEM(ivars->bucket_counts);
+    SUPER_DESTROY(self, AGGREGATIONCOLLECTOR);
+}
+
+void
+AggColl_set_reader(AggregationCollector *self, SegReader *reader) {
+    AggregationCollectorIVARS *const ivars = AggColl_IVARS(self);
+    SortReader *sort_reader = reader
+                              ? (SortReader*)SegReader_Fetch(
+                                    reader, VTable_Get_Name(SORTREADER))
+                              : NULL;
+    SortCache *cache = sort_reader
+                       ? SortReader_Fetch_Sort_Cache(sort_reader,
+                                                     ivars->field)
+                       : NULL;
+    if (cache && !SortCache_Is_A(cache, NUMERICSORTCACHE)) {
+        THROW(ERR, "'%o' isn't a numeric field", ivars->field);
+    }
+    ivars->sort_cache = (NumericSortCache*)cache;
+    ivars->int_cache  = cache
+                        && (SortCache_Is_A(cache, INT32SORTCACHE)
+                            || SortCache_Is_A(cache, INT64SORTCACHE));
+
+    if (ivars->inner_coll) { Coll_Set_Reader(ivars->inner_coll, reader); }
+    Coll_set_reader((Collector*)self, reader);
+}
+
+void
+AggColl_set_base(AggregationCollector *self, int32_t base) {
+    AggregationCollectorIVARS *const ivars = AggColl_IVARS(self);
+    if (ivars->inner_coll) { Coll_Set_Base(ivars->inner_coll, base); }
+    Coll_set_base((Collector*)self, base);
+}
+
+void
+AggColl_set_matcher(AggregationCollector *self, Matcher *matcher) {
+    AggregationCollectorIVARS *const ivars = AggColl_IVARS(self);
+    if (ivars->inner_coll) { Coll_Set_Matcher(ivars->inner_coll, matcher); }
+    Coll_set_matcher((Collector*)self, matcher);
+}
+
+// Return the index of the bucket which holds `value`: the number of
+// boundaries at or below it.
+static INLINE uint32_t
+SI_find_bucket(const double *bounds, uint32_t num_bounds, double value) {
+    uint32_t lo = 0;
+    uint32_t hi = num_bounds;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (bounds[mid] <= value) { lo = mid + 1; }
+        else                      { hi = mid; }
+    }
+    return lo;
+}
+
+void
+AggColl_collect(AggregationCollector *self, int32_t doc_id) {
+    AggregationCollectorIVARS *const ivars = AggColl_IVARS(self);
+    NumericSortCache *const cache = ivars->sort_cache;
+    if (cache) {
+        int32_t ord = NumSortCache_Ordinal(cache, doc_id);
+        if (ord != NumSortCache_Get_Null_Ord(cache)) {
+            double value;
+            if (ivars->int_cache) {
+                // Keep an exact tally alongside the doubles.
+                int64_t int_value;
+                NumSortCache_Int64_Values(cache, &doc_id, &int_value, 1, 0);
+                if (ivars->count == 0) {
+                    ivars->int_min = int_value;
+                    ivars->int_max = int_value;
+                }
+                else if (int_value < ivars->int_min) {
+                    ivars->int_min = int_value;
+                }
+                else if (int_value > ivars->int_max) {
+                    ivars->int_max = int_value;
+                }
+                ivars->int_sum = (int64_t)((uint64_t)ivars->int_sum
+                                           + (uint64_t)int_value);
+                value = (double)int_value;
+            }
+            else {
+                value = NumSortCache_Double_Value(cache, ord);
+                ivars->saw_float = true;
+            }
+            if (ivars->count == 0) {
+                ivars->min = value;
+                ivars->max = value;
+            }
+            else if (value < ivars->min) { ivars->min = value; }
+            else if (value > ivars->max) { ivars->max = value; }
+            ivars->count++;
+            ivars->sum += value;
+            if (ivars->num_bounds) {
+                uint32_t tick = SI_find_bucket(ivars->bounds,
+                                               ivars->num_bounds, value);
+                ivars->bucket_counts[tick]++;
+            }
+        }
+    }
+    if (ivars->inner_coll) { Coll_Collect(ivars->inner_coll, doc_id); }
+}
+
+bool
+AggColl_need_score(AggregationCollector *self) {
+    AggregationCollectorIVARS *const ivars = AggColl_IVARS(self);
+    return ivars->inner_coll ? Coll_Need_Score(ivars->inner_coll) : false;
+}
+
+uint64_t
+AggColl_get_count(AggregationCollector *self) {
+    return AggColl_IVARS(self)->count;
+}
+
+double
+AggColl_get_sum(AggregationCollector *self) {
+    return AggColl_IVARS(self)->sum;
+}
+
+double
+AggColl_get_min(AggregationCollector *self) {
+    return AggColl_IVARS(self)->min;
+}
+
+double
+AggColl_get_max(AggregationCollector *self) {
+    return AggColl_IVARS(self)->max;
+}
+
+static void
+S_check_integer(AggregationCollectorIVARS *ivars) {
+    if (ivars->saw_float) {
+        THROW(ERR, "'%o' isn't an integer field", ivars->field);
+    }
+}
+
+int64_t
+AggColl_get_int_sum(AggregationCollector *self) {
+    AggregationCollectorIVARS *const ivars = AggColl_IVARS(self);
+    S_check_integer(ivars);
+    return ivars->int_sum;
+}
+
+int64_t
+AggColl_get_int_min(AggregationCollector *self) {
+    AggregationCollectorIVARS *const ivars = AggColl_IVARS(self);
+    S_check_integer(ivars);
+    return ivars->int_min;
+}
+
+int64_t
+AggColl_get_int_max(AggregationCollector *self) {
+    AggregationCollectorIVARS *const ivars = AggColl_IVARS(self);
+    S_check_integer(ivars);
+    return ivars->int_max;
+}
+
+double
+AggColl_get_average(AggregationCollector *self) {
+    AggregationCollectorIVARS *const ivars = AggColl_IVARS(self);
+    return ivars->count ? ivars->sum / (double)ivars->count : F64_NAN;
+}
+
+uint32_t
+AggColl_num_buckets(AggregationCollector *self) {
+    AggregationCollectorIVARS *const ivars = AggColl_IVARS(self);
+    return ivars->num_bounds ? ivars->num_bounds + 1 : 0;
+}
+
+uint64_t
+AggColl_bucket_count(AggregationCollector *self, uint32_t tick) {
+    AggregationCollectorIVARS *const ivars = AggColl_IVARS(self);
+    if (!ivars->num_bounds || tick > ivars->num_bounds) {
+        THROW(ERR, "Bucket %u32 out of range", tick);
+    }
+    return ivars->bucket_counts[tick];
+}
+
+CharBuf*
+AggColl_get_field(AggregationCollector *self) {
+    return AggColl_IVARS(self)->field;
+}
+
+Collector*
+AggColl_get_inner_collector(AggregationCollector *self) {
+    return AggColl_IVARS(self)->inner_coll;
+}
+
+
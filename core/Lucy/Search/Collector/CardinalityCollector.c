@@ -0,0 +1,180 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define C_LUCY_CARDINALITYCOLLECTOR
+#include "Lucy/Util/ToolSet.h"
+
+#include "Lucy/Search/Collector/CardinalityCollector.h"
+#include "Lucy/Index/SegReader.h"
+#include "Lucy/Index/SortCache.h"
+#include "Lucy/Index/SortReader.h"
+#include "Lucy/Object/BitVector.h"
+#include "Lucy/Object/HyperLogLog.h"
+#include "Lucy/Search/Matcher.h"
+
+// Hash the ordinals seen in the current segment into the sketch.
+static void
+S_flush_segment(CardinalityCollectorIVARS *ivars);
+
+CardinalityCollector*
+CardColl_new(const CharBuf *field, uint32_t precision, Collector *inner_coll) {
+    CardinalityCollector *self
+        = (CardinalityCollector*)VTable_Make_Obj(CARDINALITYCOLLECTOR);
+    return CardColl_init(self, field, precision, inner_coll);
+}
+
+CardinalityCollector*
+CardColl_init(CardinalityCollector *self, const CharBuf *field,
+              uint32_t precision, Collector *inner_coll) {
+    CardinalityCollectorIVARS *const ivars = CardColl_IVARS(self);
+    Coll_init((Collector*)self);
+    ivars->field      = CB_Clone(field);
+    ivars->inner_coll = (Collector*)INCREF(inner_coll);
+    ivars->sort_cache = NULL;
+    ivars->seen       = NULL;
+    ivars->null_ord   = -1;
+    ivars->sketch     = HLL_new(precision);
+    return self;
+}
+
+void
+CardColl_destroy(CardinalityCollector *self) {
+    CardinalityCollectorIVARS *const ivars = CardColl_IVARS(self);
+    DECREF(ivars->field);
+    DECREF(ivars->sketch);
+    DECREF(ivars->inner_coll);
+    DECREF(ivars->seen);
+    SUPER_DESTROY(self, CARDINALITYCOLLECTOR);
+}
+
+static uint64_t
+S_hash_value(Obj *value) {
+    if (Obj_Is_A(value, CHARBUF)) {
+        CharBuf *string = (CharBuf*)value;
+        return HLL_hash_bytes(CB_Get_Ptr8(string), CB_Get_Size(string));
+    }
+    else if (Obj_Is_A(value, INTNUM)) {
+        // Hash a big-endian encoding so that sketches built on machines of
+        // differing endianness can be merged.
+        char  buf[sizeof(uint64_t)];
+        char *dest = buf;
+        NumUtil_encode_bigend_u64((uint64_t)Obj_To_I64(value), &dest);
+        return HLL_hash_bytes(buf, sizeof(buf));
+    }
+    else if (Obj_Is_A(value, FLOATNUM)) {
+        char  buf[sizeof(double)];
+        char *dest = buf;
+        NumUtil_encode_bigend_f64(Obj_To_F64(value), &dest);
+        return HLL_hash_bytes(buf, sizeof(buf));
+    }
+    else {
+        CharBuf *string = Obj_To_String(value);
+        uint64_t hash
+            = HLL_hash_bytes(CB_Get_Ptr8(string), CB_Get_Size(string));
+        DECREF(string);
+        return hash;
+    }
+}
+
+static void
+S_flush_segment(CardinalityCollectorIVARS *ivars) {
+    if (!ivars->seen) { return; }
+    SortCache *cache = ivars->sort_cache;
+    Obj       *blank = SortCache_Make_Blank(cache);
+    int32_t    ord   = BitVec_Next_Hit(ivars->seen, 0);
+    while (ord != -1) {
+        Obj *value = SortCache_Value(cache, ord, blank);
+        if (value) { HLL_Add_Hash(ivars->sketch, S_hash_value(value)); }
+        ord = BitVec_Next_Hit(ivars->seen, (uint32_t)ord + 1);
+    }
+    DECREF(blank);
+    DECREF(ivars->seen);
+    ivars->seen       = NULL;
+    ivars->sort_cache = NULL;
+}
+
+void
+CardColl_set_reader(CardinalityCollector *self, SegReader *reader) {
+    CardinalityCollectorIVARS *const ivars = CardColl_IVARS(self);
+    S_flush_segment(ivars);
+
+    SortReader *sort_reader = reader
+                              ? (SortReader*)SegReader_Fetch(
+                                    reader, VTable_Get_Name(SORTREADER))
+                              : NULL;
+    SortCache *cache = sort_reader
+                       ? SortReader_Fetch_Sort_Cache(sort_reader,
+                                                     ivars->field)
+                       : NULL;
+    if (cache) {
+        ivars->sort_cache = cache;
+        ivars->null_ord   = SortCache_Get_Null_Ord(cache);
+        ivars->seen
+            = BitVec_new((uint32_t)SortCache_Get_Cardinality(cache));
+    }
+
+    if (ivars->inner_coll) { Coll_Set_Reader(ivars->inner_coll, reader); }
+    Coll_set_reader((Collector*)self, reader);
+}
+
+void
+CardColl_set_base(CardinalityCollector *self, int32_t base) {
+    CardinalityCollectorIVARS *const ivars = CardColl_IVARS(self);
+    if (ivars->inner_coll) { Coll_Set_Base(ivars->inner_coll, base); }
+    Coll_set_base((Collector*)self, base);
+}
+
+void
+CardColl_set_matcher(CardinalityCollector *self, Matcher *matcher) {
+    CardinalityCollectorIVARS *const ivars = CardColl_IVARS(self);
+    if (ivars->inner_coll) { Coll_Set_Matcher(ivars->inner_coll, matcher); }
+    Coll_set_matcher((Collector*)self, matcher);
+}
+
+void
+CardColl_collect(CardinalityCollector *self, int32_t doc_id) {
+    CardinalityCollectorIVARS *const ivars = CardColl_IVARS(self);
+    if (ivars->seen) {
+        int32_t ord = SortCache_Ordinal(ivars->sort_cache, doc_id);
+        if (ord != ivars->null_ord) { BitVec_Set(ivars->seen, ord); }
+    }
+    if (ivars->inner_coll) { Coll_Collect(ivars->inner_coll, doc_id); }
+}
+
+bool
+CardColl_need_score(CardinalityCollector *self) {
+    CardinalityCollectorIVARS *const ivars = CardColl_IVARS(self);
+    return ivars->inner_coll ? Coll_Need_Score(ivars->inner_coll) : false;
+}
+
+HyperLogLog*
+CardColl_get_sketch(CardinalityCollector *self) {
+    CardinalityCollectorIVARS *const ivars = CardColl_IVARS(self);
+    S_flush_segment(ivars);
+    return ivars->sketch;
+}
+
+uint64_t
+CardColl_estimate(CardinalityCollector *self) {
+    return HLL_Estimate(CardColl_Get_Sketch(self));
+}
+
+Collector*
+CardColl_get_inner_collector(CardinalityCollector *self) {
+    return CardColl_IVARS(self)->inner_coll;
+}
+
+
@@ -0,0 +1,187 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define C_LUCY_FACETCOLLECTOR
+#include "Lucy/Util/ToolSet.h"
+
+#include "Lucy/Search/Collector/FacetCollector.h"
+#include "Lucy/Index/SegReader.h"
+#include "Lucy/Index/SortCache.h"
+#include "Lucy/Index/SortReader.h"
+#include "Lucy/Search/Matcher.h"
+
+// Merge the current segment's per-ordinal tallies into the per-field totals,
+// then release them.
+static void
+S_flush_segment(FacetCollectorIVARS *ivars);
+
+FacetCollector*
+FacetColl_new(VArray *fields, Collector *inner_coll) {
+    FacetCollector *self = (FacetCollector*)VTable_Make_Obj(FACETCOLLECTOR);
+    return FacetColl_init(self, fields, inner_coll);
+}
+
+FacetCollector*
+FacetColl_init(FacetCollector *self, VArray *fields, Collector *inner_coll) {
+    FacetCollectorIVARS *const ivars = FacetColl_IVARS(self);
+    Coll_init((Collector*)self);
+    uint32_t num_fields = VA_Get_Size(fields);
+    for (uint32_t i = 0; i < num_fields; i++) {
+        CharBuf *field = (CharBuf*)VA_Fetch(fields, i);
+        if (!field || !Obj_Is_A((Obj*)field, CHARBUF)) {
+            DECREF(self);
+            THROW(ERR, "Facet field names must be strings");
+        }
+    }
+
+    ivars->fields      = VA_Shallow_Copy(fields);
+    ivars->inner_coll  = (Collector*)INCREF(inner_coll);
+    ivars->num_fields  = num_fields;
+    ivars->counts      = (Hash**)MALLOCATE(num_fields * sizeof(Hash*));
+    ivars->sort_caches
+        = (SortCache**)CALLOCATE(num_fields, sizeof(SortCache*));
+    ivars->seg_counts
+        = (uint32_t**)CALLOCATE(num_fields, sizeof(uint32_t*));
+    for (uint32_t i = 0; i < num_fields; i++) {
+        ivars->counts[i] = Hash_new(0);
+    }
+
+    return self;
+}
+
+void
+FacetColl_destroy(FacetCollector *self) {
+    FacetCollectorIVARS *const ivars = FacetColl_IVARS(self);
+    for (uint32_t i = 0; i < ivars->num_fields; i++) {
+        if (ivars->counts)     { DECREF(ivars->counts[i]); }
+        if (ivars->seg_counts) { FREEMEM(ivars->seg_counts[i]); }
+    }
+    FREEMEM(ivars->counts);
+    FREEMEM(ivars->sort_caches);
+    FREEMEM(ivars->seg_counts);
+    DECREF(ivars->fields);
+    DECREF(ivars->inner_coll);
+    SUPER_DESTROY(self, FACETCOLLECTOR);
+}
+
+static void
+S_flush_segment(FacetCollectorIVARS *ivars) {
+    for (uint32_t i = 0; i < ivars->num_fields; i++) {
+        SortCache *cache      = ivars->sort_caches[i];
+        uint32_t  *seg_counts = ivars->seg_counts[i];
+        if (!cache) { continue; }
+
+        Hash    *counts   = ivars->counts[i];
+        Obj     *blank    = SortCache_Make_Blank(cache);
+        int32_t  null_ord = SortCache_Get_Null_Ord(cache);
+        for (int32_t ord = 0, max = SortCache_Get_Cardinality(cache);
+             ord < max;
+             ord++
+            ) {
+            if (!seg_counts[ord] || ord == null_ord) { continue; }
+            Obj *value = SortCache_Value(cache, ord, blank);
+            if (!value) { continue; }
+            Integer64 *total = (Integer64*)Hash_Fetch(counts, value);
+            if (total) {
+                Int64_Set_Value(total, Int64_Get_Value(total) + seg_counts[ord]);
+            }
+            else {
+                Hash_Store(counts, value, (Obj*)Int64_new(seg_counts[ord]));
+            }
+        }
+        DECREF(blank);
+
+        FREEMEM(seg_counts);
+        ivars->seg_counts[i]  = NULL;
+        ivars->sort_caches[i] = NULL;
+    }
+}
+
+void
+FacetColl_set_reader(FacetCollector *self, SegReader *reader) {
+    FacetCollectorIVARS *const ivars = FacetColl_IVARS(self);
+    S_flush_segment(ivars);
+
+    SortReader *sort_reader = reader
+                              ? (SortReader*)SegReader_Fetch(
+                                    reader, VTable_Get_Name(SORTREADER))
+                              : NULL;
+    if (sort_reader) {
+        for (uint32_t i = 0; i < ivars->num_fields; i++) {
+            CharBuf   *field = (CharBuf*)VA_Fetch(ivars->fields, i);
+            SortCache *cache = SortReader_Fetch_Sort_Cache(sort_reader, field);
+            if (cache) {
+                size_t cardinality = (size_t)SortCache_Get_Cardinality(cache);
+                ivars->sort_caches[i] = cache;
+                ivars->seg_counts[i]
+                    = (uint32_t*)CALLOCATE(cardinality, sizeof(uint32_t));
+            }
+        }
+    }
+
+    if (ivars->inner_coll) { Coll_Set_Reader(ivars->inner_coll, reader); }
+    Coll_set_reader((Collector*)self, reader);
+}
+
+void
+FacetColl_set_base(FacetCollector *self, int32_t base) {
+    FacetCollectorIVARS *const ivars = FacetColl_IVARS(self);
+    if (ivars->inner_coll) { Coll_Set_Base(ivars->inner_coll, base); }
+    Coll_set_base((Collector*)self, base);
+}
+
+void
+FacetColl_set_matcher(FacetCollector *self, Matcher *matcher) {
+    FacetCollectorIVARS *const ivars = FacetColl_IVARS(self);
+    if (ivars->inner_coll) { Coll_Set_Matcher(ivars->inner_coll, matcher); }
+    Coll_set_matcher((Collector*)self, matcher);
+}
+
+void
+FacetColl_collect(FacetCollector *self, int32_t doc_id) {
+    FacetCollectorIVARS *const ivars = FacetColl_IVARS(self);
+    for (uint32_t i = 0; i < ivars->num_fields; i++) {
+        SortCache *cache = ivars->sort_caches[i];
+        if (cache) {
+            ivars->seg_counts[i][SortCache_Ordinal(cache, doc_id)]++;
+        }
+    }
+    if (ivars->inner_coll) { Coll_Collect(ivars->inner_coll, doc_id); }
+}
+
+bool
+FacetColl_need_score(FacetCollector *self) {
+    FacetCollectorIVARS *const ivars = FacetColl_IVARS(self);
+    return ivars->inner_coll ? Coll_Need_Score(ivars->inner_coll) : false;
+}
+
+Hash*
+FacetColl_get_counts(FacetCollector *self, const CharBuf *field) {
+    FacetCollectorIVARS *const ivars = FacetColl_IVARS(self);
+    S_flush_segment(ivars);
+    for (uint32_t i = 0; i < ivars->num_fields; i++) {
+        CharBuf *candidate = (CharBuf*)VA_Fetch(ivars->fields, i);
+        if (CB_Equals(candidate, (Obj*)field)) { return ivars->counts[i]; }
+    }
+    return NULL;
+}
+
+Collector*
+FacetColl_get_inner_collector(FacetCollector *self) {
+    return FacetColl_IVARS(self)->inner_coll;
+}
+
+
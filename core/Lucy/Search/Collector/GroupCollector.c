@@ -0,0 +1,512 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define C_LUCY_GROUPCOLLECTOR
+#include "Lucy/Util/ToolSet.h"
+
+#include "Lucy/Search/Collector/GroupCollector.h"
+#include "Lucy/Index/SegReader.h"
+#include "Lucy/Index/SortCache.h"
+#include "Lucy/Index/SortReader.h"
+#include "Lucy/Plan/FieldType.h"
+#include "Lucy/Plan/Schema.h"
+#include "Lucy/Search/Collector/SortCollector.h"
+#include "Lucy/Search/GroupDocs.h"
+#include "Lucy/Search/HitQueue.h"
+#include "Lucy/Search/MatchDoc.h"
+#include "Lucy/Search/Matcher.h"
+#include "Lucy/Search/SortRule.h"
+#include "Lucy/Search/SortSpec.h"
+
+// Markers for ord_slots and null_slot.
+#define GROUP_UNRESOLVED -2
+#define GROUP_UNTRACKED  -1
+
+// Map a segment ordinal to its group's hit counter and slot.
+static void
+S_resolve_ord(GroupCollectorIVARS *ivars, int32_t ord);
+
+// Fill the candidate MatchDoc with the doc id, score and sort values of
+// `doc_id`.
+static void
+S_load_candidate(GroupCollectorIVARS *ivars, int32_t doc_id);
+
+// Start tracking the doc's group in `slot`, with the candidate as its head.
+static void
+S_enter_group(GroupCollectorIVARS *ivars, uint32_t slot, int32_t ord);
+
+// Stop tracking the group in `slot`.
+static void
+S_evict_group(GroupCollectorIVARS *ivars, uint32_t slot);
+
+// Restore heap order after the head at heap position `pos` got weaker than
+// its parent's, or stronger than its children's.
+static void
+S_sift_up(GroupCollectorIVARS *ivars, uint32_t pos);
+static void
+S_sift_down(GroupCollectorIVARS *ivars, uint32_t pos);
+
+GroupCollector*
+GroupColl_new(Schema *schema, const CharBuf *field, SortSpec *sort_spec,
+              uint32_t num_groups, uint32_t docs_per_group,
+              bool count_groups) {
+    GroupCollector *self = (GroupCollector*)VTable_Make_Obj(GROUPCOLLECTOR);
+    return GroupColl_init(self, schema, field, sort_spec, num_groups,
+                          docs_per_group, count_groups);
+}
+
+GroupCollector*
+GroupColl_init(GroupCollector *self, Schema *schema, const CharBuf *field,
+               SortSpec *sort_spec, uint32_t num_groups,
+               uint32_t docs_per_group, bool count_groups) {
+    GroupCollectorIVARS *const ivars = GroupColl_IVARS(self);
+    Coll_init((Collector*)self);
+
+    // Validate.
+    if (!docs_per_group) {
+        DECREF(self);
+        THROW(ERR, "docs_per_group must be greater than 0");
+    }
+    if (sort_spec && !schema) {
+        DECREF(self);
+        THROW(ERR, "Can't supply a SortSpec without a Schema.");
+    }
+    if (schema) {
+        FieldType *type = Schema_Fetch_Type(schema, field);
+        if (!type || !FType_Sortable(type)) {
+            DECREF(self);
+            THROW(ERR, "'%o' isn't a sortable field", field);
+        }
+    }
+
+    ivars->schema         = (Schema*)INCREF(schema);
+    ivars->sort_spec      = (SortSpec*)INCREF(sort_spec);
+    ivars->field          = CB_Clone(field);
+    ivars->group_q        = HitQ_new(sort_spec ? schema : NULL, sort_spec,
+                                     num_groups);
+    ivars->num_groups     = num_groups;
+    ivars->docs_per_group = docs_per_group;
+    ivars->total_hits     = 0;
+    ivars->num_slots      = 0;
+    ivars->heap           = (uint32_t*)MALLOCATE(num_groups
+                                                 * sizeof(uint32_t));
+    ivars->heap_pos       = (uint32_t*)MALLOCATE(num_groups
+                                                 * sizeof(uint32_t));
+    ivars->slot_hits      = (uint32_t*)MALLOCATE(num_groups
+                                                 * sizeof(uint32_t));
+    ivars->collectors     = VA_new(num_groups);
+    ivars->values         = VA_new(num_groups);
+    ivars->heads          = VA_new(num_groups);
+    ivars->group_slots    = Hash_new(num_groups);
+    ivars->group_hits     = Hash_new(0);
+    ivars->null_slot      = GROUP_UNTRACKED;
+    ivars->null_hits      = 0;
+    ivars->slot_segs      = (int32_t*)MALLOCATE(num_groups * sizeof(int32_t));
+    ivars->slot_ords      = (int32_t*)MALLOCATE(num_groups * sizeof(int32_t));
+    ivars->seg_num        = -1;
+    ivars->sort_cache     = NULL;
+    ivars->blank          = NULL;
+    ivars->ord_slots      = NULL;
+    ivars->ord_hits       = NULL;
+    ivars->count_groups   = count_groups;
+
+    // Scores are needed only to rank by score, values only to rank by field.
+    ivars->need_score  = sort_spec ? false : true;
+    ivars->need_values = false;
+    ivars->num_rules   = 0;
+    if (sort_spec) {
+        VArray *rules = SortSpec_Get_Rules(sort_spec);
+        ivars->num_rules = VA_Get_Size(rules);
+        for (uint32_t i = 0; i < ivars->num_rules; i++) {
+            SortRule *rule = (SortRule*)VA_Fetch(rules, i);
+            int32_t   type = SortRule_Get_Type(rule);
+            if (type == SortRule_SCORE)      { ivars->need_score  = true; }
+            else if (type == SortRule_FIELD) { ivars->need_values = true; }
+        }
+    }
+    ivars->rule_caches
+        = (SortCache**)CALLOCATE(ivars->num_rules + 1, sizeof(SortCache*));
+
+    VArray *values = ivars->need_values ? VA_new(ivars->num_rules) : NULL;
+    ivars->candidate = MatchDoc_new(0, F32_NAN, values);
+    DECREF(values);
+
+    return self;
+}
+
+void
+GroupColl_destroy(GroupCollector *self) {
+    GroupCollectorIVARS *const ivars = GroupColl_IVARS(self);
+    DECREF(ivars->schema);
+    DECREF(ivars->sort_spec);
+    DECREF(ivars->field);
+    DECREF(ivars->group_q);
+    DECREF(ivars->collectors);
+    DECREF(ivars->values);
+    DECREF(ivars->heads);
+    DECREF(ivars->candidate);
+    DECREF(ivars->group_slots);
+    DECREF(ivars->group_hits);
+    DECREF(ivars->blank);
+    FREEMEM(ivars->heap);
+    FREEMEM(ivars->heap_pos);
+    FREEMEM(ivars->slot_hits);
+    FREEMEM(ivars->slot_segs);
+    FREEMEM(ivars->slot_ords);
+    FREEMEM(ivars->rule_caches);
+    FREEMEM(ivars->ord_slots);
+    FREEMEM(ivars->ord_hits);
+    SUPER_DESTROY(self, GROUPCOLLECTOR);
+}
+
+void
+GroupColl_set_reader(GroupCollector *self, SegReader *reader) {
+    GroupCollectorIVARS *const ivars = GroupColl_IVARS(self);
+    SortReader *sort_reader = reader
+                              ? (SortReader*)SegReader_Fetch(
+                                    reader, VTable_Get_Name(SORTREADER))
+                              : NULL;
+    SortCache *cache = sort_reader
+                       ? SortReader_Fetch_Sort_Cache(sort_reader,
+                                                     ivars->field)
+                       : NULL;
+
+    // Start a fresh ordinal-to-group mapping.
+    FREEMEM(ivars->ord_slots);
+    FREEMEM(ivars->ord_hits);
+    DECREF(ivars->blank);
+    ivars->ord_slots  = NULL;
+    ivars->ord_hits   = NULL;
+    ivars->blank      = NULL;
+    ivars->sort_cache = cache;
+    if (cache) {
+        int32_t cardinality = SortCache_Get_Cardinality(cache);
+        ivars->ord_slots
+            = (int32_t*)MALLOCATE((cardinality + 1) * sizeof(int32_t));
+        ivars->ord_hits
+            = (Integer32**)CALLOCATE(cardinality + 1, sizeof(Integer32*));
+        for (int32_t i = 0; i <= cardinality; i++) {
+            ivars->ord_slots[i] = GROUP_UNRESOLVED;
+        }
+        ivars->blank = SortCache_Make_Blank(cache);
+    }
+    for (uint32_t i = 0; i < ivars->num_slots; i++) {
+        ivars->slot_ords[i] = -1;
+    }
+    ivars->seg_num++;
+
+    // Find the caches needed to load sort values for candidates.
+    if (ivars->need_values) {
+        VArray *rules = SortSpec_Get_Rules(ivars->sort_spec);
+        for (uint32_t i = 0; i < ivars->num_rules; i++) {
+            SortRule *rule = (SortRule*)VA_Fetch(rules, i);
+            ivars->rule_caches[i]
+                = sort_reader && SortRule_Get_Type(rule) == SortRule_FIELD
+                  ? SortReader_Fetch_Sort_Cache(sort_reader,
+                                                SortRule_Get_Field(rule))
+                  : NULL;
+        }
+    }
+
+    Coll_set_reader((Collector*)self, reader);
+}
+
+static void
+S_resolve_ord(GroupCollectorIVARS *ivars, int32_t ord) {
+    Obj *value = SortCache_Value(ivars->sort_cache, ord, ivars->blank);
+    if (value) {
+        if (ivars->count_groups) {
+            Integer32 *hits
+                = (Integer32*)Hash_Fetch(ivars->group_hits, value);
+            if (!hits) {
+                hits = Int32_new(0);
+                Hash_Store(ivars->group_hits, value, (Obj*)hits);
+            }
+            ivars->ord_hits[ord] = hits;
+        }
+        Integer32 *slot = (Integer32*)Hash_Fetch(ivars->group_slots, value);
+        ivars->ord_slots[ord] = slot ? Int32_Get_Value(slot)
+                                     : GROUP_UNTRACKED;
+    }
+    else {
+        ivars->ord_slots[ord] = ivars->null_slot;
+    }
+    if (ivars->ord_slots[ord] >= 0) {
+        ivars->slot_ords[ivars->ord_slots[ord]] = ord;
+    }
+}
+
+static void
+S_load_candidate(GroupCollectorIVARS *ivars, int32_t doc_id) {
+    MatchDoc *candidate = ivars->candidate;
+    MatchDoc_Set_Doc_ID(candidate, doc_id + ivars->base);
+    if (ivars->need_score) {
+        MatchDoc_Set_Score(candidate, Matcher_Score(ivars->matcher));
+    }
+    if (ivars->need_values) {
+        VArray *values = MatchDoc_Get_Values(candidate);
+        for (uint32_t i = 0; i < ivars->num_rules; i++) {
+            SortCache *cache   = ivars->rule_caches[i];
+            Obj       *old_val = VA_Delete(values, i);
+            if (cache) {
+                int32_t ord   = SortCache_Ordinal(cache, doc_id);
+                Obj    *blank = old_val
+                                ? old_val
+                                : SortCache_Make_Blank(cache);
+                Obj    *val   = SortCache_Value(cache, ord, blank);
+                if (val) { VA_Store(values, i, val); }
+                else     { DECREF(blank); }
+            }
+            else {
+                DECREF(old_val);
+            }
+        }
+    }
+}
+
+static void
+S_enter_group(GroupCollectorIVARS *ivars, uint32_t slot, int32_t ord) {
+    Obj *value = ord >= 0
+                 ? SortCache_Value(ivars->sort_cache, ord, ivars->blank)
+                 : NULL;
+    SortCollector *collector = SortColl_new(ivars->schema, ivars->sort_spec,
+                                            ivars->docs_per_group);
+    VA_Store(ivars->collectors, slot, (Obj*)collector);
+    VA_Store(ivars->values, slot, value ? Obj_Clone(value) : NULL);
+    if (value) {
+        Hash_Store(ivars->group_slots, value, (Obj*)Int32_new(slot));
+    }
+    else {
+        ivars->null_slot = slot;
+    }
+    ivars->slot_segs[slot] = -1;
+    ivars->slot_ords[slot] = ord;
+    ivars->slot_hits[slot] = 0;
+    if (ord >= 0) { ivars->ord_slots[ord] = slot; }
+
+    // The candidate becomes the group's head; allocate a fresh candidate.
+    VArray *values = ivars->need_values ? VA_new(ivars->num_rules) : NULL;
+    VA_Store(ivars->heads, slot, (Obj*)ivars->candidate);
+    ivars->candidate = MatchDoc_new(0, F32_NAN, values);
+    DECREF(values);
+}
+
+static void
+S_evict_group(GroupCollectorIVARS *ivars, uint32_t slot) {
+    Obj *value = VA_Fetch(ivars->values, slot);
+    if (value) { DECREF(Hash_Delete(ivars->group_slots, value)); }
+    else       { ivars->null_slot = GROUP_UNTRACKED; }
+    if (ivars->slot_ords[slot] >= 0) {
+        ivars->ord_slots[ivars->slot_ords[slot]] = GROUP_UNTRACKED;
+    }
+}
+
+static INLINE bool
+SI_weaker(GroupCollectorIVARS *ivars, uint32_t slot_a, uint32_t slot_b) {
+    return HitQ_Less_Than(ivars->group_q, VA_Fetch(ivars->heads, slot_a),
+                          VA_Fetch(ivars->heads, slot_b));
+}
+
+static INLINE void
+SI_heap_swap(GroupCollectorIVARS *ivars, uint32_t pos_a, uint32_t pos_b) {
+    uint32_t *const heap = ivars->heap;
+    const uint32_t slot_a = heap[pos_a];
+    heap[pos_a] = heap[pos_b];
+    heap[pos_b] = slot_a;
+    ivars->heap_pos[heap[pos_a]] = pos_a;
+    ivars->heap_pos[heap[pos_b]] = pos_b;
+}
+
+static void
+S_sift_up(GroupCollectorIVARS *ivars, uint32_t pos) {
+    while (pos > 0) {
+        const uint32_t parent = (pos - 1) / 2;
+        if (!SI_weaker(ivars, ivars->heap[pos], ivars->heap[parent])) {
+            break;
+        }
+        SI_heap_swap(ivars, pos, parent);
+        pos = parent;
+    }
+}
+
+static void
+S_sift_down(GroupCollectorIVARS *ivars, uint32_t pos) {
+    const uint32_t size = ivars->num_slots;
+    while (1) {
+        const uint32_t left  = pos * 2 + 1;
+        const uint32_t right = left + 1;
+        uint32_t child = left;
+        if (left >= size) { break; }
+        if (right < size
+            && SI_weaker(ivars, ivars->heap[right], ivars->heap[left])
+           ) {
+            child = right;
+        }
+        if (!SI_weaker(ivars, ivars->heap[child], ivars->heap[pos])) {
+            break;
+        }
+        SI_heap_swap(ivars, pos, child);
+        pos = child;
+    }
+}
+
+void
+GroupColl_collect(GroupCollector *self, int32_t doc_id) {
+    GroupCollectorIVARS *const ivars = GroupColl_IVARS(self);
+    int32_t ord = -1;
+    int32_t slot;
+
+    ivars->total_hits++;
+
+    // Map the doc's ordinal to a group, resolving the value only once per
+    // ordinal per segment, and count the hit.
+    if (ivars->sort_cache) {
+        ord = SortCache_Ordinal(ivars->sort_cache, doc_id);
+        if (ivars->ord_slots[ord] == GROUP_UNRESOLVED) {
+            S_resolve_ord(ivars, ord);
+        }
+        slot = ivars->ord_slots[ord];
+        if (ivars->count_groups) {
+            Integer32 *hits = ivars->ord_hits[ord];
+            if (hits) { Int32_Set_Value(hits, Int32_Get_Value(hits) + 1); }
+            else      { ivars->null_hits++; }
+        }
+    }
+    else {
+        slot = ivars->null_slot;
+        if (ivars->count_groups) { ivars->null_hits++; }
+    }
+
+    if (slot < 0) {
+        // The group isn't tracked.  Let it in only if there's room, or if
+        // the doc beats the head of the weakest tracked group.
+        if (!ivars->num_groups) { return; }
+        S_load_candidate(ivars, doc_id);
+        if (ivars->num_slots == ivars->num_groups) {
+            // Replace the group at the root of the heap.
+            Obj *bottom_head = VA_Fetch(ivars->heads, ivars->heap[0]);
+            if (!HitQ_Less_Than(ivars->group_q, bottom_head,
+                                (Obj*)ivars->candidate)
+               ) {
+                return;
+            }
+            slot = (int32_t)ivars->heap[0];
+            S_evict_group(ivars, slot);
+            S_enter_group(ivars, slot, ord);
+            S_sift_down(ivars, 0);
+        }
+        else {
+            const uint32_t pos = ivars->num_slots++;
+            slot = (int32_t)pos;
+            ivars->heap[pos]      = pos;
+            ivars->heap_pos[slot] = pos;
+            S_enter_group(ivars, slot, ord);
+            S_sift_up(ivars, pos);
+        }
+    }
+    else {
+        // Promote the doc to group head if it beats the current one.
+        Obj *head = VA_Fetch(ivars->heads, slot);
+        S_load_candidate(ivars, doc_id);
+        if (HitQ_Less_Than(ivars->group_q, head, (Obj*)ivars->candidate)) {
+            MatchDoc *old_head = (MatchDoc*)VA_Delete(ivars->heads, slot);
+            VA_Store(ivars->heads, slot, (Obj*)ivars->candidate);
+            ivars->candidate = old_head;
+            S_sift_down(ivars, ivars->heap_pos[slot]);
+        }
+    }
+    ivars->slot_hits[slot]++;
+
+    // Bring the group's collector up to date with the current segment.
+    Collector *collector = (Collector*)VA_Fetch(ivars->collectors, slot);
+    if (ivars->slot_segs[slot] != ivars->seg_num) {
+        Coll_Set_Reader(collector, ivars->reader);
+        Coll_Set_Base(collector, ivars->base);
+        if (ivars->matcher) { Coll_Set_Matcher(collector, ivars->matcher); }
+        ivars->slot_segs[slot] = ivars->seg_num;
+    }
+
+    SortColl_Collect((SortCollector*)collector, doc_id);
+}
+
+bool
+GroupColl_need_score(GroupCollector *self) {
+    return GroupColl_IVARS(self)->need_score;
+}
+
+VArray*
+GroupColl_pop_groups(GroupCollector *self) {
+    GroupCollectorIVARS *const ivars = GroupColl_IVARS(self);
+    uint32_t   num_slots = ivars->num_slots;
+    HitQueue  *hit_q     = HitQ_new(ivars->sort_spec ? ivars->schema : NULL,
+                                    ivars->sort_spec, ivars->num_groups);
+    Hash      *by_head   = Hash_new(num_slots);
+
+    // Rank groups by their top docs.  Doc ids are unique across groups, so
+    // each group can be found again from its top doc.
+    for (uint32_t i = 0; i < num_slots; i++) {
+        SortCollector *collector
+            = (SortCollector*)VA_Fetch(ivars->collectors, i);
+        Obj    *value      = VA_Fetch(ivars->values, i);
+        VArray *match_docs = SortColl_Pop_Match_Docs(collector);
+        if (VA_Get_Size(match_docs)) {
+            MatchDoc  *head = (MatchDoc*)VA_Fetch(match_docs, 0);
+            Integer32 *key  = Int32_new(MatchDoc_Get_Doc_ID(head));
+            uint32_t   hits = ivars->slot_hits[i];
+            if (ivars->count_groups) {
+                hits = value
+                       ? (uint32_t)Int32_Get_Value((Integer32*)
+                             Hash_Fetch(ivars->group_hits, value))
+                       : ivars->null_hits;
+            }
+            GroupDocs *group_docs = GroupDocs_new(value, match_docs, hits);
+            Hash_Store(by_head, (Obj*)key, (Obj*)group_docs);
+            HitQ_Insert(hit_q, INCREF(head));
+            DECREF(key);
+        }
+        DECREF(match_docs);
+    }
+
+    VArray *heads  = HitQ_Pop_All(hit_q);
+    VArray *groups = VA_new(VA_Get_Size(heads));
+    for (uint32_t i = 0, max = VA_Get_Size(heads); i < max; i++) {
+        MatchDoc  *head = (MatchDoc*)VA_Fetch(heads, i);
+        Integer32 *key  = Int32_new(MatchDoc_Get_Doc_ID(head));
+        VA_Push(groups, INCREF(Hash_Fetch(by_head, (Obj*)key)));
+        DECREF(key);
+    }
+
+    DECREF(heads);
+    DECREF(by_head);
+    DECREF(hit_q);
+    return groups;
+}
+
+uint32_t
+GroupColl_get_total_hits(GroupCollector *self) {
+    return GroupColl_IVARS(self)->total_hits;
+}
+
+uint32_t
+GroupColl_get_total_groups(GroupCollector *self) {
+    GroupCollectorIVARS *const ivars = GroupColl_IVARS(self);
+    if (!ivars->count_groups) {
+        THROW(ERR, "Groups weren't counted: count_groups is false");
+    }
+    return Hash_Get_Size(ivars->group_hits) + (ivars->null_hits ? 1 : 0);
+}
+
+
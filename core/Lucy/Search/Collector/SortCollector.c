@@ -20,6 +20,7 @@
 
 #include "Lucy/Search/Collector/SortCollector.h"
 #include "Lucy/Index/SegReader.h"
+#include "Lucy/Index/Segment.h"
 #include "Lucy/Index/SortCache.h"
 #include "Lucy/Index/SortCache/NumericSortCache.h"
 #include "Lucy/Index/SortCache/TextSortCache.h"
@@ -103,9 +104,11 @@ SortColl_init(SortCollector *self, Schema *schema, SortSpec *sort_spec,
     ivars->bubble_doc    = INT32_MAX;
     ivars->bubble_score  = F32_NEGINF;
     ivars->seg_doc_max   = 0;
+    ivars->total_hits_exact = true;
 
     // Assign.
     ivars->wanted        = wanted;
+    ivars->schema        = (Schema*)INCREF(schema);
 
     // Derive.
     ivars->hit_q         = HitQ_new(schema, sort_spec, wanted);
@@ -166,6 +169,7 @@ void
 SortColl_destroy(SortCollector *self) {
     SortCollectorIVARS *const ivars = SortColl_IVARS(self);
     DECREF(ivars->hit_q);
+    DECREF(ivars->schema);
     DECREF(ivars->rules);
     DECREF(ivars->bumped);
     FREEMEM(ivars->sort_caches);
@@ -221,6 +225,91 @@ S_derive_action(SortRule *rule, SortCache *cache) {
     UNREACHABLE_RETURN(int8_t);
 }
 
+// Return true if the segment's docs were written in an order consistent
+// with our SortRules: the field rules must be a prefix of the segment's index
+// sort, optionally followed by an ascending doc id rule.
+static bool
+S_segment_in_order(SortCollectorIVARS *ivars, SegReader *reader) {
+    Segment *segment = SegReader_Get_Segment(reader);
+    VArray *sort_dump
+        = (VArray*)Seg_Fetch_Metadata_Str(segment, "index_sort", 10);
+    if (!sort_dump || !Obj_Is_A((Obj*)sort_dump, VARRAY)) { return false; }
+    SortSpec *index_sort  = SortSpec_load_rules(sort_dump);
+    VArray   *index_rules = SortSpec_Get_Rules(index_sort);
+    bool      in_order    = true;
+    for (uint32_t i = 0; i < ivars->num_rules; i++) {
+        SortRule *rule = (SortRule*)VA_Fetch(ivars->rules, i);
+        int32_t   type = SortRule_Get_Type(rule);
+        if (type == SortRule_DOC_ID && !SortRule_Get_Reverse(rule)
+            && i == ivars->num_rules - 1
+           ) {
+            break;
+        }
+        SortRule *index_rule = (SortRule*)VA_Fetch(index_rules, i);
+        if (type != SortRule_FIELD
+            || !index_rule
+            || SortRule_Get_Type(index_rule) != SortRule_FIELD
+            || !SortRule_Get_Reverse(rule) != !SortRule_Get_Reverse(index_rule)
+            || !CB_Equals(SortRule_Get_Field(rule),
+                          (Obj*)SortRule_Get_Field(index_rule))
+           ) {
+            in_order = false;
+            break;
+        }
+    }
+    DECREF(index_sort);
+    return in_order;
+}
+
+// Return true once enough hits have been counted that work which only
+// affects the hit count may be skipped.
+static INLINE bool
+SI_past_threshold(SortCollectorIVARS *ivars) {
+    return ivars->total_hits_threshold
+           && ivars->total_hits >= ivars->total_hits_threshold;
+}
+
+// Consult the segment's value stats for the leading sort field: return false
+// if no doc in the segment can displace the worst doc in the full HitQueue.
+static bool
+S_segment_competitive(SortCollectorIVARS *ivars, SegReader *reader) {
+    if (!ivars->wanted
+        || HitQ_Get_Size(ivars->hit_q) < ivars->wanted
+       ) {
+        return true;
+    }
+    SortRule *rule = (SortRule*)VA_Fetch(ivars->rules, 0);
+    if (SortRule_Get_Type(rule) != SortRule_FIELD) { return true; }
+    MatchDoc *worst = (MatchDoc*)HitQ_Peek(ivars->hit_q);
+    VArray *values = MatchDoc_Get_Values(worst);
+    Obj *worst_val = values ? VA_Fetch(values, 0) : NULL;
+    if (!worst_val) { return true; }
+
+    CharBuf *field = SortRule_Get_Field(rule);
+    bool reverse = SortRule_Get_Reverse(rule);
+    SortReader *sort_reader
+        = (SortReader*)SegReader_Fetch(reader, VTable_Get_Name(SORTREADER));
+    Hash *stats = sort_reader
+                  ? SortReader_Fetch_Stats(sort_reader, field)
+                  : NULL;
+    if (!stats) { return true; }
+
+    // Docs without a value sort first in reverse order.
+    if (reverse) {
+        Obj *doc_count = Hash_Fetch_Str(stats, "doc_count", 9);
+        if (!doc_count
+            || Obj_To_I64(doc_count) < SegReader_Doc_Max(reader)
+           ) {
+            return true;
+        }
+    }
+    Obj *bound = Hash_Fetch_Str(stats, reverse ? "max" : "min", 3);
+    if (!bound) { return true; }
+    FieldType *type = Schema_Fetch_Type(ivars->schema, field);
+    int32_t comparison = FType_Compare_Values(type, bound, worst_val);
+    return reverse ? comparison >= 0 : comparison <= 0;
+}
+
 void
 SortColl_set_reader(SortCollector *self, SegReader *reader) {
     SortCollectorIVARS *const ivars = SortColl_IVARS(self);
@@ -249,7 +338,17 @@ SortColl_set_reader(SortCollector *self, SegReader *reader) {
             else       { ivars->ord_arrays[i] = NULL; }
         }
     }
-    ivars->seg_doc_max = reader ? SegReader_Doc_Max(reader) : 0;
+    ivars->seg_doc_max  = reader ? SegReader_Doc_Max(reader) : 0;
+    ivars->seg_done     = false;
+    ivars->seg_in_order = ivars->total_hits_threshold && reader
+                          ? S_segment_in_order(ivars, reader)
+                          : false;
+    if (reader && SI_past_threshold(ivars)
+        && !S_segment_competitive(ivars, reader)
+       ) {
+        ivars->seg_done         = true;
+        ivars->total_hits_exact = false;
+    }
     Coll_set_reader((Collector*)self, reader);
 }
 
@@ -264,11 +363,40 @@ SortColl_get_total_hits(SortCollector *self) {
     return SortColl_IVARS(self)->total_hits;
 }
 
+void
+SortColl_set_total_hits_threshold(SortCollector *self,
+                                  uint32_t total_hits_threshold) {
+    SortColl_IVARS(self)->total_hits_threshold = total_hits_threshold;
+}
+
+bool
+SortColl_total_hits_exact(SortCollector *self) {
+    return SortColl_IVARS(self)->total_hits_exact;
+}
+
+bool
+SortColl_segment_done(SortCollector *self) {
+    return SortColl_IVARS(self)->seg_done;
+}
+
 bool
 SortColl_need_score(SortCollector *self) {
     return SortColl_IVARS(self)->need_score;
 }
 
+// Called when a doc in an in-order segment fails to make the queue: no
+// later doc in the segment can make it either, so once the hit count no
+// longer needs to be exact, stop collecting.
+static INLINE void
+SI_maybe_finish_segment(SortCollectorIVARS *ivars, int32_t doc_id) {
+    if (SI_past_threshold(ivars)) {
+        ivars->seg_done = true;
+        if (doc_id < ivars->seg_doc_max) {
+            ivars->total_hits_exact = false;
+        }
+    }
+}
+
 void
 SortColl_collect(SortCollector *self, int32_t doc_id) {
     SortCollectorIVARS *const ivars = SortColl_IVARS(self);
@@ -317,6 +445,9 @@ SortColl_collect(SortCollector *self, int32_t doc_id) {
                 ivars->bubble_score  = match_doc_ivars->score;
                 ivars->bubble_doc    = doc_id;
                 ivars->actions       = ivars->derived_actions;
+                if (ivars->seg_in_order) {
+                    SI_maybe_finish_segment(ivars, doc_id);
+                }
             }
 
             // Recycle.
@@ -335,6 +466,9 @@ SortColl_collect(SortCollector *self, int32_t doc_id) {
         }
 
     }
+    else if (ivars->seg_in_order) {
+        SI_maybe_finish_segment(ivars, doc_id);
+    }
 }
 
 static INLINE int32_t
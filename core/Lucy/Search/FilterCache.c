@@ -0,0 +1,217 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#define C_LUCY_FILTERCACHE
+#define C_LUCY_FILTERCACHEENTRY
+#include "Lucy/Util/ToolSet.h"
+
+#include "Lucy/Search/FilterCache.h"
+#include "Lucy/Index/SegReader.h"
+#include "Lucy/Object/RoaringBitVector.h"
+#include "Lucy/Search/Query.h"
+
+// Derive the hash key for a Query/segment pair.  Distinct queries which
+// stringify identically share a key; Equals() tells them apart.
+static CharBuf*
+S_make_key(Query *query, const CharBuf *seg_name) {
+    CharBuf *query_string = Query_To_String(query);
+    CharBuf *key = CB_newf("%o %o", seg_name, query_string);
+    DECREF(query_string);
+    return key;
+}
+
+// Remove an entry from the recency list.
+static void
+S_unlink(FilterCacheIVARS *ivars, FilterCacheEntry *entry) {
+    FilterCacheEntryIVARS *const entry_ivars = FCEntry_IVARS(entry);
+    if (entry_ivars->lru_prev) {
+        FCEntry_IVARS(entry_ivars->lru_prev)->lru_next = entry_ivars->lru_next;
+    }
+    else {
+        ivars->lru_head = entry_ivars->lru_next;
+    }
+    if (entry_ivars->lru_next) {
+        FCEntry_IVARS(entry_ivars->lru_next)->lru_prev = entry_ivars->lru_prev;
+    }
+    else {
+        ivars->lru_tail = entry_ivars->lru_prev;
+    }
+    entry_ivars->lru_prev = NULL;
+    entry_ivars->lru_next = NULL;
+}
+
+// Add an entry to the most recently used end of the recency list.
+static void
+S_push_mru(FilterCacheIVARS *ivars, FilterCacheEntry *entry) {
+    FilterCacheEntryIVARS *const entry_ivars = FCEntry_IVARS(entry);
+    entry_ivars->lru_prev = ivars->lru_tail;
+    entry_ivars->lru_next = NULL;
+    if (ivars->lru_tail) {
+        FCEntry_IVARS(ivars->lru_tail)->lru_next = entry;
+    }
+    else {
+        ivars->lru_head = entry;
+    }
+    ivars->lru_tail = entry;
+}
+
+// Remove an entry from the cache, releasing it.
+static void
+S_remove(FilterCacheIVARS *ivars, FilterCacheEntry *entry) {
+    FilterCacheEntryIVARS *const entry_ivars = FCEntry_IVARS(entry);
+    S_unlink(ivars, entry);
+    ivars->num_bytes -= entry_ivars->num_bytes;
+    DECREF(Hash_Delete(ivars->entries, (Obj*)entry_ivars->key));
+}
+
+FilterCache*
+FilterCache_new(uint64_t max_bytes) {
+    FilterCache *self = (FilterCache*)VTable_Make_Obj(FILTERCACHE);
+    return FilterCache_init(self, max_bytes);
+}
+
+FilterCache*
+FilterCache_init(FilterCache *self, uint64_t max_bytes) {
+    FilterCacheIVARS *const ivars = FilterCache_IVARS(self);
+    ivars->entries   = Hash_new(0);
+    ivars->lru_head  = NULL;
+    ivars->lru_tail  = NULL;
+    ivars->max_bytes = max_bytes;
+    ivars->num_bytes = 0;
+    return self;
+}
+
+void
+FilterCache_destroy(FilterCache *self) {
+    FilterCacheIVARS *const ivars = FilterCache_IVARS(self);
+    DECREF(ivars->entries);
+    SUPER_DESTROY(self, FILTERCACHE);
+}
+
+BitVector*
+FilterCache_fetch(FilterCache *self, Query *query, SegReader *reader) {
+    FilterCacheIVARS *const ivars = FilterCache_IVARS(self);
+    CharBuf *seg_name = SegReader_Get_Seg_Name(reader);
+    CharBuf *key      = S_make_key(query, seg_name);
+    FilterCacheEntry *entry
+        = (FilterCacheEntry*)Hash_Fetch(ivars->entries, (Obj*)key);
+    BitVector *retval = NULL;
+
+    if (entry) {
+        FilterCacheEntryIVARS *const entry_ivars = FCEntry_IVARS(entry);
+        if (CB_Equals(entry_ivars->seg_name, (Obj*)seg_name)
+            && Query_Equals(entry_ivars->query, (Obj*)query)
+           ) {
+            S_unlink(ivars, entry);
+            S_push_mru(ivars, entry);
+            retval = (BitVector*)INCREF(entry_ivars->bits);
+        }
+    }
+
+    DECREF(key);
+    return retval;
+}
+
+void
+FilterCache_store(FilterCache *self, Query *query, SegReader *reader,
+                  RoaringBitVector *bits) {
+    FilterCacheIVARS *const ivars = FilterCache_IVARS(self);
+    CharBuf *seg_name = SegReader_Get_Seg_Name(reader);
+    CharBuf *key      = S_make_key(query, seg_name);
+    FilterCacheEntry *entry = FCEntry_new(query, seg_name, bits);
+    FilterCacheEntryIVARS *const entry_ivars = FCEntry_IVARS(entry);
+
+    // Replace any existing entry under the same key.
+    FilterCacheEntry *old
+        = (FilterCacheEntry*)Hash_Fetch(ivars->entries, (Obj*)key);
+    if (old) { S_remove(ivars, old); }
+
+    // Don't let a single oversized entry flush the whole cache.
+    if (entry_ivars->num_bytes > ivars->max_bytes) {
+        DECREF(entry);
+        DECREF(key);
+        return;
+    }
+
+    // Evict the least recently used entries until the new one fits.
+    while (ivars->num_bytes + entry_ivars->num_bytes > ivars->max_bytes) {
+        S_remove(ivars, ivars->lru_head);
+    }
+    entry_ivars->key = key;
+    ivars->num_bytes += entry_ivars->num_bytes;
+    S_push_mru(ivars, entry);
+    Hash_Store(ivars->entries, (Obj*)key, (Obj*)entry);
+}
+
+void
+FilterCache_clear(FilterCache *self) {
+    FilterCacheIVARS *const ivars = FilterCache_IVARS(self);
+    Hash_Clear(ivars->entries);
+    ivars->lru_head  = NULL;
+    ivars->lru_tail  = NULL;
+    ivars->num_bytes = 0;
+}
+
+uint32_t
+FilterCache_get_size(FilterCache *self) {
+    return Hash_Get_Size(FilterCache_IVARS(self)->entries);
+}
+
+uint64_t
+FilterCache_get_num_bytes(FilterCache *self) {
+    return FilterCache_IVARS(self)->num_bytes;
+}
+
+uint64_t
+FilterCache_get_max_bytes(FilterCache *self) {
+    return FilterCache_IVARS(self)->max_bytes;
+}
+
+/**********************************************************************/
+
+FilterCacheEntry*
+FCEntry_new(Query *query, const CharBuf *seg_name, RoaringBitVector *bits) {
+    FilterCacheEntry *self
+        = (FilterCacheEntry*)VTable_Make_Obj(FILTERCACHEENTRY);
+    return FCEntry_init(self, query, seg_name, bits);
+}
+
+FilterCacheEntry*
+FCEntry_init(FilterCacheEntry *self, Query *query, const CharBuf *seg_name,
+             RoaringBitVector *bits) {
+    FilterCacheEntryIVARS *const ivars = FCEntry_IVARS(self);
+    ivars->query     = (Query*)INCREF(query);
+    ivars->seg_name  = CB_Clone((CharBuf*)seg_name);
+    ivars->bits      = (RoaringBitVector*)INCREF(bits);
+    ivars->key       = NULL;
+    ivars->num_bytes = RoarBitVec_Serialized_Size(bits);
+    ivars->lru_prev  = NULL;
+    ivars->lru_next  = NULL;
+    return self;
+}
+
+void
+FCEntry_destroy(FilterCacheEntry *self) {
+    FilterCacheEntryIVARS *const ivars = FCEntry_IVARS(self);
+    DECREF(ivars->query);
+    DECREF(ivars->seg_name);
+    DECREF(ivars->key);
+    DECREF(ivars->bits);
+    SUPER_DESTROY(self, FILTERCACHEENTRY);
+}
+
+
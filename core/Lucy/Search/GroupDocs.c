@@ -0,0 +1,72 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define C_LUCY_GROUPDOCS
+#include "Lucy/Util/ToolSet.h"
+
+#include "Lucy/Search/GroupDocs.h"
+#include "Lucy/Store/InStream.h"
+#include "Lucy/Store/OutStream.h"
+#include "Lucy/Util/Freezer.h"
+
+GroupDocs*
+GroupDocs_new(Obj *value, VArray *match_docs, uint32_t total_hits) {
+    GroupDocs *self = (GroupDocs*)VTable_Make_Obj(GROUPDOCS);
+    return GroupDocs_init(self, value, match_docs, total_hits);
+}
+
+GroupDocs*
+GroupDocs_init(GroupDocs *self, Obj *value, VArray *match_docs,
+               uint32_t total_hits) {
+    TopDocs_init((TopDocs*)self, match_docs, total_hits);
+    GroupDocs_IVARS(self)->value = INCREF(value);
+    return self;
+}
+
+void
+GroupDocs_destroy(GroupDocs *self) {
+    DECREF(GroupDocs_IVARS(self)->value);
+    SUPER_DESTROY(self, GROUPDOCS);
+}
+
+void
+GroupDocs_serialize(GroupDocs *self, OutStream *outstream) {
+    GroupDocsIVARS *const ivars = GroupDocs_IVARS(self);
+    GroupDocs_Serialize_t super_serialize
+        = SUPER_METHOD_PTR(GROUPDOCS, Lucy_GroupDocs_Serialize);
+    super_serialize(self, outstream);
+    OutStream_Write_U8(outstream, ivars->value ? 1 : 0);
+    if (ivars->value) { Freezer_freeze(ivars->value, outstream); }
+}
+
+GroupDocs*
+GroupDocs_deserialize(GroupDocs *self, InStream *instream) {
+    GroupDocs_Deserialize_t super_deserialize
+        = SUPER_METHOD_PTR(GROUPDOCS, Lucy_GroupDocs_Deserialize);
+    self = super_deserialize(self, instream);
+    GroupDocsIVARS *const ivars = GroupDocs_IVARS(self);
+    ivars->value = InStream_Read_U8(instream)
+                   ? Freezer_thaw(instream)
+                   : NULL;
+    return self;
+}
+
+Obj*
+GroupDocs_get_value(GroupDocs *self) {
+    return GroupDocs_IVARS(self)->value;
+}
+
+
@@ -113,20 +113,33 @@ IxSearcher_doc_freq(IndexSearcher *self, const CharBuf *field, Obj *term) {
 
 TopDocs*
 IxSearcher_top_docs(IndexSearcher *self, Query *query, uint32_t num_wanted,
-                    SortSpec *sort_spec) {
+                    SortSpec *sort_spec, uint32_t total_hits_threshold) {
     Schema        *schema    = IxSearcher_Get_Schema(self);
     uint32_t       doc_max   = IxSearcher_Doc_Max(self);
     uint32_t       wanted    = num_wanted > doc_max ? doc_max : num_wanted;
     SortCollector *collector = SortColl_new(schema, sort_spec, wanted);
+    SortColl_Set_Total_Hits_Threshold(collector, total_hits_threshold);
     IxSearcher_Collect(self, query, (Collector*)collector);
     VArray  *match_docs = SortColl_Pop_Match_Docs(collector);
     int32_t  total_hits = SortColl_Get_Total_Hits(collector);
     TopDocs *retval     = TopDocs_new(match_docs, total_hits);
+    TopDocs_Set_Total_Hits_Exact(retval, SortColl_Total_Hits_Exact(collector));
     DECREF(collector);
     DECREF(match_docs);
     return retval;
 }
 
+// Simplify the query via Query_Rewrite(), then compile it.
+static Compiler*
+S_rewrite_and_compile(IndexSearcher *self, Query *query) {
+    Query    *rewritten = Query_Rewrite(query, (Searcher*)self);
+    Compiler *compiler  = Query_Make_Compiler(rewritten, (Searcher*)self,
+                                              Query_Get_Boost(rewritten),
+                                              false);
+    DECREF(rewritten);
+    return compiler;
+}
+
 void
 IxSearcher_collect(IndexSearcher *self, Query *query, Collector *collector) {
     IndexSearcherIVARS *const ivars = IxSearcher_IVARS(self);
@@ -135,8 +148,7 @@ IxSearcher_collect(IndexSearcher *self, Query *query, Collector *collector) {
     bool      need_score        = Coll_Need_Score(collector);
     Compiler *compiler = Query_Is_A(query, COMPILER)
                          ? (Compiler*)INCREF(query)
-                         : Query_Make_Compiler(query, (Searcher*)self,
-                                               Query_Get_Boost(query), false);
+                         : S_rewrite_and_compile(self, query);
 
     // Accumulate hits into the Collector.
     for (uint32_t i = 0, max = VA_Get_Size(seg_readers); i < max; i++) {
@@ -144,13 +156,17 @@ IxSearcher_collect(IndexSearcher *self, Query *query, Collector *collector) {
         DeletionsReader *del_reader = (DeletionsReader*)SegReader_Fetch(
                                           seg_reader,
                                           VTable_Get_Name(DELETIONSREADER));
+        int32_t seg_start = I32Arr_Get(seg_starts, i);
+        Coll_Set_Reader(collector, seg_reader);
+        Coll_Set_Base(collector, seg_start);
+
+        // The Collector may rule out the whole segment up front.
+        if (Coll_Segment_Done(collector)) { continue; }
+
         Matcher *matcher
             = Compiler_Make_Matcher(compiler, seg_reader, need_score);
         if (matcher) {
-            int32_t  seg_start = I32Arr_Get(seg_starts, i);
             Matcher *deletions = DelReader_Iterator(del_reader);
-            Coll_Set_Reader(collector, seg_reader);
-            Coll_Set_Base(collector, seg_start);
             Coll_Set_Matcher(collector, matcher);
             Matcher_Collect(matcher, collector, deletions);
             DECREF(deletions);
@@ -54,6 +54,26 @@ MatchAllMatcher_advance(MatchAllMatcher* self, int32_t target) {
     return MatchAllMatcher_next(self);
 }
 
+uint32_t
+MatchAllMatcher_next_block(MatchAllMatcher *self, int32_t *doc_ids,
+                           float *scores, uint32_t max) {
+    MatchAllMatcherIVARS *const ivars = MatchAllMatcher_IVARS(self);
+    const int32_t remaining = ivars->doc_max - ivars->doc_id;
+    const uint32_t count = remaining <= 0
+                           ? 0
+                           : (uint32_t)remaining < max
+                             ? (uint32_t)remaining
+                             : max;
+    for (uint32_t i = 0; i < count; i++) {
+        doc_ids[i] = ivars->doc_id + 1 + (int32_t)i;
+    }
+    if (scores) {
+        for (uint32_t i = 0; i < count; i++) { scores[i] = ivars->score; }
+    }
+    ivars->doc_id += (int32_t)count;
+    return count;
+}
+
 float
 MatchAllMatcher_score(MatchAllMatcher* self) {
     return MatchAllMatcher_IVARS(self)->score;
@@ -64,4 +84,9 @@ MatchAllMatcher_get_doc_id(MatchAllMatcher* self) {
     return MatchAllMatcher_IVARS(self)->doc_id;
 }
 
+uint32_t
+MatchAllMatcher_cost(MatchAllMatcher *self) {
+    return (uint32_t)MatchAllMatcher_IVARS(self)->doc_max;
+}
+
 
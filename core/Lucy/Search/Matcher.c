@@ -15,6 +15,7 @@
  */
 
 #define C_LUCY_MATCHER
+#define C_LUCY_BLOCKCURSOR
 #define CFISH_USE_SHORT_NAMES
 #define LUCY_USE_SHORT_NAMES
 #define CHY_USE_SHORT_NAMES
@@ -22,6 +23,7 @@
 #include "Lucy/Search/Matcher.h"
 #include "Clownfish/Err.h"
 #include "Clownfish/VTable.h"
+#include "Lucy/Object/BitVector.h"
 #include "Lucy/Search/Collector.h"
 
 Matcher*
@@ -40,53 +42,138 @@ Matcher_advance(Matcher *self, int32_t target) {
     }
 }
 
-void
-Matcher_collect(Matcher *self, Collector *collector, Matcher *deletions) {
-    int32_t doc_id        = 0;
+uint32_t
+Matcher_cost(Matcher *self) {
+    UNUSED_VAR(self);
+    return UINT32_MAX;
+}
+
+BitVector*
+Matcher_dense_bits(Matcher *self) {
+    UNUSED_VAR(self);
+    return NULL;
+}
+
+bool
+Matcher_has_dense_bits(Matcher *self) {
+    return Matcher_Dense_Bits(self) != NULL;
+}
+
+uint32_t
+Matcher_next_block(Matcher *self, int32_t *doc_ids, float *scores,
+                   uint32_t max) {
+    uint32_t count = 0;
+    while (count < max) {
+        const int32_t doc_id = Matcher_Next(self);
+        if (!doc_id) { break; }
+        doc_ids[count] = doc_id;
+        if (scores) { scores[count] = Matcher_Score(self); }
+        count++;
+    }
+    return count;
+}
+
+// Collectors which score call Score() from within Collect(), and only for
+// docs which they find competitive.  Feed them one doc at a time, with the
+// Matcher itself in place, so that deleted and rejected docs never get
+// scored.
+static void
+S_collect_scored(Matcher *self, Collector *collector, Matcher *deletions) {
     int32_t next_deletion = deletions ? 0 : INT32_MAX;
 
     Coll_Set_Matcher(collector, self);
 
     // Execute scoring loop.
     while (1) {
+        const int32_t doc_id = Matcher_Next(self);
+        if (!doc_id) { break; }
         if (doc_id > next_deletion) {
             next_deletion = Matcher_Advance(deletions, doc_id);
             if (next_deletion == 0) { next_deletion = INT32_MAX; }
-            continue;
         }
-        else if (doc_id == next_deletion) {
-            // Skip past deletions.
-            while (doc_id == next_deletion) {
-                // Artifically advance matcher.
-                while (doc_id == next_deletion) {
-                    doc_id++;
+        if (doc_id == next_deletion) { continue; }
+        Coll_Collect(collector, doc_id);
+        if (Coll_Segment_Done(collector)) { break; }
+    }
+
+    Coll_Set_Matcher(collector, NULL);
+}
+
+void
+Matcher_collect(Matcher *self, Collector *collector, Matcher *deletions) {
+    if (Coll_Need_Score(collector)) {
+        S_collect_scored(self, collector, deletions);
+        return;
+    }
+
+    int32_t      doc_ids[MATCHER_BLOCK_SIZE];
+    int32_t      next_deletion = deletions ? 0 : INT32_MAX;
+    BlockCursor *cursor        = BlockCursor_new();
+
+    Coll_Set_Matcher(collector, (Matcher*)cursor);
+
+    // Execute matching loop.  Nothing gets scored.
+    while (1) {
+        uint32_t count = Matcher_Next_Block(self, doc_ids, NULL,
+                                            MATCHER_BLOCK_SIZE);
+        const bool exhausted = count < MATCHER_BLOCK_SIZE;
+
+        // Skip past deletions, compacting the block in place.
+        if (next_deletion != INT32_MAX) {
+            uint32_t num_kept = 0;
+            for (uint32_t i = 0; i < count; i++) {
+                const int32_t doc_id = doc_ids[i];
+                if (doc_id > next_deletion) {
                     next_deletion = Matcher_Advance(deletions, doc_id);
                     if (next_deletion == 0) { next_deletion = INT32_MAX; }
                 }
-                // Verify that the artificial advance actually worked.
-                doc_id = Matcher_Advance(self, doc_id);
-                if (doc_id > next_deletion) {
-                    next_deletion = Matcher_Advance(deletions, doc_id);
+                if (doc_id != next_deletion) {
+                    doc_ids[num_kept++] = doc_id;
                 }
             }
-        }
-        else {
-            doc_id = Matcher_Advance(self, doc_id + 1);
-            if (doc_id >= next_deletion) {
-                next_deletion = Matcher_Advance(deletions, doc_id);
-                if (doc_id == next_deletion) { continue; }
-            }
+            count = num_kept;
         }
 
-        if (doc_id) {
-            Coll_Collect(collector, doc_id);
-        }
-        else {
-            break;
+        if (count) {
+            Coll_Collect_Block(collector, doc_ids, NULL, count);
+            if (Coll_Segment_Done(collector)) { break; }
         }
+        if (exhausted) { break; }
     }
 
     Coll_Set_Matcher(collector, NULL);
+    DECREF(cursor);
+}
+
+BlockCursor*
+BlockCursor_new() {
+    BlockCursor *self = (BlockCursor*)VTable_Make_Obj(BLOCKCURSOR);
+    return BlockCursor_init(self);
+}
+
+BlockCursor*
+BlockCursor_init(BlockCursor *self) {
+    BlockCursorIVARS *const ivars = BlockCursor_IVARS(self);
+    Matcher_init((Matcher*)self);
+    ivars->doc_id = 0;
+    ivars->score  = 0.0f;
+    return self;
+}
+
+int32_t
+BlockCursor_next(BlockCursor *self) {
+    UNUSED_VAR(self);
+    return 0;
+}
+
+int32_t
+BlockCursor_get_doc_id(BlockCursor *self) {
+    return BlockCursor_IVARS(self)->doc_id;
+}
+
+float
+BlockCursor_score(BlockCursor *self) {
+    return BlockCursor_IVARS(self)->score;
 }
 
 
@@ -19,6 +19,7 @@
 
 #include "Lucy/Search/NOTMatcher.h"
 #include "Lucy/Index/Similarity.h"
+#include "Lucy/Object/BitVector.h"
 #include "Lucy/Plan/Schema.h"
 
 NOTMatcher*
@@ -42,6 +43,16 @@ NOTMatcher_init(NOTMatcher *self, Matcher *negated_matcher, int32_t doc_max) {
     ivars->negated_matcher  = (Matcher*)INCREF(negated_matcher);
     ivars->doc_max          = doc_max;
 
+    // If the negated Matcher has a bitmap, invert it once up front rather
+    // than stepping through the negated docs one by one.
+    BitVector *negated_bits = Matcher_Dense_Bits(negated_matcher);
+    ivars->allowed = NULL;
+    if (negated_bits && doc_max > 0) {
+        ivars->allowed = BitVec_new((uint32_t)doc_max + 1);
+        BitVec_Flip_Block(ivars->allowed, 1, (uint32_t)doc_max);
+        BitVec_And_Not(ivars->allowed, negated_bits);
+    }
+
     DECREF(children);
 
     return self;
@@ -51,12 +62,24 @@ void
 NOTMatcher_destroy(NOTMatcher *self) {
     NOTMatcherIVARS *const ivars = NOTMatcher_IVARS(self);
     DECREF(ivars->negated_matcher);
+    DECREF(ivars->allowed);
     SUPER_DESTROY(self, NOTMATCHER);
 }
 
 int32_t
 NOTMatcher_next(NOTMatcher *self) {
     NOTMatcherIVARS *const ivars = NOTMatcher_IVARS(self);
+    if (ivars->allowed) {
+        int32_t hit = BitVec_Next_Hit(ivars->allowed,
+                                      (uint32_t)ivars->doc_id + 1);
+        if (hit < 0 || hit > ivars->doc_max) {
+            ivars->doc_id = ivars->doc_max; // halt advance
+            return 0;
+        }
+        ivars->doc_id = hit;
+        return hit;
+    }
+
     while (1) {
         ivars->doc_id++;
 
@@ -99,4 +122,9 @@ NOTMatcher_score(NOTMatcher *self) {
     return 0.0f;
 }
 
+uint32_t
+NOTMatcher_cost(NOTMatcher *self) {
+    return (uint32_t)NOTMatcher_IVARS(self)->doc_max;
+}
+
 
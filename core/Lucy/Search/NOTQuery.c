@@ -21,7 +21,11 @@
 #include "Lucy/Search/NOTQuery.h"
 #include "Lucy/Index/DocVector.h"
 #include "Lucy/Index/SegReader.h"
+#include "Lucy/Search/CachingFilter.h"
+#include "Lucy/Search/FilterCache.h"
 #include "Lucy/Search/MatchAllMatcher.h"
+#include "Lucy/Search/MatchAllQuery.h"
+#include "Lucy/Search/NoMatchQuery.h"
 #include "Lucy/Search/NOTMatcher.h"
 #include "Lucy/Search/Searcher.h"
 #include "Lucy/Store/InStream.h"
@@ -62,6 +66,40 @@ NOTQuery_to_string(NOTQuery *self) {
     return retval;
 }
 
+Query*
+NOTQuery_rewrite(NOTQuery *self, Searcher *searcher) {
+    NOTQueryIVARS *const ivars = NOTQuery_IVARS(self);
+    Query       *negated   = (Query*)VA_Fetch(ivars->children, 0);
+    Query       *rewritten = Query_Rewrite(negated, searcher);
+    FilterCache *cache     = Searcher_Get_Filter_Cache(searcher);
+    Query       *retval;
+
+    if (Query_Is_A(rewritten, MATCHALLQUERY)) {
+        retval = (Query*)NoMatchQuery_new();
+    }
+    else if (Query_Is_A(rewritten, NOMATCHQUERY)) {
+        retval = (Query*)MatchAllQuery_new();
+        Query_Set_Boost(retval, ivars->boost);
+    }
+    else {
+        if (cache && !Query_Is_A(rewritten, CACHINGFILTER)) {
+            Query *filter = (Query*)CachingFilter_new(rewritten, cache);
+            DECREF(rewritten);
+            rewritten = filter;
+        }
+        if (rewritten == negated) {
+            retval = (Query*)INCREF(self);
+        }
+        else {
+            retval = (Query*)NOTQuery_new(rewritten);
+            Query_Set_Boost(retval, ivars->boost);
+        }
+    }
+
+    DECREF(rewritten);
+    return retval;
+}
+
 bool
 NOTQuery_equals(NOTQuery *self, Obj *other) {
     if ((NOTQuery*)other == self)   { return true; }
@@ -46,4 +46,10 @@ NoMatchMatcher_advance(NoMatchMatcher* self, int32_t target) {
     return 0;
 }
 
+uint32_t
+NoMatchMatcher_cost(NoMatchMatcher *self) {
+    UNUSED_VAR(self);
+    return 0;
+}
+
 
@@ -151,11 +151,31 @@ ORMatcher_advance(ORMatcher *self, int32_t target) {
     } while (true);
 }
 
+uint32_t
+ORMatcher_next_block(ORMatcher *self, int32_t *doc_ids, float *scores,
+                     uint32_t max) {
+    uint32_t count = 0;
+    while (count < max) {
+        const int32_t doc_id = ORMatcher_next(self);
+        if (!doc_id) { break; }
+        doc_ids[count] = doc_id;
+        if (scores) { scores[count] = ORMatcher_Score(self); }
+        count++;
+    }
+    return count;
+}
+
 int32_t
 ORMatcher_get_doc_id(ORMatcher *self) {
     return ORMatcher_IVARS(self)->top_hmd->doc;
 }
 
+float
+ORMatcher_score(ORMatcher *self) {
+    UNUSED_VAR(self);
+    return 0.0f;
+}
+
 static void
 S_clear(ORMatcher *self, ORMatcherIVARS *ivars) {
     UNUSED_VAR(self);
@@ -389,6 +409,21 @@ ORScorer_advance(ORScorer *self, int32_t target) {
     } while (true);
 }
 
+uint32_t
+ORScorer_next_block(ORScorer *self, int32_t *doc_ids, float *scores,
+                    uint32_t max) {
+    ORScorerIVARS *const ivars = ORScorer_IVARS(self);
+    uint32_t count = 0;
+    while (count < max) {
+        const int32_t doc_id = S_advance_after_current(self, ivars);
+        if (!doc_id) { break; }
+        doc_ids[count] = doc_id;
+        if (scores) { scores[count] = ORScorer_score(self); }
+        count++;
+    }
+    return count;
+}
+
 int32_t
 ORScorer_get_doc_id(ORScorer *self) {
     return ORScorer_IVARS(self)->doc_id;
@@ -409,3 +444,15 @@ ORScorer_score(ORScorer *self) {
     return score;
 }
 
+uint32_t
+ORMatcher_cost(ORMatcher *self) {
+    ORMatcherIVARS *const ivars = ORMatcher_IVARS(self);
+    uint64_t cost = 0;
+    for (uint32_t i = 0; i < ivars->num_kids; i++) {
+        Matcher *child = (Matcher*)VA_Fetch(ivars->children, i);
+        if (child) { cost += Matcher_Cost(child); }
+    }
+    return cost > UINT32_MAX ? UINT32_MAX : (uint32_t)cost;
+}
+
+
@@ -21,6 +21,7 @@
 #include "Lucy/Search/ORQuery.h"
 #include "Lucy/Index/SegReader.h"
 #include "Lucy/Index/Similarity.h"
+#include "Lucy/Search/NoMatchQuery.h"
 #include "Lucy/Search/ORMatcher.h"
 #include "Lucy/Search/Searcher.h"
 #include "Lucy/Store/InStream.h"
@@ -47,6 +48,41 @@ ORQuery_make_compiler(ORQuery *self, Searcher *searcher, float boost,
     return (Compiler*)compiler;
 }
 
+Query*
+ORQuery_rewrite(ORQuery *self, Searcher *searcher) {
+    ORQueryIVARS *const ivars = ORQuery_IVARS(self);
+    // Nested ORQueries are left alone, since flattening them would change
+    // the coordination factors used in scoring.
+    VArray *rewritten = ORQuery_Rewrite_Children(self, searcher, false);
+    VArray *kids      = rewritten ? rewritten : ivars->children;
+    VArray *live      = VA_new(VA_Get_Size(kids));
+    Query  *retval;
+
+    // Drop clauses which can never match.
+    for (uint32_t i = 0, max = VA_Get_Size(kids); i < max; i++) {
+        Obj *kid = VA_Fetch(kids, i);
+        if (!Obj_Is_A(kid, NOMATCHQUERY)) { VA_Push(live, INCREF(kid)); }
+    }
+
+    if (VA_Get_Size(live) == 0) {
+        retval = (Query*)NoMatchQuery_new();
+    }
+    else if (VA_Get_Size(live) == 1 && ivars->boost == 1.0f) {
+        retval = (Query*)INCREF(VA_Fetch(live, 0));
+    }
+    else if (rewritten || VA_Get_Size(live) != VA_Get_Size(kids)) {
+        retval = (Query*)ORQuery_new(live);
+        Query_Set_Boost(retval, ivars->boost);
+    }
+    else {
+        retval = (Query*)INCREF(self);
+    }
+
+    DECREF(live);
+    DECREF(rewritten);
+    return retval;
+}
+
 bool
 ORQuery_equals(ORQuery *self, Obj *other) {
     if ((ORQuery*)other == self)   { return true;  }
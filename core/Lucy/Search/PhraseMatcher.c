@@ -24,6 +24,7 @@
 #include "Lucy/Index/PostingList.h"
 #include "Lucy/Index/Similarity.h"
 #include "Lucy/Search/Compiler.h"
+#include "Lucy/Util/IntersectUtils.h"
 
 PhraseMatcher*
 PhraseMatcher_new(Similarity *sim, VArray *plists, Compiler *compiler) {
@@ -58,6 +59,22 @@ PhraseMatcher_init(PhraseMatcher *self, Similarity *similarity, VArray *plists,
         ivars->plists[i] = (PostingList*)INCREF(plist);
     }
 
+    // Derive a second ordering, by ascending doc freq, so that the rarest
+    // term leads when searching for docs which contain all the terms.  The
+    // sort is stable, leaving equally common terms in phrase order.
+    ivars->leads = (PostingList**)MALLOCATE(
+                      ivars->num_elements * sizeof(PostingList*));
+    for (uint32_t i = 0; i < ivars->num_elements; i++) {
+        PostingList *const plist    = ivars->plists[i];
+        const uint32_t     doc_freq = PList_Get_Doc_Freq(plist);
+        uint32_t j = i;
+        while (j > 0 && PList_Get_Doc_Freq(ivars->leads[j - 1]) > doc_freq) {
+            ivars->leads[j] = ivars->leads[j - 1];
+            j--;
+        }
+        ivars->leads[j] = plist;
+    }
+
     // Assign.
     ivars->sim       = (Similarity*)INCREF(similarity);
     ivars->compiler  = (Compiler*)INCREF(compiler);
@@ -74,6 +91,7 @@ PhraseMatcher_destroy(PhraseMatcher *self) {
             DECREF(ivars->plists[i]);
         }
         FREEMEM(ivars->plists);
+        FREEMEM(ivars->leads);
     }
     DECREF(ivars->sim);
     DECREF(ivars->anchor_set);
@@ -88,7 +106,7 @@ PhraseMatcher_next(PhraseMatcher *self) {
         return PhraseMatcher_Advance(self, 1);
     }
     else if (ivars->more) {
-        const int32_t target = PList_Get_Doc_ID(ivars->plists[0]) + 1;
+        const int32_t target = PList_Get_Doc_ID(ivars->leads[0]) + 1;
         return PhraseMatcher_Advance(self, target);
     }
     else {
@@ -99,7 +117,7 @@ PhraseMatcher_next(PhraseMatcher *self) {
 int32_t
 PhraseMatcher_advance(PhraseMatcher *self, int32_t target) {
     PhraseMatcherIVARS *const ivars  = PhraseMatcher_IVARS(self);
-    PostingList **const plists       = ivars->plists;
+    PostingList **const leads        = ivars->leads;
     const uint32_t      num_elements = ivars->num_elements;
     int32_t             highest      = 0;
 
@@ -115,7 +133,7 @@ PhraseMatcher_advance(PhraseMatcher *self, int32_t target) {
 
         // On the first call to Advance(), advance all PostingLists.
         for (size_t i = 0, max = ivars->num_elements; i < max; i++) {
-            int32_t candidate = PList_Advance(plists[i], target);
+            int32_t candidate = PList_Advance(leads[i], target);
             if (!candidate) {
                 ivars->more = false;
                 return 0;
@@ -127,9 +145,10 @@ PhraseMatcher_advance(PhraseMatcher *self, int32_t target) {
         }
     }
     else {
-        // On subsequent iters, advance only one PostingList.  Its new doc ID
-        // becomes the minimum target which all the others must move up to.
-        highest = PList_Advance(plists[0], target);
+        // On subsequent iters, advance only the rarest PostingList.  Its new
+        // doc ID becomes the minimum target which all the others must move up
+        // to.
+        highest = PList_Advance(leads[0], target);
         if (highest == 0) {
             ivars->more = false;
             return 0;
@@ -142,7 +161,7 @@ PhraseMatcher_advance(PhraseMatcher *self, int32_t target) {
 
         // Scoot all posting lists up to at least the current minimum.
         for (uint32_t i = 0; i < num_elements; i++) {
-            PostingList *const plist = plists[i];
+            PostingList *const plist = leads[i];
             int32_t candidate = PList_Get_Doc_ID(plist);
 
             // Is this PostingList already beyond the minimum?  Then raise the
@@ -171,7 +190,7 @@ PhraseMatcher_advance(PhraseMatcher *self, int32_t target) {
         // See whether all the PostingLists have managed to converge on a
         // single doc ID.
         for (uint32_t i = 0; i < num_elements; i++) {
-            const int32_t candidate = PList_Get_Doc_ID(plists[i]);
+            const int32_t candidate = PList_Get_Doc_ID(leads[i]);
             if (candidate != highest) { agreement = false; }
         }
 
@@ -192,57 +211,6 @@ PhraseMatcher_advance(PhraseMatcher *self, int32_t target) {
     }
 }
 
-static INLINE uint32_t
-SI_winnow_anchors(uint32_t *anchors_start, const uint32_t *const anchors_end,
-                  const uint32_t *candidates, const uint32_t *const candidates_end,
-                  uint32_t offset) {
-    uint32_t *anchors = anchors_start;
-    uint32_t *anchors_found = anchors_start;
-    uint32_t target_anchor;
-    uint32_t target_candidate;
-
-    // Safety check, so there's no chance of a bad dereference.
-    if (anchors_start == anchors_end || candidates == candidates_end) {
-        return 0;
-    }
-
-    /* This function is a loop that finds terms that can continue a phrase.
-     * It overwrites the anchors in place, and returns the number remaining.
-     * The basic algorithm is to alternately increment the candidates' pointer
-     * until it is at or beyond its target position, and then increment the
-     * anchors' pointer until it is at or beyond its target.  The non-standard
-     * form is to avoid unnecessary comparisons.  This loop has not been
-     * tested for speed, but glancing at the object code produced (objdump -S)
-     * it appears to be significantly faster than the nested loop alternative.
-     * But given the vagaries of modern processors, it merits actual
-     * testing.*/
-
-SPIN_CANDIDATES:
-    target_candidate = *anchors + offset;
-    while (*candidates < target_candidate) {
-        if (++candidates == candidates_end) { goto DONE; }
-    }
-    if (*candidates == target_candidate) { goto MATCH; }
-    goto SPIN_ANCHORS;
-
-SPIN_ANCHORS:
-    target_anchor = *candidates - offset;
-    while (*anchors < target_anchor) {
-        if (++anchors == anchors_end) { goto DONE; }
-    };
-    if (*anchors == target_anchor) { goto MATCH; }
-    goto SPIN_CANDIDATES;
-
-MATCH:
-    *anchors_found++ = *anchors;
-    if (++anchors == anchors_end) { goto DONE; }
-    goto SPIN_CANDIDATES;
-
-DONE:
-    // Return number of anchors remaining.
-    return anchors_found - anchors_start;
-}
-
 float
 PhraseMatcher_calc_phrase_freq(PhraseMatcher *self) {
     PhraseMatcherIVARS *const ivars = PhraseMatcher_IVARS(self);
@@ -274,8 +242,7 @@ PhraseMatcher_calc_phrase_freq(PhraseMatcher *self) {
 
     size_t    amount        = anchors_remaining * sizeof(uint32_t);
     uint32_t *anchors_start = (uint32_t*)BB_Grow(ivars->anchor_set, amount);
-    uint32_t *anchors_end   = anchors_start + anchors_remaining;
-    memcpy(anchors_start, post_ivars->prox, amount);
+    memcpy(anchors_start, ScorePost_Get_Prox(posting), amount);
 
     // Match the positions of other terms against the anchor set.
     for (uint32_t i = 1, max = ivars->num_elements; i < max; i++) {
@@ -283,18 +250,15 @@ PhraseMatcher_calc_phrase_freq(PhraseMatcher *self) {
         // set (which is a copy), these won't be overwritten.
         ScorePosting *next_post = (ScorePosting*)PList_Get_Posting(plists[i]);
         ScorePostingIVARS *const next_post_ivars = ScorePost_IVARS(next_post);
-        uint32_t *candidates_start = next_post_ivars->prox;
-        uint32_t *candidates_end   = candidates_start + next_post_ivars->freq;
+        uint32_t *candidates_start = ScorePost_Get_Prox(next_post);
 
         // Splice out anchors that don't match the next term.  Bail out if
         // we've eliminated all possible anchors.
         anchors_remaining
-            = SI_winnow_anchors(anchors_start, anchors_end,
-                                candidates_start, candidates_end, i);
+            = Intersect_winnow_exact(anchors_start, anchors_remaining,
+                                     candidates_start,
+                                     next_post_ivars->freq, i);
         if (!anchors_remaining) { return 0.0f; }
-
-        // Adjust end for number of anchors that remain.
-        anchors_end = anchors_start + anchors_remaining;
     }
 
     // The number of anchors left is the phrase freq.
@@ -316,4 +280,15 @@ PhraseMatcher_score(PhraseMatcher *self) {
     return score;
 }
 
+uint32_t
+PhraseMatcher_cost(PhraseMatcher *self) {
+    PhraseMatcherIVARS *const ivars = PhraseMatcher_IVARS(self);
+    uint32_t cost = UINT32_MAX;
+    for (uint32_t i = 0; i < ivars->num_elements; i++) {
+        const uint32_t doc_freq = PList_Get_Doc_Freq(ivars->plists[i]);
+        if (doc_freq < cost) { cost = doc_freq; }
+    }
+    return cost;
+}
+
 
@@ -20,6 +20,8 @@
 #include "Lucy/Util/ToolSet.h"
 
 #include "Lucy/Search/PhraseQuery.h"
+#include "Lucy/Analysis/CommonGramsFilter.h"
+#include "Lucy/Analysis/PolyAnalyzer.h"
 #include "Lucy/Index/DocVector.h"
 #include "Lucy/Index/Posting.h"
 #include "Lucy/Index/Posting/ScorePosting.h"
@@ -125,10 +127,58 @@ PhraseQuery_to_string(PhraseQuery *self) {
     return retval;
 }
 
+// Return the CommonGramsFilter which ends the analysis chain, if any.
+static CommonGramsFilter*
+S_find_common_grams(Analyzer *analyzer) {
+    if (analyzer && Analyzer_Is_A(analyzer, POLYANALYZER)) {
+        VArray *analyzers
+            = PolyAnalyzer_Get_Analyzers((PolyAnalyzer*)analyzer);
+        uint32_t num_analyzers = VA_Get_Size(analyzers);
+        analyzer = num_analyzers
+                   ? (Analyzer*)VA_Fetch(analyzers, num_analyzers - 1)
+                   : NULL;
+    }
+    return analyzer && Analyzer_Is_A(analyzer, COMMONGRAMSFILTER)
+           ? (CommonGramsFilter*)analyzer
+           : NULL;
+}
+
+// If the field's analyzer ends with a CommonGramsFilter, return a copy of
+// the query in which each pair of terms containing a common word has been
+// replaced by the gram indexed for that pair.  Otherwise return NULL.
+static PhraseQuery*
+S_gram_query(PhraseQuery *self, Searcher *searcher) {
+    PhraseQueryIVARS *const ivars = PhraseQuery_IVARS(self);
+    Schema   *schema   = Searcher_Get_Schema(searcher);
+    Analyzer *analyzer = Schema_Fetch_Analyzer(schema, ivars->field);
+    CommonGramsFilter *common_grams = S_find_common_grams(analyzer);
+    if (!common_grams) { return NULL; }
+
+    VArray      *terms  = CommonGrams_Gram_Terms(common_grams, ivars->terms);
+    PhraseQuery *retval = NULL;
+    if (!VA_Equals(terms, (Obj*)ivars->terms)) {
+        retval = PhraseQuery_new(ivars->field, terms);
+        PhraseQuery_Set_Boost(retval, ivars->boost);
+    }
+    DECREF(terms);
+    return retval;
+}
+
 Compiler*
 PhraseQuery_make_compiler(PhraseQuery *self, Searcher *searcher,
                           float boost, bool subordinate) {
     PhraseQueryIVARS *const ivars = PhraseQuery_IVARS(self);
+
+    // Match grams in place of pairs which contain a common word.  Gram terms
+    // come back from Gram_Terms() unchanged, so this recurses only once.
+    PhraseQuery *gram_query = S_gram_query(self, searcher);
+    if (gram_query) {
+        Compiler *compiler = PhraseQuery_Make_Compiler(gram_query, searcher,
+                                                       boost, subordinate);
+        DECREF(gram_query);
+        return compiler;
+    }
+
     if (VA_Get_Size(ivars->terms) == 1) {
         // Optimize for one-term "phrases".
         Obj *term = VA_Fetch(ivars->terms, 0);
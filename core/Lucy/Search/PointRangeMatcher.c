@@ -0,0 +1,101 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#define C_LUCY_POINTRANGEMATCHER
+#include "Lucy/Util/ToolSet.h"
+
+#include "Lucy/Search/PointRangeMatcher.h"
+#include "Lucy/Index/PointIndex.h"
+
+PointRangeMatcher*
+PointRangeMatcher_new(int32_t lower_bound, int32_t upper_bound,
+                      PointIndex *point_index) {
+    PointRangeMatcher *self
+        = (PointRangeMatcher*)VTable_Make_Obj(POINTRANGEMATCHER);
+    return PointRangeMatcher_init(self, lower_bound, upper_bound,
+                                  point_index);
+}
+
+PointRangeMatcher*
+PointRangeMatcher_init(PointRangeMatcher *self, int32_t lower_bound,
+                       int32_t upper_bound, PointIndex *point_index) {
+    Matcher_init((Matcher*)self);
+    PointRangeMatcherIVARS *const ivars = PointRangeMatcher_IVARS(self);
+    ivars->doc_ids  = PointIndex_Find_Docs(point_index, lower_bound,
+                                           upper_bound);
+    ivars->num_docs = I32Arr_Get_Size(ivars->doc_ids);
+    ivars->tick     = 0;
+    ivars->doc_id   = 0;
+    return self;
+}
+
+void
+PointRangeMatcher_destroy(PointRangeMatcher *self) {
+    PointRangeMatcherIVARS *const ivars = PointRangeMatcher_IVARS(self);
+    DECREF(ivars->doc_ids);
+    SUPER_DESTROY(self, POINTRANGEMATCHER);
+}
+
+int32_t
+PointRangeMatcher_next(PointRangeMatcher *self) {
+    PointRangeMatcherIVARS *const ivars = PointRangeMatcher_IVARS(self);
+    if (ivars->tick >= ivars->num_docs) { return 0; }
+    ivars->doc_id = I32Arr_Get(ivars->doc_ids, ivars->tick++);
+    return ivars->doc_id;
+}
+
+int32_t
+PointRangeMatcher_advance(PointRangeMatcher *self, int32_t target) {
+    PointRangeMatcherIVARS *const ivars = PointRangeMatcher_IVARS(self);
+    I32Array *const doc_ids = ivars->doc_ids;
+    uint32_t lo = ivars->tick;
+    uint32_t hi = ivars->num_docs;
+
+    // Gallop ahead to bracket the target, then binary search.
+    uint32_t step = 1;
+    while (lo + step < hi && I32Arr_Get(doc_ids, lo + step) < target) {
+        lo += step;
+        step <<= 1;
+    }
+    if (lo + step < hi) { hi = lo + step + 1; }
+    while (lo < hi) {
+        uint32_t mid = lo + ((hi - lo) >> 1);
+        if (I32Arr_Get(doc_ids, mid) < target) { lo = mid + 1; }
+        else                                   { hi = mid; }
+    }
+
+    ivars->tick = lo;
+    return PointRangeMatcher_next(self);
+}
+
+float
+PointRangeMatcher_score(PointRangeMatcher* self) {
+    UNUSED_VAR(self);
+    return 0.0f;
+}
+
+int32_t
+PointRangeMatcher_get_doc_id(PointRangeMatcher* self) {
+    return PointRangeMatcher_IVARS(self)->doc_id;
+}
+
+uint32_t
+PointRangeMatcher_cost(PointRangeMatcher *self) {
+    return PointRangeMatcher_IVARS(self)->num_docs;
+}
+
+
@@ -66,6 +66,56 @@ PolyQuery_get_children(PolyQuery *self) {
     return PolyQuery_IVARS(self)->children;
 }
 
+// Add a child unless an equal one is already present.  Return true if the
+// child was added.
+static bool
+S_add_unique(VArray *children, Query *child) {
+    for (uint32_t i = 0, max = VA_Get_Size(children); i < max; i++) {
+        Query *existing = (Query*)VA_Fetch(children, i);
+        if (Query_Equals(existing, (Obj*)child)) { return false; }
+    }
+    VA_Push(children, INCREF(child));
+    return true;
+}
+
+VArray*
+PolyQuery_rewrite_children(PolyQuery *self, Searcher *searcher,
+                           bool flatten) {
+    PolyQueryIVARS *const ivars    = PolyQuery_IVARS(self);
+    VTable         *const vtable   = PolyQuery_Get_VTable(self);
+    const uint32_t        num_kids = VA_Get_Size(ivars->children);
+    VArray *rewritten = VA_new(num_kids);
+    bool    changed   = false;
+
+    for (uint32_t i = 0; i < num_kids; i++) {
+        Query *child = (Query*)VA_Fetch(ivars->children, i);
+        Query *new_child = Query_Rewrite(child, searcher);
+        if (new_child != child) { changed = true; }
+        if (flatten
+            && Query_Get_VTable(new_child) == vtable
+            && Query_Get_Boost(new_child) == 1.0f
+           ) {
+            // Pull the grandchildren up a level.
+            VArray *grandkids
+                = PolyQuery_IVARS((PolyQuery*)new_child)->children;
+            for (uint32_t j = 0, max = VA_Get_Size(grandkids); j < max; j++) {
+                S_add_unique(rewritten, (Query*)VA_Fetch(grandkids, j));
+            }
+            changed = true;
+        }
+        else if (!S_add_unique(rewritten, new_child)) {
+            changed = true;
+        }
+        DECREF(new_child);
+    }
+
+    if (!changed) {
+        DECREF(rewritten);
+        return NULL;
+    }
+    return rewritten;
+}
+
 void
 PolyQuery_serialize(PolyQuery *self, OutStream *outstream) {
     PolyQueryIVARS *const ivars = PolyQuery_IVARS(self);
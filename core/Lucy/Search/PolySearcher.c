@@ -115,6 +115,17 @@ PolySearcher_doc_freq(PolySearcher *self, const CharBuf *field, Obj *term) {
     return doc_freq;
 }
 
+// Simplify the query via Query_Rewrite(), then compile it.
+static Compiler*
+S_rewrite_and_compile(PolySearcher *self, Query *query) {
+    Query    *rewritten = Query_Rewrite(query, (Searcher*)self);
+    Compiler *compiler  = Query_Make_Compiler(rewritten, (Searcher*)self,
+                                              Query_Get_Boost(rewritten),
+                                              false);
+    DECREF(rewritten);
+    return compiler;
+}
+
 static void
 S_modify_doc_ids(VArray *match_docs, int32_t base) {
     for (uint32_t i = 0, max = VA_Get_Size(match_docs); i < max; i++) {
@@ -126,7 +137,7 @@ S_modify_doc_ids(VArray *match_docs, int32_t base) {
 
 TopDocs*
 PolySearcher_top_docs(PolySearcher *self, Query *query, uint32_t num_wanted,
-                      SortSpec *sort_spec) {
+                      SortSpec *sort_spec, uint32_t total_hits_threshold) {
     PolySearcherIVARS *const ivars = PolySearcher_IVARS(self);
     Schema   *schema      = PolySearcher_Get_Schema(self);
     VArray   *searchers   = ivars->searchers;
@@ -135,20 +146,23 @@ PolySearcher_top_docs(PolySearcher *self, Query *query, uint32_t num_wanted,
                             ? HitQ_new(schema, sort_spec, num_wanted)
                             : HitQ_new(NULL, NULL, num_wanted);
     uint32_t  total_hits  = 0;
+    bool      total_hits_exact = true;
     Compiler *compiler    = Query_Is_A(query, COMPILER)
                             ? ((Compiler*)INCREF(query))
-                            : Query_Make_Compiler(query, (Searcher*)self,
-                                                  Query_Get_Boost(query),
-                                                  false);
+                            : S_rewrite_and_compile(self, query);
 
     for (uint32_t i = 0, max = VA_Get_Size(searchers); i < max; i++) {
         Searcher   *searcher   = (Searcher*)VA_Fetch(searchers, i);
         int32_t     base       = I32Arr_Get(starts, i);
         TopDocs    *top_docs   = Searcher_Top_Docs(searcher, (Query*)compiler,
-                                                   num_wanted, sort_spec);
+                                                   num_wanted, sort_spec,
+                                                   total_hits_threshold);
         VArray     *sub_match_docs = TopDocs_Get_Match_Docs(top_docs);
 
         total_hits += TopDocs_Get_Total_Hits(top_docs);
+        if (!TopDocs_Get_Total_Hits_Exact(top_docs)) {
+            total_hits_exact = false;
+        }
 
         S_modify_doc_ids(sub_match_docs, base);
         for (uint32_t j = 0, jmax = VA_Get_Size(sub_match_docs); j < jmax; j++) {
@@ -161,6 +175,7 @@ PolySearcher_top_docs(PolySearcher *self, Query *query, uint32_t num_wanted,
 
     VArray  *match_docs = HitQ_Pop_All(hit_q);
     TopDocs *retval     = TopDocs_new(match_docs, total_hits);
+    TopDocs_Set_Total_Hits_Exact(retval, total_hits_exact);
 
     DECREF(match_docs);
     DECREF(compiler);
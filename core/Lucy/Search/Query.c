@@ -30,6 +30,12 @@ Query_init(Query *self, float boost) {
     return self;
 }
 
+Query*
+Query_rewrite(Query *self, Searcher *searcher) {
+    UNUSED_VAR(searcher);
+    return (Query*)INCREF(self);
+}
+
 void
 Query_set_boost(Query *self, float boost) {
     Query_IVARS(self)->boost = boost;
@@ -19,6 +19,14 @@
 
 #include "Lucy/Search/RangeMatcher.h"
 #include "Lucy/Index/SortCache.h"
+#include "Lucy/Object/BitVector.h"
+
+#define BLOCK_SIZE 64
+
+// Test a block of up to 64 docs starting at base and return a mask with a
+// bit set for each doc whose ord falls within the range.
+static uint64_t
+S_match_block(RangeMatcherIVARS *ivars, int32_t base, int32_t count);
 
 RangeMatcher*
 RangeMatcher_new(int32_t lower_bound, int32_t upper_bound, SortCache *sort_cache,
@@ -36,14 +44,23 @@ RangeMatcher_init(RangeMatcher *self, int32_t lower_bound, int32_t upper_bound,
 
     // Init.
     ivars->doc_id       = 0;
+    ivars->block_base   = -BLOCK_SIZE;
+    ivars->block_mask   = 0;
 
     // Assign.
-    ivars->lower_bound  = lower_bound;
+    ivars->lower_bound  = lower_bound < 0 ? 0 : lower_bound;
     ivars->upper_bound  = upper_bound;
     ivars->sort_cache   = (SortCache*)INCREF(sort_cache);
     ivars->doc_max      = doc_max;
 
     // Derive.
+    ivars->ords         = SortCache_Get_Ords(sort_cache);
+    ivars->ord_width    = SortCache_Get_Ord_Width(sort_cache);
+    ivars->native_ords  = SortCache_Get_Native_Ords(sort_cache);
+    if (ivars->lower_bound > ivars->upper_bound) {
+        // Nothing can match, so start out exhausted.
+        ivars->block_base = doc_max;
+    }
 
     return self;
 }
@@ -55,31 +72,136 @@ RangeMatcher_destroy(RangeMatcher *self) {
     SUPER_DESTROY(self, RANGEMATCHER);
 }
 
+static uint64_t
+S_match_block(RangeMatcherIVARS *ivars, int32_t base, int32_t count) {
+    void *const    ords  = ivars->ords;
+    const int32_t  lower = ivars->lower_bound;
+    const int32_t  upper = ivars->upper_bound;
+    // A single unsigned comparison tests both ends of the range.
+    const uint32_t span  = (uint32_t)(upper - lower);
+    uint64_t       mask  = 0;
+
+    switch (ivars->ord_width) {
+        case 1: {
+                // Ords are stored low bit first, so the bits of the block
+                // can be loaded directly.
+                uint8_t *bytes = (uint8_t*)ords + (base >> 3);
+                uint64_t bits  = 0;
+                for (int32_t i = 0, max = (count + 7) >> 3; i < max; i++) {
+                    bits |= (uint64_t)bytes[i] << (i * 8);
+                }
+                if (lower <= 0 && upper >= 0) { mask |= ~bits; }
+                if (lower <= 1 && upper >= 1) { mask |= bits; }
+            }
+            break;
+        case 2:
+            for (int32_t i = 0; i < count; i++) {
+                uint32_t ord = NumUtil_u2get(ords, (uint32_t)(base + i));
+                mask |= (uint64_t)((ord - (uint32_t)lower) <= span) << i;
+            }
+            break;
+        case 4:
+            for (int32_t i = 0; i < count; i++) {
+                uint32_t ord = NumUtil_u4get(ords, (uint32_t)(base + i));
+                mask |= (uint64_t)((ord - (uint32_t)lower) <= span) << i;
+            }
+            break;
+        case 8: {
+                const uint8_t *ints = (uint8_t*)ords + base;
+                for (int32_t i = 0; i < count; i++) {
+                    uint32_t ord = ints[i];
+                    mask |= (uint64_t)((ord - (uint32_t)lower) <= span) << i;
+                }
+            }
+            break;
+        case 16:
+            if (ivars->native_ords) {
+                const uint16_t *ints = (uint16_t*)ords + base;
+                for (int32_t i = 0; i < count; i++) {
+                    uint32_t ord = ints[i];
+                    mask |= (uint64_t)((ord - (uint32_t)lower) <= span) << i;
+                }
+            }
+            else {
+                const uint8_t *bytes
+                    = (uint8_t*)ords + base * sizeof(uint16_t);
+                for (int32_t i = 0; i < count; i++, bytes += 2) {
+                    uint32_t ord = ((uint32_t)bytes[0] << 8) | bytes[1];
+                    mask |= (uint64_t)((ord - (uint32_t)lower) <= span) << i;
+                }
+            }
+            break;
+        case 32:
+            if (ivars->native_ords) {
+                const uint32_t *ints = (uint32_t*)ords + base;
+                for (int32_t i = 0; i < count; i++) {
+                    uint32_t ord = ints[i];
+                    mask |= (uint64_t)((ord - (uint32_t)lower) <= span) << i;
+                }
+            }
+            else {
+                const uint8_t *bytes
+                    = (uint8_t*)ords + base * sizeof(uint32_t);
+                for (int32_t i = 0; i < count; i++, bytes += 4) {
+                    uint32_t ord = ((uint32_t)bytes[0] << 24)
+                                   | ((uint32_t)bytes[1] << 16)
+                                   | ((uint32_t)bytes[2] << 8)
+                                   | bytes[3];
+                    mask |= (uint64_t)((ord - (uint32_t)lower) <= span) << i;
+                }
+            }
+            break;
+        default:
+            THROW(ERR, "Invalid ord width: %i32", ivars->ord_width);
+    }
+
+    // Mask off docs past the end of the block and invalid doc id 0.
+    if (count < BLOCK_SIZE) { mask &= (UINT64_C(1) << count) - 1; }
+    if (base == 0)          { mask &= ~UINT64_C(1); }
+    return mask;
+}
+
 int32_t
 RangeMatcher_next(RangeMatcher* self) {
     RangeMatcherIVARS *const ivars = RangeMatcher_IVARS(self);
-    while (1) {
-        if (++ivars->doc_id > ivars->doc_max) {
-            ivars->doc_id--;
+    while (!ivars->block_mask) {
+        if (ivars->block_base + BLOCK_SIZE > ivars->doc_max) {
             return 0;
         }
-        else {
-            // Check if ord for this document is within the specied range.
-            // TODO: Unroll? i.e. use SortCache_Get_Ords at constructor time
-            // and save ourselves some method call overhead.
-            const int32_t ord
-                = SortCache_Ordinal(ivars->sort_cache, ivars->doc_id);
-            if (ord >= ivars->lower_bound && ord <= ivars->upper_bound) {
-                break;
-            }
-        }
+        ivars->block_base += BLOCK_SIZE;
+        int32_t remaining = ivars->doc_max + 1 - ivars->block_base;
+        ivars->block_mask
+            = S_match_block(ivars, ivars->block_base,
+                            remaining < BLOCK_SIZE ? remaining : BLOCK_SIZE);
     }
+    uint32_t tick = BitVec_ctz64(ivars->block_mask);
+    ivars->block_mask &= ivars->block_mask - 1;
+    ivars->doc_id = ivars->block_base + (int32_t)tick;
     return ivars->doc_id;
 }
 
 int32_t
 RangeMatcher_advance(RangeMatcher* self, int32_t target) {
-    RangeMatcher_IVARS(self)->doc_id = target - 1;
+    RangeMatcherIVARS *const ivars = RangeMatcher_IVARS(self);
+    if (target > ivars->doc_max || ivars->lower_bound > ivars->upper_bound) {
+        ivars->block_base = ivars->doc_max;
+        ivars->block_mask = 0;
+        return 0;
+    }
+    if (target < 1) { target = 1; }
+
+    // Load the block containing the target unless it's already current,
+    // then discard hits which precede the target.
+    int32_t base = target & ~(BLOCK_SIZE - 1);
+    if (base != ivars->block_base) {
+        int32_t remaining = ivars->doc_max + 1 - base;
+        ivars->block_base = base;
+        ivars->block_mask
+            = S_match_block(ivars, base,
+                            remaining < BLOCK_SIZE ? remaining : BLOCK_SIZE);
+    }
+    ivars->block_mask &= ~((UINT64_C(1) << (target - base)) - 1);
+
     return RangeMatcher_next(self);
 }
 
@@ -94,4 +216,9 @@ RangeMatcher_get_doc_id(RangeMatcher* self) {
     return RangeMatcher_IVARS(self)->doc_id;
 }
 
+uint32_t
+RangeMatcher_cost(RangeMatcher *self) {
+    return (uint32_t)RangeMatcher_IVARS(self)->doc_max;
+}
+
 
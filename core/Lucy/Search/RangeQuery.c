@@ -20,11 +20,14 @@
 
 #include "Lucy/Search/RangeQuery.h"
 #include "Lucy/Index/DocVector.h"
+#include "Lucy/Index/PointIndex.h"
 #include "Lucy/Index/SegReader.h"
 #include "Lucy/Index/Similarity.h"
 #include "Lucy/Index/SortReader.h"
 #include "Lucy/Index/SortCache.h"
+#include "Lucy/Plan/FieldType.h"
 #include "Lucy/Plan/Schema.h"
+#include "Lucy/Search/PointRangeMatcher.h"
 #include "Lucy/Search/RangeMatcher.h"
 #include "Lucy/Search/Searcher.h"
 #include "Lucy/Search/Span.h"
@@ -40,6 +43,12 @@ S_find_lower_bound(RangeCompiler *self, SortCache *sort_cache);
 static int32_t
 S_find_upper_bound(RangeCompiler *self, SortCache *sort_cache);
 
+// Consult the segment's recorded min and max values to rule out segments
+// which cannot match without opening the sort cache.
+static bool
+S_segment_may_match(RangeCompiler *self, SortReader *sort_reader,
+                    SegReader *reader);
+
 RangeQuery*
 RangeQuery_new(const CharBuf *field, Obj *lower_term, Obj *upper_term,
                bool include_lower, bool include_upper) {
@@ -193,10 +202,13 @@ RangeCompiler_make_matcher(RangeCompiler *self, SegReader *reader,
     const CharBuf *field = RangeQuery_IVARS(parent)->field;
     SortReader *sort_reader
         = (SortReader*)SegReader_Fetch(reader, VTable_Get_Name(SORTREADER));
+    UNUSED_VAR(need_score);
+    if (sort_reader && !S_segment_may_match(self, sort_reader, reader)) {
+        return NULL;
+    }
     SortCache *sort_cache = sort_reader
                             ? SortReader_Fetch_Sort_Cache(sort_reader, field)
                             : NULL;
-    UNUSED_VAR(need_score);
 
     if (!sort_cache) {
         return NULL;
@@ -210,6 +222,21 @@ RangeCompiler_make_matcher(RangeCompiler *self, SegReader *reader,
         }
         else {
             int32_t doc_max = SegReader_Doc_Max(reader);
+            PointIndex *point_index
+                = SortReader_Fetch_Point_Index(sort_reader, field);
+            if (point_index) {
+                // Only pay for the docs which match when the range is
+                // selective; otherwise a linear scan of the ords is cheaper.
+                int32_t doc_freq
+                    = PointIndex_Doc_Freq(point_index, lower, upper);
+                if (doc_freq == 0) {
+                    return NULL;
+                }
+                else if (doc_freq <= (doc_max >> 3)) {
+                    return (Matcher*)PointRangeMatcher_new(lower, upper,
+                                                           point_index);
+                }
+            }
             return (Matcher*)RangeMatcher_new(lower, upper, sort_cache,
                                               doc_max);
         }
@@ -276,4 +303,54 @@ S_find_upper_bound(RangeCompiler *self, SortCache *sort_cache) {
     return retval;
 }
 
+static bool
+S_comparable(Obj *term, Obj *value) {
+    return Obj_Is_A(term, Obj_Get_VTable(value))
+           || Obj_Is_A(value, Obj_Get_VTable(term));
+}
+
+static bool
+S_segment_may_match(RangeCompiler *self, SortReader *sort_reader,
+                    SegReader *reader) {
+    RangeQuery *parent = (RangeQuery*)RangeCompiler_IVARS(self)->parent;
+    RangeQueryIVARS *const parent_ivars = RangeQuery_IVARS(parent);
+    Hash *stats = SortReader_Fetch_Stats(sort_reader, parent_ivars->field);
+    if (!stats) { return true; }
+
+    Schema    *schema = SegReader_Get_Schema(reader);
+    FieldType *type   = Schema_Fetch_Type(schema, parent_ivars->field);
+    Obj       *min    = Hash_Fetch_Str(stats, "min", 3);
+    Obj       *max    = Hash_Fetch_Str(stats, "max", 3);
+    Obj       *lower_term = parent_ivars->lower_term;
+    Obj       *upper_term = parent_ivars->upper_term;
+    if (!type || !min || !max) { return true; }
+
+    // Terms of the wrong class are left for the sort cache to reject.
+    if (upper_term && S_comparable(upper_term, min)) {
+        int32_t comparison = FType_Compare_Values(type, upper_term, min);
+        if (comparison < 0
+            || (comparison == 0 && !parent_ivars->include_upper)
+           ) {
+            return false;
+        }
+    }
+    if (lower_term && S_comparable(lower_term, max)) {
+        // Without an upper term, the range extends to the NULL ord, so docs
+        // which lack a value still match.
+        int32_t doc_count
+            = (int32_t)Obj_To_I64(Hash_Fetch_Str(stats, "doc_count", 9));
+        bool nulls_match = !upper_term
+                           && doc_count < SegReader_Doc_Max(reader);
+        int32_t comparison = FType_Compare_Values(type, lower_term, max);
+        if (!nulls_match
+            && (comparison > 0
+                || (comparison == 0 && !parent_ivars->include_lower))
+           ) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
 
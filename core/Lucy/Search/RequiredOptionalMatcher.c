@@ -117,4 +117,9 @@ ReqOptMatcher_score(RequiredOptionalMatcher *self) {
     }
 }
 
+uint32_t
+ReqOptMatcher_cost(RequiredOptionalMatcher *self) {
+    return Matcher_Cost(ReqOptMatcher_IVARS(self)->req_matcher);
+}
+
 
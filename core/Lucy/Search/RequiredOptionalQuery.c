@@ -22,6 +22,7 @@
 #include "Lucy/Index/SegReader.h"
 #include "Lucy/Index/Similarity.h"
 #include "Lucy/Plan/Schema.h"
+#include "Lucy/Search/NoMatchQuery.h"
 #include "Lucy/Search/RequiredOptionalMatcher.h"
 #include "Lucy/Search/Searcher.h"
 
@@ -79,6 +80,34 @@ ReqOptQuery_to_string(RequiredOptionalQuery *self) {
     return retval;
 }
 
+Query*
+ReqOptQuery_rewrite(RequiredOptionalQuery *self, Searcher *searcher) {
+    RequiredOptionalQueryIVARS *const ivars = ReqOptQuery_IVARS(self);
+    Query *required = (Query*)VA_Fetch(ivars->children, 0);
+    Query *optional = (Query*)VA_Fetch(ivars->children, 1);
+    Query *new_req  = Query_Rewrite(required, searcher);
+    Query *new_opt  = Query_Rewrite(optional, searcher);
+    Query *retval;
+
+    if (Query_Is_A(new_req, NOMATCHQUERY)) {
+        retval = (Query*)NoMatchQuery_new();
+    }
+    else if (Query_Is_A(new_opt, NOMATCHQUERY) && ivars->boost == 1.0f) {
+        retval = (Query*)INCREF(new_req);
+    }
+    else if (new_req == required && new_opt == optional) {
+        retval = (Query*)INCREF(self);
+    }
+    else {
+        retval = (Query*)ReqOptQuery_new(new_req, new_opt);
+        Query_Set_Boost(retval, ivars->boost);
+    }
+
+    DECREF(new_req);
+    DECREF(new_opt);
+    return retval;
+}
+
 bool
 ReqOptQuery_equals(RequiredOptionalQuery *self, Obj *other) {
     if ((RequiredOptionalQuery*)other == self)   { return true;  }
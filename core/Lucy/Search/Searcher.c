@@ -22,6 +22,7 @@
 #include "Lucy/Index/DocVector.h"
 #include "Lucy/Plan/Schema.h"
 #include "Lucy/Search/Collector.h"
+#include "Lucy/Search/FilterCache.h"
 #include "Lucy/Search/Hits.h"
 #include "Lucy/Search/NoMatchQuery.h"
 #include "Lucy/Search/Query.h"
@@ -35,6 +36,7 @@ Searcher_init(Searcher *self, Schema *schema) {
     SearcherIVARS *const ivars = Searcher_IVARS(self);
     ivars->schema  = (Schema*)INCREF(schema);
     ivars->qparser = NULL;
+    ivars->filter_cache = NULL;
     ABSTRACT_CLASS_CHECK(self, SEARCHER);
     return self;
 }
@@ -44,6 +46,7 @@ Searcher_destroy(Searcher *self) {
     SearcherIVARS *const ivars = Searcher_IVARS(self);
     DECREF(ivars->schema);
     DECREF(ivars->qparser);
+    DECREF(ivars->filter_cache);
     SUPER_DESTROY(self, SEARCHER);
 }
 
@@ -56,7 +59,7 @@ Searcher_hits(Searcher *self, Obj *query, uint32_t offset, uint32_t num_wanted,
                           ? doc_max
                           : offset + num_wanted;
     TopDocs *top_docs   = Searcher_Top_Docs(self, real_query, wanted,
-                                            sort_spec);
+                                            sort_spec, 0);
     Hits    *hits       = Hits_new(self, top_docs, offset);
     DECREF(top_docs);
     DECREF(real_query);
@@ -93,6 +96,19 @@ Searcher_get_schema(Searcher *self) {
     return Searcher_IVARS(self)->schema;
 }
 
+void
+Searcher_set_filter_cache(Searcher *self, FilterCache *cache) {
+    SearcherIVARS *const ivars = Searcher_IVARS(self);
+    FilterCache *old_cache = ivars->filter_cache;
+    ivars->filter_cache = (FilterCache*)INCREF(cache);
+    DECREF(old_cache);
+}
+
+FilterCache*
+Searcher_get_filter_cache(Searcher *self) {
+    return Searcher_IVARS(self)->filter_cache;
+}
+
 void
 Searcher_close(Searcher *self) {
     UNUSED_VAR(self);
@@ -112,4 +112,15 @@ SeriesMatcher_get_doc_id(SeriesMatcher *self) {
     return SeriesMatcher_IVARS(self)->doc_id;
 }
 
+uint32_t
+SeriesMatcher_cost(SeriesMatcher *self) {
+    SeriesMatcherIVARS *const ivars = SeriesMatcher_IVARS(self);
+    uint64_t cost = 0;
+    for (int32_t i = 0; i < ivars->num_matchers; i++) {
+        Matcher *matcher = (Matcher*)VA_Fetch(ivars->matchers, i);
+        if (matcher) { cost += Matcher_Cost(matcher); }
+    }
+    return cost > UINT32_MAX ? UINT32_MAX : (uint32_t)cost;
+}
+
 
@@ -83,4 +83,64 @@ SortSpec_serialize(SortSpec *self, OutStream *target) {
     }
 }
 
+VArray*
+SortSpec_dump_rules(SortSpec *self) {
+    SortSpecIVARS *const ivars = SortSpec_IVARS(self);
+    uint32_t num_rules = VA_Get_Size(ivars->rules);
+    VArray *dump = VA_new(num_rules);
+    for (uint32_t i = 0; i < num_rules; i++) {
+        SortRule *rule = (SortRule*)VA_Fetch(ivars->rules, i);
+        Hash *rule_dump = Hash_new(2);
+        int32_t type = SortRule_Get_Type(rule);
+        if (type == SortRule_FIELD) {
+            Hash_Store_Str(rule_dump, "field", 5,
+                           (Obj*)CB_Clone(SortRule_Get_Field(rule)));
+        }
+        else if (type == SortRule_SCORE) {
+            Hash_Store_Str(rule_dump, "type", 4, (Obj*)CB_newf("score"));
+        }
+        else {
+            Hash_Store_Str(rule_dump, "type", 4, (Obj*)CB_newf("doc_id"));
+        }
+        Hash_Store_Str(rule_dump, "reverse", 7,
+                       (Obj*)(SortRule_Get_Reverse(rule)
+                              ? CFISH_TRUE : CFISH_FALSE));
+        VA_Push(dump, (Obj*)rule_dump);
+    }
+    return dump;
+}
+
+SortSpec*
+SortSpec_load_rules(VArray *dump) {
+    uint32_t num_rules = VA_Get_Size(dump);
+    VArray *rules = VA_new(num_rules);
+    for (uint32_t i = 0; i < num_rules; i++) {
+        Hash *rule_dump = (Hash*)CERTIFY(VA_Fetch(dump, i), HASH);
+        CharBuf *field   = (CharBuf*)Hash_Fetch_Str(rule_dump, "field", 5);
+        CharBuf *type    = (CharBuf*)Hash_Fetch_Str(rule_dump, "type", 4);
+        Obj     *reverse = Hash_Fetch_Str(rule_dump, "reverse", 7);
+        int32_t  rule_type;
+        if (field) {
+            CERTIFY(field, CHARBUF);
+            rule_type = SortRule_FIELD;
+        }
+        else if (type && CB_Equals_Str(type, "score", 5)) {
+            rule_type = SortRule_SCORE;
+        }
+        else if (type && CB_Equals_Str(type, "doc_id", 6)) {
+            rule_type = SortRule_DOC_ID;
+        }
+        else {
+            DECREF(rules);
+            THROW(ERR, "Invalid sort rule dump");
+        }
+        VA_Push(rules, (Obj*)SortRule_new(rule_type, field,
+                                          reverse ? Obj_To_Bool(reverse)
+                                                  : false));
+    }
+    SortSpec *loaded = SortSpec_new(rules);
+    DECREF(rules);
+    return loaded;
+}
+
 
@@ -90,10 +90,57 @@ TermMatcher_advance(TermMatcher *self, int32_t target) {
     return 0;
 }
 
+uint32_t
+TermMatcher_next_block(TermMatcher *self, int32_t *doc_ids, float *scores,
+                       uint32_t max) {
+    TermMatcherIVARS *const ivars = TermMatcher_IVARS(self);
+    PostingList *const plist = ivars->plist;
+    uint32_t count = 0;
+    if (!plist) { return 0; }
+
+    // Look up the scoring routine once rather than once per doc.
+    Matcher_Score_t score
+        = METHOD_PTR(TermMatcher_Get_VTable(self), Lucy_Matcher_Score);
+
+    while (count < max) {
+        const int32_t doc_id = PList_Next(plist);
+        if (!doc_id) {
+            // Reclaim resources a little early.
+            DECREF(plist);
+            ivars->plist = NULL;
+            break;
+        }
+        ivars->posting = PList_Get_Posting(plist);
+        doc_ids[count] = doc_id;
+        if (scores) { scores[count] = score((Matcher*)self); }
+        count++;
+    }
+
+    return count;
+}
+
 int32_t
 TermMatcher_get_doc_id(TermMatcher* self) {
     TermMatcherIVARS *const ivars = TermMatcher_IVARS(self);
     return Post_Get_Doc_ID(ivars->posting);
 }
 
+uint32_t
+TermMatcher_cost(TermMatcher *self) {
+    TermMatcherIVARS *const ivars = TermMatcher_IVARS(self);
+    return ivars->plist ? PList_Get_Doc_Freq(ivars->plist) : 0;
+}
+
+BitVector*
+TermMatcher_dense_bits(TermMatcher *self) {
+    TermMatcherIVARS *const ivars = TermMatcher_IVARS(self);
+    return ivars->plist ? PList_Dense_Bits(ivars->plist) : NULL;
+}
+
+bool
+TermMatcher_has_dense_bits(TermMatcher *self) {
+    TermMatcherIVARS *const ivars = TermMatcher_IVARS(self);
+    return ivars->plist ? PList_Has_Dense_Bits(ivars->plist) : false;
+}
+
 
@@ -0,0 +1,297 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define C_LUCY_TERMSQUERY
+#define C_LUCY_TERMSCOMPILER
+#include "Lucy/Util/ToolSet.h"
+
+#include "Lucy/Search/TermsQuery.h"
+#include "Lucy/Index/Lexicon.h"
+#include "Lucy/Index/LexiconReader.h"
+#include "Lucy/Index/PostingList.h"
+#include "Lucy/Index/PostingListReader.h"
+#include "Lucy/Index/SegReader.h"
+#include "Lucy/Object/BitVector.h"
+#include "Lucy/Search/BitVecMatcher.h"
+#include "Lucy/Search/NoMatchQuery.h"
+#include "Lucy/Search/ORMatcher.h"
+#include "Lucy/Search/Searcher.h"
+#include "Lucy/Store/InStream.h"
+#include "Lucy/Store/OutStream.h"
+#include "Lucy/Util/Freezer.h"
+
+// Up to this many terms present in a segment, their posting lists are merged
+// lazily by an ORMatcher, which can skip ahead when the TermsQuery is
+// intersected with something more selective.  Beyond it, the cost of
+// maintaining the heap makes filling a bit vector up front cheaper.
+#define MAX_HEAPED_TERMS 16
+
+// Lexicon terms to step through before falling back to a Seek().
+#define MAX_SCAN 16
+
+// Sort the terms and remove duplicates.
+static VArray*
+S_sorted_unique(VArray *terms);
+
+// Position the Lexicon at <code>term</code> if it is present, working
+// forward from the Lexicon's current position.  Return true if the term was
+// found.
+static bool
+S_seek_forward(Lexicon *lexicon, Obj *term);
+
+// Set the bit for every doc in a PostingList.
+static void
+S_set_bits(BitVector *bits, PostingList *plist);
+
+TermsQuery*
+TermsQuery_new(const CharBuf *field, VArray *terms) {
+    TermsQuery *self = (TermsQuery*)VTable_Make_Obj(TERMSQUERY);
+    return TermsQuery_init(self, field, terms);
+}
+
+TermsQuery*
+TermsQuery_init(TermsQuery *self, const CharBuf *field, VArray *terms) {
+    Query_init((Query*)self, 0.0f);
+    TermsQueryIVARS *const ivars = TermsQuery_IVARS(self);
+    ivars->field = CB_Clone(field);
+    ivars->terms = NULL;
+    for (uint32_t i = 0, max = VA_Get_Size(terms); i < max; i++) {
+        if (!VA_Fetch(terms, i)) {
+            DECREF(self);
+            THROW(ERR, "TermsQuery terms can't be NULL");
+        }
+    }
+    ivars->terms = S_sorted_unique(terms);
+    return self;
+}
+
+void
+TermsQuery_destroy(TermsQuery *self) {
+    TermsQueryIVARS *const ivars = TermsQuery_IVARS(self);
+    DECREF(ivars->field);
+    DECREF(ivars->terms);
+    SUPER_DESTROY(self, TERMSQUERY);
+}
+
+static VArray*
+S_sorted_unique(VArray *terms) {
+    VArray *sorted = VA_Shallow_Copy(terms);
+    VA_Sort(sorted, NULL, NULL);
+    VArray *unique = VA_new(VA_Get_Size(sorted));
+    Obj    *last   = NULL;
+    for (uint32_t i = 0, max = VA_Get_Size(sorted); i < max; i++) {
+        Obj *term = VA_Fetch(sorted, i);
+        if (!last || !Obj_Equals(term, last)) {
+            VA_Push(unique, Obj_Clone(term));
+            last = term;
+        }
+    }
+    DECREF(sorted);
+    return unique;
+}
+
+void
+TermsQuery_serialize(TermsQuery *self, OutStream *outstream) {
+    TermsQueryIVARS *const ivars = TermsQuery_IVARS(self);
+    Freezer_serialize_charbuf(ivars->field, outstream);
+    Freezer_serialize_varray(ivars->terms, outstream);
+    OutStream_Write_F32(outstream, ivars->boost);
+}
+
+TermsQuery*
+TermsQuery_deserialize(TermsQuery *self, InStream *instream) {
+    TermsQueryIVARS *const ivars = TermsQuery_IVARS(self);
+    ivars->field = Freezer_read_charbuf(instream);
+    ivars->terms = Freezer_read_varray(instream);
+    ivars->boost = InStream_Read_F32(instream);
+    return self;
+}
+
+CharBuf*
+TermsQuery_get_field(TermsQuery *self) {
+    return TermsQuery_IVARS(self)->field;
+}
+
+VArray*
+TermsQuery_get_terms(TermsQuery *self) {
+    return TermsQuery_IVARS(self)->terms;
+}
+
+bool
+TermsQuery_equals(TermsQuery *self, Obj *other) {
+    if ((TermsQuery*)other == self)                   { return true; }
+    if (!Obj_Is_A(other, TERMSQUERY))                 { return false; }
+    TermsQueryIVARS *const ivars = TermsQuery_IVARS(self);
+    TermsQueryIVARS *const ovars = TermsQuery_IVARS((TermsQuery*)other);
+    if (ivars->boost != ovars->boost)                 { return false; }
+    if (!CB_Equals(ivars->field, (Obj*)ovars->field)) { return false; }
+    if (!VA_Equals(ivars->terms, (Obj*)ovars->terms)) { return false; }
+    return true;
+}
+
+CharBuf*
+TermsQuery_to_string(TermsQuery *self) {
+    TermsQueryIVARS *const ivars = TermsQuery_IVARS(self);
+    CharBuf *retval = CB_newf("%o:{", ivars->field);
+    for (uint32_t i = 0, max = VA_Get_Size(ivars->terms); i < max; i++) {
+        CharBuf *term_str = Obj_To_String(VA_Fetch(ivars->terms, i));
+        if (i > 0) { CB_Cat_Trusted_Str(retval, ", ", 2); }
+        CB_Cat(retval, term_str);
+        DECREF(term_str);
+    }
+    CB_Cat_Trusted_Str(retval, "}", 1);
+    return retval;
+}
+
+Compiler*
+TermsQuery_make_compiler(TermsQuery *self, Searcher *searcher, float boost,
+                         bool subordinate) {
+    TermsCompiler *compiler = TermsCompiler_new(self, searcher, boost);
+    if (!subordinate) {
+        TermsCompiler_Normalize(compiler);
+    }
+    return (Compiler*)compiler;
+}
+
+Query*
+TermsQuery_rewrite(TermsQuery *self, Searcher *searcher) {
+    UNUSED_VAR(searcher);
+    if (VA_Get_Size(TermsQuery_IVARS(self)->terms) == 0) {
+        return (Query*)NoMatchQuery_new();
+    }
+    return (Query*)INCREF(self);
+}
+
+/**********************************************************************/
+
+TermsCompiler*
+TermsCompiler_new(TermsQuery *parent, Searcher *searcher, float boost) {
+    TermsCompiler *self = (TermsCompiler*)VTable_Make_Obj(TERMSCOMPILER);
+    return TermsCompiler_init(self, parent, searcher, boost);
+}
+
+TermsCompiler*
+TermsCompiler_init(TermsCompiler *self, TermsQuery *parent,
+                   Searcher *searcher, float boost) {
+    return (TermsCompiler*)Compiler_init((Compiler*)self, (Query*)parent,
+                                         searcher, NULL, boost);
+}
+
+float
+TermsCompiler_sum_of_squared_weights(TermsCompiler *self) {
+    UNUSED_VAR(self);
+    return 0.0f;
+}
+
+static bool
+S_seek_forward(Lexicon *lexicon, Obj *term) {
+    Obj *current = Lex_Get_Term(lexicon);
+    if (current) {
+        // Terms arrive in sorted order, so the target is often only a short
+        // step ahead -- cheaper to reach by scanning than by seeking.
+        for (uint32_t i = 0; i < MAX_SCAN; i++) {
+            int32_t comparison = Obj_Compare_To(current, term);
+            if (comparison == 0)     { return true; }
+            else if (comparison > 0) { return false; }
+            if (!Lex_Next(lexicon))  { return false; }
+            current = Lex_Get_Term(lexicon);
+        }
+    }
+    Lex_Seek(lexicon, term);
+    current = Lex_Get_Term(lexicon);
+    return current != NULL && Obj_Equals(current, term);
+}
+
+static void
+S_set_bits(BitVector *bits, PostingList *plist) {
+    int32_t doc_id;
+    while (0 != (doc_id = PList_Next(plist))) {
+        BitVec_Set(bits, doc_id);
+    }
+}
+
+Matcher*
+TermsCompiler_make_matcher(TermsCompiler *self, SegReader *reader,
+                           bool need_score) {
+    TermsQuery *parent = (TermsQuery*)TermsCompiler_IVARS(self)->parent;
+    TermsQueryIVARS *const parent_ivars = TermsQuery_IVARS(parent);
+    VArray *terms = parent_ivars->terms;
+    LexiconReader *lex_reader
+        = (LexiconReader*)SegReader_Fetch(reader,
+                                          VTable_Get_Name(LEXICONREADER));
+    PostingListReader *plist_reader
+        = (PostingListReader*)SegReader_Fetch(
+              reader, VTable_Get_Name(POSTINGLISTREADER));
+    UNUSED_VAR(need_score);
+    if (!lex_reader || !plist_reader || !VA_Get_Size(terms)) { return NULL; }
+
+    Lexicon *lexicon
+        = LexReader_Lexicon(lex_reader, parent_ivars->field,
+                            VA_Fetch(terms, 0));
+    if (!lexicon) { return NULL; }
+
+    // Walk the Lexicon once, opening a PostingList for each term present
+    // until there are too many to merge with a heap.
+    const uint32_t num_terms = VA_Get_Size(terms);
+    VArray    *plists = VA_new(MAX_HEAPED_TERMS);
+    BitVector *bits   = NULL;
+    uint32_t   i      = 0;
+    for (; i < num_terms; i++) {
+        if (!S_seek_forward(lexicon, VA_Fetch(terms, i))) { continue; }
+        if (VA_Get_Size(plists) == MAX_HEAPED_TERMS) { break; }
+        PostingList *plist
+            = PListReader_Posting_List(plist_reader, parent_ivars->field,
+                                       NULL);
+        PList_Seek_Lex(plist, lexicon);
+        VA_Push(plists, (Obj*)plist);
+    }
+
+    if (i < num_terms) {
+        // Too many terms: OR all their posting lists into a bit vector,
+        // starting with the ones already opened.
+        bits = BitVec_new(SegReader_Doc_Max(reader) + 1);
+        for (uint32_t j = 0, max = VA_Get_Size(plists); j < max; j++) {
+            S_set_bits(bits, (PostingList*)VA_Fetch(plists, j));
+        }
+        PostingList *plist
+            = PListReader_Posting_List(plist_reader, parent_ivars->field,
+                                       NULL);
+        PList_Seek_Lex(plist, lexicon); // Already positioned at term i.
+        S_set_bits(bits, plist);
+        while (++i < num_terms) {
+            if (S_seek_forward(lexicon, VA_Fetch(terms, i))) {
+                PList_Seek_Lex(plist, lexicon);
+                S_set_bits(bits, plist);
+            }
+        }
+        DECREF(plist);
+    }
+
+    Matcher *retval = NULL;
+    if (bits) {
+        retval = (Matcher*)BitVecMatcher_new(bits);
+        DECREF(bits);
+    }
+    else if (VA_Get_Size(plists)) {
+        retval = (Matcher*)ORMatcher_new(plists);
+    }
+
+    DECREF(plists);
+    DECREF(lexicon);
+    return retval;
+}
+
+
@@ -37,6 +37,7 @@ TopDocs_init(TopDocs *self, VArray *match_docs, uint32_t total_hits) {
     TopDocsIVARS *const ivars = TopDocs_IVARS(self);
     ivars->match_docs = (VArray*)INCREF(match_docs);
     ivars->total_hits = total_hits;
+    ivars->total_hits_exact = true;
     return self;
 }
 
@@ -52,6 +53,7 @@ TopDocs_serialize(TopDocs *self, OutStream *outstream) {
     TopDocsIVARS *const ivars = TopDocs_IVARS(self);
     Freezer_serialize_varray(ivars->match_docs, outstream);
     OutStream_Write_C32(outstream, ivars->total_hits);
+    OutStream_Write_U8(outstream, ivars->total_hits_exact ? 1 : 0);
 }
 
 TopDocs*
@@ -59,6 +61,7 @@ TopDocs_deserialize(TopDocs *self, InStream *instream) {
     TopDocsIVARS *const ivars = TopDocs_IVARS(self);
     ivars->match_docs = Freezer_read_varray(instream);
     ivars->total_hits = InStream_Read_C32(instream);
+    ivars->total_hits_exact = !!InStream_Read_U8(instream);
     return self;
 }
 
@@ -83,4 +86,14 @@ TopDocs_set_total_hits(TopDocs *self, uint32_t total_hits) {
     TopDocs_IVARS(self)->total_hits = total_hits;
 }
 
+bool
+TopDocs_get_total_hits_exact(TopDocs *self) {
+    return TopDocs_IVARS(self)->total_hits_exact;
+}
+
+void
+TopDocs_set_total_hits_exact(TopDocs *self, bool total_hits_exact) {
+    TopDocs_IVARS(self)->total_hits_exact = total_hits_exact;
+}
+
 
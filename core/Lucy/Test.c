@@ -24,6 +24,7 @@
 
 #include "Lucy/Test/Analysis/TestAnalyzer.h"
 #include "Lucy/Test/Analysis/TestCaseFolder.h"
+#include "Lucy/Test/Analysis/TestCommonGramsFilter.h"
 #include "Lucy/Test/Analysis/TestNormalizer.h"
 #include "Lucy/Test/Analysis/TestPolyAnalyzer.h"
 #include "Lucy/Test/Analysis/TestRegexTokenizer.h"
@@ -32,36 +33,52 @@
 #include "Lucy/Test/Analysis/TestStandardTokenizer.h"
 #include "Lucy/Test/Highlight/TestHeatMap.h"
 #include "Lucy/Test/Highlight/TestHighlighter.h"
+#include "Lucy/Test/Index/TestBM25Similarity.h"
+#include "Lucy/Test/Index/TestDeletionsWriter.h"
 #include "Lucy/Test/Index/TestDocWriter.h"
 #include "Lucy/Test/Index/TestHighlightWriter.h"
 #include "Lucy/Test/Index/TestIndexManager.h"
 #include "Lucy/Test/Index/TestPolyReader.h"
 #include "Lucy/Test/Index/TestPostingListWriter.h"
+#include "Lucy/Test/Index/TestScorePosting.h"
+#include "Lucy/Test/Index/TestSegPostingList.h"
 #include "Lucy/Test/Index/TestSegWriter.h"
 #include "Lucy/Test/Index/TestSegment.h"
 #include "Lucy/Test/Index/TestSnapshot.h"
+#include "Lucy/Test/Index/TestSortCache.h"
 #include "Lucy/Test/Index/TestTermInfo.h"
 #include "Lucy/Test/Object/TestBitVector.h"
+#include "Lucy/Test/Object/TestHyperLogLog.h"
+#include "Lucy/Test/Object/TestRoaringBitVector.h"
 #include "Lucy/Test/Object/TestI32Array.h"
 #include "Lucy/Test/Plan/TestBlobType.h"
 #include "Lucy/Test/Plan/TestFieldMisc.h"
 #include "Lucy/Test/Plan/TestFieldType.h"
 #include "Lucy/Test/Plan/TestFullTextType.h"
 #include "Lucy/Test/Plan/TestNumericType.h"
+#include "Lucy/Test/Search/TestCachingFilter.h"
+#include "Lucy/Test/Search/TestFacetCollector.h"
+#include "Lucy/Test/Search/TestAggregationCollector.h"
+#include "Lucy/Test/Search/TestGroupCollector.h"
+#include "Lucy/Test/Search/TestCardinalityCollector.h"
 #include "Lucy/Test/Search/TestLeafQuery.h"
 #include "Lucy/Test/Search/TestMatchAllQuery.h"
+#include "Lucy/Test/Search/TestMatcherBlocks.h"
+#include "Lucy/Test/Search/TestMatcherCost.h"
 #include "Lucy/Test/Search/TestNOTQuery.h"
 #include "Lucy/Test/Search/TestNoMatchQuery.h"
 #include "Lucy/Test/Search/TestPhraseQuery.h"
 #include "Lucy/Test/Search/TestPolyQuery.h"
 #include "Lucy/Test/Search/TestQueryParserLogic.h"
 #include "Lucy/Test/Search/TestQueryParserSyntax.h"
+#include "Lucy/Test/Search/TestQueryRewrite.h"
 #include "Lucy/Test/Search/TestRangeQuery.h"
 #include "Lucy/Test/Search/TestReqOptQuery.h"
 #include "Lucy/Test/Search/TestSeriesMatcher.h"
 #include "Lucy/Test/Search/TestSortSpec.h"
 #include "Lucy/Test/Search/TestSpan.h"
 #include "Lucy/Test/Search/TestTermQuery.h"
+#include "Lucy/Test/Search/TestTermsQuery.h"
 #include "Lucy/Test/Store/TestCompoundFileReader.h"
 #include "Lucy/Test/Store/TestCompoundFileWriter.h"
 #include "Lucy/Test/Store/TestFSDirHandle.h"
@@ -77,6 +94,7 @@
 #include "Lucy/Test/Store/TestRAMFolder.h"
 #include "Lucy/Test/TestSchema.h"
 #include "Lucy/Test/Util/TestIndexFileNames.h"
+#include "Lucy/Test/Util/TestIntersectUtils.h"
 #include "Lucy/Test/Util/TestJson.h"
 #include "Lucy/Test/Util/TestMemoryPool.h"
 #include "Lucy/Test/Util/TestPriorityQueue.h"
@@ -87,8 +105,11 @@ Test_create_test_suite() {
 
     TestSuite_Add_Batch(suite, (TestBatch*)TestPriQ_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestBitVector_new());
+    TestSuite_Add_Batch(suite, (TestBatch*)TestRoarBitVec_new());
+    TestSuite_Add_Batch(suite, (TestBatch*)TestHLL_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestMemPool_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestIxFileNames_new());
+    TestSuite_Add_Batch(suite, (TestBatch*)TestIntersect_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestJson_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestI32Arr_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestRAMFH_new());
@@ -110,6 +131,7 @@ Test_create_test_suite() {
     TestSuite_Add_Batch(suite, (TestBatch*)TestCaseFolder_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestRegexTokenizer_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestSnowStop_new());
+    TestSuite_Add_Batch(suite, (TestBatch*)TestCommonGrams_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestSnowStemmer_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestNormalizer_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestStandardTokenizer_new());
@@ -120,30 +142,44 @@ Test_create_test_suite() {
     TestSuite_Add_Batch(suite, (TestBatch*)TestDocWriter_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestHLWriter_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestPListWriter_new());
+    TestSuite_Add_Batch(suite, (TestBatch*)TestScorePost_new());
+    TestSuite_Add_Batch(suite, (TestBatch*)TestSegPList_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestSegWriter_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestPolyReader_new());
+    TestSuite_Add_Batch(suite, (TestBatch*)TestDelWriter_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestFullTextType_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestBlobType_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestNumericType_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestFType_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestSeg_new());
+    TestSuite_Add_Batch(suite, (TestBatch*)TestSortCache_new());
+    TestSuite_Add_Batch(suite, (TestBatch*)TestBM25Sim_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestHighlighter_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestSpan_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestHeatMap_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestTermQuery_new());
+    TestSuite_Add_Batch(suite, (TestBatch*)TestTermsQuery_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestPhraseQuery_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestSortSpec_new());
+    TestSuite_Add_Batch(suite, (TestBatch*)TestFacetCollector_new());
+    TestSuite_Add_Batch(suite, (TestBatch*)TestAggColl_new());
+    TestSuite_Add_Batch(suite, (TestBatch*)TestGroupColl_new());
+    TestSuite_Add_Batch(suite, (TestBatch*)TestCardColl_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestRangeQuery_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestANDQuery_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestMatchAllQuery_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestNOTQuery_new());
+    TestSuite_Add_Batch(suite, (TestBatch*)TestCachingFilter_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestReqOptQuery_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestLeafQuery_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestNoMatchQuery_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestSeriesMatcher_new());
+    TestSuite_Add_Batch(suite, (TestBatch*)TestMatcherBlocks_new());
+    TestSuite_Add_Batch(suite, (TestBatch*)TestMatcherCost_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestORQuery_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestQPLogic_new());
     TestSuite_Add_Batch(suite, (TestBatch*)TestQPSyntax_new());
+    TestSuite_Add_Batch(suite, (TestBatch*)TestQueryRewrite_new());
 
     return suite;
 }
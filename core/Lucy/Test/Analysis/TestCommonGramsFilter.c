@@ -0,0 +1,357 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define C_TESTLUCY_TESTCOMMONGRAMSFILTER
+#define TESTLUCY_USE_SHORT_NAMES
+#include "Lucy/Util/ToolSet.h"
+
+#include "Clownfish/TestHarness/TestBatchRunner.h"
+#include "Lucy/Test.h"
+#include "Lucy/Test/Analysis/TestCommonGramsFilter.h"
+#include "Lucy/Test/TestUtils.h"
+#include "Lucy/Analysis/CommonGramsFilter.h"
+#include "Lucy/Analysis/Inversion.h"
+#include "Lucy/Analysis/PolyAnalyzer.h"
+#include "Lucy/Analysis/StandardTokenizer.h"
+#include "Lucy/Analysis/Token.h"
+#include "Lucy/Document/Doc.h"
+#include "Lucy/Index/Indexer.h"
+#include "Lucy/Plan/FullTextType.h"
+#include "Lucy/Plan/Schema.h"
+#include "Lucy/Object/BitVector.h"
+#include "Lucy/Search/Collector.h"
+#include "Lucy/Search/Compiler.h"
+#include "Lucy/Search/Hits.h"
+#include "Lucy/Search/IndexSearcher.h"
+#include "Lucy/Search/PhraseQuery.h"
+#include "Lucy/Search/QueryParser.h"
+#include "Lucy/Search/TermQuery.h"
+#include "Lucy/Store/RAMFolder.h"
+
+TestCommonGramsFilter*
+TestCommonGrams_new() {
+    return (TestCommonGramsFilter*)VTable_Make_Obj(TESTCOMMONGRAMSFILTER);
+}
+
+static CommonGramsFilter*
+S_make_filter(void *unused, ...) {
+    va_list args;
+    Hash *common_words = Hash_new(0);
+    char *word;
+
+    va_start(args, unused);
+    while (NULL != (word = va_arg(args, char*))) {
+        Hash_Store_Str(common_words, word, strlen(word), (Obj*)CB_newf(""));
+    }
+    va_end(args);
+
+    CommonGramsFilter *self = CommonGrams_new(NULL, common_words);
+    DECREF(common_words);
+    return self;
+}
+
+static Analyzer*
+S_make_analyzer() {
+    VArray *analyzers = VA_new(2);
+    VA_Push(analyzers, (Obj*)StandardTokenizer_new());
+    VA_Push(analyzers, (Obj*)S_make_filter(NULL, "the", "of", NULL));
+    PolyAnalyzer *analyzer = PolyAnalyzer_new(NULL, analyzers);
+    DECREF(analyzers);
+    return (Analyzer*)analyzer;
+}
+
+static void
+test_Dump_Load_and_Equals(TestBatchRunner *runner) {
+    CommonGramsFilter *filter = S_make_filter(NULL, "the", "of", "a", NULL);
+    CommonGramsFilter *other  = S_make_filter(NULL, "the", "of", NULL);
+    CommonGramsFilter *english
+        = CommonGrams_new((CharBuf*)ZCB_WRAP_STR("en", 2), NULL);
+    Obj *dump         = (Obj*)CommonGrams_Dump(filter);
+    Obj *english_dump = (Obj*)CommonGrams_Dump(english);
+    CommonGramsFilter *clone
+        = (CommonGramsFilter*)CommonGrams_Load(other, dump);
+    CommonGramsFilter *english_clone
+        = (CommonGramsFilter*)CommonGrams_Load(other, english_dump);
+
+    TEST_FALSE(runner, CommonGrams_Equals(filter, (Obj*)other),
+               "Equals() false with different common words");
+    TEST_TRUE(runner, CommonGrams_Equals(filter, (Obj*)clone),
+              "Dump => Load round trip");
+    TEST_TRUE(runner, CommonGrams_Equals(english, (Obj*)english_clone),
+              "Dump => Load round trip with language");
+    TEST_TRUE(runner,
+              CommonGrams_Is_Common(english,
+                                    (CharBuf*)ZCB_WRAP_STR("the", 3)),
+              "Snowball stoplist supplies common words");
+
+    DECREF(filter);
+    DECREF(other);
+    DECREF(english);
+    DECREF(dump);
+    DECREF(english_dump);
+    DECREF(clone);
+    DECREF(english_clone);
+}
+
+static void
+test_analysis(TestBatchRunner *runner) {
+    Analyzer *analyzer = S_make_analyzer();
+    CharBuf  *source   = CB_newf("the who sang of love");
+    VArray   *wanted   = VA_new(8);
+    VA_Push(wanted, (Obj*)CB_newf("the who"));
+    VA_Push(wanted, (Obj*)CB_newf("the"));
+    VA_Push(wanted, (Obj*)CB_newf("who"));
+    VA_Push(wanted, (Obj*)CB_newf("sang of"));
+    VA_Push(wanted, (Obj*)CB_newf("sang"));
+    VA_Push(wanted, (Obj*)CB_newf("of love"));
+    VA_Push(wanted, (Obj*)CB_newf("of"));
+    VA_Push(wanted, (Obj*)CB_newf("love"));
+    TestUtils_test_analyzer(runner, analyzer, source, wanted,
+                            "grams for pairs with common words");
+
+    // Each gram shares the position of its first word, and its offsets span
+    // both words.
+    Inversion *inversion = Analyzer_Transform_Text(analyzer, source);
+    Inversion_Invert(inversion);
+    int32_t  the_who_pos = -1;
+    int32_t  sang_of_pos = -1;
+    int32_t  love_pos    = -1;
+    uint32_t sang_of_start = 0;
+    uint32_t sang_of_end   = 0;
+    Token *token;
+    while (NULL != (token = Inversion_Next(inversion))) {
+        const char *text = Token_Get_Text(token);
+        if (strcmp(text, "the who") == 0) {
+            the_who_pos = Token_Get_Pos(token);
+        }
+        else if (strcmp(text, "sang of") == 0) {
+            sang_of_pos   = Token_Get_Pos(token);
+            sang_of_start = Token_Get_Start_Offset(token);
+            sang_of_end   = Token_Get_End_Offset(token);
+        }
+        else if (strcmp(text, "love") == 0) {
+            love_pos = Token_Get_Pos(token);
+        }
+    }
+    TEST_TRUE(runner, the_who_pos == 0 && sang_of_pos == 2,
+              "grams share the position of their first word");
+    TEST_INT_EQ(runner, love_pos, 4, "grams don't advance the position");
+    TEST_TRUE(runner, sang_of_start == 8 && sang_of_end == 15,
+              "gram offsets span both words");
+    TEST_INT_EQ(runner, Inversion_Get_Size(inversion), 8,
+                "grams are part of the Inversion");
+    TEST_INT_EQ(runner, Inversion_Get_Length(inversion), 5,
+                "grams don't count toward the length");
+
+    // Other Tokens which share a position, such as synonyms, still count.
+    Inversion *synonyms = Inversion_new(NULL);
+    Inversion_Append(synonyms, Token_new("big", 3, 0, 3, 1.0f, 0));
+    Inversion_Append(synonyms, Token_new("large", 5, 0, 5, 1.0f, 1));
+    TEST_INT_EQ(runner, Inversion_Get_Length(synonyms), 2,
+                "overlapping tokens which aren't grams count");
+    DECREF(synonyms);
+
+    DECREF(inversion);
+    DECREF(wanted);
+    DECREF(source);
+    DECREF(analyzer);
+}
+
+// Split a comma-separated list of terms.
+static VArray*
+S_split(const char *terms) {
+    VArray *split = VA_new(0);
+    while (true) {
+        const char *comma = strchr(terms, ',');
+        size_t len = comma ? (size_t)(comma - terms) : strlen(terms);
+        VA_Push(split, (Obj*)CB_new_from_utf8(terms, len));
+        if (!comma) { break; }
+        terms = comma + 1;
+    }
+    return split;
+}
+
+static void
+S_check_gram_terms(TestBatchRunner *runner, CommonGramsFilter *filter,
+                   const char *source, const char *expected) {
+    VArray *terms  = S_split(source);
+    VArray *wanted = S_split(expected);
+    VArray *got    = CommonGrams_Gram_Terms(filter, terms);
+    TEST_TRUE(runner, VA_Equals(got, (Obj*)wanted),
+              "Gram_Terms: [%s] => [%s]", source, expected);
+    DECREF(got);
+    DECREF(wanted);
+    DECREF(terms);
+}
+
+static void
+test_Gram_Terms(TestBatchRunner *runner) {
+    CommonGramsFilter *filter = S_make_filter(NULL, "the", "of", NULL);
+    S_check_gram_terms(runner, filter, "the,who,sang", "the who,who,sang");
+    S_check_gram_terms(runner, filter, "who,sang,the", "who,sang the");
+    S_check_gram_terms(runner, filter, "the,the who,who", "the who");
+    S_check_gram_terms(runner, filter, "love,of,the,who",
+                       "love of,of the,the who");
+    S_check_gram_terms(runner, filter, "who,sang", "who,sang");
+    S_check_gram_terms(runner, filter, "the who", "the who");
+    S_check_gram_terms(runner, filter, "the who,sang,the", "the who,sang,the");
+    DECREF(filter);
+}
+
+static const char *docs[] = {
+    "the who sang of love",
+    "who sang the song",
+    "the song of the who",
+    "sang of the who",
+    "love the who",
+    "of who the",
+    NULL
+};
+
+static const char *phrases[] = {
+    "\"the who\"",
+    "\"who the\"",
+    "\"sang of the\"",
+    "\"who sang\"",
+    "\"of the who\"",
+    "\"the song of\"",
+    "\"love the\"",
+    "\"the the\"",
+    NULL
+};
+#define NUM_PHRASES 8
+
+static uint32_t
+S_count_hits(IndexSearcher *searcher, Schema *schema, const char *field,
+             const char *phrase) {
+    VArray *fields = VA_new(1);
+    VA_Push(fields, (Obj*)CB_newf("%s", field));
+    QueryParser *qparser = QParser_new(schema, NULL, NULL, fields);
+    CharBuf     *qstring = CB_newf("%s", phrase);
+    Query       *query   = QParser_Parse(qparser, qstring);
+    Hits        *hits    = IxSearcher_Hits(searcher, (Obj*)query, 0, 10,
+                                           NULL);
+    uint32_t     count   = Hits_Total_Hits(hits);
+    DECREF(hits);
+    DECREF(query);
+    DECREF(qstring);
+    DECREF(qparser);
+    DECREF(fields);
+    return count;
+}
+
+// Compile a PhraseQuery without rewriting it, and count its hits.
+static uint32_t
+S_count_compiled(IndexSearcher *searcher, const char *field,
+                 const char *terms) {
+    CharBuf     *field_name = CB_newf("%s", field);
+    VArray      *term_array = S_split(terms);
+    PhraseQuery *query      = PhraseQuery_new(field_name, term_array);
+    Compiler    *compiler   = PhraseQuery_Make_Compiler(query,
+                                                        (Searcher*)searcher,
+                                                        1.0f, false);
+    BitVector    *bit_vec   = BitVec_new(IxSearcher_Doc_Max(searcher) + 1);
+    BitCollector *collector = BitColl_new(bit_vec);
+    IxSearcher_Collect(searcher, (Query*)compiler, (Collector*)collector);
+    uint32_t count = BitVec_Count(bit_vec);
+    DECREF(collector);
+    DECREF(bit_vec);
+    DECREF(compiler);
+    DECREF(query);
+    DECREF(term_array);
+    DECREF(field_name);
+    return count;
+}
+
+static void
+test_phrase_search(TestBatchRunner *runner) {
+    Schema   *schema    = Schema_new();
+    Analyzer *tokenizer = (Analyzer*)StandardTokenizer_new();
+    Analyzer *analyzer  = S_make_analyzer();
+    FullTextType *plain_type = FullTextType_new(tokenizer);
+    FullTextType *grams_type = FullTextType_new(analyzer);
+    CharBuf *plain = (CharBuf*)ZCB_WRAP_STR("plain", 5);
+    CharBuf *grams = (CharBuf*)ZCB_WRAP_STR("grams", 5);
+    Schema_Spec_Field(schema, plain, (FieldType*)plain_type);
+    Schema_Spec_Field(schema, grams, (FieldType*)grams_type);
+
+    RAMFolder *folder  = RAMFolder_new(NULL);
+    Indexer   *indexer = Indexer_new(schema, (Obj*)folder, NULL, 0);
+    for (uint32_t i = 0; docs[i] != NULL; i++) {
+        Doc     *doc   = Doc_new(NULL, 0);
+        CharBuf *value = CB_newf("%s", docs[i]);
+        Doc_Store(doc, plain, (Obj*)value);
+        Doc_Store(doc, grams, (Obj*)value);
+        Indexer_Add_Doc(indexer, doc, 1.0f);
+        DECREF(value);
+        DECREF(doc);
+    }
+    Indexer_Commit(indexer);
+    DECREF(indexer);
+
+    IndexSearcher *searcher = IxSearcher_new((Obj*)folder);
+
+    VArray *terms = S_split("the,who");
+    PhraseQuery *phrase_query = PhraseQuery_new(grams, terms);
+    Compiler *compiler
+        = PhraseQuery_Make_Compiler(phrase_query, (Searcher*)searcher,
+                                    1.0f, false);
+    Query   *parent = Compiler_Get_Parent(compiler);
+    CharBuf *wanted = CB_newf("the who");
+    TEST_TRUE(runner,
+              Query_Is_A(parent, TERMQUERY)
+              && CB_Equals(wanted, TermQuery_Get_Term((TermQuery*)parent)),
+              "Make_Compiler() substitutes grams");
+    DECREF(wanted);
+    DECREF(compiler);
+    DECREF(phrase_query);
+    DECREF(terms);
+
+    TEST_TRUE(runner,
+              S_count_compiled(searcher, "grams", "the,who")
+              == S_count_compiled(searcher, "plain", "the,who")
+              && S_count_compiled(searcher, "grams", "of,the,who")
+                 == S_count_compiled(searcher, "plain", "of,the,who")
+              && S_count_compiled(searcher, "grams", "of,the,who") == 2,
+              "compiled phrases match grams without Rewrite()");
+
+    for (uint32_t i = 0; phrases[i] != NULL; i++) {
+        uint32_t expected = S_count_hits(searcher, schema, "plain",
+                                         phrases[i]);
+        uint32_t got      = S_count_hits(searcher, schema, "grams",
+                                         phrases[i]);
+        TEST_INT_EQ(runner, got, expected, "Same hits for %s", phrases[i]);
+    }
+
+    DECREF(searcher);
+    DECREF(folder);
+    DECREF(plain_type);
+    DECREF(grams_type);
+    DECREF(analyzer);
+    DECREF(tokenizer);
+    DECREF(schema);
+}
+
+void
+TestCommonGrams_run(TestCommonGramsFilter *self, TestBatchRunner *runner) {
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 22 + NUM_PHRASES);
+    test_Dump_Load_and_Equals(runner);
+    test_analysis(runner);
+    test_Gram_Terms(runner);
+    test_phrase_search(runner);
+}
+
+
@@ -0,0 +1,280 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define C_TESTLUCY_TESTBM25SIMILARITY
+#define TESTLUCY_USE_SHORT_NAMES
+#include "Lucy/Util/ToolSet.h"
+#include <math.h>
+
+#include "Clownfish/TestHarness/TestBatchRunner.h"
+#include "Lucy/Test.h"
+#include "Lucy/Test/Index/TestBM25Similarity.h"
+#include "Lucy/Analysis/StandardTokenizer.h"
+#include "Lucy/Document/Doc.h"
+#include "Lucy/Document/HitDoc.h"
+#include "Lucy/Index/BM25Similarity.h"
+#include "Lucy/Index/Indexer.h"
+#include "Lucy/Index/PolyReader.h"
+#include "Lucy/Index/SegReader.h"
+#include "Lucy/Index/Segment.h"
+#include "Lucy/Index/Similarity.h"
+#include "Lucy/Plan/Schema.h"
+#include "Lucy/Search/Hits.h"
+#include "Lucy/Search/IndexSearcher.h"
+#include "Lucy/Store/InStream.h"
+#include "Lucy/Store/OutStream.h"
+#include "Lucy/Store/RAMFile.h"
+#include "Lucy/Store/RAMFolder.h"
+#include "Lucy/Util/Freezer.h"
+
+BM25TestType*
+BM25TestType_new() {
+    BM25TestType *self = (BM25TestType*)VTable_Make_Obj(BM25TESTTYPE);
+    return BM25TestType_init(self);
+}
+
+BM25TestType*
+BM25TestType_init(BM25TestType *self) {
+    StandardTokenizer *tokenizer = StandardTokenizer_new();
+    FullTextType_init((FullTextType*)self, (Analyzer*)tokenizer);
+    DECREF(tokenizer);
+    return self;
+}
+
+Similarity*
+BM25TestType_make_similarity(BM25TestType *self) {
+    UNUSED_VAR(self);
+    return (Similarity*)BM25Sim_new(1.2f, 0.75f);
+}
+
+TestBM25Similarity*
+TestBM25Sim_new() {
+    return (TestBM25Similarity*)VTable_Make_Obj(TESTBM25SIMILARITY);
+}
+
+static bool
+S_close_to(double got, double expected) {
+    return fabs(got - expected) < 1e-5 * fabs(expected);
+}
+
+static Schema*
+S_create_schema() {
+    Schema       *schema  = Schema_new();
+    BM25TestType *type    = BM25TestType_new();
+    CharBuf      *content = (CharBuf*)ZCB_WRAP_STR("content", 7);
+    Schema_Spec_Field(schema, content, (FieldType*)type);
+    DECREF(type);
+    return schema;
+}
+
+// Add one segment containing a doc for each NULL-terminated string.
+static void
+S_add_docs(RAMFolder *folder, const char **texts, bool optimize) {
+    Schema  *schema  = S_create_schema();
+    Indexer *indexer = Indexer_new(schema, (Obj*)folder, NULL, 0);
+    CharBuf *content = (CharBuf*)ZCB_WRAP_STR("content", 7);
+    for (uint32_t i = 0; texts[i] != NULL; i++) {
+        Doc     *doc   = Doc_new(NULL, 0);
+        CharBuf *value = CB_newf("%s", texts[i]);
+        Doc_Store(doc, content, (Obj*)value);
+        Indexer_Add_Doc(indexer, doc, 1.0f);
+        DECREF(value);
+        DECREF(doc);
+    }
+    if (optimize) { Indexer_Optimize(indexer); }
+    Indexer_Commit(indexer);
+    DECREF(indexer);
+    DECREF(schema);
+}
+
+// Return the score of each doc matching <code>query</code>, indexed by doc
+// id.
+static float*
+S_scores(RAMFolder *folder, const char *query, int32_t *doc_max) {
+    IndexSearcher *searcher = IxSearcher_new((Obj*)folder);
+    CharBuf *query_str = CB_newf("%s", query);
+    Hits    *hits      = IxSearcher_Hits(searcher, (Obj*)query_str, 0, 100,
+                                         NULL);
+    *doc_max = IxSearcher_Doc_Max(searcher);
+    float   *scores = (float*)CALLOCATE(*doc_max + 1, sizeof(float));
+    HitDoc  *hit;
+    while (NULL != (hit = Hits_Next(hits))) {
+        scores[HitDoc_Get_Doc_ID(hit)] = HitDoc_Get_Score(hit);
+        DECREF(hit);
+    }
+    DECREF(hits);
+    DECREF(query_str);
+    DECREF(searcher);
+    return scores;
+}
+
+static void
+test_field_stats(TestBatchRunner *runner) {
+    RAMFolder  *folder  = RAMFolder_new(NULL);
+    CharBuf    *content = (CharBuf*)ZCB_WRAP_STR("content", 7);
+    const char *first[]  = { "a", "a b", "a b c", NULL };
+    const char *second[] = { "w x y z", "w x y z", NULL };
+
+    S_add_docs(folder, first, false);
+    PolyReader *reader  = PolyReader_open((Obj*)folder, NULL, NULL);
+    SegReader  *seg_reader
+        = (SegReader*)VA_Fetch(PolyReader_Get_Seg_Readers(reader), 0);
+    Segment    *segment = SegReader_Get_Segment(seg_reader);
+    Hash       *meta
+        = (Hash*)Seg_Fetch_Metadata_Str(segment, "postings", 8);
+    Hash       *field_stats
+        = meta ? (Hash*)Hash_Fetch_Str(meta, "field_stats", 11) : NULL;
+    Hash       *stats
+        = field_stats ? (Hash*)Hash_Fetch(field_stats, (Obj*)content) : NULL;
+    TEST_TRUE(runner, stats != NULL, "postings metadata has field_stats");
+    if (stats) {
+        TEST_INT_EQ(runner, Obj_To_I64(Hash_Fetch_Str(stats, "num_docs", 8)),
+                    3, "num_docs");
+        TEST_INT_EQ(runner,
+                    Obj_To_I64(Hash_Fetch_Str(stats, "num_tokens", 10)),
+                    6, "num_tokens");
+    }
+    else {
+        SKIP(runner, "no field_stats");
+        SKIP(runner, "no field_stats");
+    }
+    TEST_FLOAT_EQ(runner, BM25Sim_avg_field_length(segment, content), 2.0,
+                  "avg_field_length");
+    CharBuf *missing = (CharBuf*)ZCB_WRAP_STR("missing", 7);
+    TEST_TRUE(runner, BM25Sim_avg_field_length(segment, missing) == 0.0,
+              "avg_field_length for unknown field");
+    DECREF(reader);
+
+    // Stats are carried over when segments are merged.
+    S_add_docs(folder, second, true);
+    reader     = PolyReader_open((Obj*)folder, NULL, NULL);
+    seg_reader = (SegReader*)VA_Fetch(PolyReader_Get_Seg_Readers(reader), 0);
+    segment    = SegReader_Get_Segment(seg_reader);
+    TEST_INT_EQ(runner, VA_Get_Size(PolyReader_Get_Seg_Readers(reader)), 1,
+                "segments merged");
+    TEST_FLOAT_EQ(runner, BM25Sim_avg_field_length(segment, content),
+                  14.0 / 5.0, "avg_field_length after merge");
+    DECREF(reader);
+
+    DECREF(folder);
+}
+
+static void
+test_scoring(TestBatchRunner *runner) {
+    RAMFolder *folder = RAMFolder_new(NULL);
+    int32_t    doc_max;
+    const char *uniform[] = { "a", "b", "c", "d", NULL };
+    S_add_docs(folder, uniform, false);
+    float *scores = S_scores(folder, "a", &doc_max);
+
+    // With every field at the average length, a single occurrence scores
+    // exactly the BM25 IDF.
+    TEST_TRUE(runner, S_close_to(scores[1], log(1.0 + 3.5 / 1.5)),
+              "score for field of average length");
+    FREEMEM(scores);
+    DECREF(folder);
+
+    folder = RAMFolder_new(NULL);
+    const char *varied[] = {
+        "a b",
+        "a b c d e f g h i j",
+        "a a b c d e f g h i",
+        "a a a a a a a b c d",
+        "a a a a a a a a b c",
+        NULL
+    };
+    S_add_docs(folder, varied, false);
+    scores = S_scores(folder, "a", &doc_max);
+    TEST_TRUE(runner, scores[1] > scores[2], "shorter field scores higher");
+    TEST_TRUE(runner, scores[3] > scores[2], "higher freq scores higher");
+    TEST_TRUE(runner, scores[4] > scores[3],
+              "score table keeps ascending with freq");
+    TEST_TRUE(runner, scores[5] > scores[4],
+              "score past the table keeps ascending with freq");
+    TEST_TRUE(runner, scores[5] / scores[2] < 1.2f + 1.0f,
+              "term frequency saturates");
+    FREEMEM(scores);
+    DECREF(folder);
+}
+
+static Obj*
+S_freeze_thaw(Obj *object) {
+    RAMFile *ram_file = RAMFile_new(NULL, false);
+    OutStream *outstream = OutStream_open((Obj*)ram_file);
+    FREEZE(object, outstream);
+    OutStream_Close(outstream);
+    DECREF(outstream);
+
+    InStream *instream = InStream_open((Obj*)ram_file);
+    Obj *retval = THAW(instream);
+    DECREF(instream);
+    DECREF(ram_file);
+    return retval;
+}
+
+static void
+test_similarity(TestBatchRunner *runner) {
+    BM25Similarity *sim      = BM25Sim_new(1.2f, 0.75f);
+    BM25Similarity *other_k1 = BM25Sim_new(2.0f, 0.75f);
+    BM25Similarity *other_b  = BM25Sim_new(1.2f, 0.5f);
+    Similarity     *classic  = Sim_new();
+
+    TEST_FLOAT_EQ(runner, BM25Sim_TF(sim, 1.0f), 1.0f, "TF of 1");
+    TEST_TRUE(runner, BM25Sim_TF(sim, 1000.0f) < 2.2f, "TF saturates");
+    float idf = BM25Sim_IDF(sim, 1, 4);
+    TEST_TRUE(runner, S_close_to(idf * idf, log(1.0 + 3.5 / 1.5)),
+              "IDF squares to the BM25 idf");
+    TEST_TRUE(runner, BM25Sim_IDF(sim, 4, 4) > 0.0f,
+              "IDF positive for ubiquitous term");
+    TEST_FLOAT_EQ(runner, BM25Sim_Coord(sim, 1, 3), 1.0f, "Coord");
+    TEST_FLOAT_EQ(runner, BM25Sim_Query_Norm(sim, 9.0f), 1.0f, "Query_Norm");
+
+    TEST_TRUE(runner, BM25Sim_Equals(sim, (Obj*)sim), "Equals self");
+    TEST_FALSE(runner, BM25Sim_Equals(sim, (Obj*)other_k1),
+               "Equals spoiled by k1");
+    TEST_FALSE(runner, BM25Sim_Equals(sim, (Obj*)other_b),
+               "Equals spoiled by b");
+    TEST_FALSE(runner, BM25Sim_Equals(sim, (Obj*)classic),
+               "not Equal to default Similarity");
+    TEST_FALSE(runner, Sim_Equals(classic, (Obj*)sim),
+               "default Similarity not Equal to BM25Similarity");
+
+    Obj *dump = BM25Sim_Dump(other_k1);
+    BM25Similarity *loaded = BM25Sim_Load(sim, dump);
+    TEST_TRUE(runner, BM25Sim_Equals(other_k1, (Obj*)loaded), "Dump => Load");
+    DECREF(loaded);
+    DECREF(dump);
+
+    BM25Similarity *thawed = (BM25Similarity*)S_freeze_thaw((Obj*)other_b);
+    TEST_TRUE(runner, BM25Sim_Equals(other_b, (Obj*)thawed),
+              "Serialize => Deserialize");
+    DECREF(thawed);
+
+    DECREF(classic);
+    DECREF(other_b);
+    DECREF(other_k1);
+    DECREF(sim);
+}
+
+void
+TestBM25Sim_run(TestBM25Similarity *self, TestBatchRunner *runner) {
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 26);
+    test_field_stats(runner);
+    test_scoring(runner);
+    test_similarity(runner);
+}
+
+
@@ -0,0 +1,223 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#define C_TESTLUCY_TESTDELETIONSWRITER
+#define TESTLUCY_USE_SHORT_NAMES
+#include "Lucy/Util/ToolSet.h"
+
+#include "Clownfish/TestHarness/TestBatchRunner.h"
+#include "Lucy/Test.h"
+#include "Lucy/Test/Index/TestDeletionsWriter.h"
+#include "Lucy/Document/Doc.h"
+#include "Lucy/Index/DeletionsReader.h"
+#include "Lucy/Index/Indexer.h"
+#include "Lucy/Index/PolyReader.h"
+#include "Lucy/Index/SegReader.h"
+#include "Lucy/Plan/Schema.h"
+#include "Lucy/Plan/StringType.h"
+#include "Lucy/Search/Matcher.h"
+#include "Lucy/Store/RAMFolder.h"
+
+#define NUM_DOCS 1000
+
+TestDeletionsWriter*
+TestDelWriter_new() {
+    return (TestDeletionsWriter*)VTable_Make_Obj(TESTDELETIONSWRITER);
+}
+
+static Schema*
+S_create_schema() {
+    Schema     *schema = Schema_new();
+    StringType *type   = StringType_new();
+    CharBuf    *field  = CB_newf("id");
+    Schema_Spec_Field(schema, field, (FieldType*)type);
+    DECREF(field);
+    DECREF(type);
+    return schema;
+}
+
+// Index NUM_DOCS docs into a single segment.  The doc with id "n" gets doc
+// id n + 1.
+static RAMFolder*
+S_create_index(Schema *schema) {
+    RAMFolder *folder  = RAMFolder_new(NULL);
+    Indexer   *indexer = Indexer_new(schema, (Obj*)folder, NULL, 0);
+    CharBuf   *field   = CB_newf("id");
+    for (int32_t i = 0; i < NUM_DOCS; i++) {
+        Doc     *doc = Doc_new(NULL, 0);
+        CharBuf *id  = CB_newf("%i32", i);
+        Doc_Store(doc, field, (Obj*)id);
+        Indexer_Add_Doc(indexer, doc, 1.0f);
+        DECREF(id);
+        DECREF(doc);
+    }
+    Indexer_Commit(indexer);
+    DECREF(indexer);
+    DECREF(field);
+    return folder;
+}
+
+static void
+S_delete_ids(Schema *schema, RAMFolder *folder, int32_t first, int32_t last,
+             int32_t step) {
+    Indexer *indexer = Indexer_new(schema, (Obj*)folder, NULL, 0);
+    CharBuf *field   = CB_newf("id");
+    for (int32_t i = first; i <= last; i += step) {
+        CharBuf *id = CB_newf("%i32", i);
+        Indexer_Delete_By_Term(indexer, field, (Obj*)id);
+        DECREF(id);
+    }
+    Indexer_Commit(indexer);
+    DECREF(indexer);
+    DECREF(field);
+}
+
+// Verify that exactly the docs flagged in <code>expected</code> are reported
+// as deleted.
+static bool
+S_deletions_match(RAMFolder *folder, bool *expected, int32_t *del_count) {
+    PolyReader *reader = PolyReader_open((Obj*)folder, NULL, NULL);
+    DeletionsReader *del_reader
+        = (DeletionsReader*)PolyReader_Fetch(
+              reader, VTable_Get_Name(DELETIONSREADER));
+    Matcher *deletions = DelReader_Iterator(del_reader);
+    bool     matches   = true;
+    int32_t  expected_count = 0;
+    int32_t  next      = deletions ? Matcher_Next(deletions) : 0;
+
+    for (int32_t i = 0; i < NUM_DOCS; i++) {
+        if (expected[i]) {
+            expected_count++;
+            if (next != i + 1) { matches = false; }
+            else               { next = Matcher_Next(deletions); }
+        }
+    }
+    if (next != 0) { matches = false; }
+    *del_count = DelReader_Del_Count(del_reader);
+    if (*del_count != expected_count) { matches = false; }
+
+    DECREF(deletions);
+    DECREF(reader);
+    return matches;
+}
+
+static bool
+S_file_exists(RAMFolder *folder, const char *path) {
+    CharBuf *filename = CB_newf("%s", path);
+    bool     exists   = RAMFolder_Exists(folder, filename);
+    DECREF(filename);
+    return exists;
+}
+
+static void
+test_file_formats(TestBatchRunner *runner) {
+    Schema    *schema = S_create_schema();
+    RAMFolder *folder = S_create_index(schema);
+    bool       expected[NUM_DOCS];
+    int32_t    del_count;
+    memset(expected, 0, sizeof(expected));
+
+    S_delete_ids(schema, folder, 5, 35, 10);
+    for (int32_t i = 5; i <= 35; i += 10) { expected[i] = true; }
+    TEST_TRUE(runner, S_deletions_match(folder, expected, &del_count),
+              "sparse deletions");
+    TEST_INT_EQ(runner, del_count, 4, "sparse del count");
+    TEST_TRUE(runner, S_file_exists(folder, "seg_2/deletions-seg_1.rbv"),
+              "sparse deletions are written compressed");
+
+    // Stay below the proportion of deletions which triggers a merge.
+    S_delete_ids(schema, folder, 0, NUM_DOCS - 1, 12);
+    for (int32_t i = 0; i < NUM_DOCS; i += 12) { expected[i] = true; }
+    TEST_TRUE(runner, S_deletions_match(folder, expected, &del_count),
+              "scattered deletions");
+    TEST_INT_EQ(runner, del_count, 88, "scattered del count");
+    TEST_TRUE(runner, S_file_exists(folder, "seg_3/deletions-seg_1.bv"),
+              "scattered deletions are written flat");
+
+    DECREF(folder);
+    DECREF(schema);
+}
+
+// Return the number of delta files holding deletions for "seg_1", or -1 if
+// there are no deletions files for it at all.
+static int32_t
+S_num_deltas(RAMFolder *folder) {
+    PolyReader *reader   = PolyReader_open((Obj*)folder, NULL, NULL);
+    SegReader  *seg_reader
+        = (SegReader*)VA_Fetch(PolyReader_Get_Seg_Readers(reader), 0);
+    CharBuf    *seg_name = CB_newf("seg_1");
+    Hash       *file_data
+        = DefDelReader_find_file_data(SegReader_Get_Segments(seg_reader),
+                                      seg_name);
+    int32_t     retval   = -1;
+    if (file_data) {
+        VArray *deltas = (VArray*)Hash_Fetch_Str(file_data, "deltas", 6);
+        retval = deltas ? (int32_t)VA_Get_Size(deltas) : 0;
+    }
+    DECREF(seg_name);
+    DECREF(reader);
+    return retval;
+}
+
+static void
+test_deltas(TestBatchRunner *runner) {
+    Schema    *schema = S_create_schema();
+    RAMFolder *folder = S_create_index(schema);
+    bool       expected[NUM_DOCS];
+    int32_t    del_count;
+    bool       all_match = true;
+    memset(expected, 0, sizeof(expected));
+
+    S_delete_ids(schema, folder, 0, 0, 1);
+    expected[0] = true;
+    TEST_INT_EQ(runner, S_num_deltas(folder), 0,
+                "first deletions written as base file");
+    S_delete_ids(schema, folder, 3, 3, 1);
+    expected[3] = true;
+    TEST_INT_EQ(runner, S_num_deltas(folder), 1,
+                "next deletions written as delta");
+    TEST_TRUE(runner, S_file_exists(folder, "seg_2/deletions-seg_1.rbv")
+                      && S_file_exists(folder, "seg_3/deletions-seg_1.rbv"),
+              "base file retained alongside delta");
+
+    // Keep adding deltas until the chain gets consolidated.
+    int32_t max_deltas = 1;
+    for (int32_t i = 2; i < 10; i++) {
+        S_delete_ids(schema, folder, i * 3, i * 3, 1);
+        expected[i * 3] = true;
+        if (!S_deletions_match(folder, expected, &del_count)) {
+            all_match = false;
+        }
+        int32_t num_deltas = S_num_deltas(folder);
+        if (num_deltas > max_deltas) { max_deltas = num_deltas; }
+    }
+    TEST_TRUE(runner, all_match, "deletions spread across deltas");
+    TEST_INT_EQ(runner, del_count, 10, "del count with deltas");
+    TEST_TRUE(runner, max_deltas > 1 && S_num_deltas(folder) < max_deltas,
+              "chain of deltas gets consolidated");
+
+    DECREF(folder);
+    DECREF(schema);
+}
+
+void
+TestDelWriter_run(TestDeletionsWriter *self, TestBatchRunner *runner) {
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 12);
+    test_file_formats(runner);
+    test_deltas(runner);
+}
+
@@ -0,0 +1,219 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define C_TESTLUCY_TESTSCOREPOSTING
+#define C_LUCY_SCOREPOSTING
+#define TESTLUCY_USE_SHORT_NAMES
+#include "Lucy/Util/ToolSet.h"
+
+#include "Clownfish/TestHarness/TestBatchRunner.h"
+#include "Lucy/Test.h"
+#include "Lucy/Test/Index/TestScorePosting.h"
+#include "Lucy/Test/TestSchema.h"
+#include "Lucy/Test/TestUtils.h"
+#include "Lucy/Document/Doc.h"
+#include "Lucy/Index/Indexer.h"
+#include "Lucy/Index/PolyReader.h"
+#include "Lucy/Index/Posting/ScorePosting.h"
+#include "Lucy/Index/PostingList.h"
+#include "Lucy/Index/PostingListReader.h"
+#include "Lucy/Index/SegReader.h"
+#include "Lucy/Search/Hits.h"
+#include "Lucy/Search/IndexSearcher.h"
+#include "Lucy/Search/PhraseQuery.h"
+#include "Lucy/Store/InStream.h"
+#include "Lucy/Store/RAMFolder.h"
+
+#define NUM_DOCS 100
+
+TestScorePosting*
+TestScorePost_new() {
+    return (TestScorePosting*)VTable_Make_Obj(TESTSCOREPOSTING);
+}
+
+/* Doc i (doc id i + 1) reads "a [b] [a] b", where the first optional "b"
+ * appears when i is even and the optional "a" when i is a multiple of 3.
+ * Fill <code>expected</code> with the positions of <code>term</code> and
+ * return how many there are.
+ */
+static uint32_t
+S_expected_prox(int32_t i, char term, uint32_t *expected) {
+    uint32_t num_prox = 0;
+    uint32_t pos      = 0;
+    if (term == 'a') { expected[num_prox++] = pos; }
+    pos++;
+    if (i % 2 == 0) {
+        if (term == 'b') { expected[num_prox++] = pos; }
+        pos++;
+    }
+    if (i % 3 == 0) {
+        if (term == 'a') { expected[num_prox++] = pos; }
+        pos++;
+    }
+    if (term == 'b') { expected[num_prox++] = pos; }
+    return num_prox;
+}
+
+static void
+S_add_docs(RAMFolder *folder, Schema *schema, int32_t start, int32_t end) {
+    Indexer *indexer = Indexer_new(schema, (Obj*)folder, NULL, 0);
+    CharBuf *content = (CharBuf*)ZCB_WRAP_STR("content", 7);
+    for (int32_t i = start; i < end; i++) {
+        Doc     *doc   = Doc_new(NULL, 0);
+        CharBuf *value = CB_newf("a%s%s b", i % 2 == 0 ? " b" : "",
+                                 i % 3 == 0 ? " a" : "");
+        Doc_Store(doc, content, (Obj*)value);
+        Indexer_Add_Doc(indexer, doc, 1.0f);
+        DECREF(value);
+        DECREF(doc);
+    }
+    Indexer_Commit(indexer);
+    DECREF(indexer);
+}
+
+// Index the docs in two sessions, then merge them, so that positions have
+// been both flushed and merged.
+static RAMFolder*
+S_create_index() {
+    RAMFolder  *folder = RAMFolder_new(NULL);
+    TestSchema *schema = TestSchema_new(false);
+    S_add_docs(folder, (Schema*)schema, 0, NUM_DOCS / 2);
+    S_add_docs(folder, (Schema*)schema, NUM_DOCS / 2, NUM_DOCS);
+    Indexer *indexer = Indexer_new((Schema*)schema, (Obj*)folder, NULL, 0);
+    Indexer_Optimize(indexer);
+    Indexer_Commit(indexer);
+    DECREF(indexer);
+    DECREF(schema);
+    return folder;
+}
+
+static bool
+S_prox_matches(ScorePosting *posting, char term) {
+    uint32_t  expected[4];
+    int32_t   i        = ScorePost_Get_Doc_ID(posting) - 1;
+    uint32_t  num_prox = S_expected_prox(i, term, expected);
+    uint32_t *prox     = ScorePost_Get_Prox(posting);
+    if ((uint32_t)ScorePost_Get_Freq(posting) != num_prox) { return false; }
+    for (uint32_t j = 0; j < num_prox; j++) {
+        if (prox[j] != expected[j]) { return false; }
+    }
+    return true;
+}
+
+static void
+test_lazy_prox(TestBatchRunner *runner, PostingListReader *plist_reader,
+               char term) {
+    CharBuf     *field    = (CharBuf*)ZCB_WRAP_STR("content", 7);
+    CharBuf     *term_cb  = CB_newf("%s", term == 'a' ? "a" : "b");
+    PostingList *plist    = PListReader_Posting_List(plist_reader, field,
+                                                     (Obj*)term_cb);
+    ScorePosting *posting = (ScorePosting*)PList_Get_Posting(plist);
+
+    // Only ask for positions on some docs; the rest are stepped over.
+    bool    ok       = true;
+    int32_t num_docs = 0;
+    int32_t doc_id;
+    while (0 != (doc_id = PList_Next(plist))) {
+        num_docs++;
+        if (doc_id % 3 == 1 && !S_prox_matches(posting, term)) { ok = false; }
+    }
+    TEST_INT_EQ(runner, num_docs, NUM_DOCS, "Next finds every doc for '%c'",
+                term);
+    TEST_TRUE(runner, ok, "positions decoded on demand after Next for '%c'",
+              term);
+
+    // Exercise skipping, which jumps past whole runs of positions.
+    ok = true;
+    for (int32_t target = 1; target <= NUM_DOCS; target += 7) {
+        PList_Seek(plist, (Obj*)term_cb);
+        doc_id = PList_Advance(plist, target);
+        if (doc_id != target || !S_prox_matches(posting, term)) {
+            ok = false;
+        }
+    }
+    TEST_TRUE(runner, ok, "positions decoded on demand after Advance for '%c'",
+              term);
+
+    // Asking twice gives the same answer.
+    PList_Seek(plist, (Obj*)term_cb);
+    PList_Advance(plist, 7);
+    ScorePost_Get_Prox(posting);
+    TEST_TRUE(runner, S_prox_matches(posting, term),
+              "Get_Prox is repeatable for '%c'", term);
+
+    DECREF(plist);
+    DECREF(term_cb);
+}
+
+static void
+test_positions_untouched(TestBatchRunner *runner,
+                         PostingListReader *plist_reader) {
+    CharBuf     *field   = (CharBuf*)ZCB_WRAP_STR("content", 7);
+    CharBuf     *term_cb = (CharBuf*)ZCB_WRAP_STR("b", 1);
+    PostingList *plist   = PListReader_Posting_List(plist_reader, field,
+                                                    (Obj*)term_cb);
+    ScorePostingIVARS *const posting_ivars
+        = ScorePost_IVARS((ScorePosting*)PList_Get_Posting(plist));
+    InStream *prox_stream = posting_ivars->prox_stream;
+    TEST_TRUE(runner, prox_stream != NULL,
+              "positions have a stream of their own");
+
+    int32_t num_docs = 0;
+    while (PList_Next(plist)) { num_docs++; }
+    PList_Seek(plist, (Obj*)term_cb);
+    PList_Advance(plist, NUM_DOCS / 2);
+    TEST_TRUE(runner, num_docs == NUM_DOCS && InStream_Tell(prox_stream) == 0,
+              "Next and Advance never read positions");
+
+    DECREF(plist);
+}
+
+static void
+test_phrase_query(TestBatchRunner *runner, RAMFolder *folder) {
+    IndexSearcher *searcher = IxSearcher_new((Obj*)folder);
+    PhraseQuery   *query
+        = TestUtils_make_phrase_query("content", "b", "a", NULL);
+    Hits *hits = IxSearcher_Hits(searcher, (Obj*)query, 0, 10, NULL);
+    // "b a" occurs only in docs where i is a multiple of 6.
+    TEST_INT_EQ(runner, Hits_Total_Hits(hits), (NUM_DOCS + 5) / 6,
+                "PhraseQuery reads positions");
+    DECREF(hits);
+    DECREF(query);
+    DECREF(searcher);
+}
+
+void
+TestScorePost_run(TestScorePosting *self, TestBatchRunner *runner) {
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 12);
+    RAMFolder  *folder = S_create_index();
+    PolyReader *reader = PolyReader_open((Obj*)folder, NULL, NULL);
+    VArray     *seg_readers = PolyReader_Get_Seg_Readers(reader);
+    SegReader  *seg_reader  = (SegReader*)VA_Fetch(seg_readers, 0);
+    PostingListReader *plist_reader
+        = (PostingListReader*)SegReader_Fetch(
+              seg_reader, VTable_Get_Name(POSTINGLISTREADER));
+
+    TEST_INT_EQ(runner, VA_Get_Size(seg_readers), 1, "segments merged");
+    test_positions_untouched(runner, plist_reader);
+    test_lazy_prox(runner, plist_reader, 'a');
+    test_lazy_prox(runner, plist_reader, 'b');
+    test_phrase_query(runner, folder);
+
+    DECREF(reader);
+    DECREF(folder);
+}
+
+
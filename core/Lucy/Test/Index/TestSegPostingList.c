@@ -0,0 +1,264 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define C_TESTLUCY_TESTSEGPOSTINGLIST
+#define TESTLUCY_USE_SHORT_NAMES
+#include "Lucy/Util/ToolSet.h"
+
+#include "Clownfish/TestHarness/TestBatchRunner.h"
+#include "Lucy/Test.h"
+#include "Lucy/Test/Index/TestSegPostingList.h"
+#include "Lucy/Test/TestSchema.h"
+#include "Lucy/Test/TestUtils.h"
+#include "Lucy/Document/Doc.h"
+#include "Lucy/Index/Indexer.h"
+#include "Lucy/Index/PolyReader.h"
+#include "Lucy/Index/PostingList.h"
+#include "Lucy/Index/PostingListReader.h"
+#include "Lucy/Index/SegPostingList.h"
+#include "Lucy/Index/SegReader.h"
+#include "Lucy/Object/BitVector.h"
+#include "Lucy/Search/Hits.h"
+#include "Lucy/Search/IndexSearcher.h"
+#include "Lucy/Search/NOTQuery.h"
+#include "Lucy/Search/PolyQuery.h"
+#include "Lucy/Search/TermQuery.h"
+#include "Lucy/Store/RAMFolder.h"
+
+// With TestSchema's skip interval of 3, "x" gets four skip levels.
+#define NUM_DOCS 3000
+
+TestSegPostingList*
+TestSegPList_new() {
+    return (TestSegPostingList*)VTable_Make_Obj(TESTSEGPOSTINGLIST);
+}
+
+/* Every doc contains "x"; only every fifth doc, starting with doc 1,
+ * contains "y", and only every fiftieth contains "z" -- too few docs for
+ * "z" to get a dense bitmap.
+ */
+static void
+S_add_docs(Indexer *indexer, int32_t first, int32_t limit) {
+    CharBuf *content = (CharBuf*)ZCB_WRAP_STR("content", 7);
+    for (int32_t i = first; i < limit; i++) {
+        Doc     *doc   = Doc_new(NULL, 0);
+        CharBuf *value = CB_newf("x%s%s", i % 5 == 0 ? " y" : "",
+                                 i % 50 == 0 ? " z" : "");
+        Doc_Store(doc, content, (Obj*)value);
+        Indexer_Add_Doc(indexer, doc, 1.0f);
+        DECREF(value);
+        DECREF(doc);
+    }
+}
+
+static RAMFolder*
+S_create_index(bool merged) {
+    RAMFolder  *folder = RAMFolder_new(NULL);
+    TestSchema *schema = TestSchema_new(false);
+    Indexer    *indexer;
+    if (merged) {
+        // Write two segments, then merge them into one.
+        indexer = Indexer_new((Schema*)schema, (Obj*)folder, NULL, 0);
+        S_add_docs(indexer, 0, NUM_DOCS / 2);
+        Indexer_Commit(indexer);
+        DECREF(indexer);
+        indexer = Indexer_new((Schema*)schema, (Obj*)folder, NULL, 0);
+        S_add_docs(indexer, NUM_DOCS / 2, NUM_DOCS);
+        Indexer_Commit(indexer);
+        DECREF(indexer);
+        indexer = Indexer_new((Schema*)schema, (Obj*)folder, NULL, 0);
+        Indexer_Optimize(indexer);
+    }
+    else {
+        indexer = Indexer_new((Schema*)schema, (Obj*)folder, NULL, 0);
+        S_add_docs(indexer, 0, NUM_DOCS);
+    }
+    Indexer_Commit(indexer);
+    DECREF(indexer);
+    DECREF(schema);
+    return folder;
+}
+
+// Return the first doc at or after `target` which contains `term`, or 0.
+static int32_t
+S_expected(char term, int32_t target) {
+    if (target < 1) { target = 1; }
+    if (term == 'y') {
+        while ((target - 1) % 5 != 0) { target++; }
+    }
+    return target <= NUM_DOCS ? target : 0;
+}
+
+// Return how many docs up to and including `doc_id` contain `term`.
+static uint32_t
+S_expected_count(char term, int32_t doc_id) {
+    return term == 'y' ? (uint32_t)(doc_id + 4) / 5 : (uint32_t)doc_id;
+}
+
+static void
+test_advance(TestBatchRunner *runner, PostingListReader *plist_reader,
+             char term, const char *desc) {
+    CharBuf     *field   = (CharBuf*)ZCB_WRAP_STR("content", 7);
+    CharBuf     *term_cb = CB_newf("%s", term == 'x' ? "x" : "y");
+    PostingList *plist   = PListReader_Posting_List(plist_reader, field,
+                                                    (Obj*)term_cb);
+
+    // Single jumps of every length from a fresh seek.
+    bool ok = true;
+    for (int32_t target = 1; target <= NUM_DOCS + 1; target += 13) {
+        PList_Seek(plist, (Obj*)term_cb);
+        if (PList_Advance(plist, target) != S_expected(term, target)) {
+            ok = false;
+        }
+    }
+    TEST_TRUE(runner, ok, "Advance from start to any target for '%c' (%s)",
+              term, desc);
+
+    // Chains of short and long jumps, mixed with Next.
+    static const int32_t gaps[] = { 1, 2, 40, 3, 700, 5, 9, 130, 1100, 24 };
+    const size_t num_gaps = sizeof(gaps) / sizeof(gaps[0]);
+    bool count_ok = true;
+    ok = true;
+    PList_Seek(plist, (Obj*)term_cb);
+    int32_t target = 0;
+    for (size_t i = 0; ; i++) {
+        target += gaps[i % num_gaps];
+        int32_t doc_id = PList_Advance(plist, target);
+        if (doc_id != S_expected(term, target)) { ok = false; break; }
+        if (doc_id == 0) { break; }
+        uint32_t count = SegPList_Get_Count((SegPostingList*)plist);
+        if (count != S_expected_count(term, doc_id)) { count_ok = false; }
+        if (i % 3 == 0) {
+            int32_t next_doc_id = PList_Next(plist);
+            if (next_doc_id != S_expected(term, doc_id + 1)) {
+                ok = false;
+                break;
+            }
+            doc_id = next_doc_id;
+            if (doc_id == 0) { break; }
+        }
+        target = doc_id;
+    }
+    TEST_TRUE(runner, ok, "chained Advance and Next for '%c' (%s)", term,
+              desc);
+    TEST_TRUE(runner, count_ok, "Get_Count tracks skipping for '%c' (%s)",
+              term, desc);
+
+    DECREF(plist);
+    DECREF(term_cb);
+}
+
+static void
+test_dense_bits(TestBatchRunner *runner, PostingListReader *plist_reader,
+                const char *desc) {
+    CharBuf     *field = (CharBuf*)ZCB_WRAP_STR("content", 7);
+    PostingList *plist = PListReader_Posting_List(plist_reader, field,
+                                                  (Obj*)ZCB_WRAP_STR("y", 1));
+    bool         has   = PList_Has_Dense_Bits(plist);
+    BitVector   *bits  = PList_Dense_Bits(plist);
+    bool         ok    = has && bits != NULL
+                         && BitVec_Count(bits) == NUM_DOCS / 5;
+    for (int32_t doc_id = 1; ok && doc_id <= NUM_DOCS; doc_id++) {
+        if (BitVec_Get(bits, doc_id) != ((doc_id - 1) % 5 == 0)) {
+            ok = false;
+        }
+    }
+    TEST_TRUE(runner, ok, "dense term gets a bitmap of its docs (%s)", desc);
+
+    PList_Seek(plist, (Obj*)ZCB_WRAP_STR("x", 1));
+    bits = PList_Dense_Bits(plist);
+    TEST_TRUE(runner, bits != NULL && BitVec_Count(bits) == NUM_DOCS,
+              "Seek replaces the bitmap (%s)", desc);
+
+    PList_Seek(plist, (Obj*)ZCB_WRAP_STR("z", 1));
+    TEST_TRUE(runner, !PList_Has_Dense_Bits(plist)
+              && PList_Dense_Bits(plist) == NULL,
+              "sparse term has no bitmap (%s)", desc);
+
+    DECREF(plist);
+}
+
+static void
+S_test_total_hits(TestBatchRunner *runner, IndexSearcher *searcher,
+                  Query *query, uint32_t expected, const char *message,
+                  const char *desc) {
+    Hits *hits = IxSearcher_Hits(searcher, (Obj*)query, 0, 10, NULL);
+    TEST_INT_EQ(runner, Hits_Total_Hits(hits), expected, "%s (%s)", message,
+                desc);
+    DECREF(hits);
+    DECREF(query);
+}
+
+static void
+test_dense_queries(TestBatchRunner *runner, RAMFolder *folder,
+                   const char *desc) {
+    IndexSearcher *searcher = IxSearcher_new((Obj*)folder);
+    S_test_total_hits(runner, searcher,
+                      (Query*)TestUtils_make_poly_query(
+                          BOOLOP_AND,
+                          TestUtils_make_term_query("content", "x"),
+                          TestUtils_make_term_query("content", "y"),
+                          NULL),
+                      NUM_DOCS / 5, "AND of two dense terms", desc);
+    S_test_total_hits(runner, searcher,
+                      (Query*)TestUtils_make_poly_query(
+                          BOOLOP_AND,
+                          TestUtils_make_term_query("content", "y"),
+                          TestUtils_make_term_query("content", "z"),
+                          TestUtils_make_term_query("content", "x"),
+                          NULL),
+                      NUM_DOCS / 50, "AND of dense and sparse terms", desc);
+    S_test_total_hits(runner, searcher,
+                      (Query*)TestUtils_make_not_query(
+                          (Query*)TestUtils_make_term_query("content", "y")),
+                      NUM_DOCS - NUM_DOCS / 5, "NOT of a dense term", desc);
+    S_test_total_hits(runner, searcher,
+                      (Query*)TestUtils_make_not_query(
+                          (Query*)TestUtils_make_term_query("content", "z")),
+                      NUM_DOCS - NUM_DOCS / 50, "NOT of a sparse term", desc);
+    DECREF(searcher);
+}
+
+static void
+test_index(TestBatchRunner *runner, bool merged) {
+    const char *desc   = merged ? "merged" : "fresh";
+    RAMFolder  *folder = S_create_index(merged);
+    PolyReader *reader = PolyReader_open((Obj*)folder, NULL, NULL);
+    VArray     *seg_readers = PolyReader_Get_Seg_Readers(reader);
+    TEST_INT_EQ(runner, VA_Get_Size(seg_readers), 1, "one segment (%s)",
+                desc);
+    SegReader  *seg_reader = (SegReader*)VA_Fetch(seg_readers, 0);
+    PostingListReader *plist_reader
+        = (PostingListReader*)SegReader_Fetch(
+              seg_reader, VTable_Get_Name(POSTINGLISTREADER));
+
+    test_advance(runner, plist_reader, 'x', desc);
+    test_advance(runner, plist_reader, 'y', desc);
+    test_dense_bits(runner, plist_reader, desc);
+    test_dense_queries(runner, folder, desc);
+
+    DECREF(reader);
+    DECREF(folder);
+}
+
+void
+TestSegPList_run(TestSegPostingList *self, TestBatchRunner *runner) {
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 28);
+    test_index(runner, false);
+    test_index(runner, true);
+}
+
+
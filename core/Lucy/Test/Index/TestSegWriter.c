@@ -21,17 +21,238 @@
 #include "Clownfish/TestHarness/TestBatchRunner.h"
 #include "Lucy/Test.h"
 #include "Lucy/Test/Index/TestSegWriter.h"
+#include "Lucy/Document/Doc.h"
+#include "Lucy/Document/HitDoc.h"
+#include "Lucy/Index/DocReader.h"
+#include "Lucy/Index/Indexer.h"
+#include "Lucy/Index/PolyReader.h"
+#include "Lucy/Index/PostingList.h"
+#include "Lucy/Index/PostingListReader.h"
+#include "Lucy/Index/SegReader.h"
 #include "Lucy/Index/SegWriter.h"
+#include "Lucy/Index/SortCache.h"
+#include "Lucy/Index/SortReader.h"
+#include "Lucy/Plan/NumericType.h"
+#include "Lucy/Plan/Schema.h"
+#include "Lucy/Plan/StringType.h"
+#include "Lucy/Search/SortRule.h"
+#include "Lucy/Search/SortSpec.h"
+#include "Lucy/Store/RAMFolder.h"
+
+#define NUM_DOCS 100
 
 TestSegWriter*
 TestSegWriter_new() {
     return (TestSegWriter*)VTable_Make_Obj(TESTSEGWRITER);
 }
 
+// Sort first by parity ("even" before "odd"), then by descending number.
+static Schema*
+S_create_schema(bool with_index_sort) {
+    Schema     *schema   = Schema_new();
+    StringType *str_type = StringType_new();
+    Int32Type  *i32_type = Int32Type_new();
+    CharBuf    *name     = CB_newf("name");
+    CharBuf    *parity   = CB_newf("parity");
+    CharBuf    *num      = CB_newf("num");
+    StringType_Set_Sortable(str_type, true);
+    Int32Type_Set_Indexed(i32_type, false);
+    Int32Type_Set_Sortable(i32_type, true);
+    Schema_Spec_Field(schema, name, (FieldType*)str_type);
+    Schema_Spec_Field(schema, parity, (FieldType*)str_type);
+    Schema_Spec_Field(schema, num, (FieldType*)i32_type);
+
+    if (with_index_sort) {
+        VArray *rules = VA_new(2);
+        VA_Push(rules, (Obj*)SortRule_new(SortRule_FIELD, parity, false));
+        VA_Push(rules, (Obj*)SortRule_new(SortRule_FIELD, num, true));
+        SortSpec *sort_spec = SortSpec_new(rules);
+        Schema_Set_Index_Sort(schema, sort_spec);
+        DECREF(sort_spec);
+        DECREF(rules);
+    }
+
+    DECREF(num);
+    DECREF(parity);
+    DECREF(name);
+    DECREF(i32_type);
+    DECREF(str_type);
+    return schema;
+}
+
+static void
+S_add_docs(Indexer *indexer, int32_t start, int32_t end) {
+    CharBuf *name   = CB_newf("name");
+    CharBuf *parity = CB_newf("parity");
+    CharBuf *num    = CB_newf("num");
+    for (int32_t i = start; i < end; i++) {
+        int32_t    value      = (i * 37) % NUM_DOCS;
+        Doc       *doc        = Doc_new(NULL, 0);
+        CharBuf   *name_value = CB_newf("%i32", value);
+        CharBuf   *par_value  = CB_newf(value % 2 ? "odd" : "even");
+        Integer32 *num_value  = Int32_new(value);
+        Doc_Store(doc, name, (Obj*)name_value);
+        Doc_Store(doc, parity, (Obj*)par_value);
+        Doc_Store(doc, num, (Obj*)num_value);
+        Indexer_Add_Doc(indexer, doc, 1.0f);
+        DECREF(num_value);
+        DECREF(par_value);
+        DECREF(name_value);
+        DECREF(doc);
+    }
+    DECREF(num);
+    DECREF(parity);
+    DECREF(name);
+}
+
+static bool
+S_in_index_sort_order(int32_t prev, int32_t value) {
+    if (prev % 2 != value % 2) { return prev % 2 == 0; }
+    return prev > value;
+}
+
+// Verify that stored fields, sort caches and postings all agree with the
+// index sort.
+static void
+S_check_sorted(TestBatchRunner *runner, RAMFolder *folder,
+               int32_t expected_docs, const char *label) {
+    PolyReader *reader = PolyReader_open((Obj*)folder, NULL, NULL);
+    VArray     *seg_readers = PolyReader_Get_Seg_Readers(reader);
+    SegReader  *seg_reader  = (SegReader*)VA_Fetch(seg_readers, 0);
+    int32_t     doc_max     = SegReader_Doc_Max(seg_reader);
+    TEST_TRUE(runner, VA_Get_Size(seg_readers) == 1
+              && doc_max == expected_docs,
+              "%s: one segment with %d docs", label, (int)expected_docs);
+
+    DocReader *doc_reader = (DocReader*)SegReader_Fetch(
+                                seg_reader, VTable_Get_Name(DOCREADER));
+    CharBuf *name = CB_newf("name");
+    ViewCharBuf *value_buf = (ViewCharBuf*)ZCB_BLANK();
+    int32_t *values = (int32_t*)MALLOCATE((doc_max + 1) * sizeof(int32_t));
+    bool stored_ok = true;
+    for (int32_t doc_id = 1; doc_id <= doc_max; doc_id++) {
+        HitDoc *hit_doc = DocReader_Fetch_Doc(doc_reader, doc_id);
+        HitDoc_Extract(hit_doc, name, value_buf);
+        values[doc_id] = (int32_t)CB_To_I64((CharBuf*)value_buf);
+        if (doc_id > 1
+            && !S_in_index_sort_order(values[doc_id - 1], values[doc_id])
+           ) {
+            stored_ok = false;
+        }
+        DECREF(hit_doc);
+    }
+    TEST_TRUE(runner, stored_ok, "%s: stored docs follow index sort", label);
+
+    SortReader *sort_reader = (SortReader*)SegReader_Fetch(
+                                  seg_reader, VTable_Get_Name(SORTREADER));
+    CharBuf   *num        = CB_newf("num");
+    SortCache *sort_cache = SortReader_Fetch_Sort_Cache(sort_reader, num);
+    Obj       *blank      = SortCache_Make_Blank(sort_cache);
+    bool cache_ok = true;
+    for (int32_t doc_id = 1; doc_id <= doc_max; doc_id++) {
+        int32_t ord = SortCache_Ordinal(sort_cache, doc_id);
+        Obj *value = SortCache_Value(sort_cache, ord, blank);
+        if (!value || Obj_To_I64(value) != values[doc_id]) {
+            cache_ok = false;
+        }
+    }
+    TEST_TRUE(runner, cache_ok, "%s: sort cache matches stored docs", label);
+
+    PostingListReader *plist_reader
+        = (PostingListReader*)SegReader_Fetch(
+              seg_reader, VTable_Get_Name(POSTINGLISTREADER));
+    CharBuf *parity = CB_newf("parity");
+    CharBuf *even   = CB_newf("even");
+    PostingList *plist
+        = PListReader_Posting_List(plist_reader, parity, (Obj*)even);
+    int32_t num_even = 0;
+    int32_t last     = 0;
+    bool    plist_ok = true;
+    int32_t doc_id;
+    while (0 != (doc_id = PList_Next(plist))) {
+        if (doc_id <= last || values[doc_id] % 2 != 0) { plist_ok = false; }
+        last = doc_id;
+        num_even++;
+    }
+    for (int32_t i = 1; i <= doc_max; i++) {
+        if (values[i] % 2 == 0) { num_even--; }
+    }
+    TEST_TRUE(runner, plist_ok && num_even == 0,
+              "%s: postings remapped in order", label);
+
+    DECREF(plist);
+    DECREF(even);
+    DECREF(parity);
+    DECREF(blank);
+    DECREF(num);
+    FREEMEM(values);
+    DECREF(name);
+    DECREF(reader);
+}
+
+static void
+test_index_sort(TestBatchRunner *runner) {
+    RAMFolder *folder = RAMFolder_new(NULL);
+
+    Schema  *schema  = S_create_schema(true);
+    Indexer *indexer = Indexer_new(schema, (Obj*)folder, NULL, 0);
+    S_add_docs(indexer, 0, NUM_DOCS / 2);
+    Indexer_Commit(indexer);
+    DECREF(indexer);
+    DECREF(schema);
+    S_check_sorted(runner, folder, NUM_DOCS / 2, "new segment");
+
+    // The index sort is picked up from the stored Schema.  Delete a doc
+    // from the first segment, then merge everything together.
+    schema  = S_create_schema(false);
+    indexer = Indexer_new(schema, (Obj*)folder, NULL, 0);
+    S_add_docs(indexer, NUM_DOCS / 2, NUM_DOCS);
+    CharBuf *name  = CB_newf("name");
+    CharBuf *seven = CB_newf("7");
+    Indexer_Delete_By_Term(indexer, name, (Obj*)seven);
+    Indexer_Optimize(indexer);
+    Indexer_Commit(indexer);
+    DECREF(seven);
+    DECREF(name);
+    DECREF(indexer);
+    DECREF(schema);
+    S_check_sorted(runner, folder, NUM_DOCS - 1, "merged segment");
+
+    DECREF(folder);
+}
+
+static void
+test_dump_load(TestBatchRunner *runner) {
+    Schema *schema = S_create_schema(true);
+    Hash   *dump   = Schema_Dump(schema);
+    Schema *loaded = Schema_Load(schema, (Obj*)dump);
+    SortSpec *sort_spec = Schema_Get_Index_Sort(loaded);
+    VArray   *rules     = sort_spec ? SortSpec_Get_Rules(sort_spec) : NULL;
+    TEST_TRUE(runner, rules && VA_Get_Size(rules) == 2,
+              "index sort survives Dump/Load");
+    if (rules && VA_Get_Size(rules) == 2) {
+        SortRule *first  = (SortRule*)VA_Fetch(rules, 0);
+        SortRule *second = (SortRule*)VA_Fetch(rules, 1);
+        TEST_TRUE(runner,
+                  CB_Equals_Str(SortRule_Get_Field(first), "parity", 6)
+                  && !SortRule_Get_Reverse(first)
+                  && CB_Equals_Str(SortRule_Get_Field(second), "num", 3)
+                  && SortRule_Get_Reverse(second),
+                  "index sort rules round trip");
+    }
+    else {
+        FAIL(runner, "index sort rules round trip");
+    }
+    DECREF(loaded);
+    DECREF(dump);
+    DECREF(schema);
+}
+
 void
 TestSegWriter_run(TestSegWriter *self, TestBatchRunner *runner) {
-    TestBatchRunner_Plan(runner, (TestBatch*)self, 1);
-    PASS(runner, "placeholder");
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 10);
+    test_index_sort(runner);
+    test_dump_load(runner);
 }
 
 
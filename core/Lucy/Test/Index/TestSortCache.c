@@ -0,0 +1,226 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define C_TESTLUCY_TESTSORTCACHE
+#define TESTLUCY_USE_SHORT_NAMES
+#include "Lucy/Util/ToolSet.h"
+
+#include "Clownfish/TestHarness/TestBatchRunner.h"
+#include "Lucy/Test.h"
+#include "Lucy/Test/Index/TestSortCache.h"
+#include "Lucy/Document/Doc.h"
+#include "Lucy/Index/Indexer.h"
+#include "Lucy/Index/PolyReader.h"
+#include "Lucy/Index/SegReader.h"
+#include "Lucy/Index/SortCache/NumericSortCache.h"
+#include "Lucy/Index/SortCache/TextSortCache.h"
+#include "Lucy/Index/SortReader.h"
+#include "Lucy/Plan/NumericType.h"
+#include "Lucy/Plan/Schema.h"
+#include "Lucy/Plan/StringType.h"
+#include "Lucy/Store/RAMFolder.h"
+
+#define NUM_DOCS 1000
+
+TestSortCache*
+TestSortCache_new() {
+    return (TestSortCache*)VTable_Make_Obj(TESTSORTCACHE);
+}
+
+static void
+S_spec_field(Schema *schema, const char *name, FieldType *type) {
+    CharBuf *field = CB_newf("%s", name);
+    FType_Set_Sortable(type, true);
+    Schema_Spec_Field(schema, field, type);
+    DECREF(field);
+    DECREF(type);
+}
+
+static Schema*
+S_create_schema() {
+    Schema      *schema = Schema_new();
+    Int32Type   *i32    = Int32Type_new();
+    Int64Type   *i64    = Int64Type_new();
+    Float64Type *f64    = Float64Type_new();
+    Int32Type_Set_Indexed(i32, false);
+    Int64Type_Set_Indexed(i64, false);
+    Float64Type_Set_Indexed(f64, false);
+    S_spec_field(schema, "i32", (FieldType*)i32);
+    S_spec_field(schema, "i64", (FieldType*)i64);
+    S_spec_field(schema, "f64", (FieldType*)f64);
+    S_spec_field(schema, "str", (FieldType*)StringType_new());
+    return schema;
+}
+
+// Every seventh doc has no values.  The rest have values derived from the
+// doc number, so that i64 has more distinct values than fit in an 8-bit ord.
+static bool
+S_has_value(int32_t doc_id) {
+    return doc_id % 7 != 0;
+}
+
+static void
+S_store(Doc *doc, const char *name, Obj *value) {
+    CharBuf *field = CB_newf("%s", name);
+    Doc_Store(doc, field, value);
+    DECREF(field);
+    DECREF(value);
+}
+
+static RAMFolder*
+S_create_index(Schema *schema) {
+    RAMFolder *folder  = RAMFolder_new(NULL);
+    Indexer   *indexer = Indexer_new(schema, (Obj*)folder, NULL, 0);
+    for (int32_t doc_id = 1; doc_id <= NUM_DOCS; doc_id++) {
+        Doc *doc = Doc_new(NULL, 0);
+        if (S_has_value(doc_id)) {
+            S_store(doc, "i32", (Obj*)Int32_new(-(doc_id % 50)));
+            S_store(doc, "i64", (Obj*)Int64_new(doc_id * INT64_C(10000000000)));
+            S_store(doc, "f64", (Obj*)Float64_new(doc_id / 4.0));
+            S_store(doc, "str", (Obj*)CB_newf("s%i32", doc_id % 3));
+        }
+        Indexer_Add_Doc(indexer, doc, 1.0f);
+        DECREF(doc);
+    }
+    Indexer_Commit(indexer);
+    DECREF(indexer);
+    return folder;
+}
+
+static SortCache*
+S_fetch_cache(SegReader *seg_reader, const char *name) {
+    SortReader *sort_reader
+        = (SortReader*)SegReader_Fetch(seg_reader,
+                                       VTable_Get_Name(SORTREADER));
+    CharBuf   *field = CB_newf("%s", name);
+    SortCache *cache = SortReader_Fetch_Sort_Cache(sort_reader, field);
+    DECREF(field);
+    return cache;
+}
+
+static void
+S_attempt_float_as_int64(void *context) {
+    NumericSortCache *cache = (NumericSortCache*)context;
+    int32_t doc_id = 1;
+    int64_t value;
+    NumSortCache_Int64_Values(cache, &doc_id, &value, 1, 0);
+}
+
+static void
+test_bulk_access(TestBatchRunner *runner) {
+    Schema     *schema = S_create_schema();
+    RAMFolder  *folder = S_create_index(schema);
+    PolyReader *reader = PolyReader_open((Obj*)folder, NULL, NULL);
+    SegReader  *seg_reader
+        = (SegReader*)VA_Fetch(PolyReader_Get_Seg_Readers(reader), 0);
+
+    // Ask for the docs in a scrambled order.
+    int32_t *doc_ids = (int32_t*)MALLOCATE(NUM_DOCS * sizeof(int32_t));
+    int32_t *ords    = (int32_t*)MALLOCATE(NUM_DOCS * sizeof(int32_t));
+    int64_t *ints    = (int64_t*)MALLOCATE(NUM_DOCS * sizeof(int64_t));
+    double  *floats  = (double*)MALLOCATE(NUM_DOCS * sizeof(double));
+    for (int32_t i = 0; i < NUM_DOCS; i++) {
+        doc_ids[i] = (i * 389) % NUM_DOCS + 1;
+    }
+
+    SortCache *i64_cache = S_fetch_cache(seg_reader, "i64");
+    SortCache_Ordinals(i64_cache, doc_ids, ords, NUM_DOCS);
+    bool ords_ok = SortCache_Get_Ord_Width(i64_cache) > 8;
+    for (int32_t i = 0; i < NUM_DOCS; i++) {
+        if (ords[i] != SortCache_Ordinal(i64_cache, doc_ids[i])) {
+            ords_ok = false;
+        }
+    }
+    TEST_TRUE(runner, ords_ok, "Ordinals matches Ordinal");
+
+    NumSortCache_Int64_Values((NumericSortCache*)i64_cache, doc_ids, ints,
+                              NUM_DOCS, -1);
+    bool ints_ok = true;
+    for (int32_t i = 0; i < NUM_DOCS; i++) {
+        int64_t expected = S_has_value(doc_ids[i])
+                           ? doc_ids[i] * INT64_C(10000000000)
+                           : -1;
+        if (ints[i] != expected) { ints_ok = false; }
+    }
+    TEST_TRUE(runner, ints_ok, "Int64_Values for Int64Type, exactly");
+
+    SortCache *i32_cache = S_fetch_cache(seg_reader, "i32");
+    NumSortCache_Int64_Values((NumericSortCache*)i32_cache, doc_ids, ints,
+                              NUM_DOCS, 1);
+    ints_ok = true;
+    for (int32_t i = 0; i < NUM_DOCS; i++) {
+        int64_t expected = S_has_value(doc_ids[i]) ? -(doc_ids[i] % 50) : 1;
+        if (ints[i] != expected) { ints_ok = false; }
+    }
+    TEST_TRUE(runner, ints_ok, "Int64_Values for Int32Type");
+
+    SortCache *f64_cache = S_fetch_cache(seg_reader, "f64");
+    NumSortCache_Double_Values((NumericSortCache*)f64_cache, doc_ids, floats,
+                               NUM_DOCS);
+    bool floats_ok = true;
+    for (int32_t i = 0; i < NUM_DOCS; i++) {
+        if (S_has_value(doc_ids[i])) {
+            if (floats[i] != doc_ids[i] / 4.0) { floats_ok = false; }
+        }
+        else if (floats[i] == floats[i]) {
+            floats_ok = false; // Not NaN.
+        }
+    }
+    TEST_TRUE(runner, floats_ok, "Double_Values, NaN for missing values");
+
+    Err *error = Err_trap(S_attempt_float_as_int64, f64_cache);
+    TEST_TRUE(runner, error != NULL
+              && CB_Find_Str(Err_Get_Mess(error), "integer", 7) != -1,
+              "Int64_Values throws for a float field");
+    DECREF(error);
+
+    SortCache *str_cache = S_fetch_cache(seg_reader, "str");
+    VArray *strings = TextSortCache_Values((TextSortCache*)str_cache,
+                                           doc_ids, NUM_DOCS);
+    bool strings_ok = VA_Get_Size(strings) <= NUM_DOCS;
+    for (int32_t i = 0; i < NUM_DOCS; i++) {
+        CharBuf *value = (CharBuf*)VA_Fetch(strings, i);
+        if (S_has_value(doc_ids[i])) {
+            char expected[3] = { 's', (char)('0' + doc_ids[i] % 3), '\0' };
+            if (!value || !CB_Equals_Str(value, expected, 2)) {
+                strings_ok = false;
+            }
+        }
+        else if (value) {
+            strings_ok = false;
+        }
+    }
+    TEST_TRUE(runner, strings_ok, "TextSortCache Values");
+    TEST_TRUE(runner, VA_Fetch(strings, 0) == VA_Fetch(strings, 5),
+              "docs which share a value share a CharBuf");
+    DECREF(strings);
+
+    FREEMEM(floats);
+    FREEMEM(ints);
+    FREEMEM(ords);
+    FREEMEM(doc_ids);
+    DECREF(reader);
+    DECREF(folder);
+    DECREF(schema);
+}
+
+void
+TestSortCache_run(TestSortCache *self, TestBatchRunner *runner) {
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 7);
+    test_bulk_access(runner);
+}
+
+
@@ -32,6 +32,7 @@ void
 test_freqfilepos(TestBatchRunner *runner) {
     TermInfo* tinfo = TInfo_new(10);
     TInfo_Set_Post_FilePos(tinfo, 20);
+    TInfo_Set_Prox_FilePos(tinfo, 30);
     TInfo_Set_Skip_FilePos(tinfo, 40);
     TInfo_Set_Lex_FilePos(tinfo, 50);
 
@@ -41,6 +42,7 @@ test_freqfilepos(TestBatchRunner *runner) {
     TEST_INT_EQ(runner, TInfo_Get_Doc_Freq(tinfo), 10, "new sets doc_freq correctly" );
     TEST_INT_EQ(runner, TInfo_Get_Doc_Freq(tinfo), 10, "... doc_freq cloned" );
     TEST_INT_EQ(runner, TInfo_Get_Post_FilePos(tinfo), 20, "... post_filepos cloned" );
+    TEST_INT_EQ(runner, TInfo_Get_Prox_FilePos(cloned_tinfo), 30, "... prox_filepos cloned" );
     TEST_INT_EQ(runner, TInfo_Get_Skip_FilePos(tinfo), 40, "... skip_filepos cloned" );
     TEST_INT_EQ(runner, TInfo_Get_Lex_FilePos(tinfo),  50, "... lex_filepos cloned" );
 
@@ -51,6 +53,9 @@ test_freqfilepos(TestBatchRunner *runner) {
     TInfo_Set_Post_FilePos(tinfo, 15);
     TEST_INT_EQ(runner, TInfo_Get_Post_FilePos(tinfo), 15, "set/get post_filepos" );
 
+    TInfo_Set_Prox_FilePos(tinfo, 25);
+    TEST_INT_EQ(runner, TInfo_Get_Prox_FilePos(tinfo), 25, "set/get prox_filepos" );
+
     TInfo_Set_Skip_FilePos(tinfo, 35);
     TEST_INT_EQ(runner, TInfo_Get_Skip_FilePos(tinfo), 35, "set/get skip_filepos" );
 
@@ -63,6 +68,6 @@ test_freqfilepos(TestBatchRunner *runner) {
 
 void
 TestTermInfo_run(TestTermInfo *self, TestBatchRunner *runner) {
-    TestBatchRunner_Plan(runner, (TestBatch*)self, 11);
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 13);
     test_freqfilepos(runner);
 }
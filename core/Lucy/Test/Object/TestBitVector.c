@@ -23,6 +23,7 @@
 #include "Lucy/Test.h"
 #include "Lucy/Test/TestUtils.h"
 #include "Lucy/Test/Object/TestBitVector.h"
+#include "Lucy/Search/BitVecMatcher.h"
 
 TestBitVector*
 TestBitVector_new() {
@@ -353,6 +354,43 @@ test_Next_Hit(TestBatchRunner *runner) {
     }
 }
 
+static void
+test_Next_Hits(TestBatchRunner *runner) {
+    // 1001 bits leaves a partial word at the end.
+    BitVector *bit_vec = BitVec_new(1001);
+    int32_t    hits[10];
+    uint32_t   num_hits;
+    uint32_t   tick       = 3;
+    int32_t    expected;
+    int32_t    mismatches = 0;
+    for (uint32_t i = 0; i <= 1000; i += 7) { BitVec_Set(bit_vec, i); }
+    BitVec_Set(bit_vec, 1000);
+
+    expected = BitVec_Next_Hit(bit_vec, tick);
+    while (0 != (num_hits = BitVec_Next_Hits(bit_vec, tick, hits, 10))) {
+        for (uint32_t i = 0; i < num_hits; i++) {
+            if (hits[i] != expected) { mismatches++; }
+            expected = BitVec_Next_Hit(bit_vec, hits[i] + 1);
+        }
+        tick = hits[num_hits - 1] + 1;
+    }
+    TEST_INT_EQ(runner, mismatches, 0, "Next_Hits agrees with Next_Hit");
+    TEST_INT_EQ(runner, expected, -1, "Next_Hits exhausts set bits");
+
+    // Iterate with a BitVecMatcher, mixing Next and Advance.
+    BitVecMatcher *matcher = BitVecMatcher_new(bit_vec);
+    bool ok = BitVecMatcher_Next(matcher) == 7
+              && BitVecMatcher_Advance(matcher, 8) == 14
+              && BitVecMatcher_Next(matcher) == 21
+              && BitVecMatcher_Advance(matcher, 500) == 504
+              && BitVecMatcher_Next(matcher) == 511
+              && BitVecMatcher_Advance(matcher, 995) == 1000
+              && BitVecMatcher_Next(matcher) == 0;
+    TEST_TRUE(runner, ok, "BitVecMatcher Next and Advance");
+    DECREF(matcher);
+    DECREF(bit_vec);
+}
+
 static void
 test_Clear_All(TestBatchRunner *runner) {
     BitVector *bit_vec = BitVec_new(64);
@@ -442,7 +480,7 @@ test_off_by_one_error() {
 
 void
 TestBitVector_run(TestBitVector *self, TestBatchRunner *runner) {
-    TestBatchRunner_Plan(runner, (TestBatch*)self, 1029);
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 1032);
     test_Set_and_Get(runner);
     test_Flip(runner);
     test_Flip_Block_ascending(runner);
@@ -455,6 +493,7 @@ TestBitVector_run(TestBitVector *self, TestBatchRunner *runner) {
     test_And_Not(runner);
     test_Count(runner);
     test_Next_Hit(runner);
+    test_Next_Hits(runner);
     test_Clear_All(runner);
     test_Clone(runner);
     test_To_Array(runner);
@@ -0,0 +1,128 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define C_TESTLUCY_TESTHYPERLOGLOG
+#define TESTLUCY_USE_SHORT_NAMES
+#include "Lucy/Util/ToolSet.h"
+
+#include "Clownfish/TestHarness/TestBatchRunner.h"
+#include "Lucy/Test.h"
+#include "Lucy/Test/Object/TestHyperLogLog.h"
+#include "Lucy/Object/HyperLogLog.h"
+#include "Lucy/Store/InStream.h"
+#include "Lucy/Store/OutStream.h"
+#include "Lucy/Store/RAMFolder.h"
+
+TestHyperLogLog*
+TestHLL_new() {
+    return (TestHyperLogLog*)VTable_Make_Obj(TESTHYPERLOGLOG);
+}
+
+// Add the integers from `start` up to but not including `end`.
+static void
+S_add_range(HyperLogLog *hll, uint64_t start, uint64_t end) {
+    for (uint64_t i = start; i < end; i++) {
+        HLL_Add_Hash(hll, HLL_hash_bytes(&i, sizeof(uint64_t)));
+    }
+}
+
+// Return true if `estimate` is within `tolerance` (a fraction) of `actual`.
+static bool
+S_close_to(uint64_t estimate, uint64_t actual, double tolerance) {
+    double diff = (double)estimate - (double)actual;
+    if (diff < 0) { diff = -diff; }
+    return diff <= tolerance * (double)actual;
+}
+
+static void
+S_attempt_bad_precision(void *context) {
+    UNUSED_VAR(context);
+    HyperLogLog *hll = HLL_new(30);
+    DECREF(hll);
+}
+
+static void
+test_Estimate(TestBatchRunner *runner) {
+    HyperLogLog *hll = HLL_new(14);
+    TEST_INT_EQ(runner, (long)HLL_Estimate(hll), 0, "empty sketch");
+
+    S_add_range(hll, 0, 100);
+    TEST_INT_EQ(runner, (long)HLL_Estimate(hll), 100,
+                "small counts are nearly exact");
+
+    S_add_range(hll, 0, 100);
+    TEST_INT_EQ(runner, (long)HLL_Estimate(hll), 100,
+                "duplicates don't change the estimate");
+
+    S_add_range(hll, 100, 200000);
+    uint64_t estimate = HLL_Estimate(hll);
+    TEST_TRUE(runner, S_close_to(estimate, 200000, 0.03),
+              "large count estimated within 3%%: %ld", (long)estimate);
+
+    Err *error = Err_trap(S_attempt_bad_precision, NULL);
+    TEST_TRUE(runner, error != NULL, "precision out of range throws");
+    DECREF(error);
+
+    DECREF(hll);
+}
+
+static void
+test_Merge_and_Serialize(TestBatchRunner *runner) {
+    HyperLogLog *whole = HLL_new(12);
+    HyperLogLog *left  = HLL_new(12);
+    HyperLogLog *right = HLL_new(12);
+    S_add_range(whole, 0, 50000);
+    S_add_range(left, 0, 30000);
+    S_add_range(right, 20000, 50000);
+    HLL_Merge(left, right);
+    TEST_TRUE(runner, HLL_Equals(left, (Obj*)whole),
+              "Merge yields the sketch of the union");
+
+    RAMFolder *folder    = RAMFolder_new(NULL);
+    CharBuf   *filename  = CB_newf("hll");
+    OutStream *outstream = RAMFolder_Open_Out(folder, filename);
+    HLL_Serialize(whole, outstream);
+    OutStream_Close(outstream);
+    InStream    *instream = RAMFolder_Open_In(folder, filename);
+    HyperLogLog *thawed   = (HyperLogLog*)VTable_Make_Obj(HYPERLOGLOG);
+    thawed = HLL_Deserialize(thawed, instream);
+    TEST_TRUE(runner, HLL_Equals(thawed, (Obj*)whole)
+              && HLL_Estimate(thawed) == HLL_Estimate(whole),
+              "Serialize/Deserialize round trip");
+
+    HyperLogLog *coarse = HLL_new(10);
+    TEST_FALSE(runner, HLL_Equals(coarse, (Obj*)whole),
+               "different precisions spoil Equals");
+
+    DECREF(coarse);
+    DECREF(thawed);
+    DECREF(instream);
+    DECREF(outstream);
+    DECREF(filename);
+    DECREF(folder);
+    DECREF(right);
+    DECREF(left);
+    DECREF(whole);
+}
+
+void
+TestHLL_run(TestHyperLogLog *self, TestBatchRunner *runner) {
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 8);
+    test_Estimate(runner);
+    test_Merge_and_Serialize(runner);
+}
+
+
@@ -0,0 +1,284 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#define C_TESTLUCY_TESTROARINGBITVECTOR
+#define TESTLUCY_USE_SHORT_NAMES
+#include "Lucy/Util/ToolSet.h"
+
+#include "Clownfish/TestHarness/TestBatchRunner.h"
+#include "Lucy/Test.h"
+#include "Lucy/Test/Object/TestRoaringBitVector.h"
+#include "Lucy/Object/RoaringBitVector.h"
+#include "Lucy/Search/BitVecMatcher.h"
+#include "Lucy/Store/InStream.h"
+#include "Lucy/Store/OutStream.h"
+#include "Lucy/Store/RAMFolder.h"
+
+#define LIMIT 300000
+
+#define OP_AND     1
+#define OP_OR      2
+#define OP_XOR     3
+#define OP_AND_NOT 4
+
+TestRoaringBitVector*
+TestRoarBitVec_new() {
+    return (TestRoaringBitVector*)VTable_Make_Obj(TESTROARINGBITVECTOR);
+}
+
+// Set bits in a mix of patterns which exercise every container type: a
+// sparse scattering, a dense chunk, and a long run.
+static void
+S_fill(BitVector *bit_vec, uint32_t variant) {
+    for (uint32_t i = variant; i < LIMIT; i += 997 + variant) {
+        BitVec_Set(bit_vec, i);
+    }
+    for (uint32_t i = 65536 + variant; i < 2 * 65536; i += 3) {
+        BitVec_Set(bit_vec, i);
+    }
+    for (uint32_t i = 200000 + variant * 1000; i < 260000; i++) {
+        BitVec_Set(bit_vec, i);
+    }
+}
+
+// Return the number of ticks where the two BitVectors disagree.
+static uint32_t
+S_count_mismatches(BitVector *a, BitVector *b) {
+    uint32_t mismatches = 0;
+    for (uint32_t i = 0; i < LIMIT; i++) {
+        if (BitVec_Get(a, i) != BitVec_Get(b, i)) { mismatches++; }
+    }
+    return mismatches;
+}
+
+static void
+S_do_op(BitVector *self, const BitVector *other, int op) {
+    switch (op) {
+        case OP_AND:     BitVec_And(self, other);     break;
+        case OP_OR:      BitVec_Or(self, other);      break;
+        case OP_XOR:     BitVec_Xor(self, other);     break;
+        case OP_AND_NOT: BitVec_And_Not(self, other); break;
+        default:         THROW(ERR, "Unexpected op: %i32", (int32_t)op);
+    }
+}
+
+static void
+test_Set_Get_and_Clear(TestBatchRunner *runner) {
+    RoaringBitVector *roaring = RoarBitVec_new(0);
+    BitVector        *flat    = BitVec_new(0);
+    S_fill((BitVector*)roaring, 0);
+    S_fill(flat, 0);
+
+    TEST_INT_EQ(runner, RoarBitVec_Count(roaring), BitVec_Count(flat),
+                "Count");
+    TEST_INT_EQ(runner, S_count_mismatches((BitVector*)roaring, flat), 0,
+                "Set/Get");
+
+    for (uint32_t i = 65536; i < 2 * 65536; i += 2) {
+        RoarBitVec_Clear(roaring, i);
+        BitVec_Clear(flat, i);
+    }
+    TEST_INT_EQ(runner, S_count_mismatches((BitVector*)roaring, flat), 0,
+                "Clear converts dense chunk back down");
+    TEST_INT_EQ(runner, RoarBitVec_Count(roaring), BitVec_Count(flat),
+                "Count after Clear");
+
+    RoarBitVec_Clear_All(roaring);
+    TEST_INT_EQ(runner, RoarBitVec_Count(roaring), 0, "Clear_All");
+    TEST_INT_EQ(runner, RoarBitVec_Next_Hit(roaring, 0), -1,
+                "no Next_Hit after Clear_All");
+
+    DECREF(roaring);
+    DECREF(flat);
+}
+
+static void
+test_logical_ops(TestBatchRunner *runner) {
+    static const int ops[] = { OP_AND, OP_OR, OP_XOR, OP_AND_NOT };
+    static const char *names[] = { "And", "Or", "Xor", "And_Not" };
+
+    for (uint32_t i = 0; i < 4; i++) {
+        RoaringBitVector *roaring_a = RoarBitVec_new(0);
+        RoaringBitVector *roaring_b = RoarBitVec_new(0);
+        RoaringBitVector *roaring_c = RoarBitVec_new(0);
+        BitVector        *flat_a    = BitVec_new(0);
+        BitVector        *flat_b    = BitVec_new(0);
+        BitVector        *flat_c    = BitVec_new(0);
+        S_fill((BitVector*)roaring_a, 0);
+        S_fill((BitVector*)roaring_b, 5);
+        S_fill((BitVector*)roaring_c, 0);
+        S_fill(flat_a, 0);
+        S_fill(flat_b, 5);
+        S_fill(flat_c, 0);
+        RoarBitVec_Run_Optimize(roaring_b);
+
+        S_do_op((BitVector*)roaring_a, (BitVector*)roaring_b, ops[i]);
+        S_do_op((BitVector*)roaring_c, flat_b, ops[i]);
+        S_do_op(flat_c, (BitVector*)roaring_b, ops[i]);
+        S_do_op(flat_a, flat_b, ops[i]);
+
+        TEST_INT_EQ(runner,
+                    S_count_mismatches((BitVector*)roaring_a, flat_a), 0,
+                    "%s against RoaringBitVector", names[i]);
+        TEST_INT_EQ(runner,
+                    S_count_mismatches((BitVector*)roaring_c, flat_a), 0,
+                    "%s against flat BitVector", names[i]);
+        TEST_INT_EQ(runner, S_count_mismatches(flat_c, flat_a), 0,
+                    "flat BitVector %s against RoaringBitVector", names[i]);
+
+        DECREF(roaring_a);
+        DECREF(roaring_b);
+        DECREF(roaring_c);
+        DECREF(flat_a);
+        DECREF(flat_b);
+        DECREF(flat_c);
+    }
+}
+
+static void
+test_Flip_Block(TestBatchRunner *runner) {
+    RoaringBitVector *roaring = RoarBitVec_new(0);
+    BitVector        *flat    = BitVec_new(0);
+    S_fill((BitVector*)roaring, 1);
+    S_fill(flat, 1);
+
+    RoarBitVec_Flip_Block(roaring, 60000, 150000);
+    BitVec_Flip_Block(flat, 60000, 150000);
+    TEST_INT_EQ(runner, S_count_mismatches((BitVector*)roaring, flat), 0,
+                "Flip_Block spanning several chunks");
+    RoarBitVec_Flip(roaring, 3);
+    BitVec_Flip(flat, 3);
+    TEST_INT_EQ(runner, S_count_mismatches((BitVector*)roaring, flat), 0,
+                "Flip");
+
+    DECREF(roaring);
+    DECREF(flat);
+}
+
+static void
+test_iteration(TestBatchRunner *runner) {
+    RoaringBitVector *roaring = RoarBitVec_new(0);
+    BitVector        *flat    = BitVec_new(0);
+    S_fill((BitVector*)roaring, 2);
+    S_fill(flat, 2);
+    RoarBitVec_Run_Optimize(roaring);
+
+    uint32_t mismatches = 0;
+    for (uint32_t i = 0; i < LIMIT; i += 7) {
+        if (RoarBitVec_Next_Hit(roaring, i) != BitVec_Next_Hit(flat, i)) {
+            mismatches++;
+        }
+    }
+    TEST_INT_EQ(runner, mismatches, 0, "Next_Hit");
+
+    I32Array *expected = BitVec_To_Array(flat);
+    I32Array *got      = RoarBitVec_To_Array(roaring);
+    uint32_t size = I32Arr_Get_Size(expected);
+    mismatches = I32Arr_Get_Size(got) == size ? 0 : 1;
+    for (uint32_t i = 0; i < size && !mismatches; i++) {
+        if (I32Arr_Get(got, i) != I32Arr_Get(expected, i)) { mismatches++; }
+    }
+    TEST_INT_EQ(runner, mismatches, 0, "To_Array");
+
+    // Drain in small blocks, starting partway into the run container.
+    int32_t  hits[100];
+    uint32_t num_hits;
+    uint32_t total = 0;
+    uint32_t tick  = 210000;
+    mismatches = 0;
+    while (0 != (num_hits = RoarBitVec_Next_Hits(roaring, tick, hits, 100))) {
+        for (uint32_t i = 0; i < num_hits; i++) {
+            if (hits[i] != BitVec_Next_Hit(flat, tick)) { mismatches++; }
+            tick = hits[i] + 1;
+        }
+        total += num_hits;
+    }
+    TEST_INT_EQ(runner, mismatches, 0, "Next_Hits");
+    uint32_t expected_total = 0;
+    for (int32_t hit = BitVec_Next_Hit(flat, 210000);
+         hit != -1;
+         hit = BitVec_Next_Hit(flat, hit + 1)
+        ) {
+        expected_total++;
+    }
+    TEST_INT_EQ(runner, total, expected_total, "Next_Hits total");
+
+    BitVecMatcher *matcher = BitVecMatcher_new((BitVector*)roaring);
+    int32_t doc_id;
+    mismatches = 0;
+    tick = 0;
+    while (0 != (doc_id = BitVecMatcher_Next(matcher))) {
+        if (doc_id != BitVec_Next_Hit(flat, 1 + tick)) { mismatches++; }
+        tick = doc_id;
+    }
+    TEST_INT_EQ(runner, mismatches, 0, "BitVecMatcher backed by roaring");
+
+    DECREF(matcher);
+    DECREF(expected);
+    DECREF(got);
+    DECREF(roaring);
+    DECREF(flat);
+}
+
+static void
+test_Run_Optimize_and_Serialize(TestBatchRunner *runner) {
+    RoaringBitVector *roaring = RoarBitVec_new(0);
+    S_fill((BitVector*)roaring, 3);
+    RoaringBitVector *twin = RoarBitVec_Clone(roaring);
+    uint64_t before = RoarBitVec_Serialized_Size(roaring);
+    RoarBitVec_Run_Optimize(roaring);
+    TEST_TRUE(runner, RoarBitVec_Serialized_Size(roaring) < before,
+              "Run_Optimize shrinks a run-heavy set");
+    TEST_TRUE(runner, RoarBitVec_Equals(roaring, (Obj*)twin),
+              "Run_Optimize preserves contents");
+
+    RAMFolder *folder   = RAMFolder_new(NULL);
+    CharBuf   *filename = CB_newf("roaring");
+    OutStream *outstream = RAMFolder_Open_Out(folder, filename);
+    RoarBitVec_Serialize(roaring, outstream);
+    TEST_INT_EQ(runner, (long)OutStream_Tell(outstream),
+                (long)RoarBitVec_Serialized_Size(roaring), "Serialized_Size");
+    OutStream_Close(outstream);
+    InStream *instream = RAMFolder_Open_In(folder, filename);
+    RoaringBitVector *thawed
+        = (RoaringBitVector*)VTable_Make_Obj(ROARINGBITVECTOR);
+    thawed = RoarBitVec_Deserialize(thawed, instream);
+    TEST_TRUE(runner, RoarBitVec_Equals(thawed, (Obj*)twin),
+              "Serialize/Deserialize round trip");
+    TEST_INT_EQ(runner, BitVec_Get_Capacity((BitVector*)thawed),
+                BitVec_Get_Capacity((BitVector*)roaring),
+                "Deserialize restores capacity");
+
+    DECREF(thawed);
+    DECREF(instream);
+    DECREF(outstream);
+    DECREF(filename);
+    DECREF(folder);
+    DECREF(twin);
+    DECREF(roaring);
+}
+
+void
+TestRoarBitVec_run(TestRoaringBitVector *self, TestBatchRunner *runner) {
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 30);
+    test_Set_Get_and_Clear(runner);
+    test_logical_ops(runner);
+    test_Flip_Block(runner);
+    test_iteration(runner);
+    test_Run_Optimize_and_Serialize(runner);
+}
+
@@ -0,0 +1,269 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#define C_TESTLUCY_TESTAGGREGATIONCOLLECTOR
+#define TESTLUCY_USE_SHORT_NAMES
+#include "Lucy/Util/ToolSet.h"
+
+#include "Clownfish/TestHarness/TestBatchRunner.h"
+#include "Lucy/Test.h"
+#include "Lucy/Test/Search/TestAggregationCollector.h"
+#include "Lucy/Document/Doc.h"
+#include "Lucy/Index/Indexer.h"
+#include "Lucy/Plan/NumericType.h"
+#include "Lucy/Plan/Schema.h"
+#include "Lucy/Plan/StringType.h"
+#include "Lucy/Search/Collector/AggregationCollector.h"
+#include "Lucy/Search/Collector/SortCollector.h"
+#include "Lucy/Search/IndexSearcher.h"
+#include "Lucy/Search/MatchAllQuery.h"
+#include "Lucy/Search/TermQuery.h"
+#include "Lucy/Store/RAMFolder.h"
+
+TestAggregationCollector*
+TestAggColl_new() {
+    return (TestAggregationCollector*)VTable_Make_Obj(
+               TESTAGGREGATIONCOLLECTOR);
+}
+
+static Schema*
+S_create_schema() {
+    Schema     *schema   = Schema_new();
+    StringType *str_type = StringType_new();
+    Int32Type  *i32_type = Int32Type_new();
+    StringType *unsorted = StringType_new();
+    StringType_Set_Sortable(str_type, true);
+    Int32Type_Set_Indexed(i32_type, false);
+    Int32Type_Set_Sortable(i32_type, true);
+    CharBuf *cat   = CB_newf("cat");
+    CharBuf *num   = CB_newf("num");
+    CharBuf *title = CB_newf("title");
+    Schema_Spec_Field(schema, cat, (FieldType*)str_type);
+    Schema_Spec_Field(schema, num, (FieldType*)i32_type);
+    Schema_Spec_Field(schema, title, (FieldType*)unsorted);
+    DECREF(title);
+    DECREF(num);
+    DECREF(cat);
+    DECREF(unsorted);
+    DECREF(i32_type);
+    DECREF(str_type);
+    return schema;
+}
+
+// Add a segment of docs.  Doc i is in category "a" if i is a multiple of
+// three and "b" otherwise, except that every tenth doc has no category.  Its
+// num is i % 4.
+static void
+S_add_docs(Schema *schema, RAMFolder *folder, int32_t num_docs) {
+    Indexer *indexer = Indexer_new(schema, (Obj*)folder, NULL, 0);
+    CharBuf *cat     = CB_newf("cat");
+    CharBuf *num     = CB_newf("num");
+    CharBuf *title   = CB_newf("title");
+    for (int32_t i = 0; i < num_docs; i++) {
+        Doc       *doc       = Doc_new(NULL, 0);
+        Integer32 *num_value = Int32_new(i % 4);
+        CharBuf   *title_value = CB_newf("doc %i32", i);
+        Doc_Store(doc, num, (Obj*)num_value);
+        Doc_Store(doc, title, (Obj*)title_value);
+        if (i % 10 != 9) {
+            CharBuf *cat_value = CB_newf("%s", i % 3 == 0 ? "a" : "b");
+            Doc_Store(doc, cat, (Obj*)cat_value);
+            DECREF(cat_value);
+        }
+        Indexer_Add_Doc(indexer, doc, 1.0f);
+        DECREF(title_value);
+        DECREF(num_value);
+        DECREF(doc);
+    }
+    Indexer_Commit(indexer);
+    DECREF(indexer);
+    DECREF(title);
+    DECREF(num);
+    DECREF(cat);
+}
+
+static VArray*
+S_make_bounds(double first, double second) {
+    VArray *bounds = VA_new(2);
+    VA_Push(bounds, (Obj*)Float64_new(first));
+    VA_Push(bounds, (Obj*)Float64_new(second));
+    return bounds;
+}
+
+static void
+S_attempt_descending_bounds(void *context) {
+    CharBuf *field  = (CharBuf*)context;
+    VArray  *bounds = S_make_bounds(3.0, 1.0);
+    AggregationCollector *collector = AggColl_new(field, bounds, NULL);
+    DECREF(collector);
+    DECREF(bounds);
+}
+
+static void
+test_aggregation(TestBatchRunner *runner) {
+    Schema    *schema = S_create_schema();
+    RAMFolder *folder = RAMFolder_new(NULL);
+    S_add_docs(schema, folder, 30);
+    S_add_docs(schema, folder, 60);
+
+    IndexSearcher *searcher  = IxSearcher_new((Obj*)folder);
+    MatchAllQuery *match_all = MatchAllQuery_new();
+    SortCollector *top_docs  = SortColl_new(NULL, NULL, 5);
+    CharBuf       *num       = CB_newf("num");
+    VArray        *bounds    = S_make_bounds(1.0, 3.0);
+    AggregationCollector *collector
+        = AggColl_new(num, bounds, (Collector*)top_docs);
+    IxSearcher_Collect(searcher, (Query*)match_all, (Collector*)collector);
+
+    // 23 zeros, 23 ones, 22 twos and 22 threes.
+    TEST_TRUE(runner, AggColl_Get_Count(collector) == 90
+              && AggColl_Get_Sum(collector) == 133.0
+              && AggColl_Get_Min(collector) == 0.0
+              && AggColl_Get_Max(collector) == 3.0,
+              "count, sum, min and max");
+    TEST_TRUE(runner, AggColl_Get_Average(collector) == 133.0 / 90.0,
+              "average");
+    TEST_TRUE(runner, AggColl_Num_Buckets(collector) == 3
+              && AggColl_Bucket_Count(collector, 0) == 23
+              && AggColl_Bucket_Count(collector, 1) == 45
+              && AggColl_Bucket_Count(collector, 2) == 22,
+              "histogram buckets");
+    TEST_INT_EQ(runner, SortColl_Get_Total_Hits(top_docs), 90,
+                "inner collector sees every hit");
+    DECREF(collector);
+    DECREF(top_docs);
+
+    CharBuf   *cat_field = CB_newf("cat");
+    CharBuf   *term      = CB_newf("a");
+    TermQuery *query     = TermQuery_new(cat_field, (Obj*)term);
+    collector = AggColl_new(num, NULL, NULL);
+    IxSearcher_Collect(searcher, (Query*)query, (Collector*)collector);
+    TEST_TRUE(runner, AggColl_Get_Count(collector) == 27
+              && AggColl_Get_Sum(collector) == 5.0 + 2 * 7.0 + 3 * 7.0
+              && AggColl_Num_Buckets(collector) == 0,
+              "aggregates restricted to matching docs");
+    DECREF(collector);
+    DECREF(query);
+    DECREF(term);
+    DECREF(cat_field);
+
+    Err *error = Err_trap(S_attempt_descending_bounds, num);
+    TEST_TRUE(runner, error != NULL
+              && CB_Find_Str(Err_Get_Mess(error), "ascending", 9) != -1,
+              "bucket boundaries out of order throw an error");
+    DECREF(error);
+
+    DECREF(bounds);
+    DECREF(num);
+    DECREF(match_all);
+    DECREF(searcher);
+    DECREF(folder);
+    DECREF(schema);
+}
+
+static Schema*
+S_make_wide_schema() {
+    Schema      *schema   = Schema_new();
+    Int64Type   *i64_type = Int64Type_new();
+    Float64Type *f64_type = Float64Type_new();
+    Int64Type_Set_Indexed(i64_type, false);
+    Int64Type_Set_Sortable(i64_type, true);
+    Float64Type_Set_Indexed(f64_type, false);
+    Float64Type_Set_Sortable(f64_type, true);
+    CharBuf *big   = CB_newf("big");
+    CharBuf *price = CB_newf("price");
+    Schema_Spec_Field(schema, big, (FieldType*)i64_type);
+    Schema_Spec_Field(schema, price, (FieldType*)f64_type);
+    DECREF(price);
+    DECREF(big);
+    DECREF(f64_type);
+    DECREF(i64_type);
+    return schema;
+}
+
+static AggregationCollector*
+S_aggregate(IndexSearcher *searcher, const char *field) {
+    CharBuf       *field_cb  = CB_newf("%s", field);
+    MatchAllQuery *match_all = MatchAllQuery_new();
+    AggregationCollector *collector = AggColl_new(field_cb, NULL, NULL);
+    IxSearcher_Collect(searcher, (Query*)match_all, (Collector*)collector);
+    DECREF(match_all);
+    DECREF(field_cb);
+    return collector;
+}
+
+static void
+S_attempt_int_sum(void *context) {
+    AggColl_Get_Int_Sum((AggregationCollector*)context);
+}
+
+static void
+test_int64_precision(TestBatchRunner *runner) {
+    Schema    *schema  = S_make_wide_schema();
+    RAMFolder *folder  = RAMFolder_new(NULL);
+    Indexer   *indexer = Indexer_new(schema, (Obj*)folder, NULL, 0);
+    CharBuf   *big     = CB_newf("big");
+    CharBuf   *price   = CB_newf("price");
+    const int64_t base = INT64_C(1) << 53;
+    for (int64_t i = 1; i <= 5; i += 2) {
+        Doc       *doc         = Doc_new(NULL, 0);
+        Integer64 *big_value   = Int64_new(base + i);
+        Float64   *price_value = Float64_new(i / 2.0);
+        Doc_Store(doc, big, (Obj*)big_value);
+        Doc_Store(doc, price, (Obj*)price_value);
+        Indexer_Add_Doc(indexer, doc, 1.0f);
+        DECREF(price_value);
+        DECREF(big_value);
+        DECREF(doc);
+    }
+    Indexer_Commit(indexer);
+    DECREF(indexer);
+    DECREF(price);
+    DECREF(big);
+    IndexSearcher *searcher = IxSearcher_new((Obj*)folder);
+
+    AggregationCollector *collector = S_aggregate(searcher, "big");
+    TEST_TRUE(runner, AggColl_Get_Int_Sum(collector) == 3 * base + 9,
+              "integer sum is exact above 2**53");
+    TEST_TRUE(runner, AggColl_Get_Int_Min(collector) == base + 1
+              && AggColl_Get_Int_Max(collector) == base + 5,
+              "integer min and max are exact above 2**53");
+    DECREF(collector);
+
+    collector = S_aggregate(searcher, "price");
+    TEST_TRUE(runner, AggColl_Get_Sum(collector) == 4.5,
+              "floating point sum");
+    Err *error = Err_trap(S_attempt_int_sum, collector);
+    TEST_TRUE(runner, error != NULL
+              && CB_Find_Str(Err_Get_Mess(error), "integer", 7) != -1,
+              "integer getters throw for floating point fields");
+    DECREF(error);
+    DECREF(collector);
+
+    DECREF(searcher);
+    DECREF(folder);
+    DECREF(schema);
+}
+
+void
+TestAggColl_run(TestAggregationCollector *self, TestBatchRunner *runner) {
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 10);
+    test_aggregation(runner);
+    test_int64_precision(runner);
+}
+
+
@@ -0,0 +1,251 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#define C_TESTLUCY_TESTCACHINGFILTER
+#define TESTLUCY_USE_SHORT_NAMES
+#include "Lucy/Util/ToolSet.h"
+
+#include "Clownfish/TestHarness/TestBatchRunner.h"
+#include "Lucy/Test.h"
+#include "Lucy/Test/Search/TestCachingFilter.h"
+#include "Lucy/Document/Doc.h"
+#include "Lucy/Index/Indexer.h"
+#include "Lucy/Index/PolyReader.h"
+#include "Lucy/Index/SegReader.h"
+#include "Lucy/Object/RoaringBitVector.h"
+#include "Lucy/Plan/Schema.h"
+#include "Lucy/Plan/StringType.h"
+#include "Lucy/Search/CachingFilter.h"
+#include "Lucy/Search/FilterCache.h"
+#include "Lucy/Search/Hits.h"
+#include "Lucy/Search/IndexSearcher.h"
+#include "Lucy/Search/TermQuery.h"
+#include "Lucy/Store/RAMFolder.h"
+
+TestCachingFilter*
+TestCachingFilter_new() {
+    return (TestCachingFilter*)VTable_Make_Obj(TESTCACHINGFILTER);
+}
+
+static Schema*
+S_create_schema() {
+    Schema     *schema = Schema_new();
+    StringType *type   = StringType_new();
+    CharBuf    *field  = CB_newf("cat");
+    Schema_Spec_Field(schema, field, (FieldType*)type);
+    DECREF(field);
+    DECREF(type);
+    return schema;
+}
+
+// Add a segment of docs, every third of which is in category "a" and the
+// rest in category "b".
+static void
+S_add_docs(Schema *schema, RAMFolder *folder, int32_t num_docs) {
+    Indexer *indexer = Indexer_new(schema, (Obj*)folder, NULL, 0);
+    CharBuf *field   = CB_newf("cat");
+    for (int32_t i = 0; i < num_docs; i++) {
+        Doc     *doc = Doc_new(NULL, 0);
+        CharBuf *cat = CB_newf("%s", i % 3 == 0 ? "a" : "b");
+        Doc_Store(doc, field, (Obj*)cat);
+        Indexer_Add_Doc(indexer, doc, 1.0f);
+        DECREF(cat);
+        DECREF(doc);
+    }
+    Indexer_Commit(indexer);
+    DECREF(indexer);
+    DECREF(field);
+}
+
+static Query*
+S_make_filter(const char *cat, FilterCache *cache) {
+    CharBuf   *field = CB_newf("cat");
+    CharBuf   *term  = CB_newf("%s", cat);
+    TermQuery *inner = TermQuery_new(field, (Obj*)term);
+    Query     *filter = (Query*)CachingFilter_new((Query*)inner, cache);
+    DECREF(inner);
+    DECREF(term);
+    DECREF(field);
+    return filter;
+}
+
+static uint32_t
+S_total_hits(RAMFolder *folder, Query *query) {
+    IndexSearcher *searcher = IxSearcher_new((Obj*)folder);
+    Hits *hits = IxSearcher_Hits(searcher, (Obj*)query, 0, 10, NULL);
+    uint32_t total = Hits_Total_Hits(hits);
+    DECREF(hits);
+    DECREF(searcher);
+    return total;
+}
+
+static void
+test_caching(TestBatchRunner *runner) {
+    Schema      *schema = S_create_schema();
+    RAMFolder   *folder = RAMFolder_new(NULL);
+    FilterCache *cache  = FilterCache_new(1024 * 1024);
+    Query       *filter = S_make_filter("a", cache);
+
+    S_add_docs(schema, folder, 300);
+    TEST_INT_EQ(runner, S_total_hits(folder, filter), 100,
+                "CachingFilter matches the wrapped query");
+    TEST_INT_EQ(runner, FilterCache_Get_Size(cache), 1,
+                "one entry per segment");
+    uint64_t num_bytes = FilterCache_Get_Num_Bytes(cache);
+    TEST_INT_EQ(runner, S_total_hits(folder, filter), 100,
+                "same results from cache");
+    TEST_TRUE(runner, FilterCache_Get_Size(cache) == 1
+                      && FilterCache_Get_Num_Bytes(cache) == num_bytes,
+              "repeat search served from cache");
+
+    // An equal filter with its own wrapper shares the cached entries.
+    Query *twin = S_make_filter("a", cache);
+    TEST_INT_EQ(runner, S_total_hits(folder, twin), 100,
+                "equal query hits cache");
+    TEST_INT_EQ(runner, FilterCache_Get_Size(cache), 1,
+                "equal query adds no entries");
+    DECREF(twin);
+
+    // Adding a segment leaves the old entry in place.
+    S_add_docs(schema, folder, 30);
+    TEST_INT_EQ(runner, S_total_hits(folder, filter), 110,
+                "results after refresh");
+    TEST_INT_EQ(runner, FilterCache_Get_Size(cache), 2,
+                "only the new segment is cached after refresh");
+
+    // Deletions are applied after the cached filter.
+    Indexer *indexer = Indexer_new(schema, (Obj*)folder, NULL, 0);
+    Indexer_Delete_By_Doc_ID(indexer, 4);
+    Indexer_Commit(indexer);
+    DECREF(indexer);
+    TEST_INT_EQ(runner, S_total_hits(folder, filter), 109,
+                "deleted docs excluded from cached filter results");
+
+    DECREF(filter);
+    DECREF(cache);
+    DECREF(folder);
+    DECREF(schema);
+}
+
+static void
+test_eviction(TestBatchRunner *runner) {
+    Schema      *schema = S_create_schema();
+    RAMFolder   *folder = RAMFolder_new(NULL);
+    S_add_docs(schema, folder, 300);
+
+    // Find out how big a single entry is, then allow room for just one.
+    FilterCache *probe = FilterCache_new(1024 * 1024);
+    Query *a_filter = S_make_filter("a", probe);
+    S_total_hits(folder, a_filter);
+    uint64_t entry_size = FilterCache_Get_Num_Bytes(probe);
+    DECREF(a_filter);
+    DECREF(probe);
+
+    FilterCache *cache = FilterCache_new(entry_size + entry_size / 2);
+    a_filter = S_make_filter("a", cache);
+    Query *b_filter = S_make_filter("b", cache);
+    TEST_INT_EQ(runner, S_total_hits(folder, a_filter), 100, "a");
+    TEST_INT_EQ(runner, S_total_hits(folder, b_filter), 200, "b");
+    TEST_TRUE(runner, FilterCache_Get_Size(cache) == 1
+                      && FilterCache_Get_Num_Bytes(cache)
+                         <= FilterCache_Get_Max_Bytes(cache),
+              "least recently used entry evicted");
+    TEST_INT_EQ(runner, S_total_hits(folder, a_filter), 100,
+                "evicted entry recomputed");
+
+    DECREF(a_filter);
+    DECREF(b_filter);
+    DECREF(cache);
+    DECREF(folder);
+    DECREF(schema);
+}
+
+static void
+test_lru_order(TestBatchRunner *runner) {
+    Schema     *schema = S_create_schema();
+    RAMFolder  *folder = RAMFolder_new(NULL);
+    S_add_docs(schema, folder, 30);
+    PolyReader *reader = PolyReader_open((Obj*)folder, NULL, NULL);
+    SegReader  *seg_reader
+        = (SegReader*)VA_Fetch(PolyReader_Get_Seg_Readers(reader), 0);
+    CharBuf    *field  = CB_newf("cat");
+    RoaringBitVector *bits = RoarBitVec_new(0);
+    RoarBitVec_Set(bits, 1);
+
+    // Room for three entries.  Keep touching the first one while storing
+    // many others.
+    FilterCache *cache = FilterCache_new(RoarBitVec_Serialized_Size(bits) * 3);
+    Query *queries[100];
+    for (uint32_t i = 0; i < 100; i++) {
+        CharBuf *term = CB_newf("q%u32", i);
+        queries[i] = (Query*)TermQuery_new(field, (Obj*)term);
+        FilterCache_Store(cache, queries[i], seg_reader, bits);
+        DECREF(FilterCache_Fetch(cache, queries[0], seg_reader));
+        DECREF(term);
+    }
+
+    BitVector *first   = FilterCache_Fetch(cache, queries[0], seg_reader);
+    BitVector *last    = FilterCache_Fetch(cache, queries[99], seg_reader);
+    BitVector *evicted = FilterCache_Fetch(cache, queries[97], seg_reader);
+    TEST_INT_EQ(runner, FilterCache_Get_Size(cache), 3,
+                "cache stays within its bound");
+    TEST_TRUE(runner, first != NULL && last != NULL,
+              "recently used entries survive");
+    TEST_TRUE(runner, evicted == NULL, "least recently used entry evicted");
+
+    DECREF(first);
+    DECREF(last);
+    for (uint32_t i = 0; i < 100; i++) { DECREF(queries[i]); }
+    DECREF(cache);
+    DECREF(bits);
+    DECREF(field);
+    DECREF(reader);
+    DECREF(folder);
+    DECREF(schema);
+}
+
+static void
+test_Equals_and_Dump(TestBatchRunner *runner) {
+    Query *a_filter = S_make_filter("a", NULL);
+    Query *b_filter = S_make_filter("b", NULL);
+    Obj   *dump     = (Obj*)Query_Dump(a_filter);
+    Query *clone    = (Query*)Obj_Load(dump, dump);
+
+    TEST_FALSE(runner, Query_Equals(a_filter, (Obj*)b_filter),
+               "different queries spoil Equals");
+    TEST_TRUE(runner, Query_Equals(a_filter, (Obj*)clone),
+              "Dump => Load round trip");
+    TEST_TRUE(runner,
+              CachingFilter_Get_Cache((CachingFilter*)clone) != NULL,
+              "loaded filter gets a cache");
+
+    DECREF(clone);
+    DECREF(dump);
+    DECREF(b_filter);
+    DECREF(a_filter);
+}
+
+void
+TestCachingFilter_run(TestCachingFilter *self, TestBatchRunner *runner) {
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 19);
+    test_caching(runner);
+    test_eviction(runner);
+    test_lru_order(runner);
+    test_Equals_and_Dump(runner);
+}
+
+
@@ -0,0 +1,180 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#define C_TESTLUCY_TESTCARDINALITYCOLLECTOR
+#define TESTLUCY_USE_SHORT_NAMES
+#include "Lucy/Util/ToolSet.h"
+
+#include "Clownfish/TestHarness/TestBatchRunner.h"
+#include "Lucy/Test.h"
+#include "Lucy/Test/Search/TestCardinalityCollector.h"
+#include "Lucy/Document/Doc.h"
+#include "Lucy/Index/Indexer.h"
+#include "Lucy/Object/HyperLogLog.h"
+#include "Lucy/Plan/NumericType.h"
+#include "Lucy/Plan/Schema.h"
+#include "Lucy/Plan/StringType.h"
+#include "Lucy/Search/Collector/CardinalityCollector.h"
+#include "Lucy/Search/IndexSearcher.h"
+#include "Lucy/Search/MatchAllQuery.h"
+#include "Lucy/Search/TermQuery.h"
+#include "Lucy/Store/RAMFolder.h"
+
+TestCardinalityCollector*
+TestCardColl_new() {
+    return (TestCardinalityCollector*)VTable_Make_Obj(
+               TESTCARDINALITYCOLLECTOR);
+}
+
+static Schema*
+S_create_schema() {
+    Schema     *schema   = Schema_new();
+    StringType *str_type = StringType_new();
+    Int32Type  *i32_type = Int32Type_new();
+    StringType *unsorted = StringType_new();
+    StringType_Set_Sortable(str_type, true);
+    Int32Type_Set_Indexed(i32_type, false);
+    Int32Type_Set_Sortable(i32_type, true);
+    CharBuf *cat   = CB_newf("cat");
+    CharBuf *num   = CB_newf("num");
+    CharBuf *title = CB_newf("title");
+    Schema_Spec_Field(schema, cat, (FieldType*)str_type);
+    Schema_Spec_Field(schema, num, (FieldType*)i32_type);
+    Schema_Spec_Field(schema, title, (FieldType*)unsorted);
+    DECREF(title);
+    DECREF(num);
+    DECREF(cat);
+    DECREF(unsorted);
+    DECREF(i32_type);
+    DECREF(str_type);
+    return schema;
+}
+
+// Add a segment of docs.  Doc i is in category "a" if i is a multiple of
+// three and "b" otherwise, except that every tenth doc has no category.  Its
+// num is i % 4.
+static void
+S_add_docs(Schema *schema, RAMFolder *folder, int32_t num_docs) {
+    Indexer *indexer = Indexer_new(schema, (Obj*)folder, NULL, 0);
+    CharBuf *cat     = CB_newf("cat");
+    CharBuf *num     = CB_newf("num");
+    CharBuf *title   = CB_newf("title");
+    for (int32_t i = 0; i < num_docs; i++) {
+        Doc       *doc       = Doc_new(NULL, 0);
+        Integer32 *num_value = Int32_new(i % 4);
+        CharBuf   *title_value = CB_newf("doc %i32", i);
+        Doc_Store(doc, num, (Obj*)num_value);
+        Doc_Store(doc, title, (Obj*)title_value);
+        if (i % 10 != 9) {
+            CharBuf *cat_value = CB_newf("%s", i % 3 == 0 ? "a" : "b");
+            Doc_Store(doc, cat, (Obj*)cat_value);
+            DECREF(cat_value);
+        }
+        Indexer_Add_Doc(indexer, doc, 1.0f);
+        DECREF(title_value);
+        DECREF(num_value);
+        DECREF(doc);
+    }
+    Indexer_Commit(indexer);
+    DECREF(indexer);
+    DECREF(title);
+    DECREF(num);
+    DECREF(cat);
+}
+
+static uint64_t
+S_distinct(IndexSearcher *searcher, Query *query, const char *field) {
+    CharBuf *field_cb = CB_newf("%s", field);
+    CardinalityCollector *collector = CardColl_new(field_cb, 14, NULL);
+    IxSearcher_Collect(searcher, query, (Collector*)collector);
+    uint64_t estimate = CardColl_Estimate(collector);
+    DECREF(collector);
+    DECREF(field_cb);
+    return estimate;
+}
+
+static void
+test_cardinality(TestBatchRunner *runner) {
+    Schema    *schema = S_create_schema();
+    RAMFolder *folder = RAMFolder_new(NULL);
+    S_add_docs(schema, folder, 30);
+    S_add_docs(schema, folder, 60);
+
+    IndexSearcher *searcher  = IxSearcher_new((Obj*)folder);
+    MatchAllQuery *match_all = MatchAllQuery_new();
+    TEST_INT_EQ(runner, (long)S_distinct(searcher, (Query*)match_all, "cat"),
+                2, "values shared across segments are counted once");
+    TEST_INT_EQ(runner, (long)S_distinct(searcher, (Query*)match_all, "num"),
+                4, "numeric values");
+
+    CharBuf   *field = CB_newf("cat");
+    CharBuf   *term  = CB_newf("a");
+    TermQuery *query = TermQuery_new(field, (Obj*)term);
+    TEST_TRUE(runner, S_distinct(searcher, (Query*)query, "cat") == 1
+              && S_distinct(searcher, (Query*)query, "num") == 4,
+              "distinct values among matching docs only");
+    DECREF(query);
+    DECREF(term);
+    DECREF(field);
+
+    DECREF(match_all);
+    DECREF(searcher);
+    DECREF(folder);
+    DECREF(schema);
+}
+
+static void
+test_byte_order(TestBatchRunner *runner) {
+    Schema    *schema = S_create_schema();
+    RAMFolder *folder = RAMFolder_new(NULL);
+    S_add_docs(schema, folder, 30);
+
+    IndexSearcher *searcher  = IxSearcher_new((Obj*)folder);
+    MatchAllQuery *match_all = MatchAllQuery_new();
+    CharBuf       *num       = CB_newf("num");
+    CardinalityCollector *collector = CardColl_new(num, 14, NULL);
+    IxSearcher_Collect(searcher, (Query*)match_all, (Collector*)collector);
+
+    // Integers are hashed as big-endian 64-bit values.
+    HyperLogLog *expected = HLL_new(14);
+    for (uint64_t i = 0; i < 4; i++) {
+        char  buf[sizeof(uint64_t)];
+        char *dest = buf;
+        NumUtil_encode_bigend_u64(i, &dest);
+        HLL_Add_Hash(expected, HLL_hash_bytes(buf, sizeof(buf)));
+    }
+    TEST_TRUE(runner, HLL_Equals(CardColl_Get_Sketch(collector),
+                                 (Obj*)expected),
+              "numeric values are hashed in big-endian byte order");
+
+    DECREF(expected);
+    DECREF(collector);
+    DECREF(num);
+    DECREF(match_all);
+    DECREF(searcher);
+    DECREF(folder);
+    DECREF(schema);
+}
+
+void
+TestCardColl_run(TestCardinalityCollector *self, TestBatchRunner *runner) {
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 4);
+    test_cardinality(runner);
+    test_byte_order(runner);
+}
+
+
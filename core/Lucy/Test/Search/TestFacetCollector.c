@@ -0,0 +1,208 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define C_TESTLUCY_TESTFACETCOLLECTOR
+#define TESTLUCY_USE_SHORT_NAMES
+#include "Lucy/Util/ToolSet.h"
+
+#include "Clownfish/TestHarness/TestBatchRunner.h"
+#include "Lucy/Test.h"
+#include "Lucy/Test/Search/TestFacetCollector.h"
+#include "Lucy/Document/Doc.h"
+#include "Lucy/Index/Indexer.h"
+#include "Lucy/Plan/NumericType.h"
+#include "Lucy/Plan/Schema.h"
+#include "Lucy/Plan/StringType.h"
+#include "Lucy/Search/Collector/FacetCollector.h"
+#include "Lucy/Search/Collector/SortCollector.h"
+#include "Lucy/Search/IndexSearcher.h"
+#include "Lucy/Search/MatchAllQuery.h"
+#include "Lucy/Search/TermQuery.h"
+#include "Lucy/Store/RAMFolder.h"
+
+TestFacetCollector*
+TestFacetCollector_new() {
+    return (TestFacetCollector*)VTable_Make_Obj(TESTFACETCOLLECTOR);
+}
+
+static Schema*
+S_create_schema() {
+    Schema     *schema   = Schema_new();
+    StringType *str_type = StringType_new();
+    Int32Type  *i32_type = Int32Type_new();
+    StringType *unsorted = StringType_new();
+    StringType_Set_Sortable(str_type, true);
+    Int32Type_Set_Indexed(i32_type, false);
+    Int32Type_Set_Sortable(i32_type, true);
+    CharBuf *cat   = CB_newf("cat");
+    CharBuf *num   = CB_newf("num");
+    CharBuf *title = CB_newf("title");
+    Schema_Spec_Field(schema, cat, (FieldType*)str_type);
+    Schema_Spec_Field(schema, num, (FieldType*)i32_type);
+    Schema_Spec_Field(schema, title, (FieldType*)unsorted);
+    DECREF(title);
+    DECREF(num);
+    DECREF(cat);
+    DECREF(unsorted);
+    DECREF(i32_type);
+    DECREF(str_type);
+    return schema;
+}
+
+// Add a segment of docs.  Doc i is in category "a" if i is a multiple of
+// three and "b" otherwise, except that every tenth doc has no category.  Its
+// num is i % 4.
+static void
+S_add_docs(Schema *schema, RAMFolder *folder, int32_t num_docs) {
+    Indexer *indexer = Indexer_new(schema, (Obj*)folder, NULL, 0);
+    CharBuf *cat     = CB_newf("cat");
+    CharBuf *num     = CB_newf("num");
+    CharBuf *title   = CB_newf("title");
+    for (int32_t i = 0; i < num_docs; i++) {
+        Doc       *doc       = Doc_new(NULL, 0);
+        Integer32 *num_value = Int32_new(i % 4);
+        CharBuf   *title_value = CB_newf("doc %i32", i);
+        Doc_Store(doc, num, (Obj*)num_value);
+        Doc_Store(doc, title, (Obj*)title_value);
+        if (i % 10 != 9) {
+            CharBuf *cat_value = CB_newf("%s", i % 3 == 0 ? "a" : "b");
+            Doc_Store(doc, cat, (Obj*)cat_value);
+            DECREF(cat_value);
+        }
+        Indexer_Add_Doc(indexer, doc, 1.0f);
+        DECREF(title_value);
+        DECREF(num_value);
+        DECREF(doc);
+    }
+    Indexer_Commit(indexer);
+    DECREF(indexer);
+    DECREF(title);
+    DECREF(num);
+    DECREF(cat);
+}
+
+static FacetCollector*
+S_make_collector(Collector *inner) {
+    VArray *fields = VA_new(3);
+    VA_Push(fields, (Obj*)CB_newf("cat"));
+    VA_Push(fields, (Obj*)CB_newf("num"));
+    VA_Push(fields, (Obj*)CB_newf("title"));
+    FacetCollector *collector = FacetColl_new(fields, inner);
+    DECREF(fields);
+    return collector;
+}
+
+static int64_t
+S_count(FacetCollector *collector, const char *field, Obj *value) {
+    CharBuf *field_cb = CB_newf("%s", field);
+    Hash    *counts   = FacetColl_Get_Counts(collector, field_cb);
+    Obj     *count    = counts ? Hash_Fetch(counts, value) : NULL;
+    DECREF(field_cb);
+    return count ? Obj_To_I64(count) : 0;
+}
+
+static int64_t
+S_str_count(FacetCollector *collector, const char *field, const char *str) {
+    CharBuf *value = CB_newf("%s", str);
+    int64_t  count = S_count(collector, field, (Obj*)value);
+    DECREF(value);
+    return count;
+}
+
+static int64_t
+S_int_count(FacetCollector *collector, const char *field, int32_t num) {
+    Integer32 *value = Int32_new(num);
+    int64_t    count = S_count(collector, field, (Obj*)value);
+    DECREF(value);
+    return count;
+}
+
+static void
+test_facets(TestBatchRunner *runner) {
+    Schema    *schema = S_create_schema();
+    RAMFolder *folder = RAMFolder_new(NULL);
+    S_add_docs(schema, folder, 30);
+    S_add_docs(schema, folder, 60);
+
+    IndexSearcher  *searcher  = IxSearcher_new((Obj*)folder);
+    SortCollector  *top_docs  = SortColl_new(NULL, NULL, 5);
+    FacetCollector *collector = S_make_collector((Collector*)top_docs);
+    MatchAllQuery  *match_all = MatchAllQuery_new();
+    IxSearcher_Collect(searcher, (Query*)match_all, (Collector*)collector);
+
+    // Segment 1: a=9, b=18, none=3.  Segment 2: a=18, b=36, none=6.
+    TEST_INT_EQ(runner, S_str_count(collector, "cat", "a"), 27,
+                "counts merged across segments by value");
+    TEST_INT_EQ(runner, S_str_count(collector, "cat", "b"), 54,
+                "counts for a second value");
+    CharBuf *cat = CB_newf("cat");
+    TEST_INT_EQ(runner, Hash_Get_Size(FacetColl_Get_Counts(collector, cat)),
+                2, "docs without a value aren't counted");
+    DECREF(cat);
+    TEST_TRUE(runner, S_int_count(collector, "num", 0) == 23
+              && S_int_count(collector, "num", 1) == 23
+              && S_int_count(collector, "num", 2) == 22
+              && S_int_count(collector, "num", 3) == 22,
+              "numeric values");
+    CharBuf *title = CB_newf("title");
+    CharBuf *other = CB_newf("other");
+    TEST_INT_EQ(runner, Hash_Get_Size(FacetColl_Get_Counts(collector, title)),
+                0, "fields which aren't sortable yield no counts");
+    TEST_TRUE(runner, FacetColl_Get_Counts(collector, other) == NULL,
+              "NULL for fields which weren't requested");
+    DECREF(other);
+    DECREF(title);
+
+    VArray *match_docs = SortColl_Pop_Match_Docs(top_docs);
+    TEST_TRUE(runner, VA_Get_Size(match_docs) == 5
+              && SortColl_Get_Total_Hits(top_docs) == 90,
+              "inner collector sees every hit in the same pass");
+    DECREF(match_docs);
+    DECREF(collector);
+    DECREF(top_docs);
+
+    // Only matching docs are counted.
+    CharBuf   *field = CB_newf("cat");
+    CharBuf   *term  = CB_newf("a");
+    TermQuery *query = TermQuery_new(field, (Obj*)term);
+    collector = S_make_collector(NULL);
+    IxSearcher_Collect(searcher, (Query*)query, (Collector*)collector);
+    TEST_TRUE(runner, S_str_count(collector, "cat", "a") == 27
+              && S_str_count(collector, "cat", "b") == 0,
+              "counts restricted to matching docs");
+    TEST_TRUE(runner, S_int_count(collector, "num", 0) == 8
+              && S_int_count(collector, "num", 1) == 5
+              && S_int_count(collector, "num", 2) == 7
+              && S_int_count(collector, "num", 3) == 7,
+              "other fields restricted to matching docs");
+    DECREF(collector);
+    DECREF(query);
+    DECREF(term);
+    DECREF(field);
+
+    DECREF(match_all);
+    DECREF(searcher);
+    DECREF(folder);
+    DECREF(schema);
+}
+
+void
+TestFacetCollector_run(TestFacetCollector *self, TestBatchRunner *runner) {
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 9);
+    test_facets(runner);
+}
+
+
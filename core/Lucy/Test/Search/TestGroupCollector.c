@@ -0,0 +1,374 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#define C_TESTLUCY_TESTGROUPCOLLECTOR
+#define TESTLUCY_USE_SHORT_NAMES
+#include "Lucy/Util/ToolSet.h"
+#include <stdio.h>
+
+#include "Clownfish/TestHarness/TestBatchRunner.h"
+#include "Lucy/Test.h"
+#include "Lucy/Test/Search/TestGroupCollector.h"
+#include "Lucy/Document/Doc.h"
+#include "Lucy/Index/Indexer.h"
+#include "Lucy/Plan/NumericType.h"
+#include "Lucy/Plan/Schema.h"
+#include "Lucy/Plan/StringType.h"
+#include "Lucy/Search/Collector/GroupCollector.h"
+#include "Lucy/Search/GroupDocs.h"
+#include "Lucy/Search/IndexSearcher.h"
+#include "Lucy/Search/MatchAllQuery.h"
+#include "Lucy/Search/MatchDoc.h"
+#include "Lucy/Search/SortRule.h"
+#include "Lucy/Search/SortSpec.h"
+#include "Lucy/Store/RAMFolder.h"
+
+TestGroupCollector*
+TestGroupColl_new() {
+    return (TestGroupCollector*)VTable_Make_Obj(TESTGROUPCOLLECTOR);
+}
+
+static Schema*
+S_create_schema() {
+    Schema     *schema   = Schema_new();
+    StringType *str_type = StringType_new();
+    Int32Type  *i32_type = Int32Type_new();
+    StringType *unsorted = StringType_new();
+    StringType_Set_Sortable(str_type, true);
+    Int32Type_Set_Indexed(i32_type, false);
+    Int32Type_Set_Sortable(i32_type, true);
+    CharBuf *cat   = CB_newf("cat");
+    CharBuf *num   = CB_newf("num");
+    CharBuf *title = CB_newf("title");
+    Schema_Spec_Field(schema, cat, (FieldType*)str_type);
+    Schema_Spec_Field(schema, num, (FieldType*)i32_type);
+    Schema_Spec_Field(schema, title, (FieldType*)unsorted);
+    DECREF(title);
+    DECREF(num);
+    DECREF(cat);
+    DECREF(unsorted);
+    DECREF(i32_type);
+    DECREF(str_type);
+    return schema;
+}
+
+// Add a segment of docs.  Doc i is in category "a" if i is a multiple of
+// three and "b" otherwise, except that every tenth doc has no category.  Its
+// num is i % 4.
+static void
+S_add_docs(Schema *schema, RAMFolder *folder, int32_t num_docs) {
+    Indexer *indexer = Indexer_new(schema, (Obj*)folder, NULL, 0);
+    CharBuf *cat     = CB_newf("cat");
+    CharBuf *num     = CB_newf("num");
+    CharBuf *title   = CB_newf("title");
+    for (int32_t i = 0; i < num_docs; i++) {
+        Doc       *doc       = Doc_new(NULL, 0);
+        Integer32 *num_value = Int32_new(i % 4);
+        CharBuf   *title_value = CB_newf("doc %i32", i);
+        Doc_Store(doc, num, (Obj*)num_value);
+        Doc_Store(doc, title, (Obj*)title_value);
+        if (i % 10 != 9) {
+            CharBuf *cat_value = CB_newf("%s", i % 3 == 0 ? "a" : "b");
+            Doc_Store(doc, cat, (Obj*)cat_value);
+            DECREF(cat_value);
+        }
+        Indexer_Add_Doc(indexer, doc, 1.0f);
+        DECREF(title_value);
+        DECREF(num_value);
+        DECREF(doc);
+    }
+    Indexer_Commit(indexer);
+    DECREF(indexer);
+    DECREF(title);
+    DECREF(num);
+    DECREF(cat);
+}
+
+// Return true if the group has the expected value, hit count and top docs.
+static bool
+S_group_matches(GroupDocs *group, const char *value, uint32_t total_hits,
+                int32_t *doc_ids, uint32_t num_doc_ids) {
+    Obj    *group_value = GroupDocs_Get_Value(group);
+    VArray *match_docs  = GroupDocs_Get_Match_Docs(group);
+    if (value) {
+        if (!group_value || !Obj_Is_A(group_value, CHARBUF)) { return false; }
+        if (!CB_Equals_Str((CharBuf*)group_value, value, strlen(value))) {
+            return false;
+        }
+    }
+    else if (group_value) {
+        return false;
+    }
+    if (GroupDocs_Get_Total_Hits(group) != total_hits) { return false; }
+    if (VA_Get_Size(match_docs) != num_doc_ids)        { return false; }
+    for (uint32_t i = 0; i < num_doc_ids; i++) {
+        MatchDoc *match_doc = (MatchDoc*)VA_Fetch(match_docs, i);
+        if (MatchDoc_Get_Doc_ID(match_doc) != doc_ids[i]) { return false; }
+    }
+    return true;
+}
+
+static void
+S_attempt_unsortable_group_field(void *context) {
+    Schema  *schema = (Schema*)context;
+    CharBuf *field  = CB_newf("title");
+    GroupCollector *collector
+        = GroupColl_new(schema, field, NULL, 10, 1, false);
+    DECREF(collector);
+    DECREF(field);
+}
+
+static void
+test_grouping(TestBatchRunner *runner) {
+    Schema    *schema = S_create_schema();
+    RAMFolder *folder = RAMFolder_new(NULL);
+    S_add_docs(schema, folder, 30);
+    S_add_docs(schema, folder, 60);
+
+    IndexSearcher *searcher  = IxSearcher_new((Obj*)folder);
+    MatchAllQuery *match_all = MatchAllQuery_new();
+    CharBuf       *num       = CB_newf("num");
+    CharBuf       *cat       = CB_newf("cat");
+    VArray        *rules     = VA_new(2);
+    VA_Push(rules, (Obj*)SortRule_new(SortRule_FIELD, num, false));
+    VA_Push(rules, (Obj*)SortRule_new(SortRule_DOC_ID, NULL, false));
+    SortSpec *sort_spec = SortSpec_new(rules);
+
+    GroupCollector *collector
+        = GroupColl_new(schema, cat, sort_spec, 2, 3, true);
+    IxSearcher_Collect(searcher, (Query*)match_all, (Collector*)collector);
+    TEST_TRUE(runner, GroupColl_Get_Total_Hits(collector) == 90
+              && GroupColl_Get_Total_Groups(collector) == 3,
+              "total hits and groups");
+    VArray *groups = GroupColl_Pop_Groups(collector);
+    int32_t a_docs[] = { 1, 13, 25 };
+    int32_t b_docs[] = { 5, 9, 17 };
+    TEST_TRUE(runner, VA_Get_Size(groups) == 2
+              && S_group_matches((GroupDocs*)VA_Fetch(groups, 0), "a", 27,
+                                 a_docs, 3)
+              && S_group_matches((GroupDocs*)VA_Fetch(groups, 1), "b", 54,
+                                 b_docs, 3),
+              "top groups with top docs per group, across segments");
+    DECREF(groups);
+    DECREF(collector);
+
+    // Rank by score, then doc id.  Docs without a value form a group.
+    collector = GroupColl_new(NULL, cat, NULL, 5, 1, true);
+    IxSearcher_Collect(searcher, (Query*)match_all, (Collector*)collector);
+    groups = GroupColl_Pop_Groups(collector);
+    int32_t a_head[]    = { 1 };
+    int32_t b_head[]    = { 2 };
+    int32_t null_head[] = { 10 };
+    TEST_TRUE(runner, VA_Get_Size(groups) == 3
+              && S_group_matches((GroupDocs*)VA_Fetch(groups, 0), "a", 27,
+                                 a_head, 1)
+              && S_group_matches((GroupDocs*)VA_Fetch(groups, 1), "b", 54,
+                                 b_head, 1)
+              && S_group_matches((GroupDocs*)VA_Fetch(groups, 2), NULL, 9,
+                                 null_head, 1),
+              "docs without a value are grouped together");
+    DECREF(groups);
+    DECREF(collector);
+
+    Err *error = Err_trap(S_attempt_unsortable_group_field, schema);
+    TEST_TRUE(runner, error != NULL
+              && CB_Find_Str(Err_Get_Mess(error), "sortable", 8) != -1,
+              "grouping by an unsortable field throws an error");
+    DECREF(error);
+
+    DECREF(sort_spec);
+    DECREF(rules);
+    DECREF(cat);
+    DECREF(num);
+    DECREF(match_all);
+    DECREF(searcher);
+    DECREF(folder);
+    DECREF(schema);
+}
+
+#define NUM_DISTINCT 500
+
+// Add one doc for each of NUM_DISTINCT distinct "cat" values, in scrambled
+// order.  The doc at offset i has "num" (i * 7) % NUM_DISTINCT and "cat"
+// "g" followed by its num.
+static void
+S_add_distinct_docs(Schema *schema, RAMFolder *folder) {
+    Indexer *indexer = Indexer_new(schema, (Obj*)folder, NULL, 0);
+    CharBuf *cat     = CB_newf("cat");
+    CharBuf *num     = CB_newf("num");
+    for (int32_t i = 0; i < NUM_DISTINCT; i++) {
+        int32_t    value     = (i * 7) % NUM_DISTINCT;
+        Doc       *doc       = Doc_new(NULL, 0);
+        CharBuf   *cat_value = CB_newf("g%i32", value);
+        Integer32 *num_value = Int32_new(value);
+        Doc_Store(doc, cat, (Obj*)cat_value);
+        Doc_Store(doc, num, (Obj*)num_value);
+        Indexer_Add_Doc(indexer, doc, 1.0f);
+        DECREF(num_value);
+        DECREF(cat_value);
+        DECREF(doc);
+    }
+    Indexer_Commit(indexer);
+    DECREF(indexer);
+    DECREF(num);
+    DECREF(cat);
+}
+
+static void
+test_many_groups(TestBatchRunner *runner) {
+    Schema    *schema = S_create_schema();
+    RAMFolder *folder = RAMFolder_new(NULL);
+    S_add_distinct_docs(schema, folder);
+    S_add_distinct_docs(schema, folder);
+
+    IndexSearcher *searcher  = IxSearcher_new((Obj*)folder);
+    MatchAllQuery *match_all = MatchAllQuery_new();
+    CharBuf       *num       = CB_newf("num");
+    CharBuf       *cat       = CB_newf("cat");
+    VArray        *rules     = VA_new(2);
+    VA_Push(rules, (Obj*)SortRule_new(SortRule_FIELD, num, true));
+    VA_Push(rules, (Obj*)SortRule_new(SortRule_DOC_ID, NULL, false));
+    SortSpec *sort_spec = SortSpec_new(rules);
+
+    GroupCollector *collector
+        = GroupColl_new(schema, cat, sort_spec, 3, 2, true);
+    IxSearcher_Collect(searcher, (Query*)match_all, (Collector*)collector);
+    TEST_TRUE(runner, GroupColl_Get_Total_Hits(collector) == 2 * NUM_DISTINCT
+              && GroupColl_Get_Total_Groups(collector) == NUM_DISTINCT,
+              "every distinct value is counted");
+
+    // Each value has one doc per segment, at the same offset.
+    VArray *groups = GroupColl_Pop_Groups(collector);
+    bool    ok     = VA_Get_Size(groups) == 3;
+    for (int32_t rank = 0; ok && rank < 3; rank++) {
+        int32_t want = NUM_DISTINCT - 1 - rank;
+        int32_t offset = 0;
+        while ((offset * 7) % NUM_DISTINCT != want) { offset++; }
+        int32_t doc_ids[2] = { offset + 1, offset + 1 + NUM_DISTINCT };
+        char    value[16];
+        sprintf(value, "g%d", (int)want);
+        ok = S_group_matches((GroupDocs*)VA_Fetch(groups, rank), value, 2,
+                             doc_ids, 2);
+    }
+    TEST_TRUE(runner, ok, "top groups among many distinct values");
+    DECREF(groups);
+    DECREF(collector);
+
+    DECREF(sort_spec);
+    DECREF(rules);
+    DECREF(cat);
+    DECREF(num);
+    DECREF(match_all);
+    DECREF(searcher);
+    DECREF(folder);
+    DECREF(schema);
+}
+
+// Add one segment with a doc for each of the `num_docs` cat/num pairs.
+static void
+S_add_pairs(Schema *schema, RAMFolder *folder, const char **cats,
+            int32_t *nums, uint32_t num_docs) {
+    Indexer *indexer = Indexer_new(schema, (Obj*)folder, NULL, 0);
+    CharBuf *cat     = CB_newf("cat");
+    CharBuf *num     = CB_newf("num");
+    for (uint32_t i = 0; i < num_docs; i++) {
+        Doc       *doc       = Doc_new(NULL, 0);
+        CharBuf   *cat_value = CB_newf("%s", cats[i]);
+        Integer32 *num_value = Int32_new(nums[i]);
+        Doc_Store(doc, cat, (Obj*)cat_value);
+        Doc_Store(doc, num, (Obj*)num_value);
+        Indexer_Add_Doc(indexer, doc, 1.0f);
+        DECREF(num_value);
+        DECREF(cat_value);
+        DECREF(doc);
+    }
+    Indexer_Commit(indexer);
+    DECREF(indexer);
+    DECREF(num);
+    DECREF(cat);
+}
+
+static void
+S_attempt_get_total_groups(void *context) {
+    GroupColl_Get_Total_Groups((GroupCollector*)context);
+}
+
+static void
+test_evicted_docs(TestBatchRunner *runner) {
+    Schema    *schema = S_create_schema();
+    RAMFolder *folder = RAMFolder_new(NULL);
+    const char *cats[] = { "x", "y", "x" };
+    int32_t     nums[] = { 5, 9, 10 };
+    S_add_pairs(schema, folder, cats, nums, 3);
+
+    IndexSearcher *searcher  = IxSearcher_new((Obj*)folder);
+    MatchAllQuery *match_all = MatchAllQuery_new();
+    CharBuf       *num       = CB_newf("num");
+    CharBuf       *cat       = CB_newf("cat");
+    VArray        *rules     = VA_new(2);
+    VA_Push(rules, (Obj*)SortRule_new(SortRule_FIELD, num, true));
+    VA_Push(rules, (Obj*)SortRule_new(SortRule_DOC_ID, NULL, false));
+    SortSpec *sort_spec = SortSpec_new(rules);
+
+    // Doc 2 evicts group "x", and doc 3 brings it back, without doc 1.
+    int32_t x_docs[] = { 3 };
+    GroupCollector *collector
+        = GroupColl_new(schema, cat, sort_spec, 1, 2, false);
+    IxSearcher_Collect(searcher, (Query*)match_all, (Collector*)collector);
+    VArray *groups = GroupColl_Pop_Groups(collector);
+    TEST_TRUE(runner, VA_Get_Size(groups) == 1
+              && S_group_matches((GroupDocs*)VA_Fetch(groups, 0), "x", 1,
+                                 x_docs, 1),
+              "docs collected before a group's eviction are lost");
+    Err *error = Err_trap(S_attempt_get_total_groups, collector);
+    TEST_TRUE(runner, error != NULL,
+              "Get_Total_Groups throws unless groups are counted");
+    DECREF(error);
+    DECREF(groups);
+    DECREF(collector);
+
+    // Counting groups makes hit counts exact, but not the docs.
+    collector = GroupColl_new(schema, cat, sort_spec, 1, 2, true);
+    IxSearcher_Collect(searcher, (Query*)match_all, (Collector*)collector);
+    groups = GroupColl_Pop_Groups(collector);
+    TEST_TRUE(runner, GroupColl_Get_Total_Groups(collector) == 2
+              && VA_Get_Size(groups) == 1
+              && S_group_matches((GroupDocs*)VA_Fetch(groups, 0), "x", 2,
+                                 x_docs, 1),
+              "counted groups have exact hit counts");
+    DECREF(groups);
+    DECREF(collector);
+
+    DECREF(sort_spec);
+    DECREF(rules);
+    DECREF(cat);
+    DECREF(num);
+    DECREF(match_all);
+    DECREF(searcher);
+    DECREF(folder);
+    DECREF(schema);
+}
+
+void
+TestGroupColl_run(TestGroupCollector *self, TestBatchRunner *runner) {
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 9);
+    test_grouping(runner);
+    test_many_groups(runner);
+    test_evicted_docs(runner);
+}
+
+
@@ -0,0 +1,305 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define C_TESTLUCY_TESTMATCHERBLOCKS
+#define C_TESTLUCY_SCORECOUNTINGMATCHER
+#define TESTLUCY_USE_SHORT_NAMES
+#include "Lucy/Util/ToolSet.h"
+
+#include "Clownfish/TestHarness/TestBatchRunner.h"
+#include "Lucy/Test.h"
+#include "Lucy/Test/Search/TestMatcherBlocks.h"
+#include "Lucy/Document/Doc.h"
+#include "Lucy/Index/Indexer.h"
+#include "Lucy/Index/PolyReader.h"
+#include "Lucy/Index/SegReader.h"
+#include "Lucy/Plan/Schema.h"
+#include "Lucy/Plan/StringType.h"
+#include "Lucy/Search/ANDMatcher.h"
+#include "Lucy/Search/BitVecMatcher.h"
+#include "Lucy/Search/Collector.h"
+#include "Lucy/Search/Collector/SortCollector.h"
+#include "Lucy/Search/Compiler.h"
+#include "Lucy/Search/IndexSearcher.h"
+#include "Lucy/Search/MatchAllMatcher.h"
+#include "Lucy/Search/MatchDoc.h"
+#include "Lucy/Search/ORMatcher.h"
+#include "Lucy/Search/TermQuery.h"
+#include "Lucy/Store/RAMFolder.h"
+
+ScoreCountingMatcher*
+ScoreCounter_new(float score, int32_t doc_max) {
+    ScoreCountingMatcher *self
+        = (ScoreCountingMatcher*)VTable_Make_Obj(SCORECOUNTINGMATCHER);
+    MatchAllMatcher_init((MatchAllMatcher*)self, score, doc_max);
+    ScoreCounter_IVARS(self)->num_scored = 0;
+    return self;
+}
+
+float
+ScoreCounter_score(ScoreCountingMatcher *self) {
+    ScoreCounter_IVARS(self)->num_scored++;
+    return MatchAllMatcher_score((MatchAllMatcher*)self);
+}
+
+int32_t
+ScoreCounter_get_num_scored(ScoreCountingMatcher *self) {
+    return ScoreCounter_IVARS(self)->num_scored;
+}
+
+TestMatcherBlocks*
+TestMatcherBlocks_new() {
+    return (TestMatcherBlocks*)VTable_Make_Obj(TESTMATCHERBLOCKS);
+}
+
+// Run two equivalent Matchers side by side, one through Next_Block() and
+// one through Next() and Score(), and verify that they agree.  Both are
+// consumed and released.
+static void
+S_test_blocks(TestBatchRunner *runner, Matcher *blocked, Matcher *serial,
+              bool need_score, uint32_t block_size, const char *name) {
+    int32_t  *doc_ids = (int32_t*)MALLOCATE(block_size * sizeof(int32_t));
+    float    *scores  = need_score
+                        ? (float*)MALLOCATE(block_size * sizeof(float))
+                        : NULL;
+    uint32_t  total   = 0;
+    bool      agree   = true;
+
+    // Start off with a single Next() to check that the two styles mix.
+    int32_t first = Matcher_Next(blocked);
+    if (first != Matcher_Next(serial)) { agree = false; }
+    total += first ? 1 : 0;
+
+    while (first && agree) {
+        uint32_t count
+            = Matcher_Next_Block(blocked, doc_ids, scores, block_size);
+        for (uint32_t i = 0; i < count; i++) {
+            if (doc_ids[i] != Matcher_Next(serial)
+                || (scores && scores[i] != Matcher_Score(serial))
+               ) {
+                agree = false;
+                break;
+            }
+        }
+        if (count == block_size
+            && Matcher_Get_Doc_ID(blocked) != doc_ids[count - 1]
+           ) {
+            agree = false;
+        }
+        total += count;
+        if (count < block_size) { break; }
+    }
+    if (agree && first && Matcher_Next(serial) != 0) { agree = false; }
+
+    TEST_TRUE(runner, agree && total > 0,
+              "%s: Next_Block() agrees with Next() over %u docs", name,
+              total);
+
+    FREEMEM(doc_ids);
+    FREEMEM(scores);
+    DECREF(blocked);
+    DECREF(serial);
+}
+
+static Matcher*
+S_bit_vec_matcher(int32_t mod, int32_t doc_max) {
+    BitVector *bit_vec = BitVec_new(doc_max + 1);
+    for (int32_t doc_id = mod; doc_id <= doc_max; doc_id += mod) {
+        BitVec_Set(bit_vec, doc_id);
+    }
+    Matcher *matcher = (Matcher*)BitVecMatcher_new(bit_vec);
+    DECREF(bit_vec);
+    return matcher;
+}
+
+static VArray*
+S_kids(Matcher *a, Matcher *b) {
+    VArray *kids = VA_new(2);
+    VA_Push(kids, (Obj*)a);
+    VA_Push(kids, (Obj*)b);
+    return kids;
+}
+
+static Matcher*
+S_and_matcher() {
+    VArray  *kids = S_kids(S_bit_vec_matcher(2, 1000),
+                           S_bit_vec_matcher(3, 1000));
+    Matcher *matcher = (Matcher*)ANDMatcher_new(kids, NULL);
+    DECREF(kids);
+    return matcher;
+}
+
+static Matcher*
+S_or_matcher() {
+    VArray  *kids = S_kids(S_bit_vec_matcher(5, 1000),
+                           S_bit_vec_matcher(7, 1000));
+    Matcher *matcher = (Matcher*)ORMatcher_new(kids);
+    DECREF(kids);
+    return matcher;
+}
+
+static Matcher*
+S_or_scorer() {
+    VArray  *kids = S_kids((Matcher*)MatchAllMatcher_new(1.0f, 150),
+                           (Matcher*)MatchAllMatcher_new(2.0f, 400));
+    Matcher *matcher = (Matcher*)ORScorer_new(kids, NULL);
+    DECREF(kids);
+    return matcher;
+}
+
+static void
+test_next_block(TestBatchRunner *runner) {
+    uint32_t sizes[2] = { 7, MATCHER_BLOCK_SIZE };
+    for (uint32_t i = 0; i < 2; i++) {
+        uint32_t size = sizes[i];
+        S_test_blocks(runner, (Matcher*)MatchAllMatcher_new(1.5f, 300),
+                      (Matcher*)MatchAllMatcher_new(1.5f, 300), true, size,
+                      "MatchAllMatcher");
+        S_test_blocks(runner, S_bit_vec_matcher(3, 1000),
+                      S_bit_vec_matcher(3, 1000), true, size,
+                      "BitVecMatcher");
+        S_test_blocks(runner, S_and_matcher(), S_and_matcher(), true, size,
+                      "ANDMatcher");
+        S_test_blocks(runner, S_or_matcher(), S_or_matcher(), false, size,
+                      "ORMatcher");
+        S_test_blocks(runner, S_or_scorer(), S_or_scorer(), true, size,
+                      "ORScorer");
+    }
+}
+
+static RAMFolder*
+S_create_index() {
+    Schema     *schema  = Schema_new();
+    StringType *type    = StringType_new();
+    CharBuf    *field   = CB_newf("cat");
+    RAMFolder  *folder  = RAMFolder_new(NULL);
+    Schema_Spec_Field(schema, field, (FieldType*)type);
+    Indexer    *indexer = Indexer_new(schema, (Obj*)folder, NULL, 0);
+    for (int32_t i = 0; i < 500; i++) {
+        Doc     *doc = Doc_new(NULL, 0);
+        CharBuf *cat = CB_newf("%s", i % 3 == 0 ? "a" : "b");
+        Doc_Store(doc, field, (Obj*)cat);
+        Indexer_Add_Doc(indexer, doc, 1.0f);
+        DECREF(cat);
+        DECREF(doc);
+    }
+    Indexer_Commit(indexer);
+    DECREF(indexer);
+    DECREF(field);
+    DECREF(type);
+    DECREF(schema);
+    return folder;
+}
+
+static void
+test_term_matcher(TestBatchRunner *runner) {
+    RAMFolder     *folder   = S_create_index();
+    IndexSearcher *searcher = IxSearcher_new((Obj*)folder);
+    PolyReader    *reader   = (PolyReader*)IxSearcher_Get_Reader(searcher);
+    SegReader     *seg_reader
+        = (SegReader*)VA_Fetch(PolyReader_Get_Seg_Readers(reader), 0);
+    CharBuf       *field    = CB_newf("cat");
+    CharBuf       *term     = CB_newf("b");
+    TermQuery     *query    = TermQuery_new(field, (Obj*)term);
+    Compiler      *compiler = TermQuery_Make_Compiler(query,
+                                                      (Searcher*)searcher,
+                                                      1.0f, false);
+
+    S_test_blocks(runner, Compiler_Make_Matcher(compiler, seg_reader, true),
+                  Compiler_Make_Matcher(compiler, seg_reader, true), true,
+                  7, "TermMatcher");
+    S_test_blocks(runner, Compiler_Make_Matcher(compiler, seg_reader, false),
+                  Compiler_Make_Matcher(compiler, seg_reader, false), false,
+                  MATCHER_BLOCK_SIZE, "TermMatcher without scores");
+
+    DECREF(compiler);
+    DECREF(query);
+    DECREF(term);
+    DECREF(field);
+    DECREF(searcher);
+    DECREF(folder);
+}
+
+static void
+test_collect(TestBatchRunner *runner) {
+    // Delete every third doc.
+    Matcher *matcher   = (Matcher*)MatchAllMatcher_new(2.5f, 1000);
+    Matcher *deletions = S_bit_vec_matcher(3, 1000);
+    BitVector    *bit_vec  = BitVec_new(1001);
+    BitCollector *bit_coll = BitColl_new(bit_vec);
+    Matcher_Collect(matcher, (Collector*)bit_coll, deletions);
+    bool all_live = true;
+    for (int32_t doc_id = 1; doc_id <= 1000; doc_id++) {
+        if (BitVec_Get(bit_vec, doc_id) != (doc_id % 3 != 0)) {
+            all_live = false;
+        }
+    }
+    TEST_INT_EQ(runner, BitVec_Count(bit_vec), 667,
+                "BitCollector collects every live doc");
+    TEST_TRUE(runner, all_live, "BitCollector skips deletions");
+    DECREF(bit_coll);
+    DECREF(bit_vec);
+    DECREF(deletions);
+    DECREF(matcher);
+
+    // A scoring Collector behind a wrapper sees the score for each doc.
+    matcher   = (Matcher*)MatchAllMatcher_new(2.5f, 1000);
+    deletions = S_bit_vec_matcher(3, 1000);
+    SortCollector   *sort_coll = SortColl_new(NULL, NULL, 300);
+    OffsetCollector *wrapper
+        = OffsetColl_new((Collector*)sort_coll, 1000);
+    Matcher_Collect(matcher, (Collector*)wrapper, deletions);
+    VArray *match_docs = SortColl_Pop_Match_Docs(sort_coll);
+    bool scores_ok = true;
+    bool doc_ids_ok = true;
+    for (uint32_t i = 0; i < VA_Get_Size(match_docs); i++) {
+        MatchDoc *match_doc = (MatchDoc*)VA_Fetch(match_docs, i);
+        int32_t   expected  = 1000 + (int32_t)(i / 2) * 3 + (int32_t)(i % 2) + 1;
+        if (MatchDoc_Get_Score(match_doc) != 2.5f) { scores_ok = false; }
+        if (MatchDoc_Get_Doc_ID(match_doc) != expected) { doc_ids_ok = false; }
+    }
+    TEST_INT_EQ(runner, SortColl_Get_Total_Hits(sort_coll), 667,
+                "wrapped SortCollector sees every live doc");
+    TEST_TRUE(runner, scores_ok, "wrapped SortCollector gets scores");
+    TEST_TRUE(runner, doc_ids_ok && VA_Get_Size(match_docs) == 300,
+              "wrapped SortCollector gets offset doc ids");
+    DECREF(match_docs);
+    DECREF(wrapper);
+    DECREF(sort_coll);
+    DECREF(deletions);
+    DECREF(matcher);
+
+    // Deleted docs never get scored.
+    ScoreCountingMatcher *counter = ScoreCounter_new(2.5f, 1000);
+    deletions = S_bit_vec_matcher(3, 1000);
+    sort_coll = SortColl_new(NULL, NULL, 10);
+    Matcher_Collect((Matcher*)counter, (Collector*)sort_coll, deletions);
+    TEST_INT_EQ(runner, ScoreCounter_Get_Num_Scored(counter), 667,
+                "only live docs are scored");
+    DECREF(sort_coll);
+    DECREF(deletions);
+    DECREF(counter);
+}
+
+void
+TestMatcherBlocks_run(TestMatcherBlocks *self, TestBatchRunner *runner) {
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 18);
+    test_next_block(runner);
+    test_term_matcher(runner);
+    test_collect(runner);
+}
+
+
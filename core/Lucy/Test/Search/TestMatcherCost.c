@@ -0,0 +1,162 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define C_TESTLUCY_TESTMATCHERCOST
+#define TESTLUCY_USE_SHORT_NAMES
+#include "Lucy/Util/ToolSet.h"
+
+#include "Clownfish/TestHarness/TestBatchRunner.h"
+#include "Lucy/Test.h"
+#include "Lucy/Test/Search/TestMatcherCost.h"
+#include "Lucy/Search/ANDMatcher.h"
+#include "Lucy/Search/BitVecMatcher.h"
+#include "Lucy/Search/MatchAllMatcher.h"
+#include "Lucy/Search/NoMatchMatcher.h"
+#include "Lucy/Search/ORMatcher.h"
+#include "LucyX/Search/MockMatcher.h"
+
+TestMatcherCost*
+TestMatcherCost_new() {
+    return (TestMatcherCost*)VTable_Make_Obj(TESTMATCHERCOST);
+}
+
+// Return a MockMatcher which matches every doc divisible by
+// <code>interval</code>, up to <code>doc_max</code>.
+static Matcher*
+S_mock_matcher(int32_t interval, int32_t doc_max) {
+    int32_t  count   = doc_max / interval;
+    int32_t *doc_ids = (int32_t*)MALLOCATE(count * sizeof(int32_t));
+    for (int32_t i = 0; i < count; i++) {
+        doc_ids[i] = (i + 1) * interval;
+    }
+    I32Array *array = I32Arr_new_steal(doc_ids, count);
+    Matcher *matcher = (Matcher*)MockMatcher_new(array, NULL);
+    DECREF(array);
+    return matcher;
+}
+
+static Matcher*
+S_bit_vec_matcher(int32_t interval, int32_t doc_max) {
+    BitVector *bit_vec = BitVec_new(doc_max + 1);
+    for (int32_t doc_id = interval; doc_id <= doc_max; doc_id += interval) {
+        BitVec_Set(bit_vec, doc_id);
+    }
+    Matcher *matcher = (Matcher*)BitVecMatcher_new(bit_vec);
+    DECREF(bit_vec);
+    return matcher;
+}
+
+static VArray*
+S_kids(Matcher *a, Matcher *b, Matcher *c) {
+    VArray *kids = VA_new(3);
+    VA_Push(kids, (Obj*)a);
+    VA_Push(kids, (Obj*)b);
+    if (c) { VA_Push(kids, (Obj*)c); }
+    return kids;
+}
+
+static void
+test_cost(TestBatchRunner *runner) {
+    Matcher *matcher = S_mock_matcher(4, 1000);
+    TEST_INT_EQ(runner, Matcher_Cost(matcher), 250, "MockMatcher");
+    DECREF(matcher);
+
+    matcher = S_bit_vec_matcher(3, 1000);
+    TEST_INT_EQ(runner, Matcher_Cost(matcher), 333, "BitVecMatcher");
+    DECREF(matcher);
+
+    matcher = (Matcher*)MatchAllMatcher_new(1.0f, 1000);
+    TEST_INT_EQ(runner, Matcher_Cost(matcher), 1000, "MatchAllMatcher");
+    DECREF(matcher);
+
+    matcher = (Matcher*)NoMatchMatcher_new();
+    TEST_INT_EQ(runner, Matcher_Cost(matcher), 0, "NoMatchMatcher");
+    DECREF(matcher);
+
+    VArray *kids = S_kids(S_mock_matcher(2, 1000), S_mock_matcher(50, 1000),
+                          S_mock_matcher(7, 1000));
+    matcher = (Matcher*)ANDMatcher_new(kids, NULL);
+    TEST_INT_EQ(runner, Matcher_Cost(matcher), 20,
+                "ANDMatcher costs as much as its rarest child");
+    DECREF(matcher);
+    matcher = (Matcher*)ORMatcher_new(kids);
+    TEST_INT_EQ(runner, Matcher_Cost(matcher), 500 + 20 + 142,
+                "ORMatcher costs as much as all its children together");
+    DECREF(matcher);
+    DECREF(kids);
+}
+
+static void
+S_test_intersection(TestBatchRunner *runner, int32_t a, int32_t b,
+                    int32_t c) {
+    // The common child comes first, so a rarer one must take the lead.
+    VArray  *kids = S_kids(S_mock_matcher(a, 2000), S_bit_vec_matcher(b, 2000),
+                           S_mock_matcher(c, 2000));
+    Matcher *and_matcher = (Matcher*)ANDMatcher_new(kids, NULL);
+    int32_t  lcm = a * b * c; // intervals are pairwise coprime
+    int32_t  expected = lcm;
+    bool     ok = true;
+    int32_t  count = 0;
+
+    for (int32_t doc_id = Matcher_Next(and_matcher);
+         doc_id != 0;
+         doc_id = Matcher_Next(and_matcher)
+        ) {
+        if (doc_id != expected) { ok = false; break; }
+        expected += lcm;
+        count++;
+    }
+    TEST_TRUE(runner, ok && count == 2000 / lcm,
+              "intersect %i32, %i32 and %i32", a, b, c);
+
+    DECREF(and_matcher);
+    DECREF(kids);
+}
+
+static void
+test_intersection(TestBatchRunner *runner) {
+    S_test_intersection(runner, 1, 3, 7);
+    S_test_intersection(runner, 2, 5, 97);
+    S_test_intersection(runner, 97, 5, 2);
+    S_test_intersection(runner, 3, 1, 1);
+}
+
+static void
+test_bit_vec_advance(TestBatchRunner *runner) {
+    Matcher *matcher = S_bit_vec_matcher(3, 1000);
+    int32_t  targets[] = { 1, 4, 7, 10, 14, 100, 104, 190, 193, 600, 900 };
+    size_t   num_targets = sizeof(targets) / sizeof(targets[0]);
+    bool     ok = true;
+    for (size_t i = 0; i < num_targets; i++) {
+        const int32_t target   = targets[i];
+        const int32_t expected = ((target + 2) / 3) * 3;
+        if (Matcher_Advance(matcher, target) != expected) { ok = false; }
+    }
+    TEST_TRUE(runner, ok, "BitVecMatcher advances within its buffer");
+    TEST_INT_EQ(runner, Matcher_Advance(matcher, 1000), 0,
+                "BitVecMatcher advances past end");
+    DECREF(matcher);
+}
+
+void
+TestMatcherCost_run(TestMatcherCost *self, TestBatchRunner *runner) {
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 12);
+    test_cost(runner);
+    test_intersection(runner);
+    test_bit_vec_advance(runner);
+}
+
+
@@ -0,0 +1,293 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define C_TESTLUCY_TESTQUERYREWRITE
+#define TESTLUCY_USE_SHORT_NAMES
+#include "Lucy/Util/ToolSet.h"
+
+#include "Clownfish/TestHarness/TestBatchRunner.h"
+#include "Lucy/Test.h"
+#include "Lucy/Test/Search/TestQueryRewrite.h"
+#include "Lucy/Test/TestUtils.h"
+#include "Lucy/Document/Doc.h"
+#include "Lucy/Index/Indexer.h"
+#include "Lucy/Plan/Schema.h"
+#include "Lucy/Plan/StringType.h"
+#include "Lucy/Search/ANDQuery.h"
+#include "Lucy/Search/CachingFilter.h"
+#include "Lucy/Search/FilterCache.h"
+#include "Lucy/Search/Hits.h"
+#include "Lucy/Search/IndexSearcher.h"
+#include "Lucy/Search/MatchAllQuery.h"
+#include "Lucy/Search/NoMatchQuery.h"
+#include "Lucy/Search/NOTQuery.h"
+#include "Lucy/Search/ORQuery.h"
+#include "Lucy/Search/RequiredOptionalQuery.h"
+#include "Lucy/Search/TermQuery.h"
+#include "Lucy/Store/RAMFolder.h"
+
+TestQueryRewrite*
+TestQueryRewrite_new() {
+    return (TestQueryRewrite*)VTable_Make_Obj(TESTQUERYREWRITE);
+}
+
+// Index 30 docs, every third of which is in category "a" and the rest in
+// category "b".
+static IndexSearcher*
+S_create_searcher() {
+    Schema     *schema  = Schema_new();
+    StringType *type    = StringType_new();
+    RAMFolder  *folder  = RAMFolder_new(NULL);
+    CharBuf    *field   = CB_newf("cat");
+    Schema_Spec_Field(schema, field, (FieldType*)type);
+
+    Indexer *indexer = Indexer_new(schema, (Obj*)folder, NULL, 0);
+    for (int32_t i = 0; i < 30; i++) {
+        Doc     *doc = Doc_new(NULL, 0);
+        CharBuf *cat = CB_newf("%s", i % 3 == 0 ? "a" : "b");
+        Doc_Store(doc, field, (Obj*)cat);
+        Indexer_Add_Doc(indexer, doc, 1.0f);
+        DECREF(cat);
+        DECREF(doc);
+    }
+    Indexer_Commit(indexer);
+
+    IndexSearcher *searcher = IxSearcher_new((Obj*)folder);
+    DECREF(indexer);
+    DECREF(field);
+    DECREF(folder);
+    DECREF(type);
+    DECREF(schema);
+    return searcher;
+}
+
+static Query*
+S_term(const char *term) {
+    return (Query*)TestUtils_make_term_query("cat", term);
+}
+
+static Query*
+S_poly(uint32_t boolop, Query *a, Query *b, Query *c) {
+    return (Query*)TestUtils_make_poly_query(boolop, a, b, c, NULL);
+}
+
+static void
+test_flatten_and_dedupe(TestBatchRunner *runner, Searcher *searcher) {
+    Query *nested   = S_poly(BOOLOP_AND, S_term("a"),
+                             S_poly(BOOLOP_AND, S_term("b"), S_term("c"),
+                                    NULL),
+                             NULL);
+    Query *flat     = S_poly(BOOLOP_AND, S_term("a"), S_term("b"),
+                             S_term("c"));
+    Query *got      = Query_Rewrite(nested, searcher);
+    TEST_TRUE(runner, Query_Equals(got, (Obj*)flat),
+              "nested ANDQuery flattened");
+    DECREF(got);
+    DECREF(nested);
+
+    Query *inner = S_poly(BOOLOP_AND, S_term("b"), S_term("c"), NULL);
+    Query_Set_Boost(inner, 2.0f);
+    nested = S_poly(BOOLOP_AND, S_term("a"), inner, NULL);
+    got = Query_Rewrite(nested, searcher);
+    TEST_TRUE(runner, got == nested, "boosted child not flattened");
+    DECREF(got);
+    DECREF(nested);
+
+    Query *mixed = S_poly(BOOLOP_OR, S_term("a"),
+                          S_poly(BOOLOP_AND, S_term("b"), S_term("c"),
+                                 NULL),
+                          NULL);
+    got = Query_Rewrite(mixed, searcher);
+    TEST_TRUE(runner, got == mixed, "child of a different type kept");
+    DECREF(got);
+    DECREF(mixed);
+
+    nested = S_poly(BOOLOP_OR, S_term("a"),
+                    S_poly(BOOLOP_OR, S_term("b"), S_term("c"), NULL),
+                    NULL);
+    got = Query_Rewrite(nested, searcher);
+    TEST_TRUE(runner, got == nested,
+              "nested ORQuery left alone to preserve scores");
+    DECREF(got);
+    DECREF(nested);
+
+    Query *dupes    = S_poly(BOOLOP_OR, S_term("a"), S_term("b"),
+                             S_term("a"));
+    Query *expected = S_poly(BOOLOP_OR, S_term("a"), S_term("b"), NULL);
+    got = Query_Rewrite(dupes, searcher);
+    TEST_TRUE(runner, Query_Equals(got, (Obj*)expected),
+              "duplicate clause removed");
+    DECREF(got);
+    DECREF(expected);
+    DECREF(dupes);
+
+    dupes = S_poly(BOOLOP_AND, S_term("a"), S_term("a"), NULL);
+    Query *a_term = S_term("a");
+    got = Query_Rewrite(dupes, searcher);
+    TEST_TRUE(runner, Query_Equals(got, (Obj*)a_term),
+              "single remaining clause unwrapped");
+    DECREF(got);
+    DECREF(dupes);
+
+    Query *single = S_poly(BOOLOP_OR, S_term("a"), NULL, NULL);
+    Query_Set_Boost(single, 3.0f);
+    got = Query_Rewrite(single, searcher);
+    TEST_TRUE(runner, got == single,
+              "boosted single clause query not unwrapped");
+    DECREF(got);
+    DECREF(single);
+
+    DECREF(a_term);
+    DECREF(flat);
+}
+
+static void
+test_fold_constants(TestBatchRunner *runner, Searcher *searcher) {
+    Query *a_term = S_term("a");
+    Query *query;
+    Query *got;
+
+    query = S_poly(BOOLOP_AND, S_term("a"), (Query*)NoMatchQuery_new(),
+                   NULL);
+    got = Query_Rewrite(query, searcher);
+    TEST_TRUE(runner, Query_Is_A(got, NOMATCHQUERY),
+              "ANDQuery with a NoMatchQuery clause folded");
+    DECREF(got);
+    DECREF(query);
+
+    query = S_poly(BOOLOP_OR, S_term("a"), (Query*)NoMatchQuery_new(),
+                   NULL);
+    got = Query_Rewrite(query, searcher);
+    TEST_TRUE(runner, Query_Equals(got, (Obj*)a_term),
+              "NoMatchQuery clause dropped from ORQuery");
+    DECREF(got);
+    DECREF(query);
+
+    query = S_poly(BOOLOP_OR, (Query*)NoMatchQuery_new(),
+                   (Query*)NoMatchQuery_new(), NULL);
+    got = Query_Rewrite(query, searcher);
+    TEST_TRUE(runner, Query_Is_A(got, NOMATCHQUERY),
+              "ORQuery of NoMatchQuery clauses folded");
+    DECREF(got);
+    DECREF(query);
+
+    query = (Query*)TestUtils_make_not_query((Query*)MatchAllQuery_new());
+    got = Query_Rewrite(query, searcher);
+    TEST_TRUE(runner, Query_Is_A(got, NOMATCHQUERY),
+              "NOTQuery of MatchAllQuery folded");
+    DECREF(got);
+    DECREF(query);
+
+    query = (Query*)TestUtils_make_not_query((Query*)NoMatchQuery_new());
+    got = Query_Rewrite(query, searcher);
+    TEST_TRUE(runner, Query_Is_A(got, MATCHALLQUERY),
+              "NOTQuery of NoMatchQuery folded");
+    DECREF(got);
+    DECREF(query);
+
+    Query *no_match = (Query*)NoMatchQuery_new();
+    query = (Query*)ReqOptQuery_new(no_match, a_term);
+    got = Query_Rewrite(query, searcher);
+    TEST_TRUE(runner, Query_Is_A(got, NOMATCHQUERY),
+              "ReqOptQuery with a NoMatchQuery required clause folded");
+    DECREF(got);
+    DECREF(query);
+
+    query = (Query*)ReqOptQuery_new(a_term, no_match);
+    got = Query_Rewrite(query, searcher);
+    TEST_TRUE(runner, Query_Equals(got, (Obj*)a_term),
+              "ReqOptQuery with a NoMatchQuery optional clause folded");
+    DECREF(got);
+    DECREF(query);
+
+    query = S_poly(BOOLOP_OR, S_term("a"), S_term("b"), NULL);
+    got = Query_Rewrite(query, searcher);
+    TEST_TRUE(runner, got == query, "nothing to rewrite");
+    DECREF(got);
+    DECREF(query);
+
+    DECREF(no_match);
+    DECREF(a_term);
+}
+
+static uint32_t
+S_total_hits(Searcher *searcher, Query *query) {
+    Hits *hits = Searcher_Hits(searcher, (Obj*)query, 0, 10, NULL);
+    uint32_t total = Hits_Total_Hits(hits);
+    DECREF(hits);
+    return total;
+}
+
+static void
+test_filter_cache(TestBatchRunner *runner, Searcher *searcher) {
+    FilterCache *cache = FilterCache_new(1024 * 1024);
+    Query *query = (Query*)TestUtils_make_not_query(S_term("a"));
+    Query *got   = Query_Rewrite(query, searcher);
+    TEST_TRUE(runner, got == query, "no filter cache, no CachingFilter");
+    DECREF(got);
+
+    Searcher_Set_Filter_Cache(searcher, cache);
+    got = Query_Rewrite(query, searcher);
+    Query *negated = NOTQuery_Get_Negated_Query((NOTQuery*)got);
+    TEST_TRUE(runner, Query_Is_A(negated, CACHINGFILTER),
+              "negated clause wrapped in a CachingFilter");
+    DECREF(got);
+
+    TEST_INT_EQ(runner, S_total_hits(searcher, query), 20,
+                "NOTQuery results with filter cache");
+    TEST_INT_EQ(runner, FilterCache_Get_Size(cache), 1,
+                "negated clause cached");
+
+    Searcher_Set_Filter_Cache(searcher, NULL);
+    TEST_TRUE(runner, Searcher_Get_Filter_Cache(searcher) == NULL,
+              "filter cache cleared");
+
+    DECREF(query);
+    DECREF(cache);
+}
+
+static void
+test_search_results(TestBatchRunner *runner, Searcher *searcher) {
+    Query *query = S_poly(BOOLOP_AND, S_term("b"),
+                          S_poly(BOOLOP_AND, S_term("b"),
+                                 S_poly(BOOLOP_OR, S_term("b"),
+                                        (Query*)NoMatchQuery_new(), NULL),
+                                 NULL),
+                          NULL);
+    TEST_INT_EQ(runner, S_total_hits(searcher, query), 20,
+                "rewritten query matches the same docs");
+    DECREF(query);
+
+    query = S_poly(BOOLOP_OR, S_term("a"),
+                   S_poly(BOOLOP_OR, S_term("b"), S_term("a"), NULL),
+                   NULL);
+    TEST_INT_EQ(runner, S_total_hits(searcher, query), 30,
+                "deduped ORQuery matches the same docs");
+    DECREF(query);
+}
+
+void
+TestQueryRewrite_run(TestQueryRewrite *self, TestBatchRunner *runner) {
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 22);
+    Searcher *searcher = (Searcher*)S_create_searcher();
+    test_flatten_and_dedupe(runner, searcher);
+    test_fold_constants(runner, searcher);
+    test_filter_cache(runner, searcher);
+    test_search_results(runner, searcher);
+    DECREF(searcher);
+}
+
+
@@ -23,7 +23,30 @@
 #include "Lucy/Test.h"
 #include "Lucy/Test/TestUtils.h"
 #include "Lucy/Test/Search/TestRangeQuery.h"
+#include "Lucy/Document/Doc.h"
+#include "Lucy/Index/IndexReader.h"
+#include "Lucy/Index/Indexer.h"
+#include "Lucy/Index/PointIndex.h"
+#include "Lucy/Index/PolyReader.h"
+#include "Lucy/Index/SegReader.h"
+#include "Lucy/Index/SortCache.h"
+#include "Lucy/Index/SortReader.h"
+#include "Lucy/Plan/NumericType.h"
+#include "Lucy/Plan/Schema.h"
+#include "Lucy/Plan/StringType.h"
+#include "Lucy/Search/Compiler.h"
+#include "Lucy/Search/Hits.h"
+#include "Lucy/Search/IndexSearcher.h"
+#include "Lucy/Search/PointRangeMatcher.h"
+#include "Lucy/Search/RangeMatcher.h"
 #include "Lucy/Search/RangeQuery.h"
+#include "Lucy/Store/RAMFolder.h"
+
+#define NUM_DOCS 2000
+
+// Fields whose cardinalities call for ord widths of 1, 2, 4 and 8 bits.
+static const int32_t moduli[] = { 1, 3, 14, 200 };
+#define NUM_MODULI 4
 
 TestRangeQuery*
 TestRangeQuery_new() {
@@ -65,11 +88,390 @@ test_Dump_Load_and_Equals(TestBatchRunner *runner) {
     DECREF(clone);
 }
 
+// Every tenth doc has no value for "num".
+static int32_t
+S_num_for_doc(int32_t i) {
+    return i % 10 == 9 ? -1 : (i * 37) % 500;
+}
+
+static RAMFolder*
+S_create_index() {
+    Schema     *schema   = Schema_new();
+    StringType *str_type = StringType_new();
+    Int32Type  *i32_type = Int32Type_new();
+    CharBuf    *id_field  = CB_newf("id");
+    CharBuf    *num_field = CB_newf("num");
+    Int32Type_Set_Indexed(i32_type, false);
+    Int32Type_Set_Sortable(i32_type, true);
+    Schema_Spec_Field(schema, id_field, (FieldType*)str_type);
+    Schema_Spec_Field(schema, num_field, (FieldType*)i32_type);
+    CharBuf     *f64_field = CB_newf("f64");
+    Float64Type *f64_type  = Float64Type_new();
+    Float64Type_Set_Indexed(f64_type, false);
+    Float64Type_Set_Sortable(f64_type, true);
+    Schema_Spec_Field(schema, f64_field, (FieldType*)f64_type);
+    StringType_Set_Sortable(str_type, true);
+    for (int32_t j = 0; j < NUM_MODULI; j++) {
+        CharBuf *mod_field = CB_newf("mod%i32", moduli[j]);
+        Schema_Spec_Field(schema, mod_field, (FieldType*)i32_type);
+        DECREF(mod_field);
+    }
+
+    RAMFolder *folder  = RAMFolder_new(NULL);
+    Indexer   *indexer = Indexer_new(schema, (Obj*)folder, NULL, 0);
+    for (int32_t i = 0; i < NUM_DOCS; i++) {
+        Doc     *doc = Doc_new(NULL, 0);
+        CharBuf *id  = CB_newf("%i32", i);
+        Doc_Store(doc, id_field, (Obj*)id);
+        int32_t num = S_num_for_doc(i);
+        if (num >= 0) {
+            Integer32 *value = Int32_new(num);
+            Doc_Store(doc, num_field, (Obj*)value);
+            DECREF(value);
+            Float64 *f64_value = Float64_new(i / 3.0);
+            Doc_Store(doc, f64_field, (Obj*)f64_value);
+            DECREF(f64_value);
+            for (int32_t j = 0; j < NUM_MODULI; j++) {
+                CharBuf   *mod_field = CB_newf("mod%i32", moduli[j]);
+                Integer32 *mod_value = Int32_new(i % moduli[j]);
+                Doc_Store(doc, mod_field, (Obj*)mod_value);
+                DECREF(mod_value);
+                DECREF(mod_field);
+            }
+        }
+        Indexer_Add_Doc(indexer, doc, 1.0f);
+        DECREF(id);
+        DECREF(doc);
+    }
+    Indexer_Commit(indexer);
+
+    DECREF(indexer);
+    DECREF(f64_field);
+    DECREF(f64_type);
+    DECREF(num_field);
+    DECREF(id_field);
+    DECREF(i32_type);
+    DECREF(str_type);
+    DECREF(schema);
+    return folder;
+}
+
+static void
+S_check_hits(TestBatchRunner *runner, IndexSearcher *searcher, int32_t lower,
+             int32_t upper, bool include_lower, bool include_upper) {
+    uint32_t expected = 0;
+    for (int32_t i = 0; i < NUM_DOCS; i++) {
+        int32_t num = S_num_for_doc(i);
+        if (num < 0) { continue; }
+        if (num < lower || (num == lower && !include_lower)) { continue; }
+        if (num > upper || (num == upper && !include_upper)) { continue; }
+        expected++;
+    }
+
+    CharBuf    *field = CB_newf("num");
+    Integer32  *lower_term = Int32_new(lower);
+    Integer32  *upper_term = Int32_new(upper);
+    RangeQuery *query = RangeQuery_new(field, (Obj*)lower_term,
+                                       (Obj*)upper_term, include_lower,
+                                       include_upper);
+    Hits *hits = IxSearcher_Hits(searcher, (Obj*)query, 0, 10, NULL);
+    TEST_INT_EQ(runner, Hits_Total_Hits(hits), expected,
+                "num:%s%d TO %d%s", include_lower ? "[" : "{", lower,
+                upper, include_upper ? "]" : "}");
+    DECREF(hits);
+    DECREF(query);
+    DECREF(upper_term);
+    DECREF(lower_term);
+    DECREF(field);
+}
+
+static void
+test_hits(TestBatchRunner *runner) {
+    RAMFolder     *folder   = S_create_index();
+    IndexSearcher *searcher = IxSearcher_new((Obj*)folder);
+    S_check_hits(runner, searcher, 10, 12, true, true);
+    S_check_hits(runner, searcher, 10, 12, false, false);
+    S_check_hits(runner, searcher, 0, 400, true, true);
+    S_check_hits(runner, searcher, 499, 499, true, true);
+    S_check_hits(runner, searcher, 600, 700, true, true);
+    DECREF(searcher);
+    DECREF(folder);
+}
+
+static void
+test_PointRangeMatcher(TestBatchRunner *runner) {
+    RAMFolder  *folder = S_create_index();
+    PolyReader *reader = PolyReader_open((Obj*)folder, NULL, NULL);
+    SegReader  *seg_reader
+        = (SegReader*)VA_Fetch(PolyReader_Get_Seg_Readers(reader), 0);
+    SortReader *sort_reader = (SortReader*)SegReader_Fetch(
+                                  seg_reader, VTable_Get_Name(SORTREADER));
+    CharBuf    *field       = CB_newf("num");
+    SortCache  *sort_cache  = SortReader_Fetch_Sort_Cache(sort_reader, field);
+    PointIndex *point_index = SortReader_Fetch_Point_Index(sort_reader,
+                                                           field);
+    int32_t     doc_max     = SegReader_Doc_Max(seg_reader);
+    TEST_TRUE(runner, point_index != NULL, "numeric field has a point index");
+
+    // Compare against a scan over the same range of ords, which includes
+    // the NULL ord.
+    int32_t lower = 30;
+    int32_t upper = SortCache_Get_Cardinality(sort_cache) - 1;
+    PointRangeMatcher *point_matcher
+        = PointRangeMatcher_new(lower, upper, point_index);
+    RangeMatcher *scan_matcher
+        = RangeMatcher_new(lower, upper, sort_cache, doc_max);
+    int32_t num_docs = 0;
+    bool    equal    = true;
+    int32_t doc_id;
+    while (0 != (doc_id = PointRangeMatcher_Next(point_matcher))) {
+        if (RangeMatcher_Next(scan_matcher) != doc_id) { equal = false; }
+        num_docs++;
+    }
+    if (RangeMatcher_Next(scan_matcher) != 0) { equal = false; }
+    TEST_TRUE(runner, equal && num_docs > 0, "Next() matches a scan");
+    TEST_INT_EQ(runner, num_docs,
+                PointIndex_Doc_Freq(point_index, lower, upper), "Doc_Freq");
+    DECREF(point_matcher);
+    DECREF(scan_matcher);
+
+    point_matcher = PointRangeMatcher_new(lower, upper, point_index);
+    scan_matcher  = RangeMatcher_new(lower, upper, sort_cache, doc_max);
+    equal = true;
+    for (int32_t target = 1; target; ) {
+        doc_id = PointRangeMatcher_Advance(point_matcher, target);
+        if (RangeMatcher_Advance(scan_matcher, target) != doc_id) {
+            equal = false;
+        }
+        target = doc_id ? doc_id + 13 : 0;
+    }
+    TEST_TRUE(runner, equal, "Advance() matches a scan");
+    DECREF(point_matcher);
+    DECREF(scan_matcher);
+
+    DECREF(field);
+    DECREF(reader);
+    DECREF(folder);
+}
+
+// Compare a RangeMatcher against calls to SortCache_Ordinal() for a single
+// range, using both Next() and Advance().
+static bool
+S_range_matcher_agrees(SortCache *sort_cache, int32_t doc_max, int32_t lower,
+                       int32_t upper) {
+    bool equal = true;
+    RangeMatcher *matcher
+        = RangeMatcher_new(lower, upper, sort_cache, doc_max);
+    int32_t doc_id = 0;
+    for (int32_t i = 1; i <= doc_max; i++) {
+        int32_t ord = SortCache_Ordinal(sort_cache, i);
+        if (ord >= lower && ord <= upper) {
+            if ((doc_id = RangeMatcher_Next(matcher)) != i) { equal = false; }
+        }
+    }
+    if (RangeMatcher_Next(matcher) != 0) { equal = false; }
+    DECREF(matcher);
+
+    matcher = RangeMatcher_new(lower, upper, sort_cache, doc_max);
+    for (int32_t target = 1; target; ) {
+        int32_t expected = 0;
+        for (int32_t i = target; i <= doc_max; i++) {
+            int32_t ord = SortCache_Ordinal(sort_cache, i);
+            if (ord >= lower && ord <= upper) {
+                expected = i;
+                break;
+            }
+        }
+        doc_id = RangeMatcher_Advance(matcher, target);
+        if (doc_id != expected) { equal = false; }
+        target = doc_id ? doc_id + 7 : 0;
+    }
+    DECREF(matcher);
+
+    return equal;
+}
+
+static void
+test_RangeMatcher(TestBatchRunner *runner) {
+    RAMFolder  *folder = S_create_index();
+    PolyReader *reader = PolyReader_open((Obj*)folder, NULL, NULL);
+    SegReader  *seg_reader
+        = (SegReader*)VA_Fetch(PolyReader_Get_Seg_Readers(reader), 0);
+    SortReader *sort_reader = (SortReader*)SegReader_Fetch(
+                                  seg_reader, VTable_Get_Name(SORTREADER));
+    int32_t     doc_max     = SegReader_Doc_Max(seg_reader);
+
+    for (int32_t j = 0; j <= NUM_MODULI; j++) {
+        CharBuf *field = j < NUM_MODULI
+                         ? CB_newf("mod%i32", moduli[j])
+                         : CB_newf("num");
+        SortCache *sort_cache
+            = SortReader_Fetch_Sort_Cache(sort_reader, field);
+        int32_t card = SortCache_Get_Cardinality(sort_cache);
+        bool    ok   = true;
+        ok = ok && S_range_matcher_agrees(sort_cache, doc_max, 0, 0);
+        ok = ok && S_range_matcher_agrees(sort_cache, doc_max, 1, 1);
+        ok = ok && S_range_matcher_agrees(sort_cache, doc_max, 0, card - 1);
+        ok = ok && S_range_matcher_agrees(sort_cache, doc_max, 1, INT32_MAX);
+        ok = ok && S_range_matcher_agrees(sort_cache, doc_max, card / 2,
+                                          card / 2 + 1);
+        ok = ok && S_range_matcher_agrees(sort_cache, doc_max, 2, 1);
+        TEST_TRUE(runner, ok, "RangeMatcher agrees with scan for %d-bit ords",
+                  SortCache_Get_Ord_Width(sort_cache));
+        DECREF(field);
+    }
+
+    DECREF(reader);
+    DECREF(folder);
+}
+
+static void
+test_stats(TestBatchRunner *runner) {
+    RAMFolder  *folder = S_create_index();
+    PolyReader *reader = PolyReader_open((Obj*)folder, NULL, NULL);
+    SegReader  *seg_reader
+        = (SegReader*)VA_Fetch(PolyReader_Get_Seg_Readers(reader), 0);
+    SortReader *sort_reader = (SortReader*)SegReader_Fetch(
+                                  seg_reader, VTable_Get_Name(SORTREADER));
+
+    int32_t min = INT32_MAX, max = -1, doc_count = 0, value_count = 0;
+    bool seen[500] = { false };
+    for (int32_t i = 0; i < NUM_DOCS; i++) {
+        int32_t num = S_num_for_doc(i);
+        if (num < 0) { continue; }
+        if (num < min) { min = num; }
+        if (num > max) { max = num; }
+        if (!seen[num]) { seen[num] = true; value_count++; }
+        doc_count++;
+    }
+
+    CharBuf *field = CB_newf("num");
+    Hash    *stats = SortReader_Fetch_Stats(sort_reader, field);
+    TEST_TRUE(runner, stats
+              && Obj_To_I64(Hash_Fetch_Str(stats, "min", 3)) == min
+              && Obj_To_I64(Hash_Fetch_Str(stats, "max", 3)) == max,
+              "min and max");
+    TEST_TRUE(runner, stats
+              && Obj_To_I64(Hash_Fetch_Str(stats, "value_count", 11))
+                 == value_count
+              && Obj_To_I64(Hash_Fetch_Str(stats, "doc_count", 9))
+                 == doc_count,
+              "value_count and doc_count");
+
+    CB_setf(field, "f64");
+    stats = SortReader_Fetch_Stats(sort_reader, field);
+    TEST_TRUE(runner, stats
+              && Obj_Is_A(Hash_Fetch_Str(stats, "max", 3), FLOAT64)
+              && Obj_To_F64(Hash_Fetch_Str(stats, "max", 3)) == 1998 / 3.0,
+              "float max survives round trip without loss");
+
+    CB_setf(field, "id");
+    stats = SortReader_Fetch_Stats(sort_reader, field);
+    CharBuf *expected_min = CB_newf("0");
+    CharBuf *expected_max = CB_newf("999");
+    TEST_TRUE(runner, stats
+              && CB_Equals(expected_min, Hash_Fetch_Str(stats, "min", 3))
+              && CB_Equals(expected_max, Hash_Fetch_Str(stats, "max", 3)),
+              "text min and max");
+    DECREF(expected_min);
+    DECREF(expected_max);
+
+    DECREF(field);
+    DECREF(reader);
+    DECREF(folder);
+}
+
+// Index two segments whose "num" values cover disjoint windows, with a
+// trailing doc lacking a value in each.
+static RAMFolder*
+S_create_windowed_index() {
+    Schema    *schema   = Schema_new();
+    Int32Type *i32_type = Int32Type_new();
+    CharBuf   *field    = CB_newf("num");
+    Int32Type_Set_Indexed(i32_type, false);
+    Int32Type_Set_Sortable(i32_type, true);
+    Schema_Spec_Field(schema, field, (FieldType*)i32_type);
+
+    RAMFolder *folder = RAMFolder_new(NULL);
+    for (int32_t window = 0; window < 2; window++) {
+        Indexer *indexer = Indexer_new(schema, (Obj*)folder, NULL, 0);
+        for (int32_t i = 0; i <= 100; i++) {
+            Doc *doc = Doc_new(NULL, 0);
+            if (i < 100) {
+                Integer32 *value = Int32_new(window * 100 + i);
+                Doc_Store(doc, field, (Obj*)value);
+                DECREF(value);
+            }
+            Indexer_Add_Doc(indexer, doc, 1.0f);
+            DECREF(doc);
+        }
+        Indexer_Commit(indexer);
+        DECREF(indexer);
+    }
+
+    DECREF(field);
+    DECREF(i32_type);
+    DECREF(schema);
+    return folder;
+}
+
+static bool
+S_makes_matcher(IndexSearcher *searcher, SegReader *seg_reader,
+                Obj *lower, Obj *upper) {
+    CharBuf    *field = CB_newf("num");
+    RangeQuery *query = RangeQuery_new(field, lower, upper, true, true);
+    Compiler   *compiler = (Compiler*)RangeQuery_Make_Compiler(
+                               query, (Searcher*)searcher, 1.0f, false);
+    Matcher    *matcher = Compiler_Make_Matcher(compiler, seg_reader, false);
+    bool        retval  = matcher != NULL;
+    DECREF(matcher);
+    DECREF(compiler);
+    DECREF(query);
+    DECREF(field);
+    return retval;
+}
+
+static void
+test_segment_pruning(TestBatchRunner *runner) {
+    RAMFolder     *folder   = S_create_windowed_index();
+    IndexSearcher *searcher = IxSearcher_new((Obj*)folder);
+    VArray        *seg_readers
+        = IxReader_Seg_Readers(IxSearcher_Get_Reader(searcher));
+    SegReader *first  = (SegReader*)VA_Fetch(seg_readers, 0);
+    SegReader *second = (SegReader*)VA_Fetch(seg_readers, 1);
+    Integer32 *low    = Int32_new(150);
+    Integer32 *high   = Int32_new(160);
+    Integer32 *huge   = Int32_new(500);
+
+    TEST_FALSE(runner, S_makes_matcher(searcher, first, (Obj*)low,
+                                       (Obj*)high),
+               "segment below the range is skipped");
+    TEST_TRUE(runner, S_makes_matcher(searcher, second, (Obj*)low,
+                                      (Obj*)high),
+              "segment overlapping the range is searched");
+    TEST_FALSE(runner, S_makes_matcher(searcher, second, (Obj*)huge,
+                                       (Obj*)huge),
+               "segment above the range is skipped");
+    TEST_TRUE(runner, S_makes_matcher(searcher, second, (Obj*)huge, NULL),
+              "open upper bound still reaches docs without a value");
+
+    DECREF(huge);
+    DECREF(high);
+    DECREF(low);
+    DECREF(seg_readers);
+    DECREF(searcher);
+    DECREF(folder);
+}
 
 void
 TestRangeQuery_run(TestRangeQuery *self, TestBatchRunner *runner) {
-    TestBatchRunner_Plan(runner, (TestBatch*)self, 5);
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 27);
     test_Dump_Load_and_Equals(runner);
+    test_hits(runner);
+    test_PointRangeMatcher(runner);
+    test_RangeMatcher(runner);
+    test_stats(runner);
+    test_segment_pruning(runner);
 }
 
 
@@ -36,9 +36,13 @@
 #include "Lucy/Plan/NumericType.h"
 #include "Lucy/Plan/Schema.h"
 #include "Lucy/Plan/StringType.h"
+#include "Lucy/Search/Collector/SortCollector.h"
 #include "Lucy/Search/Hits.h"
 #include "Lucy/Search/IndexSearcher.h"
+#include "Lucy/Search/MatchAllQuery.h"
+#include "Lucy/Search/MatchDoc.h"
 #include "Lucy/Search/SortRule.h"
+#include "Lucy/Search/TopDocs.h"
 #include "Lucy/Store/RAMFolder.h"
 
 static CharBuf *air_cb;
@@ -626,11 +630,187 @@ test_sort_spec(TestBatchRunner *runner) {
     DECREF(folder);
 }
 
+static SortSpec*
+S_num_sort_spec(bool reverse) {
+    VArray *rules = VA_new(1);
+    VA_Push(rules, (Obj*)SortRule_new(SortRule_FIELD, num_cb, reverse));
+    SortSpec *sort_spec = SortSpec_new(rules);
+    DECREF(rules);
+    return sort_spec;
+}
+
+static SortCollector*
+S_collect(IndexSearcher *searcher, SortSpec *sort_spec, uint32_t threshold) {
+    Schema        *schema    = IxSearcher_Get_Schema(searcher);
+    MatchAllQuery *query     = MatchAllQuery_new();
+    SortCollector *collector = SortColl_new(schema, sort_spec, 10);
+    SortColl_Set_Total_Hits_Threshold(collector, threshold);
+    IxSearcher_Collect(searcher, (Query*)query, (Collector*)collector);
+    DECREF(query);
+    return collector;
+}
+
+static bool
+S_same_doc_ids(VArray *a, VArray *b) {
+    if (VA_Get_Size(a) != VA_Get_Size(b)) { return false; }
+    for (uint32_t i = 0, max = VA_Get_Size(a); i < max; i++) {
+        MatchDoc *a_doc = (MatchDoc*)VA_Fetch(a, i);
+        MatchDoc *b_doc = (MatchDoc*)VA_Fetch(b, i);
+        if (MatchDoc_Get_Doc_ID(a_doc) != MatchDoc_Get_Doc_ID(b_doc)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void
+test_early_termination(TestBatchRunner *runner) {
+    Schema    *schema   = Schema_new();
+    Int32Type *i32_type = Int32Type_new();
+    Int32Type_Set_Indexed(i32_type, false);
+    Int32Type_Set_Sortable(i32_type, true);
+    Schema_Spec_Field(schema, num_cb, (FieldType*)i32_type);
+    SortSpec *sort_spec = S_num_sort_spec(false);
+    Schema_Set_Index_Sort(schema, sort_spec);
+
+    // Three segments, each sorted by ascending num.
+    RAMFolder *folder = RAMFolder_new(NULL);
+    for (int32_t seg = 0; seg < 3; seg++) {
+        Indexer *indexer = Indexer_new(schema, (Obj*)folder, NULL, 0);
+        for (int32_t i = seg * 100; i < (seg + 1) * 100; i++) {
+            Doc       *doc   = Doc_new(NULL, 0);
+            Integer32 *value = Int32_new((i * 37) % 300);
+            Doc_Store(doc, num_cb, (Obj*)value);
+            Indexer_Add_Doc(indexer, doc, 1.0f);
+            DECREF(value);
+            DECREF(doc);
+        }
+        Indexer_Commit(indexer);
+        DECREF(indexer);
+    }
+
+    IndexSearcher *searcher   = IxSearcher_new((Obj*)folder);
+    SortCollector *exhaustive = S_collect(searcher, sort_spec, 0);
+    SortCollector *early      = S_collect(searcher, sort_spec, 1);
+    TEST_TRUE(runner, SortColl_Get_Total_Hits(exhaustive) == 300
+              && SortColl_Total_Hits_Exact(exhaustive),
+              "exhaustive collection counts every hit");
+    TEST_TRUE(runner, SortColl_Get_Total_Hits(early) < 300
+              && !SortColl_Total_Hits_Exact(early),
+              "early termination reports a lower bound (%u)",
+              (unsigned)SortColl_Get_Total_Hits(early));
+    VArray *exhaustive_docs = SortColl_Pop_Match_Docs(exhaustive);
+    VArray *early_docs      = SortColl_Pop_Match_Docs(early);
+    TEST_TRUE(runner, VA_Get_Size(early_docs) == 10
+              && S_same_doc_ids(exhaustive_docs, early_docs),
+              "early termination finds the same top docs");
+    DECREF(early_docs);
+    DECREF(exhaustive_docs);
+    DECREF(early);
+    DECREF(exhaustive);
+
+    // A descending sort doesn't match the index sort.
+    SortSpec      *reverse_spec = S_num_sort_spec(true);
+    SortCollector *reverse      = S_collect(searcher, reverse_spec, 1);
+    TEST_TRUE(runner, SortColl_Get_Total_Hits(reverse) == 300
+              && SortColl_Total_Hits_Exact(reverse),
+              "no early termination when sort order doesn't match");
+    DECREF(reverse);
+    DECREF(reverse_spec);
+
+    MatchAllQuery *query    = MatchAllQuery_new();
+    TopDocs       *top_docs = IxSearcher_Top_Docs(searcher, (Query*)query,
+                                                  10, sort_spec, 0);
+    TEST_TRUE(runner, TopDocs_Get_Total_Hits_Exact(top_docs),
+              "Top_Docs counts exactly by default");
+    DECREF(top_docs);
+    top_docs = IxSearcher_Top_Docs(searcher, (Query*)query, 10, sort_spec,
+                                   50);
+    TEST_TRUE(runner, TopDocs_Get_Total_Hits(top_docs) >= 50
+              && TopDocs_Get_Total_Hits(top_docs) < 300
+              && !TopDocs_Get_Total_Hits_Exact(top_docs),
+              "Top_Docs counts at least total_hits_threshold hits");
+    DECREF(top_docs);
+    top_docs = IxSearcher_Top_Docs(searcher, (Query*)query, 10, sort_spec,
+                                   1000);
+    TEST_TRUE(runner, TopDocs_Get_Total_Hits(top_docs) == 300
+              && TopDocs_Get_Total_Hits_Exact(top_docs),
+              "Top_Docs counts exactly below total_hits_threshold");
+    DECREF(top_docs);
+    DECREF(query);
+
+    DECREF(searcher);
+    DECREF(folder);
+    DECREF(sort_spec);
+    DECREF(i32_type);
+    DECREF(schema);
+}
+
+static void
+test_segment_pruning(TestBatchRunner *runner) {
+    Schema    *schema   = Schema_new();
+    Int32Type *i32_type = Int32Type_new();
+    Int32Type_Set_Indexed(i32_type, false);
+    Int32Type_Set_Sortable(i32_type, true);
+    Schema_Spec_Field(schema, num_cb, (FieldType*)i32_type);
+
+    // Three unsorted segments with disjoint ranges of values, the lowest
+    // first.
+    RAMFolder *folder = RAMFolder_new(NULL);
+    for (int32_t seg = 0; seg < 3; seg++) {
+        Indexer *indexer = Indexer_new(schema, (Obj*)folder, NULL, 0);
+        for (int32_t i = 0; i < 100; i++) {
+            Doc       *doc   = Doc_new(NULL, 0);
+            Integer32 *value = Int32_new(seg * 100 + (i * 37) % 100);
+            Doc_Store(doc, num_cb, (Obj*)value);
+            Indexer_Add_Doc(indexer, doc, 1.0f);
+            DECREF(value);
+            DECREF(doc);
+        }
+        Indexer_Commit(indexer);
+        DECREF(indexer);
+    }
+
+    IndexSearcher *searcher   = IxSearcher_new((Obj*)folder);
+    SortSpec      *sort_spec  = S_num_sort_spec(false);
+    SortCollector *exhaustive = S_collect(searcher, sort_spec, 0);
+    SortCollector *pruned     = S_collect(searcher, sort_spec, 1);
+    TEST_TRUE(runner, SortColl_Get_Total_Hits(pruned) == 100
+              && !SortColl_Total_Hits_Exact(pruned),
+              "segments which can't compete are skipped");
+    VArray *exhaustive_docs = SortColl_Pop_Match_Docs(exhaustive);
+    VArray *pruned_docs     = SortColl_Pop_Match_Docs(pruned);
+    TEST_TRUE(runner, VA_Get_Size(pruned_docs) == 10
+              && S_same_doc_ids(exhaustive_docs, pruned_docs),
+              "segment pruning finds the same top docs");
+    DECREF(pruned_docs);
+    DECREF(exhaustive_docs);
+    DECREF(pruned);
+    DECREF(exhaustive);
+
+    // In reverse order every segment may hold a better doc than the last.
+    SortSpec      *reverse_spec = S_num_sort_spec(true);
+    SortCollector *reverse      = S_collect(searcher, reverse_spec, 1);
+    TEST_TRUE(runner, SortColl_Get_Total_Hits(reverse) == 300
+              && SortColl_Total_Hits_Exact(reverse),
+              "competitive segments aren't skipped");
+    DECREF(reverse);
+    DECREF(reverse_spec);
+
+    DECREF(sort_spec);
+    DECREF(searcher);
+    DECREF(folder);
+    DECREF(i32_type);
+    DECREF(schema);
+}
+
 void
 TestSortSpec_run(TestSortSpec *self, TestBatchRunner *runner) {
-    TestBatchRunner_Plan(runner, (TestBatch*)self, 18);
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 28);
     S_init_strings();
     test_sort_spec(runner);
+    test_early_termination(runner);
+    test_segment_pruning(runner);
     S_destroy_strings();
 }
 
@@ -0,0 +1,285 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define C_TESTLUCY_TESTTERMSQUERY
+#define TESTLUCY_USE_SHORT_NAMES
+#include "Lucy/Util/ToolSet.h"
+#include <stdarg.h>
+
+#include "Clownfish/TestHarness/TestBatchRunner.h"
+#include "Lucy/Test.h"
+#include "Lucy/Test/Search/TestTermsQuery.h"
+#include "Lucy/Test/TestUtils.h"
+#include "Lucy/Document/Doc.h"
+#include "Lucy/Document/HitDoc.h"
+#include "Lucy/Index/IndexReader.h"
+#include "Lucy/Index/Indexer.h"
+#include "Lucy/Index/SegReader.h"
+#include "Lucy/Plan/Schema.h"
+#include "Lucy/Plan/StringType.h"
+#include "Lucy/Search/ANDQuery.h"
+#include "Lucy/Search/BitVecMatcher.h"
+#include "Lucy/Search/Compiler.h"
+#include "Lucy/Search/Hits.h"
+#include "Lucy/Search/IndexSearcher.h"
+#include "Lucy/Search/NoMatchQuery.h"
+#include "Lucy/Search/ORMatcher.h"
+#include "Lucy/Search/ORQuery.h"
+#include "Lucy/Search/TermQuery.h"
+#include "Lucy/Search/TermsQuery.h"
+#include "Lucy/Store/InStream.h"
+#include "Lucy/Store/OutStream.h"
+#include "Lucy/Store/RAMFile.h"
+#include "Lucy/Store/RAMFolder.h"
+#include "Lucy/Util/Freezer.h"
+
+#define NUM_DOCS 200
+
+TestTermsQuery*
+TestTermsQuery_new() {
+    return (TestTermsQuery*)VTable_Make_Obj(TESTTERMSQUERY);
+}
+
+static TermsQuery*
+S_make_terms_query(const char *field, ...) {
+    VArray  *terms = VA_new(0);
+    CharBuf *field_cb = CB_newf("%s", field);
+    char    *term_str;
+    va_list  args;
+
+    va_start(args, field);
+    while (NULL != (term_str = va_arg(args, char*))) {
+        VA_Push(terms, (Obj*)CB_newf("%s", term_str));
+    }
+    va_end(args);
+
+    TermsQuery *query = TermsQuery_new(field_cb, terms);
+    DECREF(field_cb);
+    DECREF(terms);
+    return query;
+}
+
+// Match every <code>step</code>th id, plus a few ids which aren't present.
+static TermsQuery*
+S_make_id_query(int32_t step) {
+    VArray  *terms = VA_new(0);
+    CharBuf *field = CB_newf("id");
+    for (int32_t i = NUM_DOCS - 1; i >= 0; i--) {
+        if (i % step == 0) { VA_Push(terms, (Obj*)CB_newf("id%i32", i)); }
+    }
+    for (int32_t i = 0; i < 10; i++) {
+        VA_Push(terms, (Obj*)CB_newf("missing%i32", i));
+    }
+    TermsQuery *query = TermsQuery_new(field, terms);
+    DECREF(field);
+    DECREF(terms);
+    return query;
+}
+
+// Index NUM_DOCS docs in two segments, each with a unique "id" and a "cat"
+// of either "even" or "odd".
+static IndexSearcher*
+S_create_searcher() {
+    Schema     *schema = Schema_new();
+    StringType *type   = StringType_new();
+    RAMFolder  *folder = RAMFolder_new(NULL);
+    CharBuf    *id     = CB_newf("id");
+    CharBuf    *cat    = CB_newf("cat");
+    Schema_Spec_Field(schema, id, (FieldType*)type);
+    Schema_Spec_Field(schema, cat, (FieldType*)type);
+
+    for (int32_t seg = 0; seg < 2; seg++) {
+        Indexer *indexer = Indexer_new(schema, (Obj*)folder, NULL, 0);
+        for (int32_t i = seg * NUM_DOCS / 2; i < (seg + 1) * NUM_DOCS / 2;
+             i++
+            ) {
+            Doc     *doc       = Doc_new(NULL, 0);
+            CharBuf *id_val    = CB_newf("id%i32", i);
+            CharBuf *cat_val   = CB_newf("%s", i % 2 ? "odd" : "even");
+            Doc_Store(doc, id, (Obj*)id_val);
+            Doc_Store(doc, cat, (Obj*)cat_val);
+            Indexer_Add_Doc(indexer, doc, 1.0f);
+            DECREF(cat_val);
+            DECREF(id_val);
+            DECREF(doc);
+        }
+        Indexer_Commit(indexer);
+        DECREF(indexer);
+    }
+
+    IndexSearcher *searcher = IxSearcher_new((Obj*)folder);
+    DECREF(cat);
+    DECREF(id);
+    DECREF(folder);
+    DECREF(type);
+    DECREF(schema);
+    return searcher;
+}
+
+static Obj*
+S_freeze_thaw(Obj *object) {
+    RAMFile *ram_file = RAMFile_new(NULL, false);
+    OutStream *outstream = OutStream_open((Obj*)ram_file);
+    FREEZE(object, outstream);
+    OutStream_Close(outstream);
+    DECREF(outstream);
+
+    InStream *instream = InStream_open((Obj*)ram_file);
+    Obj *retval = THAW(instream);
+    DECREF(instream);
+    DECREF(ram_file);
+    return retval;
+}
+
+static void
+test_Dump_Load_and_Equals(TestBatchRunner *runner) {
+    TermsQuery *query     = S_make_terms_query("id", "b", "a", "b", NULL);
+    TermsQuery *sorted    = S_make_terms_query("id", "a", "b", NULL);
+    TermsQuery *field_differs
+        = S_make_terms_query("cat", "a", "b", NULL);
+    TermsQuery *terms_differ
+        = S_make_terms_query("id", "a", "b", "c", NULL);
+
+    TEST_INT_EQ(runner, VA_Get_Size(TermsQuery_Get_Terms(query)), 2,
+                "duplicate terms removed");
+    TEST_TRUE(runner, TermsQuery_Equals(query, (Obj*)sorted),
+              "term order doesn't affect Equals()");
+    TEST_FALSE(runner, TermsQuery_Equals(query, (Obj*)field_differs),
+               "Equals() false with different field");
+    TEST_FALSE(runner, TermsQuery_Equals(query, (Obj*)terms_differ),
+               "Equals() false with different terms");
+
+    CharBuf *string = TermsQuery_To_String(query);
+    TEST_TRUE(runner, CB_Equals_Str(string, "id:{a, b}", 9), "To_String");
+    DECREF(string);
+
+    Obj *dump = (Obj*)TermsQuery_Dump(query);
+    TermsQuery *clone = (TermsQuery*)TermsQuery_Load(terms_differ, dump);
+    TEST_TRUE(runner, TermsQuery_Equals(query, (Obj*)clone),
+              "Dump => Load round trip");
+    DECREF(clone);
+    DECREF(dump);
+
+    TermsQuery_Set_Boost(query, 2.0f);
+    clone = (TermsQuery*)S_freeze_thaw((Obj*)query);
+    TEST_TRUE(runner, TermsQuery_Equals(query, (Obj*)clone),
+              "Serialization round trip");
+    DECREF(clone);
+
+    DECREF(terms_differ);
+    DECREF(field_differs);
+    DECREF(sorted);
+    DECREF(query);
+}
+
+static uint32_t
+S_total_hits(Searcher *searcher, Query *query) {
+    Hits *hits = Searcher_Hits(searcher, (Obj*)query, 0, 10, NULL);
+    uint32_t total = Hits_Total_Hits(hits);
+    DECREF(hits);
+    return total;
+}
+
+// Return the Matcher the query would use on the first segment.
+static Matcher*
+S_first_matcher(IndexSearcher *searcher, Query *query) {
+    IndexReader *reader = IxSearcher_Get_Reader(searcher);
+    VArray   *seg_readers = IxReader_Seg_Readers(reader);
+    SegReader *seg_reader = (SegReader*)VA_Fetch(seg_readers, 0);
+    Compiler *compiler = Query_Make_Compiler(query, (Searcher*)searcher,
+                                             Query_Get_Boost(query), false);
+    Matcher *matcher = Compiler_Make_Matcher(compiler, seg_reader, false);
+    DECREF(compiler);
+    DECREF(seg_readers);
+    return matcher;
+}
+
+static void
+test_search(TestBatchRunner *runner, IndexSearcher *ix_searcher) {
+    Searcher *searcher = (Searcher*)ix_searcher;
+    Matcher  *matcher;
+
+    TermsQuery *few = S_make_terms_query("id", "id150", "id3", "nope",
+                                         NULL);
+    TEST_INT_EQ(runner, S_total_hits(searcher, (Query*)few), 2,
+                "few terms");
+    matcher = S_first_matcher(ix_searcher, (Query*)few);
+    TEST_TRUE(runner, matcher && Matcher_Is_A(matcher, ORMATCHER),
+              "few terms merged with a heap");
+    DECREF(matcher);
+
+    Hits   *hits = Searcher_Hits(searcher, (Obj*)few, 0, 10, NULL);
+    HitDoc *hit  = Hits_Next(hits);
+    TEST_TRUE(runner, hit && HitDoc_Get_Score(hit) == 0.0f,
+              "TermsQuery doesn't score");
+    DECREF(hit);
+    DECREF(hits);
+    DECREF(few);
+
+    TermsQuery *many = S_make_id_query(3);
+    TEST_INT_EQ(runner, S_total_hits(searcher, (Query*)many), 67,
+                "many terms");
+    matcher = S_first_matcher(ix_searcher, (Query*)many);
+    TEST_TRUE(runner, matcher && Matcher_Is_A(matcher, BITVECMATCHER),
+              "many terms gathered into a bit vector");
+    DECREF(matcher);
+
+    // Compare against the equivalent ORQuery.
+    VArray *kids  = VA_new(0);
+    VArray *terms = TermsQuery_Get_Terms(many);
+    for (uint32_t i = 0, max = VA_Get_Size(terms); i < max; i++) {
+        VA_Push(kids, (Obj*)TermQuery_new(TermsQuery_Get_Field(many),
+                                          VA_Fetch(terms, i)));
+    }
+    ORQuery *or_query = ORQuery_new(kids);
+    TEST_INT_EQ(runner, S_total_hits(searcher, (Query*)or_query), 67,
+                "same hits as ORQuery");
+    DECREF(or_query);
+    DECREF(kids);
+
+    Query *even = (Query*)TestUtils_make_term_query("cat", "even");
+    Query *and_query = (Query*)TestUtils_make_poly_query(BOOLOP_AND, even,
+                                                         INCREF(many), NULL);
+    TEST_INT_EQ(runner, S_total_hits(searcher, and_query), 34,
+                "intersected with another query");
+    DECREF(and_query);
+    DECREF(many);
+
+    TermsQuery *none = S_make_terms_query("id", NULL);
+    Query *rewritten = TermsQuery_Rewrite(none, searcher);
+    TEST_TRUE(runner, Query_Is_A(rewritten, NOMATCHQUERY),
+              "empty TermsQuery rewritten to NoMatchQuery");
+    TEST_INT_EQ(runner, S_total_hits(searcher, (Query*)none), 0,
+                "empty TermsQuery matches nothing");
+    DECREF(rewritten);
+    DECREF(none);
+
+    TermsQuery *absent = S_make_terms_query("id", "nope", "zilch", NULL);
+    TEST_INT_EQ(runner, S_total_hits(searcher, (Query*)absent), 0,
+                "absent terms match nothing");
+    DECREF(absent);
+}
+
+void
+TestTermsQuery_run(TestTermsQuery *self, TestBatchRunner *runner) {
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 17);
+    IndexSearcher *searcher = S_create_searcher();
+    test_Dump_Load_and_Equals(runner);
+    test_search(runner, searcher);
+    DECREF(searcher);
+}
+
+
@@ -0,0 +1,146 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define C_TESTLUCY_TESTINTERSECTUTILS
+#define TESTLUCY_USE_SHORT_NAMES
+#include "Lucy/Util/ToolSet.h"
+
+#include "Clownfish/TestHarness/TestBatchRunner.h"
+#include "Clownfish/TestHarness/TestUtils.h"
+#include "Lucy/Test.h"
+#include "Lucy/Test/Util/TestIntersectUtils.h"
+#include "Lucy/Util/IntersectUtils.h"
+
+TestIntersectUtils*
+TestIntersect_new() {
+    return (TestIntersectUtils*)VTable_Make_Obj(TESTINTERSECTUTILS);
+}
+
+// Fill <code>array</code> with <code>size</code> random ascending positions,
+// spaced by gaps of 1 to <code>max_gap</code>.
+static void
+S_fill_positions(uint32_t *array, uint32_t size, uint32_t max_gap) {
+    uint32_t pos = (uint32_t)(TestUtils_random_u64() % max_gap);
+    for (uint32_t i = 0; i < size; i++) {
+        array[i] = pos;
+        pos += 1 + (uint32_t)(TestUtils_random_u64() % max_gap);
+    }
+}
+
+// Reference implementation: test each anchor against every candidate.
+static uint32_t
+S_naive_winnow(uint32_t *anchors, uint32_t num_anchors,
+               const uint32_t *candidates, uint32_t num_candidates,
+               uint32_t offset, uint32_t within) {
+    uint32_t num_kept = 0;
+    for (uint32_t i = 0; i < num_anchors; i++) {
+        const uint32_t target = anchors[i] + offset;
+        for (uint32_t j = 0; j < num_candidates; j++) {
+            if (candidates[j] >= target && candidates[j] - target < within) {
+                anchors[num_kept++] = anchors[i];
+                break;
+            }
+        }
+    }
+    return num_kept;
+}
+
+// Winnow random arrays of the given sizes both ways and compare.
+static bool
+S_agrees(uint32_t num_anchors, uint32_t anchor_gap, uint32_t num_candidates,
+         uint32_t candidate_gap, uint32_t within, uint32_t trials) {
+    const size_t anchors_size    = (num_anchors + 1) * sizeof(uint32_t);
+    const size_t candidates_size = (num_candidates + 1) * sizeof(uint32_t);
+    uint32_t *anchors    = (uint32_t*)MALLOCATE(anchors_size);
+    uint32_t *expected   = (uint32_t*)MALLOCATE(anchors_size);
+    uint32_t *candidates = (uint32_t*)MALLOCATE(candidates_size);
+    bool      ok         = true;
+
+    for (uint32_t trial = 0; trial < trials && ok; trial++) {
+        const uint32_t offset = 1 + trial % 3;
+        S_fill_positions(anchors, num_anchors, anchor_gap);
+        S_fill_positions(candidates, num_candidates, candidate_gap);
+        memcpy(expected, anchors, num_anchors * sizeof(uint32_t));
+        uint32_t num_expected
+            = S_naive_winnow(expected, num_anchors, candidates,
+                             num_candidates, offset, within);
+        uint32_t num_kept = within == 1
+            ? Intersect_winnow_exact(anchors, num_anchors, candidates,
+                                     num_candidates, offset)
+            : Intersect_winnow_within(anchors, num_anchors, candidates,
+                                      num_candidates, offset, within);
+        if (num_kept != num_expected
+            || memcmp(anchors, expected, num_kept * sizeof(uint32_t)) != 0
+           ) {
+            ok = false;
+        }
+    }
+
+    FREEMEM(anchors);
+    FREEMEM(expected);
+    FREEMEM(candidates);
+    return ok;
+}
+
+static void
+test_exact(TestBatchRunner *runner) {
+    TEST_TRUE(runner, S_agrees(200, 4, 200, 4, 1, 50),
+              "winnow_exact merges arrays of similar size");
+    TEST_TRUE(runner, S_agrees(7, 3, 5, 3, 1, 200),
+              "winnow_exact handles arrays shorter than a vector");
+    TEST_TRUE(runner, S_agrees(5, 400, 3000, 2, 1, 20),
+              "winnow_exact gallops through many candidates");
+    TEST_TRUE(runner, S_agrees(3000, 2, 5, 400, 1, 20),
+              "winnow_exact gallops through many anchors");
+}
+
+static void
+test_within(TestBatchRunner *runner) {
+    TEST_TRUE(runner, S_agrees(200, 6, 200, 6, 4, 50),
+              "winnow_within merges arrays of similar size");
+    TEST_TRUE(runner, S_agrees(5, 400, 3000, 2, 3, 20),
+              "winnow_within gallops through many candidates");
+
+    // An earlier anchor's near miss must not hide a later anchor's match.
+    uint32_t anchors[]    = { 0, 5 };
+    uint32_t candidates[] = { 7 };
+    TEST_INT_EQ(runner, Intersect_winnow_within(anchors, 2, candidates, 1,
+                                                1, 3), 1,
+                "winnow_within keeps a match after a near miss");
+    TEST_INT_EQ(runner, anchors[0], 5, "the right anchor is kept");
+}
+
+static void
+test_edge_cases(TestBatchRunner *runner) {
+    uint32_t anchors[]    = { 1, 2, 3 };
+    uint32_t candidates[] = { 0, 1 };
+    TEST_INT_EQ(runner, Intersect_winnow_exact(anchors, 3, candidates, 0, 1),
+                0, "no candidates leaves no anchors");
+    TEST_INT_EQ(runner, Intersect_winnow_exact(anchors, 0, candidates, 2, 1),
+                0, "no anchors stays no anchors");
+    TEST_INT_EQ(runner, Intersect_winnow_exact(anchors, 3, candidates, 2, 5),
+                0, "candidates below the offset never match");
+}
+
+void
+TestIntersect_run(TestIntersectUtils *self, TestBatchRunner *runner) {
+    TestBatchRunner_Plan(runner, (TestBatch*)self, 11);
+    test_exact(runner);
+    test_within(runner);
+    test_edge_cases(runner);
+}
+
+
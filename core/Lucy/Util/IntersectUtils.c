@@ -0,0 +1,197 @@
+/* Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define C_LUCY_INTERSECTUTILS
+#include "Lucy/Util/ToolSet.h"
+
+#include "Lucy/Util/IntersectUtils.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+  #include <emmintrin.h>
+  #define LUCY_INTERSECT_SSE2
+#endif
+
+// Return the index of the first element at or after <code>start</code>
+// which is not less than <code>target</code>, or <code>size</code> if there
+// is none.  Probes at exponentially growing distances, then bisects.
+static INLINE uint32_t
+SI_gallop(const uint32_t *array, uint32_t start, uint32_t size,
+          uint32_t target) {
+    uint32_t lo   = start;
+    uint32_t step = 1;
+    if (lo >= size || array[lo] >= target) { return lo; }
+    uint32_t hi = lo + step;
+    while (hi < size && array[hi] < target) {
+        lo   = hi;
+        step <<= 1;
+        hi   = lo + step;
+    }
+    if (hi > size) { hi = size; }
+
+    // Now array[lo] < target, and array[hi] >= target if hi < size.
+    while (hi - lo > 1) {
+        const uint32_t mid = lo + ((hi - lo) >> 1);
+        if (array[mid] < target) { lo = mid; }
+        else                     { hi = mid; }
+    }
+    return hi;
+}
+
+// Few anchors, many candidates: look each anchor up.
+static uint32_t
+S_exact_gallop_candidates(uint32_t *anchors, uint32_t num_anchors,
+                          const uint32_t *candidates,
+                          uint32_t num_candidates, uint32_t offset) {
+    uint32_t num_kept = 0;
+    uint32_t tick     = 0;
+    for (uint32_t i = 0; i < num_anchors; i++) {
+        const uint32_t target = anchors[i] + offset;
+        tick = SI_gallop(candidates, tick, num_candidates, target);
+        if (tick == num_candidates) { break; }
+        if (candidates[tick] == target) { anchors[num_kept++] = anchors[i]; }
+    }
+    return num_kept;
+}
+
+// Many anchors, few candidates: look each candidate up.
+static uint32_t
+S_exact_gallop_anchors(uint32_t *anchors, uint32_t num_anchors,
+                       const uint32_t *candidates, uint32_t num_candidates,
+                       uint32_t offset) {
+    uint32_t num_kept = 0;
+    uint32_t tick     = 0;
+    for (uint32_t i = 0; i < num_candidates; i++) {
+        if (candidates[i] < offset) { continue; }
+        const uint32_t target = candidates[i] - offset;
+        tick = SI_gallop(anchors, tick, num_anchors, target);
+        if (tick == num_anchors) { break; }
+        if (anchors[tick] == target) { anchors[num_kept++] = target; }
+    }
+    return num_kept;
+}
+
+// Comparable sizes: merge.  Anchors are only ever written at or behind the
+// one being read, so the winnowing can happen in place.
+static uint32_t
+S_exact_merge(uint32_t *anchors, uint32_t num_anchors,
+              const uint32_t *candidates, uint32_t num_candidates,
+              uint32_t offset) {
+    uint32_t num_kept = 0;
+    uint32_t i        = 0;
+    uint32_t j        = 0;
+
+#ifdef LUCY_INTERSECT_SSE2
+    /* Compare four anchors against four candidates at a time: one compare
+     * against the candidates as loaded, and three more against rotations of
+     * them.  Since neither array has duplicates, each anchor matches at most
+     * once, and whichever block has the lower maximum can't match anything
+     * beyond the other block, so it is the one to move on. */
+    const __m128i offsets = _mm_set1_epi32((int)offset);
+    while (i + 4 <= num_anchors && j + 4 <= num_candidates) {
+        const __m128i a = _mm_add_epi32(
+                              _mm_loadu_si128((const __m128i*)(anchors + i)),
+                              offsets);
+        const __m128i c = _mm_loadu_si128((const __m128i*)(candidates + j));
+        const __m128i eq = _mm_or_si128(
+            _mm_or_si128(
+                _mm_cmpeq_epi32(a, c),
+                _mm_cmpeq_epi32(a, _mm_shuffle_epi32(c, _MM_SHUFFLE(0, 3, 2, 1)))),
+            _mm_or_si128(
+                _mm_cmpeq_epi32(a, _mm_shuffle_epi32(c, _MM_SHUFFLE(1, 0, 3, 2))),
+                _mm_cmpeq_epi32(a, _mm_shuffle_epi32(c, _MM_SHUFFLE(2, 1, 0, 3)))));
+        const int mask = _mm_movemask_ps(_mm_castsi128_ps(eq));
+        const uint32_t a_max = anchors[i + 3] + offset;
+        const uint32_t c_max = candidates[j + 3];
+        for (uint32_t k = 0; k < 4; k++) {
+            if (mask & (1 << k)) { anchors[num_kept++] = anchors[i + k]; }
+        }
+        if (a_max <= c_max) { i += 4; }
+        if (c_max <= a_max) { j += 4; }
+    }
+#endif
+
+    while (i < num_anchors && j < num_candidates) {
+        const uint32_t target    = anchors[i] + offset;
+        const uint32_t candidate = candidates[j];
+        if (target == candidate) {
+            anchors[num_kept++] = anchors[i];
+            i++;
+            j++;
+        }
+        else if (target < candidate) { i++; }
+        else                         { j++; }
+    }
+
+    return num_kept;
+}
+
+uint32_t
+Intersect_winnow_exact(uint32_t *anchors, uint32_t num_anchors,
+                       const uint32_t *candidates, uint32_t num_candidates,
+                       uint32_t offset) {
+    if (!num_anchors || !num_candidates) {
+        return 0;
+    }
+    else if (num_candidates / INTERSECT_GALLOP_RATIO >= num_anchors) {
+        return S_exact_gallop_candidates(anchors, num_anchors, candidates,
+                                         num_candidates, offset);
+    }
+    else if (num_anchors / INTERSECT_GALLOP_RATIO >= num_candidates) {
+        return S_exact_gallop_anchors(anchors, num_anchors, candidates,
+                                      num_candidates, offset);
+    }
+    else {
+        return S_exact_merge(anchors, num_anchors, candidates,
+                             num_candidates, offset);
+    }
+}
+
+uint32_t
+Intersect_winnow_within(uint32_t *anchors, uint32_t num_anchors,
+                        const uint32_t *candidates, uint32_t num_candidates,
+                        uint32_t offset, uint32_t within) {
+    if (within <= 1) {
+        return Intersect_winnow_exact(anchors, num_anchors, candidates,
+                                      num_candidates, offset);
+    }
+    if (!num_anchors || !num_candidates) { return 0; }
+
+    // Find the first candidate at or after each anchor's slot, and keep the
+    // anchor if that candidate lies inside the window.  Both the anchors and
+    // their slots ascend, so the search never moves backwards.
+    const bool gallop
+        = num_candidates / INTERSECT_GALLOP_RATIO >= num_anchors;
+    uint32_t num_kept = 0;
+    uint32_t tick     = 0;
+    for (uint32_t i = 0; i < num_anchors; i++) {
+        const uint32_t target = anchors[i] + offset;
+        if (gallop) {
+            tick = SI_gallop(candidates, tick, num_candidates, target);
+        }
+        else {
+            while (tick < num_candidates && candidates[tick] < target) {
+                tick++;
+            }
+        }
+        if (tick == num_candidates) { break; }
+        if (candidates[tick] - target < within) {
+            anchors[num_kept++] = anchors[i];
+        }
+    }
+    return num_kept;
+}
+
+
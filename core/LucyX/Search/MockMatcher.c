@@ -70,4 +70,9 @@ MockMatcher_get_doc_id(MockMatcher* self) {
     return I32Arr_Get(ivars->doc_ids, ivars->tick);
 }
 
+uint32_t
+MockMatcher_cost(MockMatcher* self) {
+    return (uint32_t)MockMatcher_IVARS(self)->size;
+}
+
 
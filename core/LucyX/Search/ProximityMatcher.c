@@ -24,6 +24,7 @@
 #include "Lucy/Index/PostingList.h"
 #include "Lucy/Index/Similarity.h"
 #include "Lucy/Search/Compiler.h"
+#include "Lucy/Util/IntersectUtils.h"
 
 
 ProximityMatcher*
@@ -197,57 +198,6 @@ ProximityMatcher_advance(ProximityMatcher *self, int32_t target) {
 }
 
 
-static INLINE uint32_t
-SI_winnow_anchors(uint32_t *anchors_start, const uint32_t *const anchors_end,
-                  const uint32_t *candidates, const uint32_t *const candidates_end,
-                  uint32_t offset, uint32_t within) {
-    uint32_t *anchors = anchors_start;
-    uint32_t *anchors_found = anchors_start;
-    uint32_t target_anchor;
-    uint32_t target_candidate;
-
-    // Safety check, so there's no chance of a bad dereference.
-    if (anchors_start == anchors_end || candidates == candidates_end) {
-        return 0;
-    }
-
-    /* This function is a loop that finds terms that can continue a phrase.
-     * It overwrites the anchors in place, and returns the number remaining.
-     * The basic algorithm is to alternately increment the candidates' pointer
-     * until it is at or beyond its target position, and then increment the
-     * anchors' pointer until it is at or beyond its target.  The non-standard
-     * form is to avoid unnecessary comparisons.  This loop has not been
-     * tested for speed, but glancing at the object code produced (objdump -S)
-     * it appears to be significantly faster than the nested loop alternative.
-     * But given the vagaries of modern processors, it merits actual
-     * testing.*/
-
-SPIN_CANDIDATES:
-    target_candidate = *anchors + offset;
-    while (*candidates < target_candidate) {
-        if (++candidates == candidates_end) { goto DONE; }
-    }
-    if ((*candidates - target_candidate) < within) { goto MATCH; }
-    goto SPIN_ANCHORS;
-
-SPIN_ANCHORS:
-    target_anchor = *candidates - offset;
-    while (*anchors < target_anchor) {
-        if (++anchors == anchors_end) { goto DONE; }
-    };
-    if (*anchors == target_anchor) { goto MATCH; }
-    goto SPIN_CANDIDATES;
-
-MATCH:
-    *anchors_found++ = *anchors;
-    if (++anchors == anchors_end) { goto DONE; }
-    goto SPIN_CANDIDATES;
-
-DONE:
-    // Return number of anchors remaining.
-    return anchors_found - anchors_start;
-}
-
 float
 ProximityMatcher_calc_proximity_freq(ProximityMatcher *self) {
     ProximityMatcherIVARS *const ivars = ProximityMatcher_IVARS(self);
@@ -279,8 +229,7 @@ ProximityMatcher_calc_proximity_freq(ProximityMatcher *self) {
 
     size_t    amount        = anchors_remaining * sizeof(uint32_t);
     uint32_t *anchors_start = (uint32_t*)BB_Grow(ivars->anchor_set, amount);
-    uint32_t *anchors_end   = anchors_start + anchors_remaining;
-    memcpy(anchors_start, post_ivars->prox, amount);
+    memcpy(anchors_start, ScorePost_Get_Prox(posting), amount);
 
     // Match the positions of other terms against the anchor set.
     for (uint32_t i = 1, max = ivars->num_elements; i < max; i++) {
@@ -288,26 +237,16 @@ ProximityMatcher_calc_proximity_freq(ProximityMatcher *self) {
         // set (which is a copy), these won't be overwritten.
         ScorePosting *next_post = (ScorePosting*)PList_Get_Posting(plists[i]);
         ScorePostingIVARS *const next_post_ivars = ScorePost_IVARS(next_post);
-        uint32_t *candidates_start = next_post_ivars->prox;
-        uint32_t *candidates_end   = candidates_start + next_post_ivars->freq;
+        uint32_t *candidates_start = ScorePost_Get_Prox(next_post);
 
         // Splice out anchors that don't match the next term.  Bail out if
         // we've eliminated all possible anchors.
-        if (ivars->within == 1) { // exact phrase match
-            anchors_remaining = SI_winnow_anchors(anchors_start, anchors_end,
-                                                  candidates_start,
-                                                  candidates_end, i, 1);
-        }
-        else {  // fuzzy-phrase match
-            anchors_remaining = SI_winnow_anchors(anchors_start, anchors_end,
-                                                  candidates_start,
-                                                  candidates_end, i,
-                                                  ivars->within);
-        }
+        anchors_remaining
+            = Intersect_winnow_within(anchors_start, anchors_remaining,
+                                      candidates_start,
+                                      next_post_ivars->freq, i,
+                                      ivars->within);
         if (!anchors_remaining) { return 0.0f; }
-
-        // Adjust end for number of anchors that remain.
-        anchors_end = anchors_start + anchors_remaining;
     }
 
     // The number of anchors left is the proximity freq.
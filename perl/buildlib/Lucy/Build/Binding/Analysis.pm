@@ -23,6 +23,7 @@ sub bind_all {
     my $class = shift;
     $class->bind_analyzer;
     $class->bind_casefolder;
+    $class->bind_commongramsfilter;
     $class->bind_easyanalyzer;
     $class->bind_inversion;
     $class->bind_normalizer;
@@ -73,6 +74,38 @@ END_CONSTRUCTOR
     Clownfish::CFC::Binding::Perl::Class->register($binding);
 }
 
+sub bind_commongramsfilter {
+    my $pod_spec = Clownfish::CFC::Binding::Perl::Pod->new;
+    my $synopsis = <<'END_SYNOPSIS';
+    my $common_grams = Lucy::Analysis::CommonGramsFilter->new(
+        language => 'en',
+    );
+    my $polyanalyzer = Lucy::Analysis::PolyAnalyzer->new(
+        analyzers => [ $tokenizer, $normalizer, $common_grams ],
+    );
+END_SYNOPSIS
+    my $constructor = <<'END_CONSTRUCTOR';
+    my $common_grams = Lucy::Analysis::CommonGramsFilter->new(
+        language => 'en',
+    );
+    
+    # or...
+    my $common_grams = Lucy::Analysis::CommonGramsFilter->new(
+        common_words => \%common_words,
+    );
+END_CONSTRUCTOR
+    $pod_spec->set_synopsis($synopsis);
+    $pod_spec->add_constructor( alias => 'new', sample => $constructor );
+
+    my $binding = Clownfish::CFC::Binding::Perl::Class->new(
+        parcel     => "Lucy",
+        class_name => "Lucy::Analysis::CommonGramsFilter",
+    );
+    $binding->set_pod_spec($pod_spec);
+
+    Clownfish::CFC::Binding::Perl::Class->register($binding);
+}
+
 sub bind_easyanalyzer {
     my $pod_spec = Clownfish::CFC::Binding::Perl::Pod->new;
     my $synopsis = <<'END_SYNOPSIS';
@@ -22,6 +22,7 @@ $VERSION = eval $VERSION;
 sub bind_all {
     my $class = shift;
     $class->bind_backgroundmerger;
+    $class->bind_bm25similarity;
     $class->bind_datareader;
     $class->bind_datawriter;
     $class->bind_deletionswriter;
@@ -74,6 +75,40 @@ END_CONSTRUCTOR
     Clownfish::CFC::Binding::Perl::Class->register($binding);
 }
 
+sub bind_bm25similarity {
+    my @exposed = qw(
+        Get_K1
+        Get_B
+    );
+
+    my $pod_spec = Clownfish::CFC::Binding::Perl::Pod->new;
+    my $synopsis = <<'END_SYNOPSIS';
+    package MyFullTextType;
+    use base qw( Lucy::Plan::FullTextType );
+
+    sub make_similarity {
+        return Lucy::Index::BM25Similarity->new( k1 => 1.2, b => 0.75 );
+    }
+END_SYNOPSIS
+    my $constructor = <<'END_CONSTRUCTOR';
+    my $sim = Lucy::Index::BM25Similarity->new(
+        k1 => 1.2,     # default: 1.2
+        b  => 0.75,    # default: 0.75
+    );
+END_CONSTRUCTOR
+    $pod_spec->set_synopsis($synopsis);
+    $pod_spec->add_constructor( alias => 'new', sample => $constructor, );
+    $pod_spec->add_method( method => $_, alias => lc($_) ) for @exposed;
+
+    my $binding = Clownfish::CFC::Binding::Perl::Class->new(
+        parcel     => "Lucy",
+        class_name => "Lucy::Index::BM25Similarity",
+    );
+    $binding->set_pod_spec($pod_spec);
+
+    Clownfish::CFC::Binding::Perl::Class->register($binding);
+}
+
 sub bind_datareader {
     my @exposed = qw(
         Get_Schema
@@ -22,6 +22,7 @@ $VERSION = eval $VERSION;
 sub bind_all {
     my $class = shift;
     $class->bind_bitvector;
+    $class->bind_roaringbitvector;
     $class->bind_i32array;
 }
 
@@ -66,6 +67,39 @@ END_CONSTRUCTOR
         class_name => "Lucy::Object::BitVector",
     );
     $binding->set_pod_spec($pod_spec);
+    $binding->exclude_method($_) for qw( Next_Hits );
+
+    Clownfish::CFC::Binding::Perl::Class->register($binding);
+}
+
+sub bind_roaringbitvector {
+    my @exposed = qw(
+        Run_Optimize
+    );
+
+    my $pod_spec = Clownfish::CFC::Binding::Perl::Pod->new;
+    my $synopsis = <<'END_SYNOPSIS';
+    my $bit_vec = Lucy::Object::RoaringBitVector->new;
+    $bit_vec->flip_block( offset => 1_000_000, length => 50_000 );
+    $bit_vec->set(5);
+    $bit_vec->run_optimize;
+    print $bit_vec->count . "\n";    # prints 50001
+END_SYNOPSIS
+    my $constructor = <<'END_CONSTRUCTOR';
+    my $bit_vec = Lucy::Object::RoaringBitVector->new(
+        capacity => $doc_max + 1,   # default 0,
+    );
+END_CONSTRUCTOR
+    $pod_spec->set_synopsis($synopsis);
+    $pod_spec->add_constructor( alias => 'new', sample => $constructor );
+    $pod_spec->add_method( method => $_, alias => lc($_) ) for @exposed;
+
+    my $binding = Clownfish::CFC::Binding::Perl::Class->new(
+        parcel     => "Lucy",
+        class_name => "Lucy::Object::RoaringBitVector",
+    );
+    $binding->set_pod_spec($pod_spec);
+    $binding->exclude_method($_) for qw( Next_Hits );
 
     Clownfish::CFC::Binding::Perl::Class->register($binding);
 }
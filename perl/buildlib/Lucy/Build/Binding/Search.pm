@@ -24,7 +24,9 @@ sub bind_all {
     $class->bind_andquery;
     $class->bind_collector;
     $class->bind_bitcollector;
+    $class->bind_cachingfilter;
     $class->bind_compiler;
+    $class->bind_filtercache;
     $class->bind_hits;
     $class->bind_indexsearcher;
     $class->bind_leafquery;
@@ -48,6 +50,7 @@ sub bind_all {
     $class->bind_span;
     $class->bind_termquery;
     $class->bind_termcompiler;
+    $class->bind_termsquery;
 }
 
 sub bind_andquery {
@@ -336,6 +339,76 @@ END_CONSTRUCTOR_CODE_SAMPLE
     Clownfish::CFC::Binding::Perl::Class->register($binding);
 }
 
+sub bind_cachingfilter {
+    my @exposed = qw( Get_Query Get_Cache );
+
+    my $pod_spec = Clownfish::CFC::Binding::Perl::Pod->new;
+    my $synopsis = <<'END_SYNOPSIS';
+    my $cache = Lucy::Search::FilterCache->new;
+    my %category_filters;
+    for my $category (qw( sweet sour salty bitter )) {
+        my $cat_query = Lucy::Search::TermQuery->new(
+            field => 'category',
+            term  => $category,
+        );
+        $category_filters{$category} = Lucy::Search::CachingFilter->new(
+            query => $cat_query,
+            cache => $cache,
+        );
+    }
+    my $and_query = Lucy::Search::ANDQuery->new(
+        children => [ $user_query, $category_filters{$category} ],
+    );
+    my $hits = $searcher->hits( query => $and_query );
+END_SYNOPSIS
+    my $constructor = <<'END_CONSTRUCTOR';
+    my $filter = Lucy::Search::CachingFilter->new(
+        query => $query,    # required
+        cache => $cache,    # default: private FilterCache
+    );
+END_CONSTRUCTOR
+    $pod_spec->set_synopsis($synopsis);
+    $pod_spec->add_constructor( alias => 'new', sample => $constructor, );
+    $pod_spec->add_method( method => $_, alias => lc($_) ) for @exposed;
+
+    my $binding = Clownfish::CFC::Binding::Perl::Class->new(
+        parcel     => "Lucy",
+        class_name => "Lucy::Search::CachingFilter",
+    );
+    $binding->set_pod_spec($pod_spec);
+
+    Clownfish::CFC::Binding::Perl::Class->register($binding);
+}
+
+sub bind_filtercache {
+    my @exposed = qw( Clear Get_Size Get_Num_Bytes Get_Max_Bytes );
+
+    my $pod_spec = Clownfish::CFC::Binding::Perl::Pod->new;
+    my $synopsis = <<'END_SYNOPSIS';
+    my $cache = Lucy::Search::FilterCache->new( max_bytes => 64 * 1024 * 1024 );
+    my $filter = Lucy::Search::CachingFilter->new(
+        query => $acl_query,
+        cache => $cache,
+    );
+END_SYNOPSIS
+    my $constructor = <<'END_CONSTRUCTOR';
+    my $cache = Lucy::Search::FilterCache->new(
+        max_bytes => $max_bytes,    # default: 16 MB
+    );
+END_CONSTRUCTOR
+    $pod_spec->set_synopsis($synopsis);
+    $pod_spec->add_constructor( alias => 'new', sample => $constructor, );
+    $pod_spec->add_method( method => $_, alias => lc($_) ) for @exposed;
+
+    my $binding = Clownfish::CFC::Binding::Perl::Class->new(
+        parcel     => "Lucy",
+        class_name => "Lucy::Search::FilterCache",
+    );
+    $binding->set_pod_spec($pod_spec);
+
+    Clownfish::CFC::Binding::Perl::Class->register($binding);
+}
+
 sub bind_notquery {
     my @exposed = qw(
         Get_Negated_Query
@@ -951,6 +1024,39 @@ END_CONSTRUCTOR
     Clownfish::CFC::Binding::Perl::Class->register($binding);
 }
 
+sub bind_termsquery {
+    my @exposed = qw( Get_Field Get_Terms );
+
+    my $pod_spec = Clownfish::CFC::Binding::Perl::Pod->new;
+    my $synopsis = <<'END_SYNOPSIS';
+    my $readable_query = Lucy::Search::TermsQuery->new(
+        field => 'acl_group',
+        terms => \@user_groups,
+    );
+    my $and_query = Lucy::Search::ANDQuery->new(
+        children => [ $user_query, $readable_query ],
+    );
+    my $hits = $searcher->hits( query => $and_query );
+END_SYNOPSIS
+    my $constructor = <<'END_CONSTRUCTOR';
+    my $terms_query = Lucy::Search::TermsQuery->new(
+        field => 'id',                      # required
+        terms => [ 'a17', 'b42', 'c99' ],   # required
+    );
+END_CONSTRUCTOR
+    $pod_spec->set_synopsis($synopsis);
+    $pod_spec->add_constructor( alias => 'new', sample => $constructor, );
+    $pod_spec->add_method( method => $_, alias => lc($_) ) for @exposed;
+
+    my $binding = Clownfish::CFC::Binding::Perl::Class->new(
+        parcel     => "Lucy",
+        class_name => "Lucy::Search::TermsQuery",
+    );
+    $binding->set_pod_spec($pod_spec);
+
+    Clownfish::CFC::Binding::Perl::Class->register($binding);
+}
+
 sub bind_termcompiler {
     my $binding = Clownfish::CFC::Binding::Perl::Class->new(
         parcel     => "Lucy",
@@ -263,11 +263,16 @@ sub top_docs {
     my $num_wanted = $args{num_wanted};
     my $sort_spec  = $args{sort_spec};
 
-    # Weight query if necessary.
+    # Each shard stops counting exactly once it reaches the threshold.
+    $args{total_hits_threshold} ||= 0;
+
+    # Simplify and weight the query if necessary, as PolySearcher does, then
+    # send the shards the compiled query.
     my $compiler
         = $query->isa("Lucy::Search::Compiler")
         ? $query
-        : $query->make_compiler( searcher => $self );
+        : $query->rewrite($self)->make_compiler( searcher => $self );
+    $args{query} = $compiler;
 
     # Create HitQueue.
     my $hit_q;
@@ -286,6 +291,7 @@ sub top_docs {
     $args{_action} = 'top_docs';
     my $responses  = $self->_multi_rpc( \%args );
     my $total_hits = 0;
+    my $total_hits_exact = 1;
     for ( my $i = 0; $i < $num_shards; $i++ ) {
         my $base           = $starts->get($i);
         my $sub_top_docs   = $responses->[$i];
@@ -296,14 +302,18 @@ sub top_docs {
             $hit_q->insert($match_doc);
         }
         $total_hits += $sub_top_docs->get_total_hits;
+        $total_hits_exact &&= $sub_top_docs->get_total_hits_exact;
     }
 
-    # Return a TopDocs object with the best of the best.
+    # Return a TopDocs object with the best of the best.  The total is only
+    # exact if every shard counted exactly.
     my $best_match_docs = $hit_q->pop_all;
-    return Lucy::Search::TopDocs->new(
+    my $top_docs        = Lucy::Search::TopDocs->new(
         total_hits => $total_hits,
         match_docs => $best_match_docs,
     );
+    $top_docs->set_total_hits_exact( $total_hits_exact ? 1 : 0 );
+    return $top_docs;
 }
 
 sub terminate {
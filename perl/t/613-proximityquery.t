@@ -17,7 +17,7 @@ use strict;
 use warnings;
 use lib 'buildlib';
 
-use Test::More tests => 11;
+use Test::More tests => 12;
 use Storable qw( freeze thaw );
 use Lucy::Test;
 use Lucy::Test::TestUtils qw( create_index );
@@ -106,3 +106,14 @@ $proximity_query = LucyX::Search::ProximityQuery->new(
 );
 $hits = $searcher->hits( query => $proximity_query );
 is( $hits->total_hits, 1, 'within range is exclusive' );
+
+# An anchor which misses must not hide a later anchor which matches.
+my $near_miss_searcher = Lucy::Search::IndexSearcher->new(
+    index => create_index('a x x x x a x b'), );
+$proximity_query = LucyX::Search::ProximityQuery->new(
+    field  => 'content',
+    terms  => [qw( a b )],
+    within => 3,
+);
+$hits = $near_miss_searcher->hits( query => $proximity_query );
+is( $hits->total_hits, 1, 'match after a near miss' );